@@ -13,7 +13,12 @@
 #include "../sockstreambuf.h"
 #include "../logger.h"
 #include "../algs.h"
+#include "../vectorstream.h"
+#include "../compress_stream.h"
+#include "../misc_api.h"
+#include "../uintn.h"
 #include <iostream>
+#include <vector>
 
 namespace dlib
 {
@@ -139,6 +144,56 @@ namespace dlib
         throw serialization_error("It is illegal to serialize bridge_status objects.");
     }
 
+// ----------------------------------------------------------------------------------------
+
+    struct bridge_options
+    {
+        bridge_options() :
+            batched_framing(false),
+            max_batch_size(64*1024),
+            max_batch_delay(2),
+            compression_threshold(0),
+            flow_control_window(0)
+        {}
+
+        bool batched_framing;
+        unsigned long max_batch_size;
+        unsigned long max_batch_delay;
+        unsigned long compression_threshold;
+        unsigned long flow_control_window;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    struct bridge_stats
+    {
+        bridge_stats() :
+            messages_sent(0),
+            messages_received(0),
+            batches_sent(0),
+            batches_received(0),
+            bytes_sent(0),
+            bytes_received(0),
+            uncompressed_bytes_sent(0),
+            uncompressed_bytes_received(0),
+            transmit_queue_depth(0),
+            receive_queue_depth(0),
+            available_credits(0)
+        {}
+
+        uint64 messages_sent;
+        uint64 messages_received;
+        uint64 batches_sent;
+        uint64 batches_received;
+        uint64 bytes_sent;
+        uint64 bytes_received;
+        uint64 uncompressed_bytes_sent;
+        uint64 uncompressed_bytes_received;
+        unsigned long transmit_queue_depth;
+        unsigned long receive_queue_depth;
+        unsigned long available_credits;
+    };
+
 // ----------------------------------------------------------------------------------------
 
     namespace impl
@@ -151,6 +206,9 @@ namespace dlib
 
             virtual bridge_status get_bridge_status (
             ) const = 0;
+
+            virtual bridge_stats get_bridge_stats (
+            ) const = 0;
         };
 
         template <
@@ -169,13 +227,33 @@ namespace dlib
                           not connected.
 
                     - get_bridge_status() == current_bs
+
+                    - if (opts.batched_framing) then
+                        - the transmit thread sends messages in batch frames and all writes
+                          to con are done while holding write_m.
+                        - if (opts.flow_control_window != 0) then
+                            - credits == the number of batches we may send before the
+                              remote end grants us more.
+                            - credits_valid == false if the receive thread has finished
+                              with the current connection, true otherwise.
+                            - The receive thread never blocks on the receive pipe since
+                              that would stop it from reading the credits sent by the
+                              other end.  Instead, it hands each batch to the delivery
+                              thread via delivery_pipe and the delivery thread grants a
+                              new credit once the batch has been enqueued onto the
+                              receive pipe.
+                            - num_undelivered == the number of batches given to the
+                              delivery thread that it hasn't finished with yet.
+                    - stats == the counters reported by get_bridge_stats(), protected
+                      by stats_m.
             !*/
         public:
 
             impl_bridge (
                 unsigned short listen_port,
                 transmit_pipe_type* transmit_pipe_,
-                receive_pipe_type* receive_pipe_
+                receive_pipe_type* receive_pipe_,
+                const bridge_options& opts_
             ) :
                 s(m),
                 receive_thread_active(false),
@@ -183,9 +261,17 @@ namespace dlib
                 port(0),
                 transmit_pipe(transmit_pipe_),
                 receive_pipe(receive_pipe_),
+                opts(opts_),
                 dlog("dlib.bridge"),
                 keepalive_code(0),
-                message_code(1)
+                message_code(1),
+                batch_code(2),
+                credit_code(3),
+                credit_s(credit_m),
+                credits(0),
+                credits_valid(false),
+                num_undelivered(0),
+                delivery_pipe(opts_.flow_control_window+1)
             {
                 int status = create_listener(list, listen_port);
                 if (status == PORTINUSE)
@@ -202,6 +288,7 @@ namespace dlib
                 register_thread(*this, &impl_bridge::transmit_thread);
                 register_thread(*this, &impl_bridge::receive_thread);
                 register_thread(*this, &impl_bridge::connect_thread);
+                register_thread(*this, &impl_bridge::delivery_thread);
 
                 start();
             }
@@ -210,7 +297,8 @@ namespace dlib
                 const std::string ip_,
                 unsigned short port_,
                 transmit_pipe_type* transmit_pipe_,
-                receive_pipe_type* receive_pipe_
+                receive_pipe_type* receive_pipe_,
+                const bridge_options& opts_
             ) :
                 s(m),
                 receive_thread_active(false),
@@ -219,13 +307,22 @@ namespace dlib
                 ip(ip_),
                 transmit_pipe(transmit_pipe_),
                 receive_pipe(receive_pipe_),
+                opts(opts_),
                 dlog("dlib.bridge"),
                 keepalive_code(0),
-                message_code(1)
+                message_code(1),
+                batch_code(2),
+                credit_code(3),
+                credit_s(credit_m),
+                credits(0),
+                credits_valid(false),
+                num_undelivered(0),
+                delivery_pipe(opts_.flow_control_window+1)
             {
                 register_thread(*this, &impl_bridge::transmit_thread);
                 register_thread(*this, &impl_bridge::receive_thread);
                 register_thread(*this, &impl_bridge::connect_thread);
+                register_thread(*this, &impl_bridge::delivery_thread);
 
                 start();
             }
@@ -251,6 +348,7 @@ namespace dlib
                     receive_enabled = receive_pipe->is_enqueue_enabled();
                     receive_pipe->disable_enqueue();
                 }
+                delivery_pipe.disable();
 
                 {
                     auto_mutex lock(m);
@@ -277,6 +375,23 @@ namespace dlib
                 return current_bs;
             }
 
+            bridge_stats get_bridge_stats (
+            ) const
+            {
+                bridge_stats temp;
+                {   auto_mutex lock(stats_m);
+                    temp = stats;
+                }
+                {   auto_mutex lock(credit_m);
+                    temp.available_credits = credits;
+                }
+                if (transmit_pipe)
+                    temp.transmit_queue_depth = transmit_pipe->size();
+                if (receive_pipe)
+                    temp.receive_queue_depth = receive_pipe->size();
+                return temp;
+            }
+
         private:
 
 
@@ -342,6 +457,11 @@ namespace dlib
                     enqueue_bridge_status(receive_pipe, temp_bs);
 
 
+                    {   auto_mutex lock(credit_m);
+                        credits = 0;
+                        credits_valid = true;
+                    }
+
                     receive_thread_active = true;
                     transmit_thread_active = true;
 
@@ -386,8 +506,13 @@ namespace dlib
 
                     try
                     {
-                        if (receive_pipe)
+                        if (receive_pipe || opts.batched_framing)
                         {
+                            // Let the other end know how many batches it may send before
+                            // waiting to hear back from us.
+                            if (opts.batched_framing && opts.flow_control_window != 0)
+                                send_credits(opts.flow_control_window);
+
                             sockstreambuf buf(con);
                             std::istream in(&buf);
                             typename receive_pipe_type::type item;
@@ -395,6 +520,7 @@ namespace dlib
                             // item being uninitialized sometimes.
                             assign_zero_if_built_in_scalar_type(item);
 
+                            std::vector<char> payload, raw;
                             while (in.peek() != EOF)
                             {
                                 unsigned char code;
@@ -402,7 +528,23 @@ namespace dlib
                                 if (code == message_code)
                                 {
                                     deserialize(item, in);
-                                    receive_pipe->enqueue(item);
+                                    if (receive_pipe)
+                                        receive_pipe->enqueue(item);
+
+                                    auto_mutex lock(stats_m);
+                                    ++stats.messages_received;
+                                }
+                                else if (code == batch_code)
+                                {
+                                    receive_batch(in, item, payload, raw);
+                                }
+                                else if (code == credit_code)
+                                {
+                                    unsigned long num;
+                                    deserialize(num, in);
+                                    auto_mutex lock(credit_m);
+                                    credits += num;
+                                    credit_s.broadcast();
                                 }
                             }
                         }
@@ -436,6 +578,13 @@ namespace dlib
 
 
                     con->shutdown();
+                    {   auto_mutex lock(credit_m);
+                        credits_valid = false;
+                        credit_s.broadcast();
+                        // Don't let go of con until the delivery thread is done with it.
+                        while (num_undelivered != 0 && !should_stop())
+                            credit_s.wait_or_timeout(1000);
+                    }
                     auto_mutex lock(m);
                     receive_thread_active = false;
                     s.broadcast();
@@ -446,6 +595,129 @@ namespace dlib
                 s.broadcast();
             }
 
+            void receive_batch (
+                std::istream& in,
+                typename receive_pipe_type::type& item,
+                std::vector<char>& payload,
+                std::vector<char>& raw
+            )
+            /*!
+                ensures
+                    - reads the rest of a batch frame (i.e. everything after the batch_code
+                      byte) from in and enqueues the messages it contains onto the receive
+                      pipe.  
+                    - if (flow control is enabled) then
+                        - grants the other end one more credit once all the messages have
+                          been enqueued.
+            !*/
+            {
+                unsigned long num_messages, raw_size, wire_size;
+                unsigned char compressed;
+                deserialize(num_messages, in);
+                deserialize(raw_size, in);
+                deserialize(wire_size, in);
+                in.read((char*)&compressed, sizeof(compressed));
+
+                payload.resize(wire_size);
+                if (wire_size != 0)
+                    in.read(&payload[0], wire_size);
+                if (!in)
+                    throw serialization_error("Unexpected end of stream while reading a bridge batch.");
+
+                {   auto_mutex lock(stats_m);
+                    ++stats.batches_received;
+                    stats.messages_received += num_messages;
+                    stats.bytes_received += wire_size;
+                    stats.uncompressed_bytes_received += raw_size;
+                }
+
+                if (receive_pipe)
+                {
+                    if (compressed)
+                    {
+                        raw.clear();
+                        raw.reserve(raw_size);
+                        vectorstream cin(payload);
+                        vectorstream cout(raw);
+                        compress_stream::kernel_1a().decompress(cin, cout);
+                        raw.swap(payload);
+                    }
+
+                    if (opts.batched_framing && opts.flow_control_window != 0)
+                    {
+                        {   auto_mutex lock(credit_m);
+                            ++num_undelivered;
+                        }
+                        if (!delivery_pipe.enqueue(payload))
+                        {
+                            auto_mutex lock(credit_m);
+                            --num_undelivered;
+                            credit_s.broadcast();
+                        }
+                        return;
+                    }
+
+                    vectorstream min(payload);
+                    for (unsigned long i = 0; i < num_messages; ++i)
+                    {
+                        deserialize(item, min);
+                        receive_pipe->enqueue(item);
+                    }
+                }
+
+                if (opts.batched_framing && opts.flow_control_window != 0)
+                    send_credits(1);
+            }
+
+            void delivery_thread (
+            )
+            {
+                typename receive_pipe_type::type item;
+                // This isn't necessary but doing it avoids a warning about
+                // item being uninitialized sometimes.
+                assign_zero_if_built_in_scalar_type(item);
+
+                std::vector<char> payload;
+                while (delivery_pipe.dequeue(payload))
+                {
+                    try
+                    {
+                        vectorstream min(payload);
+                        while (min.peek() != EOF)
+                        {
+                            deserialize(item, min);
+                            receive_pipe->enqueue(item);
+                        }
+                        send_credits(1);
+                    }
+                    catch (std::exception& e)
+                    {
+                        dlog << LERROR << "exception thrown while delivering messages from " 
+                            << con->get_foreign_ip() << ":" << con->get_foreign_port() 
+                            << ".\nThe exception error message is: \n" << e.what();
+                        con->shutdown();
+                    }
+
+                    auto_mutex lock(credit_m);
+                    --num_undelivered;
+                    credit_s.broadcast();
+                }
+            }
+
+            void send_credits (
+                unsigned long num
+            )
+            {
+                std::vector<char> frame;
+                vectorstream out(frame);
+                out.write((char*)&credit_code, sizeof(credit_code));
+                serialize(num, out);
+
+                auto_mutex lock(write_m);
+                if (con->write(&frame[0], frame.size()) != (long)frame.size())
+                    throw socket_error("Unable to send flow control credits.");
+            }
+
             void transmit_thread (
             )
             {
@@ -466,47 +738,56 @@ namespace dlib
 
                     try
                     {
-                        sockstreambuf buf(con);
-                        std::ostream out(&buf);
-                        typename transmit_pipe_type::type item;
-                        // This isn't necessary but doing it avoids a warning about
-                        // item being uninitialized sometimes.
-                        assign_zero_if_built_in_scalar_type(item);
+                        if (opts.batched_framing)
+                        {
+                            transmit_batches();
+                        }
+                        else
+                        {
+                            sockstreambuf buf(con);
+                            std::ostream out(&buf);
+                            typename transmit_pipe_type::type item;
+                            // This isn't necessary but doing it avoids a warning about
+                            // item being uninitialized sometimes.
+                            assign_zero_if_built_in_scalar_type(item);
 
 
-                        while (out)
-                        {
-                            bool dequeue_timed_out = false;
-                            if (transmit_pipe )
+                            while (out)
                             {
-                                if (transmit_pipe->dequeue_or_timeout(item,1000))
+                                bool dequeue_timed_out = false;
+                                if (transmit_pipe )
                                 {
-                                    out.write((char*)&message_code, sizeof(message_code));
-                                    serialize(item, out);
-                                    if (transmit_pipe->size() == 0)
-                                        out.flush();
-
-                                    continue;
+                                    if (transmit_pipe->dequeue_or_timeout(item,1000))
+                                    {
+                                        out.write((char*)&message_code, sizeof(message_code));
+                                        serialize(item, out);
+                                        if (transmit_pipe->size() == 0)
+                                            out.flush();
+
+                                        auto_mutex lock(stats_m);
+                                        ++stats.messages_sent;
+                                        continue;
+                                    }
+
+                                    dequeue_timed_out = (transmit_pipe->is_enabled() && transmit_pipe->is_dequeue_enabled());
                                 }
 
-                                dequeue_timed_out = (transmit_pipe->is_enabled() && transmit_pipe->is_dequeue_enabled());
-                            }
-
-                            // Pause for about a second.  Note that we use a wait_or_timeout() call rather 
-                            // than sleep() here because we want to wake up immediately if this object is 
-                            // being destructed rather than hang for a second.
-                            if (!dequeue_timed_out)
-                            {
-                                auto_mutex lock(m);
-                                if (should_stop())
-                                    break;
+                                // Pause for about a second.  Note that we use a wait_or_timeout() call rather 
+                                // than sleep() here because we want to wake up immediately if this object is 
+                                // being destructed rather than hang for a second.
+                                if (!dequeue_timed_out)
+                                {
+                                    auto_mutex lock(m);
+                                    if (should_stop())
+                                        break;
 
-                                s.wait_or_timeout(1000);
+                                    s.wait_or_timeout(1000);
+                                }
+                                // Just send the keepalive byte periodically so we can
+                                // tell if the connection is alive. 
+                                out.write((char*)&keepalive_code, sizeof(keepalive_code));
+                                out.flush();
                             }
-                            // Just send the keepalive byte periodically so we can
-                            // tell if the connection is alive. 
-                            out.write((char*)&keepalive_code, sizeof(keepalive_code));
-                            out.flush();
                         }
                     }
                     catch (std::bad_alloc& )
@@ -541,6 +822,152 @@ namespace dlib
                 s.broadcast();
             }
 
+            void transmit_batches (
+            )
+            /*!
+                requires
+                    - opts.batched_framing == true
+                ensures
+                    - sends everything dequeued from the transmit pipe over con in batch
+                      frames until the connection fails or this object is stopped.
+            !*/
+            {
+                typename transmit_pipe_type::type item;
+                // This isn't necessary but doing it avoids a warning about
+                // item being uninitialized sometimes.
+                assign_zero_if_built_in_scalar_type(item);
+
+                std::vector<char> batch, compressed;
+                timestamper ts;
+                while (true)
+                {
+                    bool dequeue_timed_out = false;
+                    if (transmit_pipe)
+                    {
+                        if (transmit_pipe->dequeue_or_timeout(item,1000))
+                        {
+                            batch.clear();
+                            vectorstream out(batch);
+                            serialize(item, out);
+                            unsigned long num_messages = 1;
+
+                            // Keep adding messages to this batch until it's full or we
+                            // have held onto the first message for max_batch_delay
+                            // milliseconds.
+                            const uint64 deadline = ts.get_timestamp() + opts.max_batch_delay*1000;
+                            while (batch.size() < opts.max_batch_size)
+                            {
+                                if (!transmit_pipe->dequeue_or_timeout(item,0))
+                                {
+                                    const uint64 now = ts.get_timestamp();
+                                    if (now >= deadline)
+                                        break;
+                                    const unsigned long wait_time = static_cast<unsigned long>((deadline-now+999)/1000);
+                                    if (!transmit_pipe->dequeue_or_timeout(item,wait_time))
+                                        break;
+                                }
+                                serialize(item, out);
+                                ++num_messages;
+                            }
+
+                            if (!send_batch(batch, compressed, num_messages))
+                                return;
+                            continue;
+                        }
+
+                        dequeue_timed_out = (transmit_pipe->is_enabled() && transmit_pipe->is_dequeue_enabled());
+                    }
+
+                    // Pause for about a second.  Note that we use a wait_or_timeout() call rather 
+                    // than sleep() here because we want to wake up immediately if this object is 
+                    // being destructed rather than hang for a second.
+                    if (!dequeue_timed_out)
+                    {
+                        auto_mutex lock(m);
+                        if (should_stop())
+                            return;
+
+                        s.wait_or_timeout(1000);
+                    }
+                    // Just send the keepalive byte periodically so we can
+                    // tell if the connection is alive. 
+                    auto_mutex lock(write_m);
+                    if (con->write((char*)&keepalive_code, sizeof(keepalive_code)) != sizeof(keepalive_code))
+                        return;
+                }
+            }
+
+            bool send_batch (
+                std::vector<char>& batch,
+                std::vector<char>& compressed,
+                unsigned long num_messages
+            )
+            /*!
+                ensures
+                    - writes a batch frame containing the num_messages serialized messages
+                      in batch to con.  The payload is compressed first if it's at least
+                      opts.compression_threshold bytes and compression makes it smaller.
+                    - if (flow control is enabled) then
+                        - blocks until the other end has granted us a credit and
+                          consumes it.
+                    - returns true if the frame was sent and false if the connection
+                      has failed or this object is being stopped.
+            !*/
+            {
+                const unsigned long raw_size = batch.size();
+                std::vector<char>* payload = &batch;
+                unsigned char is_compressed = 0;
+                if (opts.compression_threshold != 0 && raw_size >= opts.compression_threshold)
+                {
+                    compressed.clear();
+                    vectorstream cin(batch);
+                    vectorstream cout(compressed);
+                    compress_stream::kernel_1a().compress(cin, cout);
+                    if (compressed.size() < raw_size)
+                    {
+                        payload = &compressed;
+                        is_compressed = 1;
+                    }
+                }
+
+                if (opts.flow_control_window != 0)
+                {
+                    auto_mutex lock(credit_m);
+                    while (credits == 0)
+                    {
+                        if (!credits_valid || should_stop())
+                            return false;
+                        credit_s.wait_or_timeout(1000);
+                    }
+                    --credits;
+                }
+
+                std::vector<char> header;
+                vectorstream out(header);
+                out.write((char*)&batch_code, sizeof(batch_code));
+                serialize(num_messages, out);
+                serialize(raw_size, out);
+                serialize(static_cast<unsigned long>(payload->size()), out);
+                out.write((char*)&is_compressed, sizeof(is_compressed));
+
+                // Send the header and payload together in one gather write.
+                const_io_buffer bufs[2];
+                bufs[0] = const_io_buffer(&header[0], header.size());
+                bufs[1] = const_io_buffer(&(*payload)[0], payload->size());
+                const long total = header.size() + payload->size();
+                {   auto_mutex lock(write_m);
+                    if (con->write(bufs,2) != total)
+                        return false;
+                }
+
+                auto_mutex lock(stats_m);
+                ++stats.batches_sent;
+                stats.messages_sent += num_messages;
+                stats.bytes_sent += payload->size();
+                stats.uncompressed_bytes_sent += raw_size;
+                return true;
+            }
+
             mutex m;
             signaler s;
             bool receive_thread_active;
@@ -551,12 +978,27 @@ namespace dlib
             const std::string ip;
             transmit_pipe_type* const transmit_pipe;
             receive_pipe_type* const receive_pipe;
+            const bridge_options opts;
             logger dlog;
             const unsigned char keepalive_code;
             const unsigned char message_code;
+            const unsigned char batch_code;
+            const unsigned char credit_code;
 
             mutex current_bs_mutex;
             bridge_status current_bs;
+
+            mutex write_m;
+
+            mutex credit_m;
+            signaler credit_s;
+            unsigned long credits;
+            bool credits_valid;
+            unsigned long num_undelivered;
+            dlib::pipe<std::vector<char> > delivery_pipe;
+
+            mutex stats_m;
+            bridge_stats stats;
         };
     }
 
@@ -582,6 +1024,21 @@ namespace dlib
             U pipe 
         ) { reconfigure(network_parameters,pipe); }
 
+        template < typename T, typename U, typename V >
+        bridge (
+            T network_parameters,
+            U pipe1,
+            V pipe2,
+            const bridge_options& opts
+        ) { reconfigure(network_parameters,pipe1,pipe2,opts); }
+
+        template < typename T, typename U>
+        bridge (
+            T network_parameters,
+            U pipe,
+            const bridge_options& opts
+        ) { reconfigure(network_parameters,pipe,opts); }
+
 
         void clear (
         )
@@ -593,27 +1050,31 @@ namespace dlib
         void reconfigure (
             listen_on_port network_parameters,
             bridge_transmit_decoration<T> transmit_pipe,
-            bridge_receive_decoration<R> receive_pipe
-        ) { pimpl.reset(); pimpl.reset(new impl::impl_bridge<T,R>(network_parameters.port, &transmit_pipe.p, &receive_pipe.p)); }
+            bridge_receive_decoration<R> receive_pipe,
+            const bridge_options& opts = bridge_options()
+        ) { pimpl.reset(); pimpl.reset(new impl::impl_bridge<T,R>(network_parameters.port, &transmit_pipe.p, &receive_pipe.p, opts)); }
 
         template < typename T, typename R >
         void reconfigure (
             listen_on_port network_parameters,
             bridge_receive_decoration<R> receive_pipe,
-            bridge_transmit_decoration<T> transmit_pipe
-        ) { pimpl.reset(); pimpl.reset(new impl::impl_bridge<T,R>(network_parameters.port, &transmit_pipe.p, &receive_pipe.p)); }
+            bridge_transmit_decoration<T> transmit_pipe,
+            const bridge_options& opts = bridge_options()
+        ) { pimpl.reset(); pimpl.reset(new impl::impl_bridge<T,R>(network_parameters.port, &transmit_pipe.p, &receive_pipe.p, opts)); }
 
         template < typename T >
         void reconfigure (
             listen_on_port network_parameters,
-            bridge_transmit_decoration<T> transmit_pipe
-        ) { pimpl.reset(); pimpl.reset(new impl::impl_bridge<T,T>(network_parameters.port, &transmit_pipe.p, 0)); }
+            bridge_transmit_decoration<T> transmit_pipe,
+            const bridge_options& opts = bridge_options()
+        ) { pimpl.reset(); pimpl.reset(new impl::impl_bridge<T,T>(network_parameters.port, &transmit_pipe.p, 0, opts)); }
 
         template < typename R >
         void reconfigure (
             listen_on_port network_parameters,
-            bridge_receive_decoration<R> receive_pipe
-        ) { pimpl.reset(); pimpl.reset(new impl::impl_bridge<R,R>(network_parameters.port, 0, &receive_pipe.p)); }
+            bridge_receive_decoration<R> receive_pipe,
+            const bridge_options& opts = bridge_options()
+        ) { pimpl.reset(); pimpl.reset(new impl::impl_bridge<R,R>(network_parameters.port, 0, &receive_pipe.p, opts)); }
 
 
 
@@ -622,27 +1083,31 @@ namespace dlib
         void reconfigure (
             connect_to_ip_and_port network_parameters,
             bridge_transmit_decoration<T> transmit_pipe,
-            bridge_receive_decoration<R> receive_pipe
-        ) { pimpl.reset(); pimpl.reset(new impl::impl_bridge<T,R>(network_parameters.ip, network_parameters.port, &transmit_pipe.p, &receive_pipe.p)); }
+            bridge_receive_decoration<R> receive_pipe,
+            const bridge_options& opts = bridge_options()
+        ) { pimpl.reset(); pimpl.reset(new impl::impl_bridge<T,R>(network_parameters.ip, network_parameters.port, &transmit_pipe.p, &receive_pipe.p, opts)); }
 
         template < typename T, typename R >
         void reconfigure (
             connect_to_ip_and_port network_parameters,
             bridge_receive_decoration<R> receive_pipe,
-            bridge_transmit_decoration<T> transmit_pipe
-        ) { pimpl.reset(); pimpl.reset(new impl::impl_bridge<T,R>(network_parameters.ip, network_parameters.port, &transmit_pipe.p, &receive_pipe.p)); }
+            bridge_transmit_decoration<T> transmit_pipe,
+            const bridge_options& opts = bridge_options()
+        ) { pimpl.reset(); pimpl.reset(new impl::impl_bridge<T,R>(network_parameters.ip, network_parameters.port, &transmit_pipe.p, &receive_pipe.p, opts)); }
 
         template < typename R >
         void reconfigure (
             connect_to_ip_and_port network_parameters,
-            bridge_receive_decoration<R> receive_pipe
-        ) { pimpl.reset(); pimpl.reset(new impl::impl_bridge<R,R>(network_parameters.ip, network_parameters.port, 0, &receive_pipe.p)); }
+            bridge_receive_decoration<R> receive_pipe,
+            const bridge_options& opts = bridge_options()
+        ) { pimpl.reset(); pimpl.reset(new impl::impl_bridge<R,R>(network_parameters.ip, network_parameters.port, 0, &receive_pipe.p, opts)); }
 
         template < typename T >
         void reconfigure (
             connect_to_ip_and_port network_parameters,
-            bridge_transmit_decoration<T> transmit_pipe
-        ) { pimpl.reset(); pimpl.reset(new impl::impl_bridge<T,T>(network_parameters.ip, network_parameters.port, &transmit_pipe.p, 0)); }
+            bridge_transmit_decoration<T> transmit_pipe,
+            const bridge_options& opts = bridge_options()
+        ) { pimpl.reset(); pimpl.reset(new impl::impl_bridge<T,T>(network_parameters.ip, network_parameters.port, &transmit_pipe.p, 0, opts)); }
 
 
         bridge_status get_bridge_status (
@@ -654,6 +1119,15 @@ namespace dlib
                 return bridge_status();
         }
 
+        bridge_stats get_bridge_stats (
+        ) const
+        {
+            if (pimpl)
+                return pimpl->get_bridge_stats();
+            else
+                return bridge_stats();
+        }
+
     private:
 
         scoped_ptr<impl::impl_bridge_base> pimpl;
@@ -5,6 +5,7 @@
 
 #include <string>
 #include "../pipe/pipe_kernel_abstract.h"
+#include "../uintn.h"
 
 namespace dlib
 {
@@ -108,6 +109,91 @@ namespace dlib
         std::string foreign_ip;
     };
 
+// ---------------------------------------------------------------------------------------- 
+
+    struct bridge_options
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object controls how a bridge frames the messages it sends over its
+                TCP connection.  By default a bridge sends each message as soon as it is
+                dequeued from the transmit pipe.  If batched_framing is true then the
+                bridge instead coalesces messages into batches.  Batching greatly
+                increases the throughput of a bridge carrying many small messages since
+                each batch requires only one system call.
+
+                When batched_framing == true:
+                    - A batch is sent once it contains at least max_batch_size bytes or
+                      once its first message has waited max_batch_delay milliseconds for
+                      more messages to arrive, whichever comes first.
+                    - If compression_threshold != 0 then any batch containing at least
+                      compression_threshold bytes is compressed before it is sent
+                      (unless compressing it doesn't make it smaller).  
+                    - If flow_control_window != 0 then the bridge uses credit based flow
+                      control.  That is, a bridge will never have more than
+                      flow_control_window batches in flight which the other end hasn't
+                      yet enqueued onto its receive pipe.  This bounds the memory used
+                      by both bridges and the TCP connection even when the receiving
+                      application is slow.  Note that both ends of a connection must use
+                      the same flow_control_window setting.
+        !*/
+
+        bridge_options(
+        );
+        /*!
+            ensures
+                - #batched_framing == false
+                - #max_batch_size == 64*1024
+                - #max_batch_delay == 2
+                - #compression_threshold == 0
+                - #flow_control_window == 0
+        !*/
+
+        bool batched_framing;
+        unsigned long max_batch_size;       // in bytes
+        unsigned long max_batch_delay;      // in milliseconds
+        unsigned long compression_threshold;// in bytes
+        unsigned long flow_control_window;  // in batches
+    };
+
+// ---------------------------------------------------------------------------------------- 
+
+    struct bridge_stats
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This simple struct contains performance counters for a bridge object.
+                All the counters are cumulative over the lifetime of the bridge (i.e.
+                since it was last reconfigured or cleared).
+        !*/
+
+        bridge_stats(
+        );
+        /*!
+            ensures
+                - all the counters in this object are 0.
+        !*/
+
+        uint64 messages_sent;       // number of objects sent from the transmit pipe
+        uint64 messages_received;   // number of objects received from the other end
+        uint64 batches_sent;        // number of batch frames sent
+        uint64 batches_received;    // number of batch frames received
+
+        // The following byte counts only include the payloads of batch frames, so they
+        // are always 0 unless batched_framing is being used.  The bytes_* counts give the
+        // number of bytes actually sent over the network while the
+        // uncompressed_bytes_* counts give the number of bytes before compression.
+        uint64 bytes_sent;
+        uint64 bytes_received;
+        uint64 uncompressed_bytes_sent;
+        uint64 uncompressed_bytes_received;
+
+        unsigned long transmit_queue_depth; // the number of objects in the transmit pipe
+        unsigned long receive_queue_depth;  // the number of objects in the receive pipe
+        unsigned long available_credits;    // batches we may send before the other end
+                                            // must grant us more credits.
+    };
+
 // ---------------------------------------------------------------------------------------- 
 
     class bridge : noncopyable
@@ -135,6 +221,18 @@ namespace dlib
                 Additionally, a bridge object will periodically send bytes with
                 a value of 0 to ensure the TCP connection remains alive.  These
                 are just read and ignored.  
+
+                If bridge_options::batched_framing is enabled then instead of the above
+                messages the bridge sends batch frames.  A batch frame is a byte with the
+                value 2, followed by the serialized unsigned longs num_messages,
+                raw_size, and payload_size, then a byte which is 1 if the payload is
+                compressed with compress_stream::kernel_1a and 0 otherwise, and then
+                payload_size bytes of payload.  The uncompressed payload is num_messages
+                serialized objects, which together take up raw_size bytes.  When flow
+                control is enabled, the bridge also sends credit frames.  These are a
+                byte with the value 3 followed by the serialized unsigned long number of
+                new credits granted to the other end.  Every bridge can receive any of
+                these frame types regardless of how it is configured.
         !*/
 
     public:
@@ -182,6 +280,35 @@ namespace dlib
                   and then calling reconfigure())
         !*/
 
+        template <typename T, typename U, typename V>
+        bridge (
+            T network_parameters,
+            U pipe1,
+            V pipe2,
+            const bridge_options& opts
+        ); 
+        /*!
+            requires
+                - T, U, and V meet the requirements of the above 3 argument constructor.
+            ensures
+                - this object is properly initialized
+                - performs: reconfigure(network_parameters, pipe1, pipe2, opts)
+        !*/
+
+        template <typename T, typename U>
+        bridge (
+            T network_parameters,
+            U pipe,
+            const bridge_options& opts
+        ); 
+        /*!
+            requires
+                - T and U meet the requirements of the above 2 argument constructor.
+            ensures
+                - this object is properly initialized
+                - performs: reconfigure(network_parameters, pipe, opts)
+        !*/
+
         ~bridge (
         );
         /*!
@@ -218,18 +345,31 @@ namespace dlib
                         - BS.foreign_port == 0
         !*/
 
+        bridge_stats get_bridge_stats (
+        ) const;
+        /*!
+            ensures
+                - returns the throughput and queue depth counters for this bridge.  See
+                  the bridge_stats object for details.
+                - if (this object is in its default constructed state) then
+                    - returns bridge_stats()
+        !*/
+
 
 
         template < typename T, typename R >
         void reconfigure (
             listen_on_port network_parameters,
             bridge_transmit_decoration<T> transmit_pipe,
-            bridge_receive_decoration<R> receive_pipe
+            bridge_receive_decoration<R> receive_pipe,
+            const bridge_options& opts = bridge_options()
         ); 
         /*!
             ensures
                 - This object will begin listening on the port specified by network_parameters
                   for incoming TCP connections.  Any previous bridge state is cleared out.
+                - The messages sent over the TCP connection will be framed according to
+                  opts.
                 - Onces a connection is established we will:
                     - Stop accepting new connections.
                     - Begin dequeuing objects from the transmit pipe and serializing them over 
@@ -251,16 +391,18 @@ namespace dlib
         void reconfigure (
             listen_on_port network_parameters,
             bridge_receive_decoration<R> receive_pipe,
-            bridge_transmit_decoration<T> transmit_pipe
+            bridge_transmit_decoration<T> transmit_pipe,
+            const bridge_options& opts = bridge_options()
         ); 
         /*!
             ensures
-                - performs reconfigure(network_parameters, transmit_pipe, receive_pipe)
+                - performs reconfigure(network_parameters, transmit_pipe, receive_pipe, opts)
         !*/
         template < typename T >
         void reconfigure (
             listen_on_port network_parameters,
-            bridge_transmit_decoration<T> transmit_pipe
+            bridge_transmit_decoration<T> transmit_pipe,
+            const bridge_options& opts = bridge_options()
         );
         /*!
             ensures
@@ -270,7 +412,8 @@ namespace dlib
         template < typename R >
         void reconfigure (
             listen_on_port network_parameters,
-            bridge_receive_decoration<R> receive_pipe
+            bridge_receive_decoration<R> receive_pipe,
+            const bridge_options& opts = bridge_options()
         );
         /*!
             ensures
@@ -284,12 +427,15 @@ namespace dlib
         void reconfigure (
             connect_to_ip_and_port network_parameters,
             bridge_transmit_decoration<T> transmit_pipe,
-            bridge_receive_decoration<R> receive_pipe
+            bridge_receive_decoration<R> receive_pipe,
+            const bridge_options& opts = bridge_options()
         ); 
         /*!
             ensures
                 - This object will begin making TCP connection attempts to the IP address and port 
                   specified by network_parameters.  Any previous bridge state is cleared out.
+                - The messages sent over the TCP connection will be framed according to
+                  opts.
                 - Onces a connection is established we will:
                     - Stop attempting new connections.
                     - Begin dequeuing objects from the transmit pipe and serializing them over 
@@ -309,16 +455,18 @@ namespace dlib
         void reconfigure (
             connect_to_ip_and_port network_parameters,
             bridge_receive_decoration<R> receive_pipe,
-            bridge_transmit_decoration<T> transmit_pipe
+            bridge_transmit_decoration<T> transmit_pipe,
+            const bridge_options& opts = bridge_options()
         ); 
         /*!
             ensures
-                - performs reconfigure(network_parameters, transmit_pipe, receive_pipe)
+                - performs reconfigure(network_parameters, transmit_pipe, receive_pipe, opts)
         !*/
         template <typename T>
         void reconfigure (
             connect_to_ip_and_port network_parameters,
-            bridge_transmit_decoration<T> transmit_pipe
+            bridge_transmit_decoration<T> transmit_pipe,
+            const bridge_options& opts = bridge_options()
         );
         /*!
             ensures
@@ -328,7 +476,8 @@ namespace dlib
         template <typename R>
         void reconfigure (
             connect_to_ip_and_port network_parameters,
-            bridge_receive_decoration<R> receive_pipe
+            bridge_receive_decoration<R> receive_pipe,
+            const bridge_options& opts = bridge_options()
         );
         /*!
             ensures
@@ -5,6 +5,7 @@
 
 #include "clustering/modularity_clustering.h"
 #include "clustering/chinese_whispers.h"
+#include "clustering/louvain_clustering.h"
 #include "svm/kkmeans.h"
 
 #endif // DLIB_CLuSTERING_
@@ -5,12 +5,45 @@
 
 #include "chinese_whispers_abstract.h"
 #include <vector>
+#include <limits>
+#include <algorithm>
 #include "../rand.h"
+#include "../threads.h"
+#include "../general_hash/murmur_hash3.h"
 #include "../graph_utils/edge_list_graphs.h"
 
 namespace dlib
 {
 
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        inline unsigned long remap_labels_to_contiguous_range (
+            std::vector<unsigned long>& labels
+        )
+        /*!
+            ensures
+                - Renumbers the labels so they are in the range [0, number of distinct
+                  labels).  Labels are numbered in the order they first appear in labels.
+                - returns the number of distinct labels.
+        !*/
+        {
+            // Labels produced by chinese whispers are always node indices so they are
+            // all less than labels.size().
+            const unsigned long not_mapped = std::numeric_limits<unsigned long>::max();
+            std::vector<unsigned long> label_remap(labels.size(), not_mapped);
+            unsigned long next_id = 0;
+            for (unsigned long i = 0; i < labels.size(); ++i)
+            {
+                if (label_remap[labels[i]] == not_mapped)
+                    label_remap[labels[i]] = next_id++;
+                labels[i] = label_remap[labels[i]];
+            }
+            return next_id;
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
 
     inline unsigned long chinese_whispers (
@@ -38,6 +71,13 @@ namespace dlib
         for (unsigned long i = 0; i < labels.size(); ++i)
             labels[i] = i;
 
+        // These are used to count how many times each label happens amongst a node's
+        // neighbors without allocating anything inside the loop below.  label_stamp[l]
+        // records the last iteration that touched label_counts[l], so we know which
+        // counts are stale without having to clear the whole array each time.
+        std::vector<double> label_counts(neighbors.size(), 0);
+        std::vector<unsigned long> label_stamp(neighbors.size(), std::numeric_limits<unsigned long>::max());
+        std::vector<unsigned long> touched_labels;
 
         for (unsigned long iter = 0; iter < neighbors.size()*num_iterations; ++iter)
         {
@@ -45,46 +85,39 @@ namespace dlib
             const unsigned long idx = rnd.get_random_64bit_number()%neighbors.size();
 
             // Count how many times each label happens amongst our neighbors.
-            std::map<unsigned long, double> labels_to_counts;
+            touched_labels.clear();
             const unsigned long end = neighbors[idx].second;
             for (unsigned long i = neighbors[idx].first; i != end; ++i)
             {
-                labels_to_counts[labels[edges[i].index2()]] += edges[i].distance();
+                const unsigned long l = labels[edges[i].index2()];
+                if (label_stamp[l] != iter)
+                {
+                    label_stamp[l] = iter;
+                    label_counts[l] = 0;
+                    touched_labels.push_back(l);
+                }
+                label_counts[l] += edges[i].distance();
             }
 
-            // find the most common label
-            std::map<unsigned long, double>::iterator i;
+            // find the most common label.  Break ties in favor of the smallest label.
             double best_score = -std::numeric_limits<double>::infinity();
             unsigned long best_label = labels[idx];
-            for (i = labels_to_counts.begin(); i != labels_to_counts.end(); ++i)
+            for (unsigned long i = 0; i < touched_labels.size(); ++i)
             {
-                if (i->second > best_score)
+                const unsigned long l = touched_labels[i];
+                if (label_counts[l] > best_score || 
+                    (label_counts[l] == best_score && l < best_label))
                 {
-                    best_score = i->second;
-                    best_label = i->first;
+                    best_score = label_counts[l];
+                    best_label = l;
                 }
             }
 
             labels[idx] = best_label;
         }
 
-
-        // Remap the labels into a contiguous range.  First we find the
-        // mapping.
-        std::map<unsigned long,unsigned long> label_remap;
-        for (unsigned long i = 0; i < labels.size(); ++i)
-        {
-            const unsigned long next_id = label_remap.size();
-            if (label_remap.count(labels[i]) == 0)
-                label_remap[labels[i]] = next_id;
-        }
-        // now apply the mapping to all the labels.
-        for (unsigned long i = 0; i < labels.size(); ++i)
-        {
-            labels[i] = label_remap[labels[i]];
-        }
-
-        return label_remap.size();
+        // Remap the labels into a contiguous range.
+        return impl::remap_labels_to_contiguous_range(labels);
     }
 
 // ----------------------------------------------------------------------------------------
@@ -127,6 +160,398 @@ namespace dlib
         return chinese_whispers(edges, labels, num_iterations, rnd);
     }
 
+// ----------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------
+
+    enum chinese_whispers_mode
+    {
+        chinese_whispers_asynchronous,
+        chinese_whispers_synchronous
+    };
+
+    namespace impl
+    {
+        class chinese_whispers_label_counter
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This object finds the most common label amongst a node's neighbors by
+                    sorting the (label, weight) pairs of its edges.  Its buffer is reused
+                    from node to node so once it has grown to the largest degree in the
+                    graph it doesn't allocate any more memory.  Unlike the dense counting
+                    array used by the single threaded chinese_whispers() its memory use
+                    doesn't depend on the size of the graph, which is what we want when
+                    each thread needs its own counter.
+            !*/
+        public:
+            unsigned long find_best_label (
+                const std::vector<ordered_sample_pair>& edges,
+                const std::pair<unsigned long,unsigned long>& range,
+                const std::vector<unsigned long>& labels,
+                const unsigned long current_label
+            )
+            /*!
+                ensures
+                    - returns the label with the largest total edge weight amongst the
+                      edges in range.  Ties are broken in favor of current_label and then
+                      in favor of the smallest label.  If range is empty then returns
+                      current_label.
+            !*/
+            {
+                buf.clear();
+                for (unsigned long i = range.first; i != range.second; ++i)
+                    buf.push_back(std::make_pair(labels[edges[i].index2()], edges[i].distance()));
+
+                std::sort(buf.begin(), buf.end());
+
+                double best_score = -std::numeric_limits<double>::infinity();
+                unsigned long best_label = current_label;
+                unsigned long i = 0;
+                while (i < buf.size())
+                {
+                    const unsigned long l = buf[i].first;
+                    double score = 0;
+                    for (; i < buf.size() && buf[i].first == l; ++i)
+                        score += buf[i].second;
+
+                    if (score > best_score || (score == best_score && l == current_label))
+                    {
+                        best_score = score;
+                        best_label = l;
+                    }
+                }
+                return best_label;
+            }
+
+        private:
+            std::vector<std::pair<unsigned long,double> > buf;
+        };
+
+    // ------------------------------------------------------------------------------------
+
+        template <typename job_type>
+        void run_balanced_workers (
+            thread_pool& tp,
+            const unsigned long num_threads,
+            const unsigned long num_items,
+            std::vector<unsigned long>& bounds,
+            job_type& job
+        )
+        /*!
+            requires
+                - bounds.size() > 1
+                - job.work_size(k) == the amount of work needed for item k, for all
+                  k < num_items.
+                - job.do_worker(w) processes the items in [#bounds[w], #bounds[w+1]).
+            ensures
+                - Splits the items into bounds.size()-1 contiguous ranges with about the
+                  same amount of work in each and stores them in #bounds.  Then calls
+                  job.do_worker() for each range, using tp if num_threads > 1.
+        !*/
+        {
+            const unsigned long num_workers = bounds.size()-1;
+
+            unsigned long total = 0;
+            for (unsigned long k = 0; k < num_items; ++k)
+                total += job.work_size(k);
+
+            std::fill(bounds.begin(), bounds.end(), num_items);
+            bounds[0] = 0;
+            unsigned long w = 1, sum = 0;
+            for (unsigned long k = 0; k < num_items && w < num_workers; ++k)
+            {
+                sum += job.work_size(k);
+                while (w < num_workers && sum >= (total*w)/num_workers)
+                    bounds[w++] = k+1;
+            }
+
+            // Small jobs aren't worth handing to the thread pool.
+            if (num_threads <= 1 || total < 5000)
+            {
+                for (unsigned long i = 0; i < num_workers; ++i)
+                    job.do_worker(i);
+            }
+            else
+            {
+                parallel_for(tp, 0, num_workers, job, &job_type::do_worker, 1);
+            }
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        class chinese_whispers_threaded_helper
+        {
+        public:
+            chinese_whispers_threaded_helper (
+                const std::vector<ordered_sample_pair>& edges_,
+                const std::vector<std::pair<unsigned long, unsigned long> >& neighbors_,
+                const unsigned long num_threads_
+            ) : 
+                edges(edges_), 
+                neighbors(neighbors_), 
+                num_threads(num_threads_),
+                num_workers(num_threads_*4),
+                nodes(0),
+                src(0),
+                dest(0),
+                activation_round(0),
+                tp(num_threads_ > 1 ? num_threads_ : 0)
+            {
+                counters.resize(num_workers);
+                num_changed.resize(num_workers);
+                bounds.resize(num_workers+1);
+            }
+
+            unsigned long update (
+                const std::vector<unsigned long>* nodes_,
+                const std::vector<unsigned long>& src_,
+                std::vector<unsigned long>& dest_,
+                const unsigned long activation_round_ = 0
+            )
+            /*!
+                requires
+                    - if (nodes_ != 0) then
+                        - nodes_ is a list of nodes, none of which have edges between
+                          them (except self loops).  Or &src_ != &dest_.
+                ensures
+                    - for all nodes i in *nodes_ (or all nodes if nodes_ == 0):
+                        - if (activation_round_ == 0 or node i is randomly selected for
+                          this activation round) then
+                            - #dest_[i] == the best label for i given the labels in src_
+                        - else
+                            - #dest_[i] == src_[i]
+                    - returns the number of nodes whose best label is different from
+                      their label in src_ (whether or not they were activated).
+            !*/
+            {
+                nodes = nodes_;
+                src = &src_;
+                dest = &dest_;
+                activation_round = activation_round_;
+                const unsigned long num = nodes ? nodes->size() : neighbors.size();
+                run_balanced_workers(tp, num_threads, num, bounds, *this);
+
+                unsigned long changed = 0;
+                for (unsigned long i = 0; i < num_changed.size(); ++i)
+                    changed += num_changed[i];
+                return changed;
+            }
+
+            void do_worker (
+                long w
+            )
+            {
+                num_changed[w] = 0;
+                for (unsigned long k = bounds[w]; k < bounds[w+1]; ++k)
+                {
+                    const unsigned long i = node(k);
+                    const unsigned long l = counters[w].find_best_label(edges, neighbors[i], *src, (*src)[i]);
+                    if (l != (*src)[i])
+                    {
+                        ++num_changed[w];
+                        if (activation_round != 0 && (murmur_hash3_2(i, activation_round)&1) == 0)
+                        {
+                            (*dest)[i] = (*src)[i];
+                            continue;
+                        }
+                    }
+                    (*dest)[i] = l;
+                }
+            }
+
+            unsigned long work_size (unsigned long k) const { return degree(node(k)) + 1; }
+
+        private:
+
+            unsigned long node (unsigned long k) const { return nodes ? (*nodes)[k] : k; }
+            unsigned long degree (unsigned long i) const { return neighbors[i].second - neighbors[i].first; }
+
+            const std::vector<ordered_sample_pair>& edges;
+            const std::vector<std::pair<unsigned long, unsigned long> >& neighbors;
+            const unsigned long num_threads;
+            const unsigned long num_workers;
+
+            const std::vector<unsigned long>* nodes;
+            const std::vector<unsigned long>* src;
+            std::vector<unsigned long>* dest;
+            unsigned long activation_round;
+
+            std::vector<chinese_whispers_label_counter> counters;
+            std::vector<unsigned long> num_changed;
+            std::vector<unsigned long> bounds;
+
+            thread_pool tp;
+        };
+
+    // ------------------------------------------------------------------------------------
+
+        inline void color_symmetric_graph_greedily (
+            const std::vector<unsigned long>& offsets,
+            const std::vector<unsigned long>& targets,
+            std::vector<std::vector<unsigned long> >& color_classes
+        )
+        /*!
+            requires
+                - offsets.size() > 0
+                - The neighbors of node i are targets[offsets[i]] through
+                  targets[offsets[i+1]-1].  If j is a neighbor of i then i is a neighbor
+                  of j.
+            ensures
+                - #color_classes is a partition of the nodes of the graph such that no two
+                  nodes in the same class are connected by an edge (self loops aside).
+        !*/
+        {
+            const unsigned long n = offsets.size()-1;
+            const unsigned long not_colored = std::numeric_limits<unsigned long>::max();
+            std::vector<unsigned long> color(n, not_colored);
+            std::vector<unsigned long> forbidden;
+            color_classes.clear();
+            for (unsigned long i = 0; i < n; ++i)
+            {
+                // mark the colors of all our neighbors as forbidden
+                for (unsigned long j = offsets[i]; j != offsets[i+1]; ++j)
+                {
+                    const unsigned long c = color[targets[j]];
+                    if (c != not_colored)
+                        forbidden[c] = i;
+                }
+
+                unsigned long c = 0;
+                while (c < forbidden.size() && forbidden[c] == i)
+                    ++c;
+                if (c == forbidden.size())
+                {
+                    forbidden.push_back(not_colored);
+                    color_classes.resize(c+1);
+                }
+                color[i] = c;
+                color_classes[c].push_back(i);
+            }
+        }
+
+        inline void color_graph_greedily (
+            const std::vector<ordered_sample_pair>& edges,
+            const std::vector<std::pair<unsigned long, unsigned long> >& neighbors,
+            std::vector<std::vector<unsigned long> >& color_classes
+        )
+        /*!
+            ensures
+                - #color_classes is a partition of the nodes of the graph such that no two
+                  nodes in the same class are connected by an edge (self loops aside).
+                - Since edges is a directed graph we also have to make sure that nodes
+                  which only point to each other in one direction get different colors.
+                  So we color the symmetrized graph.
+        !*/
+        {
+            const unsigned long n = neighbors.size();
+
+            // Build adjacency lists that contain both directions of each edge.
+            std::vector<unsigned long> offsets(n+1, 0);
+            for (unsigned long i = 0; i < edges.size(); ++i)
+            {
+                ++offsets[edges[i].index1()+1];
+                ++offsets[edges[i].index2()+1];
+            }
+            for (unsigned long i = 0; i < n; ++i)
+                offsets[i+1] += offsets[i];
+            std::vector<unsigned long> targets(offsets.back());
+            std::vector<unsigned long> pos(offsets.begin(), offsets.end()-1);
+            for (unsigned long i = 0; i < edges.size(); ++i)
+            {
+                targets[pos[edges[i].index1()]++] = edges[i].index2();
+                targets[pos[edges[i].index2()]++] = edges[i].index1();
+            }
+
+            color_symmetric_graph_greedily(offsets, targets, color_classes);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    inline unsigned long chinese_whispers_threaded (
+        const std::vector<ordered_sample_pair>& edges,
+        std::vector<unsigned long>& labels,
+        const unsigned long max_iterations,
+        const unsigned long num_threads,
+        const chinese_whispers_mode mode = chinese_whispers_asynchronous
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(is_ordered_by_index(edges) && num_threads > 0,
+                    "\t unsigned long chinese_whispers_threaded()"
+                    << "\n\t Invalid inputs were given to this function"
+                    << "\n\t num_threads: " << num_threads
+        );
+
+        labels.clear();
+        if (edges.size() == 0)
+            return 0;
+
+        std::vector<std::pair<unsigned long, unsigned long> > neighbors;
+        find_neighbor_ranges(edges, neighbors);
+
+        // Initialize the labels, each node gets a different label.
+        labels.resize(neighbors.size());
+        for (unsigned long i = 0; i < labels.size(); ++i)
+            labels[i] = i;
+
+        impl::chinese_whispers_threaded_helper helper(edges, neighbors, num_threads);
+
+        if (mode == chinese_whispers_synchronous)
+        {
+            // Every node computes its new label from the labels of the previous
+            // iteration.  Purely synchronous label propagation can oscillate forever
+            // (e.g. two connected nodes swapping labels each iteration) so each node only
+            // adopts its new label with probability 1/2.  The coin flips are a hash of
+            // the node index and iteration so the results don't depend on the number of
+            // threads.
+            std::vector<unsigned long> new_labels(labels.size());
+            for (unsigned long iter = 0; iter < max_iterations; ++iter)
+            {
+                const unsigned long changed = helper.update(0, labels, new_labels, iter+1);
+                labels.swap(new_labels);
+                if (changed == 0)
+                    break;
+            }
+        }
+        else
+        {
+            // Nodes of the same color don't have any edges between them so they can all
+            // be updated in place at the same time.  This gives the same result as
+            // visiting the nodes one at a time in order of color.
+            std::vector<std::vector<unsigned long> > color_classes;
+            impl::color_graph_greedily(edges, neighbors, color_classes);
+            for (unsigned long iter = 0; iter < max_iterations; ++iter)
+            {
+                unsigned long changed = 0;
+                for (unsigned long c = 0; c < color_classes.size(); ++c)
+                    changed += helper.update(&color_classes[c], labels, labels);
+                if (changed == 0)
+                    break;
+            }
+        }
+
+        return impl::remap_labels_to_contiguous_range(labels);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    inline unsigned long chinese_whispers_threaded (
+        const std::vector<sample_pair>& edges,
+        std::vector<unsigned long>& labels,
+        const unsigned long max_iterations,
+        const unsigned long num_threads,
+        const chinese_whispers_mode mode = chinese_whispers_asynchronous
+    )
+    {
+        std::vector<ordered_sample_pair> oedges;
+        convert_unordered_to_ordered(edges, oedges);
+        std::sort(oedges.begin(), oedges.end(), &order_by_index<ordered_sample_pair>);
+
+        return chinese_whispers_threaded(oedges, labels, max_iterations, num_threads, mode);
+    }
+
 // ----------------------------------------------------------------------------------------
 
 }
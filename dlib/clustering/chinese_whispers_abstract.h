@@ -89,6 +89,75 @@ namespace dlib
               where rnd is a default initialized dlib::rand object.
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    enum chinese_whispers_mode
+    {
+        chinese_whispers_asynchronous,
+        chinese_whispers_synchronous
+    };
+
+    unsigned long chinese_whispers_threaded (
+        const std::vector<ordered_sample_pair>& edges,
+        std::vector<unsigned long>& labels,
+        const unsigned long max_iterations,
+        const unsigned long num_threads,
+        const chinese_whispers_mode mode = chinese_whispers_asynchronous
+    );
+    /*!
+        requires
+            - is_ordered_by_index(edges) == true
+            - num_threads > 0
+        ensures
+            - This function is a multi-threaded version of chinese_whispers().  It
+              interprets edges in the same way and has the same outputs.  That is:
+                - returns the number of clusters found.
+                - #labels.size() == max_index_plus_one(edges)
+                - for all valid i:
+                    - #labels[i] == the cluster ID of the node with index i in the graph.  
+                    - 0 <= #labels[i] < the number of clusters found
+            - The difference is in the order the node labels are updated:
+                - if (mode == chinese_whispers_asynchronous) then
+                    - The graph is colored so that no two connected nodes have the same
+                      color.  Then each iteration updates all the nodes of one color in
+                      parallel, then all the nodes of the next color, and so on.  This is
+                      equivalent to updating the nodes one at a time as in
+                      chinese_whispers(), just in a fixed order rather than a random
+                      one.
+                - if (mode == chinese_whispers_synchronous) then
+                    - Each iteration computes the new label of every node in parallel
+                      from the labels of the previous iteration.  To prevent labels from
+                      oscillating, each node only adopts its new label in a given
+                      iteration with probability 1/2.  This mode has the most
+                      parallelism but usually needs more iterations to converge.
+            - Ties between labels are broken in favor of a node's current label and
+              then in favor of the smallest label.  The results are deterministic and
+              don't depend on num_threads.
+            - The algorithm stops when an iteration doesn't change any labels or after
+              max_iterations iterations, whichever comes first.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long chinese_whispers_threaded (
+        const std::vector<sample_pair>& edges,
+        std::vector<unsigned long>& labels,
+        const unsigned long max_iterations,
+        const unsigned long num_threads,
+        const chinese_whispers_mode mode = chinese_whispers_asynchronous
+    );
+    /*!
+        requires
+            - num_threads > 0
+        ensures
+            - This function is identical to the above chinese_whispers_threaded() routine
+              except that it operates on a vector of sample_pair objects instead of
+              ordered_sample_pairs.  Therefore, this is simply a convenience routine.  In
+              particular, it is implemented by transforming the given edges into
+              ordered_sample_pairs and then calling the chinese_whispers_threaded()
+              routine defined above.  
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
 }
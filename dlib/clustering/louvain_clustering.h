@@ -0,0 +1,456 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_LOUVAIN_ClUSTERING_H__
+#define DLIB_LOUVAIN_ClUSTERING_H__
+
+#include "louvain_clustering_abstract.h"
+#include <vector>
+#include <algorithm>
+#include "../graph_utils/edge_list_graphs.h"
+#include "../threads.h"
+#include "chinese_whispers.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        struct louvain_graph
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is a weighted undirected graph in compressed sparse row form.  The
+                    neighbors of node i are targets[offsets[i]] through
+                    targets[offsets[i+1]-1] and the corresponding edge weights are in
+                    weights.  Each edge between two different nodes is stored once in the
+                    lists of both nodes and a self loop is stored once in the list of its
+                    node.  This is the same convention as a vector of ordered_sample_pair
+                    objects has when it is given to modularity().
+
+                    degrees[i] is the sum of the weights in the list of node i and
+                    total_weight is the sum of all the degrees.
+            !*/
+
+            unsigned long size() const { return offsets.size()-1; }
+
+            std::vector<unsigned long> offsets;
+            std::vector<unsigned long> targets;
+            std::vector<double> weights;
+            std::vector<double> degrees;
+            double total_weight;
+        };
+
+        inline void make_louvain_graph (
+            const std::vector<ordered_sample_pair>& edges,
+            const unsigned long num_nodes,
+            louvain_graph& g
+        )
+        /*!
+            requires
+                - is_ordered_by_index(edges) == true
+                - num_nodes >= max_index_plus_one(edges)
+            ensures
+                - #g == the graph defined by edges.  Duplicate edges are merged into one
+                  edge whose weight is the sum of the duplicates' weights.
+        !*/
+        {
+            g.offsets.assign(num_nodes+1, 0);
+            g.targets.clear();
+            g.weights.clear();
+            g.targets.reserve(edges.size());
+            g.weights.reserve(edges.size());
+            g.degrees.assign(num_nodes, 0);
+            g.total_weight = 0;
+            for (unsigned long i = 0; i < edges.size(); ++i)
+            {
+                const unsigned long n1 = edges[i].index1();
+                const unsigned long n2 = edges[i].index2();
+                const double w = edges[i].distance();
+                if (i > 0 && edges[i-1].index1() == n1 && edges[i-1].index2() == n2)
+                {
+                    g.weights.back() += w;
+                }
+                else
+                {
+                    g.targets.push_back(n2);
+                    g.weights.push_back(w);
+                    ++g.offsets[n1+1];
+                }
+                g.degrees[n1] += w;
+                g.total_weight += w;
+            }
+            for (unsigned long i = 0; i < num_nodes; ++i)
+                g.offsets[i+1] += g.offsets[i];
+        }
+
+        inline void aggregate_louvain_graph (
+            const louvain_graph& g,
+            const std::vector<unsigned long>& labels,
+            const unsigned long num_labels,
+            louvain_graph& out
+        )
+        /*!
+            requires
+                - labels.size() == g.size()
+                - all the labels are < num_labels
+            ensures
+                - #out is the graph obtained by merging all the nodes of g with the same
+                  label into one node.  That is, #out.size() == num_labels and the weight
+                  of the edge between nodes A and B of #out is the total weight of the
+                  edges between the nodes labeled A and the nodes labeled B.  The edges
+                  inside a cluster become a self loop.  This doesn't change the modularity
+                  of the clustering.
+        !*/
+        {
+            // Sort the nodes by label.
+            std::vector<unsigned long> start(num_labels+1, 0);
+            for (unsigned long i = 0; i < labels.size(); ++i)
+                ++start[labels[i]+1];
+            for (unsigned long i = 0; i < num_labels; ++i)
+                start[i+1] += start[i];
+            std::vector<unsigned long> members(labels.size());
+            std::vector<unsigned long> pos(start.begin(), start.end()-1);
+            for (unsigned long i = 0; i < labels.size(); ++i)
+                members[pos[labels[i]]++] = i;
+
+            out.offsets.assign(num_labels+1, 0);
+            out.targets.clear();
+            out.weights.clear();
+            out.degrees.assign(num_labels, 0);
+            out.total_weight = g.total_weight;
+
+            // Sum up the edges from each cluster to its neighboring clusters.
+            std::vector<double> sums(num_labels, 0);
+            std::vector<unsigned long> touched;
+            for (unsigned long c = 0; c < num_labels; ++c)
+            {
+                touched.clear();
+                for (unsigned long m = start[c]; m < start[c+1]; ++m)
+                {
+                    const unsigned long i = members[m];
+                    out.degrees[c] += g.degrees[i];
+                    for (unsigned long e = g.offsets[i]; e < g.offsets[i+1]; ++e)
+                    {
+                        const unsigned long l = labels[g.targets[e]];
+                        if (sums[l] == 0)
+                            touched.push_back(l);
+                        sums[l] += g.weights[e];
+                    }
+                }
+
+                std::sort(touched.begin(), touched.end());
+                for (unsigned long k = 0; k < touched.size(); ++k)
+                {
+                    // An edge with weight 0 doesn't do anything so we can drop it.
+                    if (sums[touched[k]] != 0)
+                    {
+                        out.targets.push_back(touched[k]);
+                        out.weights.push_back(sums[touched[k]]);
+                    }
+                    sums[touched[k]] = 0;
+                }
+                out.offsets[c+1] = out.targets.size();
+            }
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        class louvain_local_mover
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This object performs the local moving phase of the Louvain method.
+                    That is, it repeatedly moves single nodes into the neighboring cluster
+                    which gives the biggest increase in modularity.
+
+                    To do this in parallel we color the graph and then move all the nodes
+                    of one color class at a time.  Since these nodes aren't connected to
+                    each other, moving one of them doesn't change the edge weights between
+                    the others and each cluster.  It only changes the total degrees of the
+                    clusters.  So we find the best move of every node in a color class in
+                    parallel from the current cluster degrees.  Then we go over the nodes
+                    in order and recompute the gain of each move from the cluster degrees
+                    as they are at that point.  A move is only made if it still increases
+                    the modularity.  This doesn't depend on the number of threads so the
+                    results are always the same.
+            !*/
+        public:
+            louvain_local_mover (
+                const unsigned long num_threads_
+            ) :
+                num_threads(num_threads_),
+                num_workers(num_threads_*4),
+                g(0),
+                labels(0),
+                nodes(0),
+                tp(num_threads_ > 1 ? num_threads_ : 0)
+            {
+                buffers.resize(num_workers);
+                bounds.resize(num_workers+1);
+            }
+
+            double move_nodes (
+                const louvain_graph& graph,
+                std::vector<unsigned long>& labels_,
+                const double eps,
+                const unsigned long max_iterations
+            )
+            /*!
+                requires
+                    - labels_.size() == graph.size()
+                    - all the labels are < graph.size()
+                    - graph.total_weight > 0
+                ensures
+                    - Moves nodes between the clusters defined by labels_ until a pass over
+                      all the nodes improves the modularity by less than eps or
+                      max_iterations passes have been made.
+                    - returns the total increase in modularity.
+            !*/
+            {
+                g = &graph;
+                labels = &labels_;
+                const unsigned long n = g->size();
+                cluster_degrees.assign(n, 0);
+                for (unsigned long i = 0; i < n; ++i)
+                    cluster_degrees[labels_[i]] += g->degrees[i];
+                best_moves.resize(n);
+                own_weights.resize(n);
+                best_weights.resize(n);
+
+                color_symmetric_graph_greedily(g->offsets, g->targets, color_classes);
+
+                double total_gain = 0;
+                for (unsigned long iter = 0; iter < max_iterations; ++iter)
+                {
+                    double gain = 0;
+                    for (unsigned long c = 0; c < color_classes.size(); ++c)
+                    {
+                        nodes = &color_classes[c];
+                        find_best_moves();
+
+                        const double m = g->total_weight;
+                        for (unsigned long k = 0; k < nodes->size(); ++k)
+                        {
+                            const unsigned long i = (*nodes)[k];
+                            const unsigned long own = labels_[i];
+                            const unsigned long l = best_moves[i];
+                            if (l == own)
+                                continue;
+
+                            // The moves made before this one may have changed the cluster
+                            // degrees so check that the move still helps.
+                            const double deg = g->degrees[i];
+                            const double own_score = own_weights[i] - deg*(cluster_degrees[own]-deg)/m;
+                            const double score = best_weights[i] - deg*cluster_degrees[l]/m;
+                            if (score > own_score)
+                            {
+                                cluster_degrees[own] -= deg;
+                                cluster_degrees[l] += deg;
+                                labels_[i] = l;
+                                gain += 2*(score - own_score)/m;
+                            }
+                        }
+                    }
+
+                    total_gain += gain;
+                    if (gain < eps)
+                        break;
+                }
+                return total_gain;
+            }
+
+            void do_worker (
+                long w
+            )
+            {
+                std::vector<std::pair<unsigned long,double> >& buf = buffers[w];
+                const double m = g->total_weight;
+                for (unsigned long k = bounds[w]; k < bounds[w+1]; ++k)
+                {
+                    const unsigned long i = (*nodes)[k];
+                    const unsigned long own = (*labels)[i];
+                    const double deg = g->degrees[i];
+
+                    // Find the total weight of the edges from node i to each neighboring
+                    // cluster.
+                    buf.clear();
+                    for (unsigned long e = g->offsets[i]; e < g->offsets[i+1]; ++e)
+                    {
+                        if (g->targets[e] != i)
+                            buf.push_back(std::make_pair((*labels)[g->targets[e]], g->weights[e]));
+                    }
+                    std::sort(buf.begin(), buf.end());
+
+                    // The change in modularity from moving node i out of its cluster and
+                    // into cluster c is proportional to score(c) - score(own).
+                    double own_weight = 0;
+                    for (unsigned long j = 0; j < buf.size() && buf[j].first <= own; ++j)
+                    {
+                        if (buf[j].first == own)
+                            own_weight += buf[j].second;
+                    }
+                    const double own_score = own_weight - deg*(cluster_degrees[own]-deg)/m;
+
+                    unsigned long best = own;
+                    double best_score = own_score;
+                    double best_weight = own_weight;
+                    for (unsigned long j = 0; j < buf.size(); )
+                    {
+                        const unsigned long c = buf[j].first;
+                        double weight = 0;
+                        for (; j < buf.size() && buf[j].first == c; ++j)
+                            weight += buf[j].second;
+                        if (c == own)
+                            continue;
+
+                        // Ties go to the node's current cluster and then to the smallest
+                        // cluster ID, which is the first one we see.
+                        const double score = weight - deg*cluster_degrees[c]/m;
+                        if (score > best_score)
+                        {
+                            best = c;
+                            best_score = score;
+                            best_weight = weight;
+                        }
+                    }
+
+                    best_moves[i] = best;
+                    own_weights[i] = own_weight;
+                    best_weights[i] = best_weight;
+                }
+            }
+
+            unsigned long work_size (unsigned long k) const { return degree((*nodes)[k]) + 1; }
+
+        private:
+
+            void find_best_moves (
+            )
+            {
+                run_balanced_workers(tp, num_threads, nodes->size(), bounds, *this);
+            }
+
+            unsigned long degree (unsigned long i) const { return g->offsets[i+1] - g->offsets[i]; }
+
+            const unsigned long num_threads;
+            const unsigned long num_workers;
+
+            const louvain_graph* g;
+            std::vector<unsigned long>* labels;
+            const std::vector<unsigned long>* nodes;
+
+            std::vector<std::vector<unsigned long> > color_classes;
+            std::vector<double> cluster_degrees;
+            std::vector<unsigned long> best_moves;
+            std::vector<double> own_weights;
+            std::vector<double> best_weights;
+            std::vector<std::vector<std::pair<unsigned long,double> > > buffers;
+            std::vector<unsigned long> bounds;
+
+            thread_pool tp;
+        };
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    inline unsigned long louvain_cluster (
+        const std::vector<ordered_sample_pair>& edges,
+        std::vector<unsigned long>& labels,
+        const unsigned long num_threads = 1,
+        const double eps = 1e-6,
+        const unsigned long max_iterations = 100
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(is_ordered_by_index(edges) && num_threads > 0,
+                    "\t unsigned long louvain_cluster()"
+                    << "\n\t Invalid inputs were given to this function"
+                    << "\n\t is_ordered_by_index(edges): " << is_ordered_by_index(edges)
+                    << "\n\t num_threads: " << num_threads
+        );
+
+        labels.clear();
+        if (edges.size() == 0)
+            return 0;
+
+        const unsigned long num_nodes = max_index_plus_one(edges);
+        std::vector<impl::louvain_graph> graphs(1);
+        impl::make_louvain_graph(edges, num_nodes, graphs[0]);
+
+        labels.resize(num_nodes);
+        for (unsigned long i = 0; i < labels.size(); ++i)
+            labels[i] = i;
+        if (!(graphs[0].total_weight > 0))
+            return num_nodes;
+
+        impl::louvain_local_mover mover(num_threads);
+
+        // Phase 1: Starting with every node in its own cluster, move the nodes around
+        // until the modularity stops improving, then merge each cluster into a single node
+        // and repeat on the resulting smaller graph.  levels[i] maps the nodes of
+        // graphs[i] to the nodes of graphs[i+1].
+        std::vector<std::vector<unsigned long> > levels;
+        std::vector<unsigned long> level_labels;
+        while (true)
+        {
+            const impl::louvain_graph& g = graphs.back();
+            level_labels.resize(g.size());
+            for (unsigned long i = 0; i < level_labels.size(); ++i)
+                level_labels[i] = i;
+
+            mover.move_nodes(g, level_labels, eps, max_iterations);
+            const unsigned long num_labels = impl::remap_labels_to_contiguous_range(level_labels);
+            if (num_labels == g.size())
+                break;
+
+            levels.push_back(level_labels);
+            graphs.push_back(impl::louvain_graph());
+            impl::aggregate_louvain_graph(graphs[graphs.size()-2], level_labels, num_labels, graphs.back());
+        }
+
+        // Phase 2: Refine the clustering by going back down the levels and letting the
+        // nodes of each level move between the final clusters.  This is the multilevel
+        // refinement from the paper Multilevel local search algorithms for modularity
+        // clustering by Rotta and Noack.  The mover only makes moves that increase the
+        // modularity so this never makes the clustering worse.
+        std::vector<unsigned long> clusters(graphs.back().size());
+        for (unsigned long i = 0; i < clusters.size(); ++i)
+            clusters[i] = i;
+        for (long l = (long)levels.size()-1; l >= 0; --l)
+        {
+            level_labels.resize(levels[l].size());
+            for (unsigned long i = 0; i < level_labels.size(); ++i)
+                level_labels[i] = clusters[levels[l][i]];
+            mover.move_nodes(graphs[l], level_labels, eps, max_iterations);
+            clusters.swap(level_labels);
+        }
+
+        labels.swap(clusters);
+        return impl::remap_labels_to_contiguous_range(labels);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    inline unsigned long louvain_cluster (
+        const std::vector<sample_pair>& edges,
+        std::vector<unsigned long>& labels,
+        const unsigned long num_threads = 1,
+        const double eps = 1e-6,
+        const unsigned long max_iterations = 100
+    )
+    {
+        std::vector<ordered_sample_pair> oedges;
+        convert_unordered_to_ordered(edges, oedges);
+        std::sort(oedges.begin(), oedges.end(), &order_by_index<ordered_sample_pair>);
+
+        return louvain_cluster(oedges, labels, num_threads, eps, max_iterations);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_LOUVAIN_ClUSTERING_H__
+
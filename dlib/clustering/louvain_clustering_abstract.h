@@ -0,0 +1,89 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_LOUVAIN_ClUSTERING_ABSTRACT_H__
+#ifdef DLIB_LOUVAIN_ClUSTERING_ABSTRACT_H__
+
+#include <vector>
+#include "../graph_utils/ordered_sample_pair_abstract.h"
+#include "../graph_utils/sample_pair_abstract.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long louvain_cluster (
+        const std::vector<ordered_sample_pair>& edges,
+        std::vector<unsigned long>& labels,
+        const unsigned long num_threads = 1,
+        const double eps = 1e-6,
+        const unsigned long max_iterations = 100
+    );
+    /*!
+        requires
+            - is_ordered_by_index(edges) == true
+            - num_threads > 0
+            - for all valid i:
+                - 0 <= edges[i].distance() < std::numeric_limits<double>::infinity()
+        ensures
+            - This function interprets edges as a graph and attempts to find the labeling
+              that maximizes modularity(edges, #labels).  It does this using the
+              multilevel method from the paper Fast unfolding of communities in large
+              networks by Blondel et al. (a.k.a. the Louvain method).  That is:
+                - Each node starts in its own cluster.  Then single nodes are moved to the
+                  neighboring cluster which increases the modularity the most until no
+                  move helps.
+                - Each cluster is then merged into a single node and the process is
+                  repeated on the resulting smaller graph until no clusters are merged.
+                - Finally, the clustering is refined by going back down through the
+                  levels of merged graphs and letting the nodes of each level move between
+                  the final clusters.
+            - Unlike newman_cluster(), which needs O(N^2) time, this function only needs
+              time roughly proportional to edges.size().  So it is appropriate for large
+              sparse graphs.  Moreover, the graph is kept in a compact compressed sparse
+              row form so the memory used is also proportional to edges.size().
+            - The node moving is done using num_threads threads.  The result does not
+              depend on num_threads.  That is, you always get the same labels for the same
+              edges.
+            - Each round of node moves stops when a pass over all the nodes increases the
+              modularity by less than eps or after max_iterations passes, whichever comes
+              first.
+            - returns the number of clusters found.
+            - #labels.size() == max_index_plus_one(edges)
+            - for all valid i:
+                - #labels[i] == the cluster ID of the node with index i in the graph.
+                - 0 <= #labels[i] < the number of clusters found
+                  (i.e. cluster IDs are assigned contiguously and start at 0)
+            - Nodes without any edges (or with only edges of weight 0) are each put into
+              their own cluster.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long louvain_cluster (
+        const std::vector<sample_pair>& edges,
+        std::vector<unsigned long>& labels,
+        const unsigned long num_threads = 1,
+        const double eps = 1e-6,
+        const unsigned long max_iterations = 100
+    );
+    /*!
+        requires
+            - num_threads > 0
+            - for all valid i:
+                - 0 <= edges[i].distance() < std::numeric_limits<double>::infinity()
+        ensures
+            - This function is identical to the above louvain_cluster() routine except
+              that it operates on a vector of sample_pair objects instead of
+              ordered_sample_pairs.  Therefore, this is simply a convenience routine.  In
+              particular, it is implemented by transforming the given edges into
+              ordered_sample_pairs and then calling the louvain_cluster() routine defined
+              above.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_LOUVAIN_ClUSTERING_ABSTRACT_H__
+
@@ -8,6 +8,7 @@
 
 #ifndef DLIB_ISO_CPP_ONLY
 #include "data_io/load_image_dataset.h"
+#include "data_io/sample_shard_stream.h"
 #endif
 
 #endif // DLIB_DATA_Io_HEADER
@@ -0,0 +1,411 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_SAMPLE_SHARD_STREAm_H__
+#define DLIB_SAMPLE_SHARD_STREAm_H__
+
+#include "sample_shard_stream_abstract.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "../algs.h"
+#include "../serialize.h"
+#include "../rand.h"
+#include "../string.h"
+#include "../threads.h"
+#include "libsvm_io.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename sample_type, typename label_type, typename alloc1, typename alloc2>
+    void save_sample_shard (
+        const std::string& file_name,
+        const std::vector<sample_type, alloc1>& samples,
+        const std::vector<label_type, alloc2>& labels
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(samples.size() == labels.size(),
+            "\t void save_sample_shard()"
+            << "\n\t You have to have labels for each sample and vice versa"
+            << "\n\t samples.size(): " << samples.size()
+            << "\n\t labels.size():  " << labels.size()
+            );
+
+        std::ofstream fout(file_name.c_str(), std::ios::binary);
+        if (!fout)
+            throw sample_data_io_error("Unable to open file " + file_name);
+
+        int version = 1;
+        serialize(version, fout);
+        serialize(samples, fout);
+        serialize(labels, fout);
+
+        if (!fout)
+            throw sample_data_io_error("Error while writing to file " + file_name);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename sample_type, typename label_type, typename alloc1, typename alloc2>
+    void load_sample_shard (
+        const std::string& file_name,
+        std::vector<sample_type, alloc1>& samples,
+        std::vector<label_type, alloc2>& labels
+    )
+    {
+        std::ifstream fin(file_name.c_str(), std::ios::binary);
+        if (!fin)
+            throw sample_data_io_error("Unable to open file " + file_name);
+
+        try
+        {
+            int version = 0;
+            deserialize(version, fin);
+            if (version != 1)
+                throw sample_data_io_error("Unexpected version found while loading shard " + file_name);
+
+            deserialize(samples, fin);
+            deserialize(labels, fin);
+        }
+        catch (serialization_error& e)
+        {
+            throw sample_data_io_error("Error while reading shard " + file_name + ": " + e.info);
+        }
+
+        if (samples.size() != labels.size())
+            throw sample_data_io_error("Mismatched number of samples and labels in shard " + file_name);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    struct binary_shard_loader
+    {
+        template <typename sample_type, typename label_type>
+        void operator() (
+            const std::string& file_name,
+            std::vector<sample_type>& samples,
+            std::vector<label_type>& labels
+        ) const { load_sample_shard(file_name, samples, labels); }
+    };
+
+    struct libsvm_shard_loader
+    {
+        template <typename sample_type, typename label_type>
+        void operator() (
+            const std::string& file_name,
+            std::vector<sample_type>& samples,
+            std::vector<label_type>& labels
+        ) const { load_libsvm_formatted_data(file_name, samples, labels); }
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename sample_type_,
+        typename label_type_ = double,
+        typename shard_loader_type = binary_shard_loader
+        >
+    class sample_shard_stream : noncopyable
+    {
+    public:
+        typedef sample_type_ sample_type;
+        typedef label_type_ label_type;
+
+        sample_shard_stream (
+            const std::vector<std::string>& shard_files_,
+            const shard_loader_type& loader_ = shard_loader_type()
+        ) :
+            shard_files(shard_files_),
+            loader(loader_),
+            shuffle(true),
+            pass(0),
+            shards_done(0),
+            cur_pos(0),
+            pending_shard(0),
+            prefetching(false),
+            tp(1)
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(shard_files_.size() > 0,
+                "\t sample_shard_stream::sample_shard_stream()"
+                << "\n\t You must give at least one shard file."
+                << "\n\t this: " << this
+                );
+
+            start_pass(0);
+        }
+
+        ~sample_shard_stream (
+        )
+        {
+            tp.wait_for_all_tasks();
+        }
+
+        unsigned long number_of_shards (
+        ) const { return shard_files.size(); }
+
+        void set_seed (
+            const std::string& value
+        )
+        {
+            tp.wait_for_all_tasks();
+            seed = value;
+            start_pass(pass, shards_done);
+        }
+
+        const std::string& get_seed (
+        ) const { return seed; }
+
+        void be_shuffled (
+        )
+        {
+            tp.wait_for_all_tasks();
+            shuffle = true;
+            start_pass(pass, shards_done);
+        }
+
+        void be_ordered (
+        )
+        {
+            tp.wait_for_all_tasks();
+            shuffle = false;
+            start_pass(pass, shards_done);
+        }
+
+        bool is_shuffled (
+        ) const { return shuffle; }
+
+        void start_pass (
+            unsigned long pass_,
+            unsigned long first_shard = 0
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(first_shard <= number_of_shards(),
+                "\t void sample_shard_stream::start_pass()"
+                << "\n\t Invalid arguments were given to this function."
+                << "\n\t first_shard:        " << first_shard
+                << "\n\t number_of_shards(): " << number_of_shards()
+                << "\n\t this: " << this
+                );
+
+            // Wait for any outstanding prefetch to finish since we are going to throw it
+            // away.
+            tp.wait_for_all_tasks();
+            prefetching = false;
+
+            pass = pass_;
+            shards_done = first_shard;
+            cur_samples.clear();
+            cur_labels.clear();
+            cur_pos = 0;
+
+            // Pick the order in which the shards are visited during this pass.  It only
+            // depends on the seed and pass number so a pass can be restarted from any
+            // shard and still visit the same data.
+            shard_order.resize(shard_files.size());
+            for (unsigned long i = 0; i < shard_order.size(); ++i)
+                shard_order[i] = i;
+            if (shuffle)
+            {
+                dlib::rand rnd;
+                rnd.set_seed(seed + "pass " + cast_to_string(pass));
+                random_permutation(rnd, shard_order);
+            }
+
+            start_prefetch(shards_done);
+        }
+
+        unsigned long get_pass (
+        ) const { return pass; }
+
+        unsigned long shards_completed (
+        ) const { return shards_done; }
+
+        bool end_of_pass (
+        ) const { return shards_done == shard_files.size(); }
+
+        template <typename alloc1, typename alloc2>
+        bool next_minibatch (
+            std::vector<sample_type,alloc1>& samples,
+            std::vector<label_type,alloc2>& labels,
+            unsigned long max_batch_size
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(max_batch_size > 0,
+                "\t bool sample_shard_stream::next_minibatch()"
+                << "\n\t max_batch_size must be greater than 0"
+                << "\n\t this: " << this
+                );
+
+            samples.clear();
+            labels.clear();
+
+            // move to the next shard with anything in it
+            while (cur_pos == cur_samples.size())
+            {
+                if (!prefetching)
+                    return false;
+                swap_in_prefetched_shard();
+            }
+
+            const unsigned long num = std::min<unsigned long>(max_batch_size, cur_samples.size()-cur_pos);
+            samples.reserve(num);
+            labels.reserve(num);
+            for (unsigned long i = 0; i < num; ++i)
+            {
+                samples.push_back(cur_samples[cur_pos]);
+                labels.push_back(cur_labels[cur_pos]);
+                ++cur_pos;
+            }
+
+            // When we hand out the last sample in a shard we release its memory and count
+            // it as completed.
+            if (cur_pos == cur_samples.size())
+            {
+                std::vector<sample_type>().swap(cur_samples);
+                std::vector<label_type>().swap(cur_labels);
+                cur_pos = 0;
+                ++shards_done;
+            }
+
+            return true;
+        }
+
+    private:
+
+        template <typename T>
+        static void random_permutation (
+            dlib::rand& rnd,
+            std::vector<T>& v
+        )
+        {
+            for (unsigned long i = v.size(); i > 1; --i)
+            {
+                const unsigned long j = rnd.get_random_32bit_number()%i;
+                exchange(v[i-1], v[j]);
+            }
+        }
+
+        void start_prefetch (
+            unsigned long idx
+        )
+        {
+            if (idx >= shard_files.size())
+                return;
+
+            pending_shard = idx;
+            pending_error.clear();
+            prefetching = true;
+            tp.add_task(*this, &sample_shard_stream::load_pending_shard);
+        }
+
+        void load_pending_shard (
+        )
+        {
+            // This function runs inside the thread pool so it must never let an exception
+            // escape.  Instead we save the message and rethrow it when the shard is
+            // requested by next_minibatch().
+            try
+            {
+                const std::string& file = shard_files[shard_order[pending_shard]];
+                pending_samples.clear();
+                pending_labels.clear();
+                loader(file, pending_samples, pending_labels);
+                if (pending_samples.size() != pending_labels.size())
+                    throw sample_data_io_error("Mismatched number of samples and labels in shard " + file);
+
+                if (shuffle && pending_samples.size() > 1)
+                {
+                    dlib::rand rnd;
+                    rnd.set_seed(seed + "pass " + cast_to_string(pass) + " shard " + cast_to_string(pending_shard));
+                    std::vector<unsigned long> idx(pending_samples.size());
+                    for (unsigned long i = 0; i < idx.size(); ++i)
+                        idx[i] = i;
+                    random_permutation(rnd, idx);
+
+                    std::vector<sample_type> samps(pending_samples.size());
+                    std::vector<label_type> labs(pending_labels.size());
+                    for (unsigned long i = 0; i < idx.size(); ++i)
+                    {
+                        exchange(samps[i], pending_samples[idx[i]]);
+                        labs[i] = pending_labels[idx[i]];
+                    }
+                    samps.swap(pending_samples);
+                    labs.swap(pending_labels);
+                }
+            }
+            catch (std::exception& e)
+            {
+                pending_error = e.what();
+                if (pending_error.size() == 0)
+                    pending_error = "Unknown error while loading shard.";
+            }
+        }
+
+        void swap_in_prefetched_shard (
+        )
+        {
+            tp.wait_for_all_tasks();
+            prefetching = false;
+
+            if (pending_error.size() != 0)
+            {
+                const std::string msg = pending_error;
+                pending_samples.clear();
+                pending_labels.clear();
+                // Start loading the same shard again.  That way the next call to
+                // next_minibatch() retries it rather than acting like the pass ended.
+                start_prefetch(pending_shard);
+                throw sample_data_io_error(msg);
+            }
+
+            cur_samples.swap(pending_samples);
+            cur_labels.swap(pending_labels);
+            std::vector<sample_type>().swap(pending_samples);
+            std::vector<label_type>().swap(pending_labels);
+            cur_pos = 0;
+
+            // Empty shards are completed as soon as they are loaded.
+            if (cur_samples.size() == 0)
+                ++shards_done;
+
+            // Start reading the shard after this one while the caller works on the
+            // current one.
+            start_prefetch(pending_shard+1);
+        }
+
+        std::vector<std::string> shard_files;
+        shard_loader_type loader;
+        std::string seed;
+        bool shuffle;
+
+        unsigned long pass;
+        unsigned long shards_done;
+        std::vector<unsigned long> shard_order;
+
+        std::vector<sample_type> cur_samples;
+        std::vector<label_type> cur_labels;
+        unsigned long cur_pos;
+
+        unsigned long pending_shard;
+        std::vector<sample_type> pending_samples;
+        std::vector<label_type> pending_labels;
+        std::string pending_error;
+        bool prefetching;
+
+        // This must be the last member so it is destroyed first.
+        thread_pool tp;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_SAMPLE_SHARD_STREAm_H__
+
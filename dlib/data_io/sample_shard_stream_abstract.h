@@ -0,0 +1,270 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_SAMPLE_SHARD_STREAm_ABSTRACT_H__
+#ifdef DLIB_SAMPLE_SHARD_STREAm_ABSTRACT_H__
+
+#include <string>
+#include <vector>
+#include "libsvm_io_abstract.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename sample_type, typename label_type, typename alloc1, typename alloc2>
+    void save_sample_shard (
+        const std::string& file_name,
+        const std::vector<sample_type, alloc1>& samples,
+        const std::vector<label_type, alloc2>& labels
+    );
+    /*!
+        requires
+            - samples.size() == labels.size()
+            - sample_type and label_type are serializable
+        ensures
+            - saves the data to the given file in a binary format which can be read back by
+              load_sample_shard().
+        throws
+            - sample_data_io_error
+                This exception is thrown if there is any problem saving data to file
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename sample_type, typename label_type, typename alloc1, typename alloc2>
+    void load_sample_shard (
+        const std::string& file_name,
+        std::vector<sample_type, alloc1>& samples,
+        std::vector<label_type, alloc2>& labels
+    );
+    /*!
+        requires
+            - sample_type and label_type are serializable
+        ensures
+            - loads the data saved in file_name by save_sample_shard() into samples and
+              labels.
+            - #samples.size() == #labels.size()
+        throws
+            - sample_data_io_error
+                This exception is thrown if there is any problem loading data from file
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    struct binary_shard_loader
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is a function object which loads a shard file created by
+                save_sample_shard().  That is, it just calls load_sample_shard().
+        !*/
+
+        template <typename sample_type, typename label_type>
+        void operator() (
+            const std::string& file_name,
+            std::vector<sample_type>& samples,
+            std::vector<label_type>& labels
+        ) const;
+    };
+
+    struct libsvm_shard_loader
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is a function object which loads a shard file in the LIBSVM format.
+                That is, it just calls load_libsvm_formatted_data().  Therefore, it can only
+                be used with sparse sample types.
+        !*/
+
+        template <typename sample_type, typename label_type>
+        void operator() (
+            const std::string& file_name,
+            std::vector<sample_type>& samples,
+            std::vector<label_type>& labels
+        ) const;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename sample_type_,
+        typename label_type_ = double,
+        typename shard_loader_type = binary_shard_loader
+        >
+    class sample_shard_stream : noncopyable
+    {
+        /*!
+            REQUIREMENTS ON shard_loader_type
+                shard_loader_type must be copyable and have a const member function with
+                the same signature as binary_shard_loader::operator().  It must load one
+                shard file into a pair of sample and label vectors and report errors by
+                throwing an exception derived from std::exception.
+
+            WHAT THIS OBJECT REPRESENTS
+                This object streams a dataset which is too big to fit into RAM from disk.
+                The dataset is split into a set of shard files, each of which is small
+                enough to be loaded into memory.  The shards are read in the background
+                by a separate thread so that the next shard is loaded while the user is
+                working on the current one.  Therefore, at most two shards are in memory
+                at any one time.
+
+                The data is visited in passes.  Each pass visits every shard once and
+                every sample in a shard once.  If shuffling is enabled (the default) then
+                the order of the shards and the order of the samples within each shard
+                are randomly permuted.  The permutations only depend on the seed, the pass
+                number, and the shard's position in the pass.  So a pass can be restarted
+                at any shard boundary and it will produce exactly the same samples as the
+                original pass did.  This is what makes it possible to checkpoint training
+                (see train_from_sample_stream() in dlib/svm/pegasos_abstract.h).
+        !*/
+    public:
+        typedef sample_type_ sample_type;
+        typedef label_type_ label_type;
+
+        sample_shard_stream (
+            const std::vector<std::string>& shard_files,
+            const shard_loader_type& loader = shard_loader_type()
+        );
+        /*!
+            requires
+                - shard_files.size() > 0
+            ensures
+                - #number_of_shards() == shard_files.size()
+                - #get_seed() == ""
+                - #is_shuffled() == true
+                - #get_pass() == 0
+                - #shards_completed() == 0
+                - begins loading the first shard of pass 0 in the background.
+        !*/
+
+        ~sample_shard_stream (
+        );
+        /*!
+            ensures
+                - blocks until any background loading has finished and then destroys this
+                  object.
+        !*/
+
+        unsigned long number_of_shards (
+        ) const;
+        /*!
+            ensures
+                - returns the number of shard files this object streams from.
+        !*/
+
+        void set_seed (
+            const std::string& value
+        );
+        /*!
+            ensures
+                - #get_seed() == value
+                - restarts the current pass at the beginning of shard #shards_completed().
+        !*/
+
+        const std::string& get_seed (
+        ) const;
+        /*!
+            ensures
+                - returns the string used to seed the random number generators which
+                  shuffle the data.
+        !*/
+
+        void be_shuffled (
+        );
+        /*!
+            ensures
+                - #is_shuffled() == true
+                - restarts the current pass at the beginning of shard #shards_completed().
+        !*/
+
+        void be_ordered (
+        );
+        /*!
+            ensures
+                - #is_shuffled() == false
+                - restarts the current pass at the beginning of shard #shards_completed().
+        !*/
+
+        bool is_shuffled (
+        ) const;
+        /*!
+            ensures
+                - returns true if the shards and the samples inside them are visited in a
+                  random order.  Otherwise they are visited in the order they appear in
+                  the shard files.
+        !*/
+
+        void start_pass (
+            unsigned long pass,
+            unsigned long first_shard = 0
+        );
+        /*!
+            requires
+                - first_shard <= number_of_shards()
+            ensures
+                - #get_pass() == pass
+                - #shards_completed() == first_shard
+                - Starts streaming the given pass at the beginning of its first_shard-th
+                  shard.  Any data which has been loaded but not yet returned by
+                  next_minibatch() is discarded.
+        !*/
+
+        unsigned long get_pass (
+        ) const;
+        /*!
+            ensures
+                - returns the number of the pass currently being streamed.
+        !*/
+
+        unsigned long shards_completed (
+        ) const;
+        /*!
+            ensures
+                - returns the number of shards from the current pass whose samples have
+                  all been output by next_minibatch().
+        !*/
+
+        bool end_of_pass (
+        ) const;
+        /*!
+            ensures
+                - returns shards_completed() == number_of_shards()
+        !*/
+
+        template <typename alloc1, typename alloc2>
+        bool next_minibatch (
+            std::vector<sample_type,alloc1>& samples,
+            std::vector<label_type,alloc2>& labels,
+            unsigned long max_batch_size
+        );
+        /*!
+            requires
+                - max_batch_size > 0
+            ensures
+                - if (there are samples left in the current pass) then
+                    - #samples and #labels contain the next samples in the pass.
+                    - 0 < #samples.size() <= max_batch_size
+                    - #samples.size() == #labels.size()
+                    - A minibatch never contains samples from more than one shard.
+                    - returns true
+                - else
+                    - #samples.size() == 0
+                    - #labels.size() == 0
+                    - returns false.  You must call start_pass() to begin another pass.
+            throws
+                - sample_data_io_error
+                    This exception is thrown if a shard can't be loaded.  If this happens
+                    shards_completed() doesn't change and the next call to
+                    next_minibatch() tries to load the same shard again.  So it either
+                    continues the pass from that shard or throws again.
+        !*/
+
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_SAMPLE_SHARD_STREAm_ABSTRACT_H__
+
@@ -6,6 +6,7 @@
 #include "find_max_factor_graph_potts_abstract.h"
 #include "../matrix.h"
 #include "min_cut.h"
+#include "grid_min_cut.h"
 #include "general_potts_problem.h"
 #include "../algs.h"
 #include "../graph_utils.h"
@@ -808,10 +809,41 @@ namespace dlib
         array2d<node_label,mem_manager>& labels
     )
     {
-        typedef array2d<node_label,mem_manager> image_type;
         labels.set_size(prob.nr(), prob.nc());
+
+#ifdef ENABLE_ASSERTS
+        typedef array2d<node_label,mem_manager> image_type;
         dlib::impl::potts_grid_problem<image_type,potts_grid_problem> model(labels,prob);
-        find_max_factor_graph_potts(model);
+        for (unsigned long node_i = 0; node_i < model.number_of_nodes(); ++node_i)
+        {
+            for (unsigned long jj = 0; jj < model.number_of_neighbors(node_i); ++jj)
+            {
+                unsigned long node_j = model.get_neighbor(node_i,jj);
+                DLIB_ASSERT(prob.factor_value_disagreement(node_i,node_j) >= 0,
+                    "\t void find_max_factor_graph_potts(prob,labels)"
+                    << "\n\t Invalid inputs were given to this function." 
+                    << "\n\t node_i: " << node_i 
+                    << "\n\t node_j: " << node_j 
+                    << "\n\t prob.factor_value_disagreement(node_i,node_j): " << prob.factor_value_disagreement(node_i,node_j)
+                    );
+                DLIB_ASSERT(prob.factor_value_disagreement(node_i,node_j) == prob.factor_value_disagreement(node_j,node_i),
+                    "\t void find_max_factor_graph_potts(prob,labels)"
+                    << "\n\t Invalid inputs were given to this function." 
+                    << "\n\t node_i: " << node_i 
+                    << "\n\t node_j: " << node_j 
+                    << "\n\t prob.factor_value_disagreement(node_i,node_j): " << prob.factor_value_disagreement(node_i,node_j)
+                    << "\n\t prob.factor_value_disagreement(node_j,node_i): " << prob.factor_value_disagreement(node_j,node_i)
+                    );
+            }
+        }
+#endif 
+
+        typedef typename potts_grid_problem::value_type value_type;
+        COMPILE_TIME_ASSERT(is_signed_type<value_type>::value);
+        // Grid problems have a regular structure so we use a max flow solver that is
+        // specialized for them rather than the general min_cut object.
+        dlib::impl::grid_min_cut<value_type> mc;
+        mc(prob, labels);
     }
 
 // ---------------------------------------------------------------------------------------- 
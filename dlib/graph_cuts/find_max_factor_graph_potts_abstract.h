@@ -444,6 +444,11 @@ namespace dlib
             - The optimal labels are stored in #labels.
             - #labels.nr() == prob.nr()
             - #labels.nc() == prob.nc()
+            - Since the graph is a regular grid this routine doesn't use the general
+              min_cut object.  Instead it uses a version of the same max flow algorithm
+              which stores the grid in flat arrays and finds each node's neighbors from its
+              position.  So it is faster and uses less memory than the general
+              find_max_factor_graph_potts(prob) routine would on the same problem.
     !*/
 
 // ---------------------------------------------------------------------------------------- 
@@ -0,0 +1,504 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_GRID_MIN_CuT_H__
+#define DLIB_GRID_MIN_CuT_H__
+
+#include "min_cut.h"
+#include "../uintn.h"
+#include <vector>
+#include <deque>
+#include <limits>
+#include <algorithm>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+
+        template <
+            typename value_type
+            >
+        class grid_min_cut
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is a version of dlib::min_cut specialized for the grid graphs
+                    defined by potts_grid_problem objects (see
+                    find_max_factor_graph_potts_abstract.h).  It runs the same
+                    Boykov-Kolmogorov max flow algorithm but rather than going through the
+                    flow graph interface it keeps the whole residual graph in a few flat
+                    arrays.  The four neighbors of a node are computed from its index so no
+                    adjacency lists are needed at all:
+                        - cap[4*i+d] == the residual capacity of the edge from node i to its
+                          d-th neighbor.  The neighbors are numbered as in
+                          potts_grid_problem, i.e. +1, -1, +nc, and -nc, so the edge in the
+                          opposite direction is cap[4*neighbor(i,d) + (d^1)].
+                        - tr[i] == the residual capacity of the source to node i edge if
+                          tr[i] > 0 and minus the residual capacity of the node i to sink
+                          edge if tr[i] < 0.  Since a potts problem only connects each node
+                          to one of the terminals this one number is enough.
+                        - parent[i] == the neighbor number of the parent of node i in its
+                          search tree, or TERMINAL or NO_PARENT.
+
+                    The buffers are kept between calls so solving many problems with the
+                    same object doesn't allocate any memory after the first call.
+            !*/
+
+        public:
+
+            template <
+                typename potts_grid_problem,
+                typename image_type
+                >
+            void operator() (
+                const potts_grid_problem& prob,
+                image_type& labels
+            )
+            /*!
+                requires
+                    - labels.nr() == prob.nr()
+                    - labels.nc() == prob.nc()
+                ensures
+                    - #labels == the labeling which maximizes potts_model_score(prob,#labels).
+                      That is, #labels[r][c] == SOURCE_CUT for the nodes on the source side of
+                      the minimum cut and SINK_CUT or FREE_NODE for the others.
+            !*/
+            {
+                nc = prob.nc();
+                num = prob.nr()*prob.nc();
+                if (num == 0)
+                    return;
+
+                setup(prob);
+                find_max_flow();
+
+                node_label* out = &labels[0][0];
+                for (unsigned long i = 0; i < num; ++i)
+                {
+                    if (tree[i] == source_tree)
+                        out[i] = SOURCE_CUT;
+                    else if (tree[i] == sink_tree)
+                        out[i] = SINK_CUT;
+                    else
+                        out[i] = FREE_NODE;
+                }
+            }
+
+        private:
+
+            enum
+            {
+                TERMINAL = 4,
+                NO_PARENT = 5
+            };
+
+            enum
+            {
+                free_node = 0,
+                source_tree = 1,
+                sink_tree = 2
+            };
+
+            unsigned long neighbor (
+                const unsigned long i,
+                const unsigned long d
+            ) const
+            {
+                // This must match impl::potts_grid_problem::get_neighbor().
+                switch (d)
+                {
+                    case 0: return (i+1 < num) ? i+1 : i+1-num;
+                    case 1: return (i >= 1) ? i-1 : i-1+num;
+                    case 2: return (i+nc < num) ? i+nc : i+nc-num;
+                    default: return (i >= nc) ? i-nc : i-nc+num;
+                }
+            }
+
+            template <typename potts_grid_problem>
+            void setup (
+                const potts_grid_problem& prob
+            )
+            {
+                cap.resize(4*num);
+                tr.resize(num);
+                tree.assign(num, free_node);
+                parent.assign(num, NO_PARENT);
+                ts.assign(num, 0);
+                dist.assign(num, 0);
+                is_active.assign(num, 0);
+                active.clear();
+                orphans.clear();
+                time = 0;
+
+                for (unsigned long i = 0; i < num; ++i)
+                {
+                    for (unsigned long d = 0; d < 4; ++d)
+                    {
+                        const unsigned long j = neighbor(i,d);
+                        // On a grid with only one row or column some of the neighbors of a
+                        // node are the node itself.  Those edges never matter.
+                        if (j != i)
+                            cap[4*i+d] = prob.factor_value_disagreement(i,j);
+                        else
+                            cap[4*i+d] = 0;
+                    }
+
+                    // A negative factor value is an edge from the source and a positive
+                    // one is an edge to the sink.  Either way this is just -factor_value().
+                    tr[i] = -prob.factor_value(i);
+                }
+
+                // Most of the augmenting paths in a typical image segmentation problem are
+                // just source -> i -> j -> sink for two neighboring pixels.  Pushing flow
+                // through all these paths up front is much cheaper than finding them one
+                // at a time with the search trees.
+                for (unsigned long i = 0; i < num; ++i)
+                {
+                    for (unsigned long d = 0; d < 4 && tr[i] > 0; ++d)
+                    {
+                        const unsigned long j = neighbor(i,d);
+                        if (tr[j] < 0 && cap[4*i+d] > 0)
+                        {
+                            const value_type f = std::min(std::min(tr[i], cap[4*i+d]), static_cast<value_type>(-tr[j]));
+                            tr[i] -= f;
+                            tr[j] += f;
+                            cap[4*i+d] -= f;
+                            cap[4*j+(d^1)] += f;
+                        }
+                    }
+                }
+
+                for (unsigned long i = 0; i < num; ++i)
+                {
+                    if (tr[i] > 0)
+                    {
+                        tree[i] = source_tree;
+                        parent[i] = TERMINAL;
+                        dist[i] = 1;
+                        activate(i);
+                    }
+                    else if (tr[i] < 0)
+                    {
+                        tree[i] = sink_tree;
+                        parent[i] = TERMINAL;
+                        dist[i] = 1;
+                        activate(i);
+                    }
+                }
+            }
+
+            void activate (
+                const unsigned long i
+            )
+            {
+                if (!is_active[i])
+                {
+                    is_active[i] = 1;
+                    active.push_back(i);
+                }
+            }
+
+            void make_orphan (
+                const unsigned long i
+            )
+            {
+                parent[i] = NO_PARENT;
+                orphans.push_back(i);
+            }
+
+            void find_max_flow (
+            )
+            {
+                unsigned long source_side, d;
+                while (grow(source_side, d))
+                {
+                    ++time;
+                    augment(source_side, d);
+                    adopt();
+                }
+            }
+
+            bool grow (
+                unsigned long& source_side,
+                unsigned long& dir
+            )
+            /*!
+                ensures
+                    - if (an augmenting path was found) then
+                        - returns true
+                        - The two search trees meet at the edge from node #source_side,
+                          which is in the source tree, to its #dir-th neighbor, which is in
+                          the sink tree.
+                    - else
+                        - returns false
+            !*/
+            {
+                while (active.size() != 0)
+                {
+                    const unsigned long i = active.front();
+                    if (tree[i] == source_tree)
+                    {
+                        for (unsigned long d = 0; d < 4; ++d)
+                        {
+                            if (cap[4*i+d] > 0)
+                            {
+                                const unsigned long j = neighbor(i,d);
+                                if (tree[j] == free_node)
+                                {
+                                    tree[j] = source_tree;
+                                    parent[j] = d^1;
+                                    ts[j] = ts[i];
+                                    dist[j] = dist[i] + 1;
+                                    activate(j);
+                                }
+                                else if (tree[j] == sink_tree)
+                                {
+                                    source_side = i;
+                                    dir = d;
+                                    return true;
+                                }
+                                else if (ts[j] <= ts[i] && dist[j] > dist[i])
+                                {
+                                    parent[j] = d^1;
+                                    ts[j] = ts[i];
+                                    dist[j] = dist[i] + 1;
+                                }
+                            }
+                        }
+                    }
+                    else if (tree[i] == sink_tree)
+                    {
+                        for (unsigned long d = 0; d < 4; ++d)
+                        {
+                            const unsigned long j = neighbor(i,d);
+                            if (cap[4*j+(d^1)] > 0)
+                            {
+                                if (tree[j] == free_node)
+                                {
+                                    tree[j] = sink_tree;
+                                    parent[j] = d^1;
+                                    ts[j] = ts[i];
+                                    dist[j] = dist[i] + 1;
+                                    activate(j);
+                                }
+                                else if (tree[j] == source_tree)
+                                {
+                                    source_side = j;
+                                    dir = d^1;
+                                    return true;
+                                }
+                                else if (ts[j] <= ts[i] && dist[j] > dist[i])
+                                {
+                                    parent[j] = d^1;
+                                    ts[j] = ts[i];
+                                    dist[j] = dist[i] + 1;
+                                }
+                            }
+                        }
+                    }
+
+                    is_active[i] = 0;
+                    active.pop_front();
+                }
+
+                return false;
+            }
+
+            void augment (
+                const unsigned long source_side,
+                const unsigned long dir
+            )
+            {
+                const unsigned long sink_side = neighbor(source_side, dir);
+
+                // find the bottleneck capacity on the path
+                value_type min_cap = cap[4*source_side+dir];
+                unsigned long x = source_side;
+                while (parent[x] != TERMINAL)
+                {
+                    const unsigned long p = parent[x];
+                    const unsigned long y = neighbor(x,p);
+                    min_cap = std::min(min_cap, cap[4*y+(p^1)]);
+                    x = y;
+                }
+                min_cap = std::min(min_cap, tr[x]);
+
+                x = sink_side;
+                while (parent[x] != TERMINAL)
+                {
+                    const unsigned long p = parent[x];
+                    min_cap = std::min(min_cap, cap[4*x+p]);
+                    x = neighbor(x,p);
+                }
+                min_cap = std::min<value_type>(min_cap, -tr[x]);
+
+                // now push the flow through the path
+                cap[4*source_side+dir] -= min_cap;
+                cap[4*sink_side+(dir^1)] += min_cap;
+
+                x = source_side;
+                while (parent[x] != TERMINAL)
+                {
+                    const unsigned long p = parent[x];
+                    const unsigned long y = neighbor(x,p);
+                    cap[4*y+(p^1)] -= min_cap;
+                    cap[4*x+p] += min_cap;
+                    if (cap[4*y+(p^1)] <= 0)
+                        make_orphan(x);
+                    x = y;
+                }
+                tr[x] -= min_cap;
+                if (tr[x] <= 0)
+                    make_orphan(x);
+
+                x = sink_side;
+                while (parent[x] != TERMINAL)
+                {
+                    const unsigned long p = parent[x];
+                    const unsigned long y = neighbor(x,p);
+                    cap[4*x+p] -= min_cap;
+                    cap[4*y+(p^1)] += min_cap;
+                    if (cap[4*x+p] <= 0)
+                        make_orphan(x);
+                    x = y;
+                }
+                tr[x] += min_cap;
+                if (tr[x] >= 0)
+                    make_orphan(x);
+            }
+
+            uint32 distance_to_origin (
+                unsigned long x
+            )
+            /*!
+                ensures
+                    - if (x is connected to its terminal by a chain of parents) then
+                        - returns the length of that chain and records the distances of
+                          the nodes on it so later searches can stop early.
+                    - else
+                        - returns std::numeric_limits<uint32>::max()
+            !*/
+            {
+                const unsigned long start = x;
+                uint32 d = 0;
+                while (true)
+                {
+                    if (ts[x] == time)
+                    {
+                        d += dist[x];
+                        break;
+                    }
+                    ++d;
+                    const unsigned long p = parent[x];
+                    if (p == TERMINAL)
+                    {
+                        ts[x] = time;
+                        dist[x] = 1;
+                        break;
+                    }
+                    if (p == NO_PARENT)
+                        return std::numeric_limits<uint32>::max();
+                    x = neighbor(x,p);
+                }
+
+                uint32 count_down = d;
+                for (x = start; ts[x] != time; x = neighbor(x,parent[x]))
+                {
+                    ts[x] = time;
+                    dist[x] = count_down--;
+                }
+                return d;
+            }
+
+            void adopt (
+            )
+            {
+                while (orphans.size() != 0)
+                {
+                    const unsigned long x = orphans.back();
+                    orphans.pop_back();
+                    const unsigned char label = tree[x];
+
+                    // If x is still connected to its terminal it is its own best parent.
+                    if ((label == source_tree && tr[x] > 0) || (label == sink_tree && tr[x] < 0))
+                    {
+                        parent[x] = TERMINAL;
+                        ts[x] = time;
+                        dist[x] = 1;
+                        continue;
+                    }
+
+                    // Otherwise look for the neighbor closest to the terminal which can be
+                    // its parent.
+                    uint32 best_dist = std::numeric_limits<uint32>::max();
+                    unsigned long best_d = NO_PARENT;
+                    for (unsigned long d = 0; d < 4; ++d)
+                    {
+                        const unsigned long j = neighbor(x,d);
+                        if (tree[j] != label)
+                            continue;
+                        const value_type c = (label == source_tree) ? cap[4*j+(d^1)] : cap[4*x+d];
+                        if (c <= 0)
+                            continue;
+
+                        const uint32 temp = distance_to_origin(j);
+                        if (temp < best_dist)
+                        {
+                            best_dist = temp;
+                            best_d = d;
+                        }
+                    }
+
+                    if (best_d != NO_PARENT)
+                    {
+                        parent[x] = best_d;
+                        ts[x] = time;
+                        dist[x] = best_dist + 1;
+                        continue;
+                    }
+
+                    // We didn't find a parent so x becomes a free node.  Its children become
+                    // orphans and its neighbors which might be able to grow into it again
+                    // become active.
+                    for (unsigned long d = 0; d < 4; ++d)
+                    {
+                        const unsigned long j = neighbor(x,d);
+                        if (tree[j] != label)
+                            continue;
+                        const value_type c = (label == source_tree) ? cap[4*j+(d^1)] : cap[4*x+d];
+                        if (c > 0)
+                            activate(j);
+                        if (parent[j] < TERMINAL && neighbor(j,parent[j]) == x)
+                            make_orphan(j);
+                    }
+                    tree[x] = free_node;
+                }
+            }
+
+            unsigned long nc;
+            unsigned long num;
+
+            std::vector<value_type> cap;
+            std::vector<value_type> tr;
+            std::vector<unsigned char> tree;
+            std::vector<unsigned char> parent;
+            std::vector<uint32> ts;
+            std::vector<uint32> dist;
+            std::vector<char> is_active;
+            uint32 time;
+
+            std::deque<unsigned long> active;
+            std::vector<unsigned long> orphans;
+        };
+
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_GRID_MIN_CuT_H__
+
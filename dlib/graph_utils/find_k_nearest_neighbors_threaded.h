@@ -0,0 +1,686 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_FIND_K_NEAREST_NEIGHBOrS_THREADED_H__
+#define DLIB_FIND_K_NEAREST_NEIGHBOrS_THREADED_H__
+
+#include "find_k_nearest_neighbors_threaded_abstract.h"
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+#include "../threads.h"
+#include "../matrix.h"
+#include "../serialize.h"
+#include "../smart_pointers/scoped_ptr.h"
+#include "sample_pair.h"
+#include "ordered_sample_pair.h"
+#include "edge_list_graphs.h"
+#include "function_objects.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        /*
+            For dense samples the squared euclidean, cosine, and negative dot product
+            distances are all functions of the dot products between samples and the
+            squared lengths of the samples.  So we can compute a whole block of them with
+            one matrix multiply.  However, those values contain more rounding error than
+            the ones dist_funct() computes, so they can't be used to pick the neighbors
+            directly.  Instead, knn_gemm_traits turns them into lower bounds on what
+            dist_funct() would return.  Only the candidates whose lower bound can still
+            make it into a sample's k nearest neighbors are then given to dist_funct().
+
+            The tol argument is a bound on the relative rounding error of the dot
+            products and lengths, and so also of dist_funct()'s own result.
+        */
+
+        template <typename distance_function_type, typename sample_type>
+        struct knn_gemm_traits
+        {
+            const static bool value = false;
+        };
+
+        template <typename T, long NR, typename MM, typename L>
+        struct knn_gemm_traits<squared_euclidean_distance, matrix<T,NR,1,MM,L> >
+        {
+            const static bool value = true;
+
+            static double lower_bound (
+                const squared_euclidean_distance& dist_funct,
+                const double dot,
+                const double len1,
+                const double len2,
+                const double tol
+            )
+            {
+                const double bound = len1 + len2 - 2*dot - tol*(len1 + len2);
+                if (bound <= dist_funct.upper)
+                    return bound;
+                else
+                    return std::numeric_limits<double>::infinity();
+            }
+        };
+
+        template <typename T, long NR, typename MM, typename L>
+        struct knn_gemm_traits<cosine_distance, matrix<T,NR,1,MM,L> >
+        {
+            const static bool value = true;
+
+            static double lower_bound (
+                const cosine_distance& ,
+                const double dot,
+                const double len1,
+                const double len2,
+                const double tol
+            )
+            {
+                const double temp = std::sqrt(len1*len2);
+                // We can't bound the distance of zero length samples, so make sure they
+                // are always checked with the real distance function.
+                if (temp == 0)
+                    return -std::numeric_limits<double>::infinity();
+                else
+                    return 1 - dot/temp - tol;
+            }
+        };
+
+        template <typename T, long NR, typename MM, typename L>
+        struct knn_gemm_traits<negative_dot_product_distance, matrix<T,NR,1,MM,L> >
+        {
+            const static bool value = true;
+
+            static double lower_bound (
+                const negative_dot_product_distance& ,
+                const double dot,
+                const double len1,
+                const double len2,
+                const double tol
+            )
+            {
+                return -dot - tol*(len1 + len2);
+            }
+        };
+
+    // ------------------------------------------------------------------------------------
+
+        class knn_heaps
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This object holds a bounded max-heap of the k best (distance, index)
+                    pairs seen so far for each of a set of rows.  Pairs are ordered first
+                    by distance and then by index so the result doesn't depend on the
+                    order in which candidates are added.
+            !*/
+        public:
+            typedef std::pair<double,unsigned long> neighbor;
+
+            void setup (
+                const unsigned long num_rows,
+                const unsigned long k_
+            )
+            {
+                k = k_;
+                heaps.resize(num_rows*k);
+                sizes.assign(num_rows, 0);
+            }
+
+            void add (
+                const unsigned long row,
+                const double dist,
+                const unsigned long idx
+            )
+            {
+                // samples with an infinite distance between them aren't connected
+                if (!(dist < std::numeric_limits<double>::infinity()))
+                    return;
+
+                neighbor* h = &heaps[row*k];
+                unsigned long& n = sizes[row];
+                const neighbor item(dist, idx);
+                if (n < k)
+                {
+                    h[n++] = item;
+                    std::push_heap(h, h+n);
+                }
+                else if (item < h[0])
+                {
+                    std::pop_heap(h, h+n);
+                    h[n-1] = item;
+                    std::push_heap(h, h+n);
+                }
+            }
+
+            double worst_distance (
+                const unsigned long row
+            ) const
+            /*!
+                ensures
+                    - returns the largest distance which add() might still accept for
+                      the given row.
+            !*/
+            {
+                if (sizes[row] < k)
+                    return std::numeric_limits<double>::infinity();
+                else
+                    return heaps[row*k].first;
+            }
+
+            unsigned long size (
+                const unsigned long row
+            ) const { return sizes[row]; }
+
+            const neighbor& get (
+                const unsigned long row,
+                const unsigned long i
+            ) const { return heaps[row*k + i]; }
+
+        private:
+            unsigned long k;
+            std::vector<neighbor> heaps;
+            std::vector<unsigned long> sizes;
+        };
+
+    // ------------------------------------------------------------------------------------
+
+        const long knn_block_size = 128;
+
+        struct knn_tile
+        {
+            long r_begin, r_end;
+            long c_begin, c_end;
+        };
+
+        class knn_tile_updater : noncopyable
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This object splits the distance matrix between the rows
+                    [first_row, end_row) and all the columns into tiles and then puts the
+                    distances from each tile into the knn_heaps.  
+
+                    If symmetric then the rows are all the samples and only the tiles on or
+                    above the diagonal are visited.  Each of these tiles is used to update
+                    the heaps of both its rows and its columns so each distance is only
+                    computed once.  The heaps of each block of rows are protected by their
+                    own mutex so tiles can be processed by many threads at once.  Since
+                    knn_heaps doesn't care about the order in which it sees candidates the
+                    results are always the same.
+            !*/
+        public:
+            knn_tile_updater (
+                const long n,
+                knn_heaps& heaps_,
+                const bool symmetric_
+            ) : heaps(heaps_), symmetric(symmetric_), first_row(0)
+            {
+                const long num_blocks = (n + knn_block_size - 1)/knn_block_size;
+                locks.reset(new mutex[num_blocks]);
+                set_rows(0, n, n);
+            }
+
+            void set_rows (
+                const long first_row_,
+                const long end_row,
+                const long n
+            )
+            {
+                first_row = first_row_;
+                tiles.clear();
+                for (long r = first_row; r < end_row; r += knn_block_size)
+                {
+                    for (long c = (symmetric ? r : 0); c < n; c += knn_block_size)
+                    {
+                        knn_tile t;
+                        t.r_begin = r;
+                        t.r_end = std::min(r+knn_block_size, end_row);
+                        t.c_begin = c;
+                        t.c_end = std::min(c+knn_block_size, n);
+                        tiles.push_back(t);
+                    }
+                }
+            }
+
+            long num_tiles() const { return tiles.size(); }
+
+            const knn_tile& tile (long i) const { return tiles[i]; }
+
+            template <typename distance_type>
+            void update (
+                const knn_tile& t,
+                const matrix<double>& bounds,
+                distance_type& distance
+            )
+            /*!
+                requires
+                    - bounds(r-t.r_begin, c-t.c_begin) <= distance(r,c) for all r and c in
+                      the tile.  Here distance(r,c) returns the distance between samples r
+                      and c (the diagonal is ignored).
+                ensures
+                    - only calls distance(r,c) for pairs with a bound small enough that
+                      they might be among the k nearest neighbors of r or c.
+            !*/
+            {
+                {
+                    auto_mutex lock(locks.get()[(t.r_begin-first_row)/knn_block_size]);
+                    for (long r = t.r_begin; r < t.r_end; ++r)
+                    {
+                        double worst = heaps.worst_distance(r-first_row);
+                        const double* row_bounds = &bounds(r-t.r_begin,0);
+                        for (long c = t.c_begin; c < t.c_end; ++c)
+                        {
+                            if (row_bounds[c-t.c_begin] <= worst && r != c)
+                            {
+                                const double dist = distance(r,c);
+                                if (dist <= worst)
+                                {
+                                    heaps.add(r-first_row, dist, c);
+                                    worst = heaps.worst_distance(r-first_row);
+                                }
+                            }
+                        }
+                    }
+                }
+
+                if (symmetric && t.c_begin != t.r_begin)
+                {
+                    auto_mutex lock(locks.get()[(t.c_begin-first_row)/knn_block_size]);
+                    for (long c = t.c_begin; c < t.c_end; ++c)
+                    {
+                        double worst = heaps.worst_distance(c-first_row);
+                        for (long r = t.r_begin; r < t.r_end; ++r)
+                        {
+                            if (bounds(r-t.r_begin, c-t.c_begin) <= worst)
+                            {
+                                const double dist = distance(r,c);
+                                if (dist <= worst)
+                                {
+                                    heaps.add(c-first_row, dist, r);
+                                    worst = heaps.worst_distance(c-first_row);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+
+        private:
+            knn_heaps& heaps;
+            const bool symmetric;
+            long first_row;
+            std::vector<knn_tile> tiles;
+            scoped_ptr<mutex, default_deleter<mutex[]> > locks;
+        };
+
+    // ------------------------------------------------------------------------------------
+
+        template <
+            typename vector_type,
+            typename distance_function_type,
+            bool use_gemm = knn_gemm_traits<distance_function_type,
+                                            typename vector_type::value_type>::value
+            >
+        class knn_job
+        {
+            /*!
+                This is the general version.  It just calls dist_funct() for each pair of
+                samples in a tile.
+            !*/
+        public:
+            knn_job (
+                const vector_type& samples_,
+                const distance_function_type& dist_funct_,
+                knn_tile_updater& updater_
+            ) : samples(samples_), dist_funct(dist_funct_), updater(updater_) {}
+
+            void do_tile (
+                long i
+            )
+            {
+                const knn_tile& t = updater.tile(i);
+                matrix<double> dists(t.r_end-t.r_begin, t.c_end-t.c_begin);
+                for (long r = t.r_begin; r < t.r_end; ++r)
+                {
+                    for (long c = t.c_begin; c < t.c_end; ++c)
+                    {
+                        // Always give the samples to dist_funct() in the same order as
+                        // find_k_nearest_neighbors() does.
+                        if (r < c)
+                            dists(r-t.r_begin, c-t.c_begin) = dist_funct(samples[r], samples[c]);
+                        else if (c < r)
+                            dists(r-t.r_begin, c-t.c_begin) = dist_funct(samples[c], samples[r]);
+                    }
+                }
+                tile_distance distance(t, dists);
+                updater.update(t, dists, distance);
+            }
+
+        private:
+            struct tile_distance
+            {
+                tile_distance(const knn_tile& t_, const matrix<double>& dists_) : t(t_), dists(dists_) {}
+
+                double operator() (long r, long c) const { return dists(r-t.r_begin, c-t.c_begin); }
+
+                const knn_tile& t;
+                const matrix<double>& dists;
+            };
+
+            const vector_type& samples;
+            const distance_function_type& dist_funct;
+            knn_tile_updater& updater;
+        };
+
+        template <
+            typename vector_type,
+            typename distance_function_type
+            >
+        class knn_job<vector_type,distance_function_type,true>
+        {
+            /*!
+                This is the version for distances that can be computed from the dot
+                products between samples.  
+            !*/
+            typedef typename vector_type::value_type sample_type;
+            typedef typename sample_type::type scalar_type;
+            typedef typename sample_type::mem_manager_type mem_manager_type;
+            typedef knn_gemm_traits<distance_function_type,sample_type> traits;
+        public:
+            knn_job (
+                const vector_type& samples_,
+                const distance_function_type& dist_funct_,
+                knn_tile_updater& updater_
+            ) : samples(samples_), dist_funct(dist_funct_), updater(updater_)
+            {
+                // Pack the samples into the rows of X.  Then the dot products for each
+                // tile are given by subm(X)*trans(subm(X)).
+                const long n = samples.size();
+                const long dims = samples[0].size();
+                X.set_size(n, dims);
+                lengths.set_size(n);
+                for (long i = 0; i < n; ++i)
+                {
+                    // make sure requires clause is not broken
+                    DLIB_ASSERT(samples[i].size() == dims,
+                        "\t void find_k_nearest_neighbors_threaded()"
+                        << "\n\t All the samples must have the same dimensionality."
+                        << "\n\t samples[i].size(): " << samples[i].size()
+                        << "\n\t dims: " << dims
+                        << "\n\t i:    " << i
+                        );
+
+                    set_rowm(X,i) = trans(samples[i]);
+                    lengths(i) = length_squared(samples[i]);
+                }
+            }
+
+            void do_tile (
+                long i
+            )
+            {
+                const knn_tile& t = updater.tile(i);
+                matrix<scalar_type,0,0,mem_manager_type> dots;
+                compute_dots(t, dots);
+
+                const double tol = 8*(X.nc()+2)*std::numeric_limits<scalar_type>::epsilon();
+                matrix<double> bounds(dots.nr(), dots.nc());
+                for (long r = t.r_begin; r < t.r_end; ++r)
+                {
+                    const scalar_type* row_dots = &dots(r-t.r_begin,0);
+                    double* row_bounds = &bounds(r-t.r_begin,0);
+                    const double len = lengths(r);
+                    const double* col_lengths = &lengths(t.c_begin);
+                    for (long c = 0; c < bounds.nc(); ++c)
+                        row_bounds[c] = traits::lower_bound(dist_funct, row_dots[c], len, col_lengths[c], tol);
+                }
+
+                tile_distance distance(t, samples, dist_funct);
+                updater.update(t, bounds, distance);
+            }
+
+        private:
+
+            class tile_distance
+            {
+                /*!
+                    This calls dist_funct() for the pairs of samples in a tile.  It
+                    remembers the results since the tile updater might ask for the same
+                    distance twice.
+                !*/
+            public:
+                tile_distance (
+                    const knn_tile& t_,
+                    const vector_type& samples_,
+                    const distance_function_type& dist_funct_
+                ) : t(t_), samples(samples_), dist_funct(dist_funct_), 
+                    dists(t.r_end-t.r_begin, t.c_end-t.c_begin),
+                    have_dist(t.r_end-t.r_begin, t.c_end-t.c_begin)
+                { 
+                    have_dist = 0;
+                }
+
+                double operator() (
+                    long r, 
+                    long c
+                ) 
+                {
+                    double& dist = dists(r-t.r_begin, c-t.c_begin);
+                    if (!have_dist(r-t.r_begin, c-t.c_begin))
+                    {
+                        have_dist(r-t.r_begin, c-t.c_begin) = 1;
+                        // Always give the samples to dist_funct() in the same order as
+                        // find_k_nearest_neighbors() does.
+                        if (r < c)
+                            dist = dist_funct(samples[r], samples[c]);
+                        else
+                            dist = dist_funct(samples[c], samples[r]);
+                    }
+                    return dist;
+                }
+
+            private:
+                const knn_tile& t;
+                const vector_type& samples;
+                const distance_function_type& dist_funct;
+                matrix<double> dists;
+                matrix<unsigned char> have_dist;
+            };
+
+            void compute_dots (
+                const knn_tile& t,
+                matrix<scalar_type,0,0,mem_manager_type>& dots
+            ) const
+            /*!
+                ensures
+                    - #dots == subm(X, t.r_begin, 0, t.r_end-t.r_begin, X.nc()) *
+                               trans(subm(X, t.c_begin, 0, t.c_end-t.c_begin, X.nc()))
+            !*/
+            {
+#ifdef DLIB_USE_BLAS
+                dots = subm(X, t.r_begin, 0, t.r_end-t.r_begin, X.nc()) *
+                       trans(subm(X, t.c_begin, 0, t.c_end-t.c_begin, X.nc()));
+#else
+                // Without BLAS a simple register blocked loop over the rows of X is a lot
+                // faster than dlib's generic matrix multiply for the short and wide tiles
+                // we have here.
+                dots.set_size(t.r_end-t.r_begin, t.c_end-t.c_begin);
+                const long dims = X.nc();
+                for (long r = t.r_begin; r < t.r_end; ++r)
+                {
+                    const scalar_type* a = &X(r,0);
+                    scalar_type* out = &dots(r-t.r_begin,0);
+                    long c = t.c_begin;
+                    for (; c+4 <= t.c_end; c += 4)
+                    {
+                        const scalar_type* b0 = &X(c,0);
+                        const scalar_type* b1 = b0 + dims;
+                        const scalar_type* b2 = b1 + dims;
+                        const scalar_type* b3 = b2 + dims;
+                        scalar_type t0 = 0, t1 = 0, t2 = 0, t3 = 0;
+                        for (long i = 0; i < dims; ++i)
+                        {
+                            const scalar_type v = a[i];
+                            t0 += v*b0[i];
+                            t1 += v*b1[i];
+                            t2 += v*b2[i];
+                            t3 += v*b3[i];
+                        }
+                        out[c-t.c_begin]   = t0;
+                        out[c-t.c_begin+1] = t1;
+                        out[c-t.c_begin+2] = t2;
+                        out[c-t.c_begin+3] = t3;
+                    }
+                    for (; c < t.c_end; ++c)
+                    {
+                        const scalar_type* b = &X(c,0);
+                        scalar_type sum = 0;
+                        for (long i = 0; i < dims; ++i)
+                            sum += a[i]*b[i];
+                        out[c-t.c_begin] = sum;
+                    }
+                }
+#endif
+            }
+
+            const vector_type& samples;
+            const distance_function_type& dist_funct;
+            knn_tile_updater& updater;
+
+            matrix<scalar_type,0,0,mem_manager_type> X;
+            matrix<double,0,1> lengths;
+        };
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename vector_type,
+        typename distance_function_type,
+        typename alloc
+        >
+    void find_k_nearest_neighbors_threaded (
+        const vector_type& samples,
+        const distance_function_type& dist_funct,
+        const unsigned long k,
+        const unsigned long num_threads,
+        std::vector<sample_pair, alloc>& edges
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(k > 0 && num_threads > 0,
+            "\t void find_k_nearest_neighbors_threaded()"
+            << "\n\t Invalid inputs were given to this function."
+            << "\n\t samples.size(): " << samples.size()
+            << "\n\t k:              " << k
+            << "\n\t num_threads:    " << num_threads
+            );
+
+        edges.clear();
+
+        if (samples.size() <= 1)
+            return;
+
+        const unsigned long n = samples.size();
+        impl::knn_heaps heaps;
+        heaps.setup(n, k);
+        impl::knn_tile_updater updater(n, heaps, true);
+
+        typedef impl::knn_job<vector_type,distance_function_type> job_type;
+        job_type job(samples, dist_funct, updater);
+        parallel_for(num_threads, 0, updater.num_tiles(), job, &job_type::do_tile, 4);
+
+        edges.reserve(n*k);
+        for (unsigned long i = 0; i < n; ++i)
+        {
+            for (unsigned long m = 0; m < heaps.size(i); ++m)
+            {
+                const unsigned long j = heaps.get(i,m).second;
+                const double dist = heaps.get(i,m).first;
+                if (dist < std::numeric_limits<double>::infinity())
+                    edges.push_back(sample_pair(i, j, dist));
+            }
+        }
+
+        // Each edge can be found by both of its endpoints so remove the duplicates.  This
+        // also sorts the edges by index.
+        remove_duplicate_edges(edges);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename vector_type,
+        typename distance_function_type
+        >
+    void find_k_nearest_neighbors_threaded (
+        const vector_type& samples,
+        const distance_function_type& dist_funct,
+        const unsigned long k,
+        const unsigned long num_threads,
+        std::ostream& out
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(k > 0 && num_threads > 0,
+            "\t void find_k_nearest_neighbors_threaded()"
+            << "\n\t Invalid inputs were given to this function."
+            << "\n\t samples.size(): " << samples.size()
+            << "\n\t k:              " << k
+            << "\n\t num_threads:    " << num_threads
+            );
+
+        const long n = samples.size();
+        std::vector<ordered_sample_pair> neighbors;
+        if (n <= 1)
+        {
+            for (long i = 0; i < n; ++i)
+                serialize(neighbors, out);
+            return;
+        }
+
+        // Process the rows in groups so that we only need to hold the neighbors of one
+        // group in memory at a time.  This means we can't make use of the symmetry of
+        // the distances since the rows of later groups would need the tiles computed for
+        // earlier groups.  
+        const long rows_per_group = 4*num_threads*impl::knn_block_size;
+        impl::knn_heaps heaps;
+        impl::knn_tile_updater updater(std::min(rows_per_group, n), heaps, false);
+
+        typedef impl::knn_job<vector_type,distance_function_type> job_type;
+        job_type job(samples, dist_funct, updater);
+        thread_pool tp(num_threads);
+
+        for (long first_row = 0; first_row < n; first_row += rows_per_group)
+        {
+            const long end_row = std::min(first_row + rows_per_group, n);
+            heaps.setup(end_row-first_row, k);
+            updater.set_rows(first_row, end_row, n);
+            parallel_for(tp, 0, updater.num_tiles(), job, &job_type::do_tile, 4);
+
+            for (long i = first_row; i < end_row; ++i)
+            {
+                neighbors.clear();
+                for (unsigned long m = 0; m < heaps.size(i-first_row); ++m)
+                {
+                    const unsigned long j = heaps.get(i-first_row,m).second;
+                    const double dist = heaps.get(i-first_row,m).first;
+                    if (dist < std::numeric_limits<double>::infinity())
+                        neighbors.push_back(ordered_sample_pair(i, j, dist));
+                }
+                std::sort(neighbors.begin(), neighbors.end(), &order_by_distance_and_index<ordered_sample_pair>);
+                serialize(neighbors, out);
+            }
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_FIND_K_NEAREST_NEIGHBOrS_THREADED_H__
+
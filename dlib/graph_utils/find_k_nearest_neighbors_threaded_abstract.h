@@ -0,0 +1,124 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_FIND_K_NEAREST_NEIGHBOrS_THREADED_ABSTRACT_H__
+#ifdef DLIB_FIND_K_NEAREST_NEIGHBOrS_THREADED_ABSTRACT_H__
+
+#include <vector>
+#include <iostream>
+#include "sample_pair_abstract.h"
+#include "ordered_sample_pair_abstract.h"
+#include "function_objects_abstract.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename vector_type,
+        typename distance_function_type,
+        typename alloc
+        >
+    void find_k_nearest_neighbors_threaded (
+        const vector_type& samples,
+        const distance_function_type& dist_funct,
+        const unsigned long k,
+        const unsigned long num_threads,
+        std::vector<sample_pair, alloc>& edges
+    );
+    /*!
+        requires
+            - k > 0
+            - num_threads > 0
+            - dist_funct is threadsafe.  This means that it must be safe for multiple
+              threads to invoke the member functions of dist_funct at the same time.
+            - dist_funct(samples[i], samples[j]) must be a valid expression that evaluates
+              to a floating point number
+            - vector_type is any container that looks like a std::vector or dlib::array.
+        ensures
+            - This function computes the same exact k nearest neighbors graph as
+              find_k_nearest_neighbors() but it uses num_threads threads.  That is:
+                - #edges == a set of sample_pair objects that represent all the k nearest
+                  neighbors in samples according to the given distance function
+                  dist_funct.  Note that samples with an infinite distance between them
+                  are considered to be not connected at all.
+                - for all valid i:
+                    - #edges[i].distance() == dist_funct(samples[#edges[i].index1()], samples[#edges[i].index2()])
+                    - #edges[i].distance() < std::numeric_limits<double>::infinity()
+                - contains_duplicate_pairs(#edges) == false
+                - #edges is sorted according to order_by_index().
+            - The N by N distance matrix is split into tiles small enough that the
+              samples being compared stay in cache and the tiles are processed in
+              parallel.  Since the distance matrix is symmetric only the tiles on or above
+              the diagonal are computed.  The k best neighbors of each sample are kept in
+              a bounded heap.  So besides the output and, in the dense case described
+              below, a copy of the samples, this function only needs O(samples.size()*k)
+              memory.  Ties between equally distant neighbors are broken in favor of the
+              neighbor with the smaller index.
+            - if (distance_function_type is squared_euclidean_distance, cosine_distance,
+              or negative_dot_product_distance and the samples are dense column vectors
+              (i.e. dlib::matrix objects)) then
+                - The samples are first copied into one dense matrix, which takes
+                  O(samples.size()*D) memory where D is their dimensionality.  The dot
+                  products between the samples in each block are then computed with
+                  a single matrix multiply (so BLAS is used if DLIB_USE_BLAS is defined).
+                  They give a lower bound on each distance (for squared_euclidean_distance
+                  via the identity ||a-b||^2 == ||a||^2 + ||b||^2 - 2*dot(a,b)) which
+                  allows for their rounding error.  dist_funct() is then only called
+                  for the pairs whose bound is small enough that they might be among
+                  the k nearest neighbors.  All the neighbor choices are made with the
+                  values returned by dist_funct() so the output is the same as
+                  find_k_nearest_neighbors() gives.
+                - All the samples must have the same dimensionality.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename vector_type,
+        typename distance_function_type
+        >
+    void find_k_nearest_neighbors_threaded (
+        const vector_type& samples,
+        const distance_function_type& dist_funct,
+        const unsigned long k,
+        const unsigned long num_threads,
+        std::ostream& out
+    );
+    /*!
+        requires
+            - The requirements are the same as for the above version of
+              find_k_nearest_neighbors_threaded().
+        ensures
+            - This function finds the same neighbors as the above version of
+              find_k_nearest_neighbors_threaded() but rather than putting them into a
+              vector it writes them to out as soon as they are found.  This is useful
+              when the graph is too big to fit into RAM.  Only the neighbors of a small
+              group of samples are held in memory at any one time.  However, this also
+              means the symmetry of the distance matrix can't be exploited, so this
+              function computes each distance twice.
+            - The output is a sequence of samples.size() serialized
+              std::vector<ordered_sample_pair> objects.  The i-th vector contains the k
+              nearest neighbors of samples[i].  That is, if V is the i-th vector then:
+                - V.size() <= k
+                - for all valid j:
+                    - V[j].index1() == i
+                    - V[j].distance() == the distance between samples[i] and
+                      samples[V[j].index2()] (i.e. the same value as in the above
+                      version of find_k_nearest_neighbors_threaded()).
+                    - V[j].distance() < std::numeric_limits<double>::infinity()
+                - V is sorted according to order_by_distance_and_index().
+              So you can read the neighbors of each sample back by calling deserialize()
+              samples.size() times.
+            - Note that this is a directed k nearest neighbors graph.  So unlike the
+              above function an edge from i to j doesn't mean there is also an edge from j
+              to i.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_FIND_K_NEAREST_NEIGHBOrS_THREADED_ABSTRACT_H__
+
+
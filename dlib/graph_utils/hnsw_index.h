@@ -0,0 +1,849 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_HNSW_INDEx_H__
+#define DLIB_HNSW_INDEx_H__
+
+#include "hnsw_index_abstract.h"
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include "../threads.h"
+#include "../serialize.h"
+#include "../uintn.h"
+#include "../smart_pointers/scoped_ptr.h"
+#include "../general_hash/murmur_hash3.h"
+#include "sample_pair.h"
+#include "ordered_sample_pair.h"
+#include "edge_list_graphs.h"
+#include "function_objects.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename sample_type_,
+        typename distance_function_type_ = squared_euclidean_distance
+        >
+    class hnsw_index : noncopyable
+    {
+    public:
+        typedef sample_type_ sample_type;
+        typedef distance_function_type_ distance_function_type;
+
+        hnsw_index (
+        )
+        {
+            init();
+        }
+
+        explicit hnsw_index (
+            const distance_function_type& dist_funct_
+        ) : dist_funct(dist_funct_)
+        {
+            init();
+        }
+
+        void clear (
+        )
+        {
+            samples.clear();
+            levels.clear();
+            links0.clear();
+            upper_links.clear();
+            entry_point = 0;
+            max_level = -1;
+        }
+
+        unsigned long size (
+        ) const { return samples.size(); }
+
+        const sample_type& operator[] (
+            unsigned long idx
+        ) const
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(idx < size(),
+                "\t const sample_type& hnsw_index::operator[]()"
+                << "\n\t Invalid inputs were given to this function."
+                << "\n\t idx:    " << idx
+                << "\n\t size(): " << size()
+                << "\n\t this:   " << this
+                );
+            return samples[idx];
+        }
+
+        const distance_function_type& get_distance_function (
+        ) const { return dist_funct; }
+
+        void set_max_neighbors (
+            unsigned long num
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(num > 1 && size() == 0,
+                "\t void hnsw_index::set_max_neighbors()"
+                << "\n\t Invalid inputs were given to this function."
+                << "\n\t num:    " << num
+                << "\n\t size(): " << size()
+                << "\n\t this:   " << this
+                );
+            max_neighbors = num;
+            level_mult = 1/std::log((double)max_neighbors);
+        }
+
+        unsigned long get_max_neighbors (
+        ) const { return max_neighbors; }
+
+        void set_construction_search_size (
+            unsigned long num
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(num > 0,
+                "\t void hnsw_index::set_construction_search_size()"
+                << "\n\t Invalid inputs were given to this function."
+                << "\n\t this:   " << this
+                );
+            construction_search_size = num;
+        }
+
+        unsigned long get_construction_search_size (
+        ) const { return construction_search_size; }
+
+        void set_search_size (
+            unsigned long num
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(num > 0,
+                "\t void hnsw_index::set_search_size()"
+                << "\n\t Invalid inputs were given to this function."
+                << "\n\t this:   " << this
+                );
+            search_size = num;
+        }
+
+        unsigned long get_search_size (
+        ) const { return search_size; }
+
+        void set_seed (
+            unsigned long value
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(size() == 0,
+                "\t void hnsw_index::set_seed()"
+                << "\n\t You can only set the seed of an empty index."
+                << "\n\t this:   " << this
+                );
+            seed = value;
+        }
+
+        unsigned long get_seed (
+        ) const { return seed; }
+
+        unsigned long add (
+            const sample_type& samp
+        )
+        {
+            const unsigned long idx = append(samp);
+            insert(idx, false);
+            return idx;
+        }
+
+        template <typename vector_type>
+        void add (
+            const vector_type& new_samples,
+            unsigned long num_threads
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(num_threads > 0,
+                "\t void hnsw_index::add()"
+                << "\n\t Invalid inputs were given to this function."
+                << "\n\t this:   " << this
+                );
+
+            unsigned long begin = samples.size();
+            samples.reserve(samples.size() + new_samples.size());
+            for (unsigned long i = 0; i < new_samples.size(); ++i)
+                append(new_samples[i]);
+
+            // The first node just becomes the entry point so there is nothing to do in
+            // parallel for it.
+            if (max_level < 0 && begin < samples.size())
+                insert(begin++, false);
+
+            if (num_threads == 1)
+            {
+                for (unsigned long i = begin; i < samples.size(); ++i)
+                    insert(i, false);
+            }
+            else
+            {
+                parallel_for(num_threads, begin, samples.size(), *this, &hnsw_index::insert_locked, 8);
+            }
+        }
+
+        void find_nearest_neighbors (
+            const sample_type& query,
+            unsigned long k,
+            std::vector<ordered_sample_pair>& neighbors,
+            unsigned long query_id = 0
+        ) const
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(k > 0,
+                "\t void hnsw_index::find_nearest_neighbors()"
+                << "\n\t Invalid inputs were given to this function."
+                << "\n\t this:   " << this
+                );
+
+            neighbors.clear();
+            if (size() == 0)
+                return;
+
+            node_id cur = entry_point;
+            double cur_dist = dist_funct(query, samples[cur]);
+            for (long l = max_level; l > 0; --l)
+                greedy_search(query, cur, cur_dist, l, false);
+
+            search_context ctx;
+            get_context(ctx);
+            search_layer(query, cur, cur_dist, std::max(search_size, k), 0, ctx, false);
+            for (unsigned long i = 0; i < ctx.results.size() && neighbors.size() < k; ++i)
+            {
+                if (ctx.results[i].first < std::numeric_limits<double>::infinity())
+                    neighbors.push_back(ordered_sample_pair(query_id, ctx.results[i].second, ctx.results[i].first));
+            }
+            return_context(ctx);
+        }
+
+        template <typename vector_type>
+        void find_nearest_neighbors (
+            const vector_type& queries,
+            unsigned long k,
+            unsigned long num_threads,
+            std::vector<ordered_sample_pair>& neighbors
+        ) const
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(k > 0 && num_threads > 0,
+                "\t void hnsw_index::find_nearest_neighbors()"
+                << "\n\t Invalid inputs were given to this function."
+                << "\n\t k:           " << k
+                << "\n\t num_threads: " << num_threads
+                << "\n\t this:        " << this
+                );
+
+            std::vector<std::vector<ordered_sample_pair> > results(queries.size());
+            query_job<vector_type> job(*this, queries, k, results);
+            parallel_for(num_threads, 0, queries.size(), job, &query_job<vector_type>::do_query, 8);
+
+            neighbors.clear();
+            neighbors.reserve(queries.size()*k);
+            for (unsigned long i = 0; i < results.size(); ++i)
+                neighbors.insert(neighbors.end(), results[i].begin(), results[i].end());
+        }
+
+        void get_graph (
+            std::vector<ordered_sample_pair>& edges
+        ) const
+        {
+            edges.clear();
+            edges.reserve(samples.size()*max_neighbors);
+            for (unsigned long i = 0; i < samples.size(); ++i)
+            {
+                const node_id* links = get_links(i, 0);
+                for (unsigned long j = 1; j <= links[0]; ++j)
+                    edges.push_back(ordered_sample_pair(i, links[j], dist_funct(samples[i], samples[links[j]])));
+            }
+        }
+
+        template <typename S, typename D>
+        friend void serialize (
+            const hnsw_index<S,D>& item,
+            std::ostream& out
+        );
+
+        template <typename S, typename D>
+        friend void deserialize (
+            hnsw_index<S,D>& item,
+            std::istream& in
+        );
+
+    private:
+
+        typedef uint32 node_id;
+        typedef std::pair<double,node_id> candidate;
+
+        struct search_context
+        {
+            /*!
+                These are the buffers used by search_layer().  We keep a pool of them
+                around so that searches don't need to allocate memory for the visited
+                marks, which are as big as the whole index.
+            !*/
+            search_context() : tag(0) {}
+
+            void swap (search_context& item)
+            {
+                marks.swap(item.marks);
+                std::swap(tag, item.tag);
+                candidates.swap(item.candidates);
+                results.swap(item.results);
+                links.swap(item.links);
+            }
+
+            std::vector<uint32> marks;
+            uint32 tag;
+            std::vector<candidate> candidates;
+            std::vector<candidate> results;
+            std::vector<node_id> links;
+        };
+
+        template <typename vector_type>
+        struct query_job
+        {
+            query_job (
+                const hnsw_index& index_,
+                const vector_type& queries_,
+                unsigned long k_,
+                std::vector<std::vector<ordered_sample_pair> >& results_
+            ) : index(index_), queries(queries_), k(k_), results(results_) {}
+
+            void do_query (long i)
+            {
+                index.find_nearest_neighbors(queries[i], k, results[i], i);
+            }
+
+            const hnsw_index& index;
+            const vector_type& queries;
+            const unsigned long k;
+            std::vector<std::vector<ordered_sample_pair> >& results;
+        };
+
+        const static unsigned long num_node_locks = 1024;
+
+        void init (
+        )
+        {
+            max_neighbors = 16;
+            level_mult = 1/std::log((double)max_neighbors);
+            construction_search_size = 100;
+            search_size = 50;
+            seed = 0;
+            entry_point = 0;
+            max_level = -1;
+            node_locks.reset(new mutex[num_node_locks]);
+        }
+
+        unsigned long max_links (
+            long level
+        ) const
+        {
+            // Layer 0 holds every node so we let its nodes have twice as many links.  This
+            // is the setting recommended by the HNSW paper.
+            return level == 0 ? 2*max_neighbors : max_neighbors;
+        }
+
+        node_id* get_links (
+            unsigned long idx,
+            long level
+        )
+        /*!
+            ensures
+                - returns a pointer P to the links of the given node in the given layer.
+                  P[0] is the number of links and P[1] through P[P[0]] are the links.
+        !*/
+        {
+            if (level == 0)
+                return &links0[idx*(max_links(0)+1)];
+            else
+                return &upper_links[idx][(level-1)*(max_links(level)+1)];
+        }
+
+        const node_id* get_links (
+            unsigned long idx,
+            long level
+        ) const
+        {
+            if (level == 0)
+                return &links0[idx*(max_links(0)+1)];
+            else
+                return &upper_links[idx][(level-1)*(max_links(level)+1)];
+        }
+
+        void copy_links (
+            unsigned long idx,
+            long level,
+            std::vector<node_id>& out,
+            bool locked
+        ) const
+        {
+            if (locked)
+            {
+                auto_mutex lock(node_locks.get()[idx%num_node_locks]);
+                const node_id* links = get_links(idx, level);
+                out.assign(links+1, links+1+links[0]);
+            }
+            else
+            {
+                const node_id* links = get_links(idx, level);
+                out.assign(links+1, links+1+links[0]);
+            }
+        }
+
+        unsigned long append (
+            const sample_type& samp
+        )
+        /*!
+            ensures
+                - adds samp to the end of samples and allocates its (empty) links, but
+                  doesn't connect it to the graph.
+                - returns the index of the new node.
+        !*/
+        {
+            // make sure requires clause is not broken
+            DLIB_CASSERT(samples.size() < std::numeric_limits<node_id>::max(),
+                "\t void hnsw_index::add()"
+                << "\n\t The index is full."
+                << "\n\t this:   " << this
+                );
+
+            const unsigned long idx = samples.size();
+            samples.push_back(samp);
+
+            // Pick the level of this node from a geometric distribution.  We use a hash of
+            // the node index instead of a random number generator so that the levels
+            // don't depend on the order the nodes are inserted by different threads.
+            const double u = (murmur_hash3_2(idx, seed) + 1.0)/4294967297.0;
+            const unsigned long level = static_cast<unsigned long>(-std::log(u)*level_mult);
+            levels.push_back(level);
+
+            links0.resize(links0.size() + max_links(0)+1, 0);
+            upper_links.push_back(std::vector<node_id>(level*(max_links(1)+1), 0));
+            return idx;
+        }
+
+        void greedy_search (
+            const sample_type& query,
+            node_id& cur,
+            double& cur_dist,
+            long level,
+            bool locked
+        ) const
+        /*!
+            ensures
+                - walks from cur to the node closest to query in the given layer, moving to
+                  a closer neighbor each step, and stores it into #cur.
+        !*/
+        {
+            std::vector<node_id> links;
+            bool changed = true;
+            while (changed)
+            {
+                changed = false;
+                copy_links(cur, level, links, locked);
+                for (unsigned long i = 0; i < links.size(); ++i)
+                {
+                    const double dist = dist_funct(query, samples[links[i]]);
+                    if (dist < cur_dist)
+                    {
+                        cur = links[i];
+                        cur_dist = dist;
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        void search_layer (
+            const sample_type& query,
+            const node_id entry,
+            const double entry_dist,
+            const unsigned long ef,
+            const long level,
+            search_context& ctx,
+            bool locked
+        ) const
+        /*!
+            ensures
+                - performs a best first search for the ef nodes in the given layer which are
+                  closest to query, starting at entry.
+                - #ctx.results contains the nodes found, sorted by increasing distance.
+        !*/
+        {
+            if (ctx.marks.size() < samples.size())
+                ctx.marks.resize(samples.size(), 0);
+            if (++ctx.tag == 0)
+            {
+                std::fill(ctx.marks.begin(), ctx.marks.end(), 0);
+                ctx.tag = 1;
+            }
+
+            // candidates is a min-heap of nodes to expand and results is a max-heap of the
+            // best nodes found so far.
+            std::vector<candidate>& cands = ctx.candidates;
+            std::vector<candidate>& results = ctx.results;
+            cands.clear();
+            results.clear();
+            cands.push_back(candidate(entry_dist, entry));
+            results.push_back(candidate(entry_dist, entry));
+            ctx.marks[entry] = ctx.tag;
+
+            while (cands.size() != 0)
+            {
+                const candidate c = cands.front();
+                std::pop_heap(cands.begin(), cands.end(), std::greater<candidate>());
+                cands.pop_back();
+                if (c.first > results.front().first && results.size() >= ef)
+                    break;
+
+                copy_links(c.second, level, ctx.links, locked);
+                for (unsigned long i = 0; i < ctx.links.size(); ++i)
+                {
+                    const node_id e = ctx.links[i];
+                    if (ctx.marks[e] == ctx.tag)
+                        continue;
+                    ctx.marks[e] = ctx.tag;
+
+                    const double dist = dist_funct(query, samples[e]);
+                    if (results.size() < ef || dist < results.front().first)
+                    {
+                        cands.push_back(candidate(dist, e));
+                        std::push_heap(cands.begin(), cands.end(), std::greater<candidate>());
+                        results.push_back(candidate(dist, e));
+                        std::push_heap(results.begin(), results.end());
+                        if (results.size() > ef)
+                        {
+                            std::pop_heap(results.begin(), results.end());
+                            results.pop_back();
+                        }
+                    }
+                }
+            }
+
+            std::sort_heap(results.begin(), results.end());
+        }
+
+        void select_neighbors (
+            const std::vector<candidate>& cands,
+            const unsigned long num,
+            std::vector<candidate>& selected
+        ) const
+        /*!
+            requires
+                - cands is sorted by increasing distance to some node Q.
+            ensures
+                - Picks at most num neighbors for Q from cands using the heuristic from the
+                  HNSW paper.  That is, a candidate is only kept if it is closer to Q than
+                  to any of the neighbors already kept.  This keeps the links spread out
+                  in different directions, which is what makes the graph navigable.
+        !*/
+        {
+            selected.clear();
+            for (unsigned long i = 0; i < cands.size() && selected.size() < num; ++i)
+            {
+                bool keep = true;
+                for (unsigned long j = 0; j < selected.size(); ++j)
+                {
+                    if (dist_funct(samples[cands[i].second], samples[selected[j].second]) < cands[i].first)
+                    {
+                        keep = false;
+                        break;
+                    }
+                }
+                if (keep)
+                    selected.push_back(cands[i]);
+            }
+        }
+
+        void connect (
+            const node_id from,
+            const node_id to,
+            const long level,
+            bool locked
+        )
+        /*!
+            ensures
+                - adds a link from node from to node to in the given layer.  If that gives
+                  from too many links then the worst of them are pruned with
+                  select_neighbors().
+        !*/
+        {
+            if (locked)
+                node_locks.get()[from%num_node_locks].lock();
+
+            node_id* links = get_links(from, level);
+            const unsigned long num = max_links(level);
+            if (links[0] < num)
+            {
+                links[++links[0]] = to;
+            }
+            else
+            {
+                std::vector<candidate> cands, selected;
+                cands.reserve(num+1);
+                cands.push_back(candidate(dist_funct(samples[from], samples[to]), to));
+                for (unsigned long i = 1; i <= links[0]; ++i)
+                    cands.push_back(candidate(dist_funct(samples[from], samples[links[i]]), links[i]));
+                std::sort(cands.begin(), cands.end());
+                select_neighbors(cands, num, selected);
+                links[0] = selected.size();
+                for (unsigned long i = 0; i < selected.size(); ++i)
+                    links[i+1] = selected[i].second;
+            }
+
+            if (locked)
+                node_locks.get()[from%num_node_locks].unlock();
+        }
+
+        void insert_locked (
+            long idx
+        ) { insert(idx, true); }
+
+        void insert (
+            const unsigned long idx,
+            const bool locked
+        )
+        /*!
+            requires
+                - append() has been called for node idx
+            ensures
+                - links node idx into the graph.
+                - if (locked) then
+                    - this function may be called by many threads at once.
+        !*/
+        {
+            const long level = levels[idx];
+            const sample_type& samp = samples[idx];
+
+            // If this node will become the new entry point then we keep the global lock
+            // until we are done so no other thread starts from the old entry point while
+            // the new top layers are still empty.  This doesn't happen very often.
+            if (locked)
+                global_mutex.lock();
+            if (max_level < 0)
+            {
+                entry_point = idx;
+                max_level = level;
+                if (locked)
+                    global_mutex.unlock();
+                return;
+            }
+            const long top_level = max_level;
+            node_id cur = entry_point;
+            const bool new_entry_point = level > top_level;
+            if (locked && !new_entry_point)
+                global_mutex.unlock();
+
+            double cur_dist = dist_funct(samp, samples[cur]);
+            for (long l = top_level; l > level; --l)
+                greedy_search(samp, cur, cur_dist, l, locked);
+
+            search_context ctx;
+            get_context(ctx);
+            std::vector<candidate> selected;
+            for (long l = std::min(level, top_level); l >= 0; --l)
+            {
+                search_layer(samp, cur, cur_dist, construction_search_size, l, ctx, locked);
+
+                // Make sure we don't link the node to itself, which could happen if a
+                // duplicate of an earlier node was added.
+                for (unsigned long i = 0; i < ctx.results.size(); ++i)
+                {
+                    if (ctx.results[i].second == idx)
+                    {
+                        ctx.results.erase(ctx.results.begin()+i);
+                        break;
+                    }
+                }
+
+                select_neighbors(ctx.results, max_neighbors, selected);
+
+                if (locked)
+                    node_locks.get()[idx%num_node_locks].lock();
+                node_id* links = get_links(idx, l);
+                links[0] = selected.size();
+                for (unsigned long i = 0; i < selected.size(); ++i)
+                    links[i+1] = selected[i].second;
+                if (locked)
+                    node_locks.get()[idx%num_node_locks].unlock();
+
+                for (unsigned long i = 0; i < selected.size(); ++i)
+                    connect(selected[i].second, idx, l, locked);
+
+                if (ctx.results.size() != 0)
+                {
+                    cur = ctx.results[0].second;
+                    cur_dist = ctx.results[0].first;
+                }
+            }
+            return_context(ctx);
+
+            if (new_entry_point)
+            {
+                entry_point = idx;
+                max_level = level;
+                if (locked)
+                    global_mutex.unlock();
+            }
+        }
+
+        void get_context (
+            search_context& ctx
+        ) const
+        {
+            auto_mutex lock(pool_mutex);
+            if (context_pool.size() != 0)
+            {
+                ctx.swap(context_pool.back());
+                context_pool.pop_back();
+            }
+        }
+
+        void return_context (
+            search_context& ctx
+        ) const
+        {
+            auto_mutex lock(pool_mutex);
+            context_pool.push_back(search_context());
+            context_pool.back().swap(ctx);
+        }
+
+        std::vector<sample_type> samples;
+        std::vector<unsigned long> levels;
+        // The links of all the nodes in layer 0, max_links(0)+1 entries per node.
+        std::vector<node_id> links0;
+        // The links of each node in layers 1 and above, max_links(1)+1 entries per layer.
+        std::vector<std::vector<node_id> > upper_links;
+        node_id entry_point;
+        long max_level;
+
+        unsigned long max_neighbors;
+        double level_mult;
+        unsigned long construction_search_size;
+        unsigned long search_size;
+        unsigned long seed;
+        distance_function_type dist_funct;
+
+        // These are only used to synchronize threads.  global_mutex protects the entry
+        // point while adding nodes in parallel and pool_mutex protects the context_pool.
+        // The links of node i are protected by node_locks[i%num_node_locks].
+        mutex global_mutex;
+        scoped_ptr<mutex, default_deleter<mutex[]> > node_locks;
+        mutable mutex pool_mutex;
+        mutable std::vector<search_context> context_pool;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename S, typename D>
+    void serialize (
+        const hnsw_index<S,D>& item,
+        std::ostream& out
+    )
+    {
+        int version = 1;
+        serialize(version, out);
+        serialize(item.max_neighbors, out);
+        serialize(item.construction_search_size, out);
+        serialize(item.search_size, out);
+        serialize(item.seed, out);
+        serialize(item.samples, out);
+        serialize(item.levels, out);
+        serialize(item.links0, out);
+        serialize(item.upper_links, out);
+        serialize(item.entry_point, out);
+        serialize(item.max_level, out);
+    }
+
+    template <typename S, typename D>
+    void deserialize (
+        hnsw_index<S,D>& item,
+        std::istream& in
+    )
+    {
+        int version = 0;
+        deserialize(version, in);
+        if (version != 1)
+            throw serialization_error("Unexpected version found while deserializing dlib::hnsw_index.");
+        deserialize(item.max_neighbors, in);
+        deserialize(item.construction_search_size, in);
+        deserialize(item.search_size, in);
+        deserialize(item.seed, in);
+        deserialize(item.samples, in);
+        deserialize(item.levels, in);
+        deserialize(item.links0, in);
+        deserialize(item.upper_links, in);
+        deserialize(item.entry_point, in);
+        deserialize(item.max_level, in);
+        item.level_mult = 1/std::log((double)item.max_neighbors);
+        item.context_pool.clear();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename vector_type,
+        typename distance_function_type,
+        typename alloc
+        >
+    void find_k_nearest_neighbors_hnsw (
+        const vector_type& samples,
+        const distance_function_type& dist_funct,
+        const unsigned long k,
+        const unsigned long num_threads,
+        std::vector<sample_pair, alloc>& edges
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(k > 0 && num_threads > 0,
+            "\t void find_k_nearest_neighbors_hnsw()"
+            << "\n\t Invalid inputs were given to this function."
+            << "\n\t samples.size(): " << samples.size()
+            << "\n\t k:              " << k
+            << "\n\t num_threads:    " << num_threads
+            );
+
+        edges.clear();
+        if (samples.size() <= 1)
+            return;
+
+        typedef typename vector_type::value_type sample_type;
+        hnsw_index<sample_type,distance_function_type> index(dist_funct);
+        index.add(samples, num_threads);
+
+        // Each sample will usually find itself as its own nearest neighbor so ask for
+        // one more neighbor than we need.
+        std::vector<ordered_sample_pair> neighbors;
+        index.find_nearest_neighbors(samples, k+1, num_threads, neighbors);
+
+        edges.reserve(neighbors.size());
+        unsigned long count = 0;
+        for (unsigned long i = 0; i < neighbors.size(); ++i)
+        {
+            if (i == 0 || neighbors[i].index1() != neighbors[i-1].index1())
+                count = 0;
+            if (neighbors[i].index1() != neighbors[i].index2() && count < k)
+            {
+                edges.push_back(sample_pair(neighbors[i].index1(), neighbors[i].index2(),
+                                            neighbors[i].distance()));
+                ++count;
+            }
+        }
+
+        remove_duplicate_edges(edges);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_HNSW_INDEx_H__
+
@@ -0,0 +1,365 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_HNSW_INDEx_ABSTRACT_H__
+#ifdef DLIB_HNSW_INDEx_ABSTRACT_H__
+
+#include <vector>
+#include <iostream>
+#include "../noncopyable.h"
+#include "sample_pair_abstract.h"
+#include "ordered_sample_pair_abstract.h"
+#include "function_objects_abstract.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename sample_type_,
+        typename distance_function_type_ = squared_euclidean_distance
+        >
+    class hnsw_index : noncopyable
+    {
+        /*!
+            REQUIREMENTS ON sample_type_
+                Must be copyable and serializable.
+
+            REQUIREMENTS ON distance_function_type_
+                Must be a default constructible function object such that, for any two
+                sample_type objects A and B, dist_funct(A,B) returns a double which
+                measures the distance between A and B.  It should be symmetric (i.e.
+                dist_funct(A,B) == dist_funct(B,A)) and it must be threadsafe.  The
+                objects in dlib/graph_utils/function_objects_abstract.h are examples.
+
+            INITIAL VALUE
+                - size() == 0
+                - get_max_neighbors() == 16
+                - get_construction_search_size() == 100
+                - get_search_size() == 50
+                - get_seed() == 0
+
+            WHAT THIS OBJECT REPRESENTS
+                This object is an index for answering approximate nearest neighbor
+                queries.  You add samples to it and then it can quickly find the samples
+                closest to any query sample.  It is an implementation of the hierarchical
+                navigable small world graph from the paper:
+                    Efficient and robust approximate nearest neighbor search using
+                    Hierarchical Navigable Small World graphs by Yu. A. Malkov and D. A.
+                    Yashunin
+
+                That is, the samples are the nodes of a layered graph.  Every sample is in
+                layer 0, and each layer above contains an exponentially smaller random
+                subset of the samples in the layer below.  In each layer, each sample is
+                linked to a few of its nearest neighbors in that layer.  A query is
+                answered by greedily walking toward the query in the top layer, then
+                dropping down and continuing the walk in the next layer and so on.  In
+                layer 0 a best first search which keeps track of the get_search_size()
+                best nodes found so far is used.  So the larger get_search_size() is the
+                more accurate but slower the queries are.
+
+                Unlike find_k_nearest_neighbors_lsh(), which builds a k nearest neighbors
+                graph once, this object can be queried with new samples at any time and
+                samples can be added to it incrementally.
+
+            THREAD SAFETY
+                The const member functions of this object may be called by multiple
+                threads at the same time.  However, you must not call any non-const
+                member function while another thread is using this object.  Note that
+                add() and find_nearest_neighbors() can use multiple threads themselves.
+        !*/
+
+    public:
+        typedef sample_type_ sample_type;
+        typedef distance_function_type_ distance_function_type;
+
+        hnsw_index (
+        );
+        /*!
+            ensures
+                - this object is properly initialized
+                - #get_distance_function() == a default constructed distance function
+        !*/
+
+        explicit hnsw_index (
+            const distance_function_type& dist_funct
+        );
+        /*!
+            ensures
+                - this object is properly initialized
+                - #get_distance_function() == dist_funct
+        !*/
+
+        void clear (
+        );
+        /*!
+            ensures
+                - #size() == 0
+                - The parameters of this object (e.g. get_max_neighbors()) are unchanged.
+        !*/
+
+        unsigned long size (
+        ) const;
+        /*!
+            ensures
+                - returns the number of samples in this index.
+        !*/
+
+        const sample_type& operator[] (
+            unsigned long idx
+        ) const;
+        /*!
+            requires
+                - idx < size()
+            ensures
+                - returns the idx-th sample added to this index.
+        !*/
+
+        const distance_function_type& get_distance_function (
+        ) const;
+        /*!
+            ensures
+                - returns the distance function used to compare samples.
+        !*/
+
+        void set_max_neighbors (
+            unsigned long num
+        );
+        /*!
+            requires
+                - num > 1
+                - size() == 0
+            ensures
+                - #get_max_neighbors() == num
+        !*/
+
+        unsigned long get_max_neighbors (
+        ) const;
+        /*!
+            ensures
+                - returns the maximum number of links each sample has in each layer of the
+                  graph (in layer 0 the maximum is 2*get_max_neighbors()).  Larger values
+                  give more accurate searches, especially for high dimensional data, at
+                  the expense of more memory and slower adds and queries.  This is the M
+                  parameter from the HNSW paper.
+        !*/
+
+        void set_construction_search_size (
+            unsigned long num
+        );
+        /*!
+            requires
+                - num > 0
+            ensures
+                - #get_construction_search_size() == num
+        !*/
+
+        unsigned long get_construction_search_size (
+        ) const;
+        /*!
+            ensures
+                - returns the search size used to find the neighbors of each new sample
+                  when it is added to the index.  Larger values give a better graph (and
+                  therefore more accurate queries) but make add() slower.  This is the
+                  efConstruction parameter from the HNSW paper.
+        !*/
+
+        void set_search_size (
+            unsigned long num
+        );
+        /*!
+            requires
+                - num > 0
+            ensures
+                - #get_search_size() == num
+        !*/
+
+        unsigned long get_search_size (
+        ) const;
+        /*!
+            ensures
+                - returns the number of candidates find_nearest_neighbors() keeps track of
+                  while searching layer 0.  This is the main knob for trading accuracy for
+                  speed.  Note that find_nearest_neighbors() always uses at least k
+                  candidates.  This is the ef parameter from the HNSW paper.
+        !*/
+
+        void set_seed (
+            unsigned long value
+        );
+        /*!
+            requires
+                - size() == 0
+            ensures
+                - #get_seed() == value
+        !*/
+
+        unsigned long get_seed (
+        ) const;
+        /*!
+            ensures
+                - returns the seed used to pick the layers each sample is added to.  The
+                  layers of a sample only depend on the seed and the index of the sample.
+        !*/
+
+        unsigned long add (
+            const sample_type& samp
+        );
+        /*!
+            ensures
+                - adds samp to this index.
+                - #size() == size() + 1
+                - #(*this)[size()] == samp
+                - returns size() (i.e. the index of the new sample)
+        !*/
+
+        template <typename vector_type>
+        void add (
+            const vector_type& samples,
+            unsigned long num_threads
+        );
+        /*!
+            requires
+                - num_threads > 0
+                - vector_type is any container that looks like a std::vector or
+                  dlib::array and contains sample_type objects.
+            ensures
+                - adds all the samples to this index.  That is:
+                    - #size() == size() + samples.size()
+                    - for all valid i: #(*this)[size()+i] == samples[i]
+                - The samples are added by num_threads threads at once.  Each thread only
+                  locks the few nodes it is linking together so this scales well with the
+                  number of threads.
+                - if (num_threads == 1) then
+                    - This is the same as calling add() on each sample in order.  So the
+                      resulting index is always the same.
+                - else
+                    - The order in which the samples are linked into the graph depends on
+                      the thread scheduling.  So the resulting graph, and therefore the
+                      query results, may differ slightly from run to run.
+        !*/
+
+        void find_nearest_neighbors (
+            const sample_type& query,
+            unsigned long k,
+            std::vector<ordered_sample_pair>& neighbors,
+            unsigned long query_id = 0
+        ) const;
+        /*!
+            requires
+                - k > 0
+            ensures
+                - finds the approximate k nearest neighbors of query in this index.  That
+                  is:
+                    - #neighbors.size() <= k
+                    - Samples at an infinite distance from the query are never output.
+                    - for all valid i:
+                        - #neighbors[i].index1() == query_id
+                        - #neighbors[i].index2() == the index of a sample in this index
+                        - #neighbors[i].distance() == get_distance_function()(query, (*this)[#neighbors[i].index2()])
+                    - #neighbors is sorted by increasing distance.
+                - The results are approximate, so some of the true nearest neighbors may be
+                  missing.  You can make them more accurate by increasing get_search_size().
+        !*/
+
+        template <typename vector_type>
+        void find_nearest_neighbors (
+            const vector_type& queries,
+            unsigned long k,
+            unsigned long num_threads,
+            std::vector<ordered_sample_pair>& neighbors
+        ) const;
+        /*!
+            requires
+                - k > 0
+                - num_threads > 0
+                - vector_type is any container that looks like a std::vector or
+                  dlib::array and contains sample_type objects.
+            ensures
+                - finds the approximate k nearest neighbors of each of the queries using
+                  num_threads threads.  The neighbors of queries[i] are the same as the
+                  ones output by find_nearest_neighbors(queries[i], k, neighbors, i).
+                - #neighbors contains the neighbors of all the queries.  It is sorted by
+                  index1() (i.e. by query) and then by increasing distance.
+        !*/
+
+        void get_graph (
+            std::vector<ordered_sample_pair>& edges
+        ) const;
+        /*!
+            ensures
+                - #edges == the links between the samples in layer 0 of the index.  That
+                  is, each edge E goes from sample E.index1() to one of its neighbors
+                  E.index2() and E.distance() is the distance between them.
+                - #edges is sorted by index1().  So it can be given directly to the graph
+                  tools that take ordered_sample_pair edges, like chinese_whispers().
+        !*/
+    };
+
+    template <typename S, typename D>
+    void serialize (
+        const hnsw_index<S,D>& item,
+        std::ostream& out
+    );
+    /*!
+        provides serialization support.  Note that the distance function is not saved
+        since distance function objects aren't generally serializable.
+    !*/
+
+    template <typename S, typename D>
+    void deserialize (
+        hnsw_index<S,D>& item,
+        std::istream& in
+    );
+    /*!
+        provides deserialization support.  Since the distance function isn't saved,
+        item keeps the distance function it already has.  That is,
+        #item.get_distance_function() is the same as item.get_distance_function().  So
+        you must give item the same distance function the saved index was built with
+        (e.g. the same squared_euclidean_distance limits) before calling
+        deserialize().  Otherwise the links in the index won't match the distances used
+        by later queries and calls to add().
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename vector_type,
+        typename distance_function_type,
+        typename alloc
+        >
+    void find_k_nearest_neighbors_hnsw (
+        const vector_type& samples,
+        const distance_function_type& dist_funct,
+        const unsigned long k,
+        const unsigned long num_threads,
+        std::vector<sample_pair, alloc>& edges
+    );
+    /*!
+        requires
+            - k > 0
+            - num_threads > 0
+            - dist_funct is threadsafe and meets the requirements of the distance
+              function of an hnsw_index.
+            - vector_type is any container that looks like a std::vector or dlib::array.
+        ensures
+            - This function computes an approximate k nearest neighbors graph of the
+              elements in samples.  It does this by adding all the samples to an
+              hnsw_index and then querying it with each sample, using num_threads threads.
+              This is much faster than find_k_nearest_neighbors() for large datasets.
+            - Note that samples with an infinite distance between them are considered to
+              be not connected at all.  Therefore, we exclude edges with such distances
+              from being output.
+            - for all valid i:
+                - #edges[i].distance() == dist_funct(samples[#edges[i].index1()], samples[#edges[i].index2()])
+                - #edges[i].distance() < std::numeric_limits<double>::infinity()
+            - contains_duplicate_pairs(#edges) == false
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_HNSW_INDEx_ABSTRACT_H__
+
+
@@ -132,6 +132,37 @@ namespace dlib
             }
         }
 
+        void send_file (
+            const std::string& filename
+        )
+        {
+            flush();
+            if (!con || !good() || con->send_file(filename) < 0)
+                setstate(std::ios::badbit);
+        }
+
+        void cork (
+        )
+        {
+            if (!con || con->cork() != 0)
+                setstate(std::ios::badbit);
+        }
+
+        void uncork (
+        )
+        {
+            flush();
+            if (!con || con->uncork() != 0)
+                setstate(std::ios::badbit);
+        }
+
+        void disable_nagle (
+        )
+        {
+            if (!con || con->disable_nagle() != 0)
+                setstate(std::ios::badbit);
+        }
+
     private:
 
         void terminate_connection(
@@ -147,6 +147,53 @@ namespace dlib
                     - This function has no effect on this object.
         !*/
 
+        void send_file (
+            const std::string& filename
+        );
+        /*!
+            ensures
+                - Flushes any data buffered in the output part of the stream and then
+                  writes the entire contents of the given file to the TCP connection.
+                  The file data is not copied through the stream's buffers.  Instead,
+                  it is handed to connection::send_file() which uses the OS's zero-copy
+                  file transmission facilities where available.
+                - if (there is no active TCP connection, the file can't be read, or there
+                  is an error writing to the connection) then
+                    - #bad() == true
+        !*/
+
+        void cork (
+        );
+        /*!
+            ensures
+                - Calls connection::cork() on the underlying TCP connection.  So until
+                  uncork() is called the OS will coalesce the data written to this stream
+                  into as few TCP segments as possible.  This is useful when you write
+                  a message in several pieces (e.g. some serialized headers followed by
+                  a call to send_file()).
+                - if (there is no active TCP connection or there is an error) then
+                    - #bad() == true
+        !*/
+
+        void uncork (
+        );
+        /*!
+            ensures
+                - Flushes any data buffered in the output part of the stream and then
+                  calls connection::uncork() on the underlying TCP connection.
+                - if (there is no active TCP connection or there is an error) then
+                    - #bad() == true
+        !*/
+
+        void disable_nagle (
+        );
+        /*!
+            ensures
+                - Calls connection::disable_nagle() on the underlying TCP connection.
+                - if (there is no active TCP connection or there is an error) then
+                    - #bad() == true
+        !*/
+
     };
 
 // ---------------------------------------------------------------------------------------- 
@@ -6,6 +6,7 @@
 #include "logger_kernel_1.h"
 #include <iostream>
 #include <sstream>
+#include <algorithm>
 
 namespace dlib
 {
@@ -47,6 +48,73 @@ namespace dlib
         gd.set_level("",new_level);
     }
 
+// ----------------------------------------------------------------------------------------
+
+    void enable_async_logging (
+        unsigned long max_queued_bytes,
+        async_logging_overflow_policy policy
+    )
+    {
+        DLIB_ASSERT(max_queued_bytes > 0,
+                    "\tvoid enable_async_logging()"
+                    << "\n\tYou can't give a max_queued_bytes of 0"
+        );
+
+        logger::global_data& gd = logger::get_global_data();
+        auto_mutex M(gd.m);
+        auto_mutex M2(gd.async_m);
+        gd.async_max_queued_bytes = max_queued_bytes;
+        gd.async_policy = policy;
+
+        if (!gd.writer)
+        {
+            gd.async_shutdown = false;
+            gd.writer.reset(new logger::global_data::async_writer(gd));
+            gd.writer->start();
+        }
+        gd.async_enabled = true;
+        // This also wakes up anyone blocked on a full queue since the limit may have
+        // changed.
+        gd.update_async_buffers();
+    }
+
+    void disable_async_logging (
+    )
+    {
+        logger::global_data& gd = logger::get_global_data();
+        gd.stop_async_logging();
+    }
+
+    bool async_logging_enabled (
+    )
+    {
+        logger::global_data& gd = logger::get_global_data();
+        auto_mutex M(gd.async_m);
+        return gd.async_enabled;
+    }
+
+    void flush_async_logging (
+    )
+    {
+        logger::global_data& gd = logger::get_global_data();
+        gd.async_flush();
+    }
+
+    uint64 num_dropped_log_messages (
+    )
+    {
+        logger::global_data& gd = logger::get_global_data();
+        auto_mutex M(gd.async_m);
+        uint64 num = 0;
+        for (unsigned long i = 0; i < gd.async_buffers.items.size(); ++i)
+        {
+            logger::async_thread_buffer& tb = *gd.async_buffers.items[i];
+            auto_mutex M2(tb.m);
+            num += tb.num_dropped;
+        }
+        return num;
+    }
+
 // ----------------------------------------------------------------------------------------
 
     namespace logger_helper_stuff
@@ -101,6 +169,8 @@ namespace dlib
     ~global_data (
     )
     {
+        // Output anything still sitting in the async queue before we go away.
+        stop_async_logging();
         unregister_thread_end_handler(*this,&global_data::thread_end_handler);
     }
 
@@ -109,7 +179,14 @@ namespace dlib
     logger::global_data::
     global_data(
     ) : 
-        next_thread_name(1) 
+        next_thread_name(1),
+        async_work_available(async_m),
+        async_work_pending(false),
+        async_max_queued_bytes(1024*1024),
+        async_policy(ASYNC_LOGGING_BLOCK),
+        async_shutdown(false),
+        async_enabled(false),
+        async_writer_id(0)
     { 
         // make sure the main program thread always has id 0.  Since there is
         // a global logger object declared in this file we should expect that 
@@ -369,6 +446,321 @@ namespace dlib
         return thread_name;
     }
 
+// ----------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------
+//               async logging stuff
+// ----------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------
+
+    logger::global_data::async_thread_handle::
+    ~async_thread_handle (
+    )
+    {
+        // The thread that owned this buffer has ended.  Its queue will still be
+        // emptied by the writer thread but now another thread may start using it.
+        if (buf)
+        {
+            auto_mutex M(buf->m);
+            buf->owned = false;
+        }
+    }
+
+    logger::global_data::async_buffer_list::
+    ~async_buffer_list (
+    )
+    {
+        for (unsigned long i = 0; i < items.size(); ++i)
+            delete items[i];
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    logger::async_thread_buffer* logger::global_data::
+    get_async_buffer (
+    )
+    {
+        async_thread_handle& h = thread_buffers.data();
+        if (h.buf)
+            return h.buf;
+
+        auto_mutex M(async_m);
+        // reuse the buffer of a thread that has terminated if there is one
+        for (unsigned long i = 0; i < async_buffers.items.size(); ++i)
+        {
+            async_thread_buffer& tb = *async_buffers.items[i];
+            auto_mutex M2(tb.m);
+            if (!tb.owned)
+            {
+                // The old owner is gone so we are free to reset its part of the buffer.
+                tb.owned = true;
+                tb.in_use = false;
+                tb.has_thread_name = false;
+                h.buf = &tb;
+                return h.buf;
+            }
+        }
+
+        async_buffers.items.reserve(async_buffers.items.size()+1);
+        async_thread_buffer* tb = new async_thread_buffer;
+        async_buffers.items.push_back(tb);
+        auto_mutex M2(tb->m);
+        tb->owned = true;
+        tb->enabled = async_enabled;
+        tb->max_queued_bytes = async_max_queued_bytes;
+        tb->policy = async_policy;
+        h.buf = tb;
+        return h.buf;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void logger::global_data::
+    update_async_buffers (
+    )
+    {
+        memory_barrier();
+        for (unsigned long i = 0; i < async_buffers.items.size(); ++i)
+        {
+            async_thread_buffer& tb = *async_buffers.items[i];
+            auto_mutex M(tb.m);
+            tb.enabled = async_enabled;
+            tb.max_queued_bytes = async_max_queued_bytes;
+            tb.policy = async_policy;
+            tb.space_available.broadcast();
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    bool logger::global_data::
+    async_push (
+        async_thread_buffer& tb,
+        async_record& rec
+    )
+    {
+        const unsigned long size = rec.text.size() + sizeof(async_record);
+
+        // Only the writer thread ever competes with us for tb.m.  
+        tb.m.lock();
+        if (!tb.enabled)
+        {
+            tb.m.unlock();
+            return false;
+        }
+
+        // Wait for room in the queue.  Note that a message bigger than the whole queue is
+        // still let through once the queue is empty.
+        while (tb.queued_bytes != 0 && tb.queued_bytes + size > tb.max_queued_bytes)
+        {
+            if (tb.policy == ASYNC_LOGGING_DROP && rec.l.priority < LFATAL.priority)
+            {
+                ++tb.num_dropped;
+                tb.m.unlock();
+                return true;
+            }
+            tb.space_available.wait();
+            if (!tb.enabled)
+            {
+                tb.m.unlock();
+                return false;
+            }
+        }
+
+        const bool was_empty = tb.queue.size() == 0;
+        tb.queue.resize(tb.queue.size()+1);
+        async_record& item = tb.queue.back();
+        item.log = rec.log;
+        item.l = rec.l;
+        item.thread_name = rec.thread_name;
+        item.for_hook = rec.for_hook;
+        item.text.swap(rec.text);
+
+        tb.queued_bytes += size;
+        const uint64 id = ++tb.num_pushed;
+        const bool wait_for_output = rec.l.priority >= LFATAL.priority;
+        tb.m.unlock();
+
+        // The writer thread empties every queue it finds non-empty each time it wakes up.
+        // So we only need to wake it when this queue goes from empty to non-empty.
+        if (was_empty)
+        {
+            auto_mutex M(async_m);
+            async_work_pending = true;
+            async_work_available.signal();
+        }
+
+        // Fatal messages are usually followed by the program dying so make sure they
+        // actually get written out.
+        if (wait_for_output)
+        {
+            auto_mutex M(tb.m);
+            while (tb.num_written < id)
+                tb.written_signal.wait();
+        }
+        return true;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void logger::global_data::
+    async_output (
+        async_record& rec
+    )
+    {
+        logger& log = *rec.log;
+        if (log.hook.is_set())
+        {
+            log.hook(log.name(), rec.l, rec.thread_name, rec.text.c_str());
+        }
+        else
+        {
+            std::streambuf* out = log.out.rdbuf();
+            if (out)
+            {
+                out->sputn(rec.text.data(), rec.text.size());
+                // Messages formatted for a hook don't have a newline on the end.
+                if (rec.for_hook)
+                    out->sputc('\n');
+            }
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void logger::global_data::
+    async_flush (
+    )
+    {
+        std::vector<async_thread_buffer*> buffers;
+        {
+            auto_mutex M(async_m);
+            // don't deadlock if a hook called from the writer thread asks for a flush
+            if (!writer || get_thread_id() == async_writer_id)
+                return;
+            buffers = async_buffers.items;
+        }
+
+        // The writer thread empties all the queues before it terminates so these waits
+        // always finish.
+        for (unsigned long i = 0; i < buffers.size(); ++i)
+        {
+            async_thread_buffer& tb = *buffers[i];
+            auto_mutex M(tb.m);
+            const uint64 id = tb.num_pushed;
+            while (tb.num_written < id)
+                tb.written_signal.wait();
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void logger::global_data::
+    stop_async_logging (
+    )
+    {
+        scoped_ptr<async_writer> temp;
+        {
+            auto_mutex M(m);
+            auto_mutex M2(async_m);
+            if (!writer)
+                return;
+            // Nothing gets added to the queues once they are disabled and the writer
+            // thread empties all of them before it looks at async_shutdown.
+            async_enabled = false;
+            update_async_buffers();
+            async_shutdown = true;
+            async_work_available.signal();
+            temp.swap(writer);
+        }
+        // wait for the writer thread to terminate
+        temp.reset();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void logger::global_data::async_writer::
+    thread (
+    )
+    {
+        std::vector<async_thread_buffer*> buffers;
+        std::vector<std::vector<async_record> > batches;
+        std::vector<std::streambuf*> to_flush;
+
+        // Anything logged by this thread, for instance from inside an output hook, must be
+        // output synchronously since we can't wait on ourselves to empty a queue.  So
+        // mark our own buffer as permanently in use.
+        gd.get_async_buffer()->in_use = true;
+
+        gd.async_m.lock();
+        gd.async_writer_id = get_thread_id();
+        while (true)
+        {
+            while (!gd.async_work_pending && !gd.async_shutdown)
+                gd.async_work_available.wait();
+            gd.async_work_pending = false;
+            const bool shutdown = gd.async_shutdown;
+            buffers = gd.async_buffers.items;
+            gd.async_m.unlock();
+
+            // Take everything in each queue in one go so the loggers can keep adding
+            // messages while we do the output.
+            batches.resize(buffers.size());
+            unsigned long num = 0;
+            for (unsigned long i = 0; i < buffers.size(); ++i)
+            {
+                async_thread_buffer& tb = *buffers[i];
+                auto_mutex M(tb.m);
+                batches[i].swap(tb.queue);
+                tb.queued_bytes = 0;
+                tb.space_available.broadcast();
+                num += batches[i].size();
+            }
+
+            if (num != 0)
+            {
+                auto_mutex M(gd.m);
+                for (unsigned long i = 0; i < batches.size(); ++i)
+                {
+                    for (unsigned long j = 0; j < batches[i].size(); ++j)
+                    {
+                        async_record& rec = batches[i][j];
+                        gd.async_output(rec);
+                        std::streambuf* out = rec.log->out.rdbuf();
+                        if (!rec.log->hook.is_set() && rec.log->auto_flush_enabled && out &&
+                            std::find(to_flush.begin(), to_flush.end(), out) == to_flush.end())
+                        {
+                            to_flush.push_back(out);
+                        }
+                    }
+                }
+
+                // Only flush each output once per batch.
+                for (unsigned long i = 0; i < to_flush.size(); ++i)
+                    to_flush[i]->pubsync();
+                to_flush.clear();
+
+                for (unsigned long i = 0; i < buffers.size(); ++i)
+                {
+                    if (batches[i].size() == 0)
+                        continue;
+                    async_thread_buffer& tb = *buffers[i];
+                    auto_mutex M2(tb.m);
+                    tb.num_written += batches[i].size();
+                    tb.written_signal.broadcast();
+                    batches[i].clear();
+                }
+            }
+
+            gd.async_m.lock();
+            // Once shutdown has been requested nothing new can be added to the queues,
+            // so if we just found them all empty we are done.
+            if (shutdown && num == 0)
+                break;
+        }
+        gd.async_writer_id = 0;
+        gd.async_m.unlock();
+    }
+
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
 //               logger_stream stuff
@@ -379,16 +771,64 @@ namespace dlib
     print_header_and_stuff (
     )
     {
+        if (!been_used)
+        {
+            // async_enabled is only a hint here.  The buffer's own enabled flag, which
+            // async_push() checks while holding the buffer's mutex, is what counts.
+            const bool async_hint = log.gd.async_enabled;
+            memory_barrier();
+            if (async_hint)
+            {
+                async_thread_buffer& buf = *log.gd.get_async_buffer();
+                // If this thread is already in the middle of formatting a message (e.g.
+                // some operator<< logged something) or it is the writer thread itself then
+                // we just use the normal synchronous path.
+                if (!buf.in_use)
+                {
+                    if (!buf.has_thread_name)
+                    {
+                        auto_mutex M(log.gd.m);
+                        buf.thread_name = log.gd.get_thread_name();
+                        buf.has_thread_name = true;
+                    }
+
+                    buf.in_use = true;
+                    buf.buf.buffer.resize(0);
+                    buf.out.clear();
+                    tb = &buf;
+                    out = &buf.out;
+                    if (log.hook.is_set() == false)
+                    {
+                        auto_mutex M(log.gd.async_header_m);
+                        log.logger_header()(buf.out,log.name(),l,buf.thread_name);
+                    }
+                    been_used = true;
+                    return;
+                }
+            }
+        }
+
         if (!been_used)
         {
             log.gd.m.lock();
+            out = &log.out;
 
             // Check if the output hook is setup.  If it isn't then we print the logger
             // header like normal.  Otherwise we need to remember to clear out the output
             // stringstream we always write to.
             if (log.hook.is_set() == false)
             {
-                log.logger_header()(log.out,log.name(),l,log.gd.get_thread_name());
+                // async_enabled only changes while m is locked.  When it's false nothing
+                // but us can be calling the header functions.
+                if (log.gd.async_enabled)
+                {
+                    auto_mutex M(log.gd.async_header_m);
+                    log.logger_header()(log.out,log.name(),l,log.gd.get_thread_name());
+                }
+                else
+                {
+                    log.logger_header()(log.out,log.name(),l,log.gd.get_thread_name());
+                }
             }
             else
             {
@@ -406,6 +846,29 @@ namespace dlib
     print_end_of_line (
     )
     {
+        if (tb)
+        {
+            global_data::async_record rec;
+            rec.log = &log;
+            rec.l = l;
+            rec.thread_name = tb->thread_name;
+            rec.for_hook = log.hook.is_set();
+            if (!rec.for_hook)
+                tb->buf.buffer.push_back('\n');
+            rec.text.assign(tb->buf.buffer.begin(), tb->buf.buffer.end());
+            tb->in_use = false;
+
+            if (!log.gd.async_push(*tb, rec))
+            {
+                // async logging was turned off while we were formatting this message.
+                auto_mutex M(log.gd.m);
+                log.gd.async_output(rec);
+                if (!log.hook.is_set() && log.auto_flush_enabled && log.out.rdbuf())
+                    log.out.rdbuf()->pubsync();
+            }
+            return;
+        }
+
         auto_unlock M(log.gd.m);
 
         if (log.hook.is_set() == false)
@@ -461,6 +924,9 @@ namespace dlib
     ~logger (
     ) 
     { 
+        // The async writer thread might still have messages that refer to this logger.
+        gd.async_flush();
+
         gd.m.lock();
         gd.loggers.destroy(this);            
         // if this was the last logger then delete the global data
@@ -8,6 +8,7 @@
 #include "../set.h"
 #include "logger_kernel_abstract.h"
 #include <limits>
+#include <climits>
 #include <cstring>
 #include "../algs.h"
 #include "../assert.h"
@@ -17,6 +18,7 @@
 #include "../member_function_pointer.h"
 #include <streambuf>
 #include <vector>
+#include <string>
 
 namespace dlib
 {
@@ -49,6 +51,57 @@ namespace dlib
     const log_level LERROR(300,"ERROR");
     const log_level LFATAL(400,"FATAL");
 
+// ----------------------------------------------------------------------------------------
+
+    namespace log_priorities
+    {
+        // The priorities of the built in log levels as compile time constants.  These
+        // are used by DLIB_LOG() to decide if a logging statement should be compiled in.
+        enum
+        {
+            LALL   = INT_MIN,
+            LTRACE = -100,
+            LDEBUG = 0,
+            LINFO  = 100,
+            LWARN  = 200,
+            LERROR = 300,
+            LFATAL = 400,
+            LNONE  = INT_MAX
+        };
+    }
+
+#ifndef DLIB_LOG_MIN_PRIORITY 
+#define DLIB_LOG_MIN_PRIORITY INT_MIN
+#endif
+
+#define DLIB_LOG(logger_object, level) \
+    if (dlib::log_priorities::level < DLIB_LOG_MIN_PRIORITY) {} else (logger_object) << dlib::level
+
+// ----------------------------------------------------------------------------------------
+
+    enum async_logging_overflow_policy
+    {
+        ASYNC_LOGGING_BLOCK,
+        ASYNC_LOGGING_DROP
+    };
+
+    void enable_async_logging (
+        unsigned long max_queued_bytes = 1024*1024,
+        async_logging_overflow_policy policy = ASYNC_LOGGING_BLOCK
+    );
+
+    void disable_async_logging (
+    );
+
+    bool async_logging_enabled (
+    );
+
+    void flush_async_logging (
+    );
+
+    uint64 num_dropped_log_messages (
+    );
+
 // ----------------------------------------------------------------------------------------
 
     void set_all_logging_output_streams (
@@ -113,6 +166,8 @@ namespace dlib
     // ------------------------------------------------------------------------------------
     // ------------------------------------------------------------------------------------
 
+        struct async_thread_buffer;
+
         class logger_stream
         {
             /*!
@@ -122,9 +177,17 @@ namespace dlib
                 CONVENTION
                     - enabled == is_enabled()
                     - if (been_used) then
-                        - logger::gd::m is locked
                         - someone has used the << operator to write something to the
                           output stream.
+                        - *out == the stream the message is being written to
+                        - if (tb == 0) then
+                            - logger::gd::m is locked
+                            - out == &log.out
+                        - else
+                            - the message is being formatted into the calling thread's
+                              async logging buffer and will be handed to the background
+                              writer thread by print_end_of_line().
+                            - out == &tb->out
             !*/
         public:
             logger_stream (
@@ -134,7 +197,9 @@ namespace dlib
                 l(l_),
                 log(log_),
                 been_used(false),
-                enabled (l.priority >= log.cur_level.priority)
+                enabled (l.priority >= log.cur_level.priority),
+                out(0),
+                tb(0)
             {}
 
             inline ~logger_stream(
@@ -165,7 +230,7 @@ namespace dlib
                 else
                 {
                     print_header_and_stuff();
-                    log.out << item;
+                    *out << item;
                     return *this;
                 }
             }
@@ -177,8 +242,13 @@ namespace dlib
             /*!
                 ensures
                     - if (!been_used) then
-                        - prints the logger header 
-                        - locks log.gd.m
+                        - if (async logging is enabled and the calling thread isn't 
+                          already formatting a message into its async buffer) then
+                            - prints the logger header into the calling thread's async
+                              buffer without locking log.gd.m
+                        - else
+                            - prints the logger header 
+                            - locks log.gd.m
                         - #been_used == true
             !*/
 
@@ -186,14 +256,19 @@ namespace dlib
             );
             /*!
                 ensures
-                    - prints a newline to log.out
-                    - unlocks log.gd.m
+                    - if (tb != 0) then
+                        - submits the message to the async writer thread
+                    - else
+                        - prints a newline to log.out
+                        - unlocks log.gd.m
             !*/
 
             const log_level& l;
             logger& log;
             bool been_used;
             const bool enabled;
+            std::ostream* out;
+            async_thread_buffer* tb;
         }; // end of class logger_stream
 
     // ------------------------------------------------------------------------------------
@@ -392,6 +467,137 @@ namespace dlib
 
             hook_streambuf hookbuf;
 
+            // ----------------------------------------------------------
+            // async logging state.  Unless noted otherwise it is protected by async_m.
+            // ----------------------------------------------------------
+
+            struct async_record
+            {
+                async_record() : log(0), l(LNONE), thread_name(0), for_hook(false) {}
+
+                // The writer thread looks up log's output stream and hook when it outputs
+                // the message, while holding m.  So the record doesn't hold on to
+                // anything that might be changed or destroyed before then.
+                logger* log;
+                log_level l;
+                uint64 thread_name;
+                bool for_hook;
+                std::string text;
+            };
+
+            class async_writer : public threaded_object
+            {
+            public:
+                async_writer(global_data& gd_) : gd(gd_) {}
+                ~async_writer() { wait(); }
+            private:
+                void thread();
+                global_data& gd;
+            };
+
+            struct async_thread_handle
+            {
+                /*!
+                    WHAT THIS OBJECT REPRESENTS
+                        This is what thread_buffers holds for each thread.  The buffers
+                        themselves are owned by async_buffers since the writer thread
+                        may still need them after their thread has terminated.  When
+                        this object is destroyed the buffer is marked as unowned so 
+                        another thread can reuse it.
+                !*/
+                async_thread_handle() : buf(0) {}
+                ~async_thread_handle();
+                async_thread_buffer* buf;
+            };
+
+            struct async_buffer_list
+            {
+                ~async_buffer_list();
+                std::vector<async_thread_buffer*> items;
+            };
+
+            // print_default_logger_header() and user supplied header functions aren't
+            // required to be thread safe so async mode still serializes calls to them.
+            // The synchronous path only takes this mutex while async logging is enabled.
+            mutex async_header_m;
+            mutex async_m;
+            signaler async_work_available;
+            bool async_work_pending;
+            unsigned long async_max_queued_bytes;
+            async_logging_overflow_policy async_policy;
+            bool async_shutdown;
+            // Only changed while holding both m and async_m, followed by a
+            // memory_barrier().  This lets the synchronous path read it while holding m.
+            // Everyone else only uses it as a hint and then checks the enabled flag of
+            // their own buffer.
+            volatile bool async_enabled;
+            thread_id_type async_writer_id;
+            scoped_ptr<async_writer> writer;
+            async_buffer_list async_buffers;
+            thread_specific_data<async_thread_handle> thread_buffers;
+
+            async_thread_buffer* get_async_buffer (
+            );
+            /*!
+                ensures
+                    - returns the async buffer owned by the calling thread, assigning one
+                      to the thread if it doesn't have one yet.
+            !*/
+
+            void update_async_buffers (
+            );
+            /*!
+                requires
+                    - m and async_m are locked
+                ensures
+                    - copies async_enabled, async_max_queued_bytes, and async_policy into
+                      all the async buffers and wakes up any threads waiting on them.
+            !*/
+
+            bool async_push (
+                async_thread_buffer& tb,
+                async_record& rec
+            );
+            /*!
+                requires
+                    - tb is the calling thread's async buffer
+                ensures
+                    - if (async logging is enabled) then
+                        - moves rec into tb's queue, waiting for room or dropping the 
+                          message according to async_policy.  
+                        - if (rec.l.priority >= LFATAL.priority) then
+                            - waits for the writer thread to output rec before returning
+                        - returns true
+                    - else
+                        - returns false and leaves rec unmodified
+            !*/
+
+            void async_output (
+                async_record& rec
+            );
+            /*!
+                requires
+                    - m is locked
+                ensures
+                    - outputs rec to rec.log's current output stream or hook.
+            !*/
+
+            void async_flush (
+            );
+            /*!
+                ensures
+                    - waits until all the messages submitted before this call have
+                      been output by the writer thread.
+            !*/
+
+            void stop_async_logging (
+            );
+            /*!
+                ensures
+                    - flushes any queued messages and then stops the writer thread.
+                    - #async_enabled == false
+            !*/
+
             global_data (
             );
 
@@ -572,6 +778,48 @@ namespace dlib
 
         }; // end of struct global_data
 
+        struct async_thread_buffer
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is the per thread buffer log messages are formatted into when
+                    async logging is enabled.  Finished messages go into the buffer's own
+                    queue which the writer thread empties.  So the threads doing the
+                    logging never contend for a lock with each other, only with the
+                    writer thread.
+
+                    buf, out, in_use, has_thread_name, and thread_name are only used by
+                    the thread which owns this buffer.  The rest is protected by m.
+                    enabled, max_queued_bytes, and policy are copies of the global
+                    settings made by global_data::update_async_buffers().
+            !*/
+            async_thread_buffer() : 
+                out(&buf), in_use(false), has_thread_name(false), thread_name(0),
+                space_available(m), written_signal(m), queued_bytes(0), num_pushed(0), 
+                num_written(0), num_dropped(0), enabled(false), max_queued_bytes(0),
+                policy(ASYNC_LOGGING_BLOCK), owned(false) 
+            {}
+
+            global_data::hook_streambuf buf;
+            std::ostream out;
+            bool in_use;
+            bool has_thread_name;
+            uint64 thread_name;
+
+            mutex m;
+            signaler space_available;
+            signaler written_signal;
+            std::vector<global_data::async_record> queue;
+            unsigned long queued_bytes;
+            uint64 num_pushed;
+            uint64 num_written;
+            uint64 num_dropped;
+            bool enabled;
+            unsigned long max_queued_bytes;
+            async_logging_overflow_policy policy;
+            bool owned;
+        };
+
         static global_data& get_global_data();
 
     // ------------------------------------------------------------------------------------
@@ -581,6 +829,15 @@ namespace dlib
             const log_level& new_level
         );
 
+        friend void enable_async_logging (
+            unsigned long max_queued_bytes,
+            async_logging_overflow_policy policy
+        );
+        friend void disable_async_logging ();
+        friend bool async_logging_enabled ();
+        friend void flush_async_logging ();
+        friend uint64 num_dropped_log_messages ();
+
         friend void set_all_logging_output_streams (
             std::ostream& out
         );
@@ -50,6 +50,108 @@ namespace dlib
     const log_level LERROR(300 ,"ERROR");
     const log_level LFATAL(400 ,"FATAL");
 
+// ----------------------------------------------------------------------------------------
+
+    #define DLIB_LOG_MIN_PRIORITY  /* defaults to INT_MIN if not defined by the user */
+
+    #define DLIB_LOG(logger_object, level) 
+    /*!
+        requires
+            - level is the name of one of the built in log levels above (e.g. LINFO).
+        ensures
+            - DLIB_LOG(log, LINFO) << "message " << x; does exactly the same thing as
+              log << LINFO << "message " << x; except that if the priority of the
+              level is below DLIB_LOG_MIN_PRIORITY then the whole statement is compiled
+              away.  This includes the evaluation of its arguments.  So you can #define
+              DLIB_LOG_MIN_PRIORITY to, for example, 0 to remove all TRACE logging
+              from a release build.
+            - The compile time priorities of the built in levels are available as
+              dlib::log_priorities::LTRACE, dlib::log_priorities::LINFO, etc.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------
+
+    enum async_logging_overflow_policy
+    {
+        ASYNC_LOGGING_BLOCK,
+        ASYNC_LOGGING_DROP
+    };
+
+    void enable_async_logging (
+        unsigned long max_queued_bytes = 1024*1024,
+        async_logging_overflow_policy policy = ASYNC_LOGGING_BLOCK
+    );
+    /*!
+        requires
+            - max_queued_bytes > 0
+        ensures
+            - #async_logging_enabled() == true
+            - From now on logging statements no longer write to their output streams 
+              or call their output hooks directly.  Instead, each thread formats its
+              messages into its own buffer, without locking the global logger mutex,
+              and then adds the finished message to its own queue.  A background
+              thread drains the queues and does the actual output (or calls the output
+              hooks).  The messages from any one thread are output in the order they
+              were logged.  However, messages from different threads may be output in a
+              different order than they were logged in.
+            - The output stream or hook a message goes to is the one its logger has
+              at the time the background thread outputs it.
+            - Each thread's queue holds at most about max_queued_bytes bytes of
+              messages.  When it is full then:
+                - if (policy == ASYNC_LOGGING_BLOCK) then
+                    - logging statements block until there is room in the queue.
+                - if (policy == ASYNC_LOGGING_DROP) then
+                    - new messages are discarded and counted by
+                      num_dropped_log_messages().  
+            - Messages logged at LFATAL or above are never dropped and the logging
+              statement doesn't return until the message has been output.
+            - The queues are flushed when disable_async_logging() is called and also
+              when the program terminates.  A logger's destructor waits until the 
+              messages already logged through it have been output.
+            - If async logging is already enabled then this function just updates the
+              queue size and overflow policy.
+        throws
+            - std::bad_alloc
+            - dlib::thread_error
+    !*/
+
+    void disable_async_logging (
+    );
+    /*!
+        ensures
+            - outputs all the messages in the async logging queues and then stops the
+              background thread.
+            - #async_logging_enabled() == false
+    !*/
+
+    bool async_logging_enabled (
+    );
+    /*!
+        ensures
+            - returns true if enable_async_logging() has been called and
+              disable_async_logging() hasn't been called since.
+    !*/
+
+    void flush_async_logging (
+    );
+    /*!
+        ensures
+            - if (async_logging_enabled()) then
+                - blocks until all the messages logged before this function was called
+                  have been output.  This is useful to call before doing something that
+                  might crash the program or from a crash handler.
+    !*/
+
+    uint64 num_dropped_log_messages (
+    );
+    /*!
+        ensures
+            - returns the number of messages that have been discarded because an async
+              logging queue was full and the ASYNC_LOGGING_DROP policy was in effect.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
@@ -159,6 +261,10 @@ namespace dlib
                     log << LINFO << "message " << variable << " more message";
                 The logger ensures that the entire statement executes atomically so the 
                 message won't be broken up by other loggers in other threads.
+
+                If enable_async_logging() has been called then the output and any hook
+                functions are invoked from a background thread rather than from the thread
+                doing the logging.  They are still only called one at a time.
         !*/
 
         class logger_stream
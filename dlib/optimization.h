@@ -9,9 +9,11 @@
 #include "optimization/optimization_solve_qp2_using_smo.h"
 #include "optimization/optimization_solve_qp3_using_smo.h"
 #include "optimization/optimization_oca.h"
+#include "optimization/optimization_threaded.h"
 #include "optimization/optimization_trust_region.h"
 #include "optimization/optimization_least_squares.h"
 #include "optimization/max_cost_assignment.h"
+#include "optimization/max_cost_assignment_solver.h"
 #include "optimization/max_sum_submatrix.h"
 #include "optimization/find_max_factor_graph_nmplp.h"
 #include "optimization/find_max_factor_graph_viterbi.h"
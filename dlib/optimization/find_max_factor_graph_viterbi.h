@@ -7,6 +7,9 @@
 #include <vector>
 #include "../matrix.h"
 #include "../array2d.h"
+#include "../threads.h"
+#include "../enable_if.h"
+#include <algorithm>
 
 
 namespace dlib
@@ -51,6 +54,401 @@ namespace dlib
         }
     }
 
+    namespace impl
+    {
+        DLIB_MAKE_HAS_MEMBER_FUNCTION_TEST(
+            has_factor_values, 
+            void, 
+            factor_values,
+            (unsigned long, matrix<double>&)const
+        );
+
+        template <typename map_problem>
+        typename enable_if<has_factor_values<map_problem>,bool>::type call_factor_values_if_exists (
+            const map_problem& prob,
+            unsigned long node_id,
+            matrix<double>& values
+        )
+        {
+            prob.factor_values(node_id, values);
+            return true;
+        }
+
+        template <typename map_problem>
+        typename disable_if<has_factor_values<map_problem>,bool>::type call_factor_values_if_exists (
+            const map_problem& ,
+            unsigned long ,
+            matrix<double>& 
+        )
+        {
+            return false;
+        }
+
+        inline unsigned long viterbi_pow (
+            unsigned long num_states,
+            unsigned long power
+        )
+        {
+            unsigned long result = 1;
+            for (unsigned long i = 0; i < power; ++i)
+                result *= num_states;
+            return result;
+        }
+
+        template <typename T>
+        inline void viterbi_decode_states (
+            unsigned long idx,
+            unsigned long num_states,
+            T& node_states
+        )
+        /*!
+            ensures
+                - writes idx into node_states as a base num_states number with the most
+                  significant digit in node_states(0).  That is, this is the inverse of
+                  the numbering used by advance_state().
+        !*/
+        {
+            for (long i = node_states.size()-1; i >= 0; --i)
+            {
+                node_states(i) = idx%num_states;
+                idx /= num_states;
+            }
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        template <typename map_problem>
+        class viterbi_trellis_filler
+        {
+            /*!
+                This object fills in the trellis used by find_max_factor_graph_viterbi(),
+                one node at a time.  The rows of a node are independent of each other so
+                they can be filled in by multiple threads.
+            !*/
+        public:
+            viterbi_trellis_filler (
+                const map_problem& prob_,
+                array2d<viterbi_data>& trellis_
+            ) :
+                prob(prob_),
+                trellis(trellis_),
+                order(prob_.order()),
+                num_states(prob_.num_states()),
+                trellis_size(viterbi_pow(num_states, order)),
+                node(0),
+                ring_size(1),
+                have_values(false),
+                values_ptr(0),
+                failed(false)
+            {}
+
+            void fill_node (
+                unsigned long node_,
+                thread_pool* tp
+            )
+            {
+                node = node_;
+                ring_size = viterbi_pow(num_states, std::min(node, order));
+                have_values = call_factor_values_if_exists(prob, node, values);
+                if (have_values)
+                {
+                    DLIB_ASSERT(values.nr() == (long)num_states && values.nc() == (long)ring_size,
+                        "\t void find_max_factor_graph_viterbi()"
+                        << "\n\t prob.factor_values() output a matrix of the wrong size."
+                        << "\n\t node_id:       " << node
+                        << "\n\t values.nr():   " << values.nr()
+                        << "\n\t values.nc():   " << values.nc()
+                        << "\n\t expected size: " << num_states << "x" << ring_size 
+                        );
+                    values_ptr = &values(0,0);
+                }
+
+                const long num_rows = (node < order) ? ring_size*num_states : trellis_size;
+                if (tp != 0 && tp->num_threads_in_pool() != 0 && num_rows*num_states >= 1000)
+                {
+                    failed = false;
+                    parallel_for_blocked(*tp, 0, num_rows, *this, &viterbi_trellis_filler::process_rows_and_catch, 4);
+                    // A worker thread can't hand its exception over to us.  So if prob
+                    // threw while filling some of the rows we fill the whole node again
+                    // here, which lets the exception reach our caller as it was thrown.
+                    if (failed)
+                        process_rows(0, num_rows);
+                }
+                else
+                {
+                    process_rows(0, num_rows);
+                }
+            }
+
+            void process_rows (
+                long begin,
+                long end
+            )
+            {
+                if (node < order)
+                {
+                    process_initial_rows(begin, end);
+                }
+                else if (order == 1)
+                {
+                    process_rows_<2>(begin, end);
+                }
+                else if (order == 2)
+                {
+                    process_rows_<3>(begin, end);
+                }
+                else if (order == 3)
+                {
+                    process_rows_<4>(begin, end);
+                }
+                else
+                {
+                    process_rows_<0>(begin, end);
+                }
+            }
+
+        private:
+
+            void process_rows_and_catch (
+                long begin,
+                long end
+            )
+            {
+                try
+                {
+                    process_rows(begin, end);
+                }
+                catch (...)
+                {
+                    auto_mutex lock(failed_mutex);
+                    failed = true;
+                }
+            }
+
+            void process_initial_rows (
+                long begin,
+                long end
+            )
+            {
+                // The first few nodes don't have order() nodes before them so each row
+                // only has one way to get to it.
+                matrix<unsigned long,1,0> node_states(node+1);
+                for (long idx = begin; idx < end; ++idx)
+                {
+                    double val;
+                    if (have_values)
+                    {
+                        val = values_ptr[idx];
+                    }
+                    else
+                    {
+                        viterbi_decode_states(idx, num_states, node_states);
+                        val = prob.factor_value(node, node_states);
+                    }
+
+                    if (node == 0)
+                    {
+                        trellis[node][idx].val = val;
+                    }
+                    else
+                    {
+                        const unsigned long back_index = idx%ring_size;
+                        trellis[node][idx].val = val + trellis[node-1][back_index].val;
+                        trellis[node][idx].back_index = back_index;
+                    }
+                }
+            }
+
+            template <long NC>
+            void process_rows_ (
+                long begin,
+                long end
+            )
+            {
+                /*
+                    Since the size of node_states is a compile time constant for the common
+                    orders this function runs significantly faster than it would with a 
+                    dynamically sized node_states.
+                */
+                matrix<unsigned long,1,NC> node_states(order+1);
+                // Only decoded when there are no precomputed values, but set it anyway
+                // so the compiler can see it's never read uninitialized.
+                node_states = 0;
+                const viterbi_data* prev = &trellis[node-1][0];
+                for (long i = begin; i < end; ++i)
+                {
+                    unsigned long count = i*num_states;
+                    if (!have_values)
+                        viterbi_decode_states(count, num_states, node_states);
+                    unsigned long back_index = 0;
+                    double best_score = -std::numeric_limits<double>::infinity();
+                    for (unsigned long s = 0; s < num_states; ++s)
+                    {
+                        double temp;
+                        if (have_values)
+                        {
+                            temp = values_ptr[count] + prev[count%trellis_size].val;
+                        }
+                        else
+                        {
+                            temp = prob.factor_value(node,node_states) + prev[count%trellis_size].val;
+                            advance_state(node_states,num_states);
+                        }
+
+                        if (temp > best_score)
+                        {
+                            best_score = temp;
+                            back_index = count%trellis_size;
+                        }
+                        ++count;
+                    }
+                    trellis[node][i].val = best_score;
+                    trellis[node][i].back_index = back_index;
+                }
+            }
+
+            const map_problem& prob;
+            array2d<viterbi_data>& trellis;
+            const unsigned long order;
+            const unsigned long num_states;
+            const unsigned long trellis_size;
+
+            unsigned long node;
+            unsigned long ring_size;
+            bool have_values;
+            matrix<double> values;
+            const double* values_ptr;
+
+            mutex failed_mutex;
+            bool failed;
+        };
+
+    // ------------------------------------------------------------------------------------
+
+        template <
+            typename map_problem
+            >
+        void find_max_factor_graph_viterbi (
+            const map_problem& prob,
+            std::vector<unsigned long>& map_assignment,
+            thread_pool* tp
+        )
+        {
+            const unsigned long order = prob.order();
+            const unsigned long num_states = prob.num_states();
+
+
+            DLIB_ASSERT(prob.num_states() > 0,
+                "\t void find_max_factor_graph_viterbi()"
+                << "\n\t The nodes in a factor graph have to be able to take on more than 0 states."
+                );
+            DLIB_ASSERT(std::pow(num_states,(double)order) < std::numeric_limits<unsigned long>::max(),
+                "\t void find_max_factor_graph_viterbi()"
+                << "\n\t The order is way too large for this algorithm to handle."
+                << "\n\t order:      " << order
+                << "\n\t num_states: " << num_states 
+                << "\n\t std::pow(num_states,order):                " << std::pow(num_states,(double)order) 
+                << "\n\t std::numeric_limits<unsigned long>::max(): " << std::numeric_limits<unsigned long>::max() 
+                );
+
+            if (prob.number_of_nodes() == 0)
+            {
+                map_assignment.clear();
+                return;
+            }
+
+            if (order == 0)
+            {
+                map_assignment.resize(prob.number_of_nodes());
+                matrix<double> values;
+                for (unsigned long i = 0; i < map_assignment.size(); ++i)
+                {
+                    const bool have_values = call_factor_values_if_exists(prob, i, values);
+                    matrix<unsigned long,1,1> node_state;
+                    unsigned long best_state = 0;
+                    double best_val = -std::numeric_limits<double>::infinity();
+                    for (unsigned long s = 0; s < num_states; ++s)
+                    {
+                        node_state(0) = s;
+                        const double temp = have_values ? values(s) : prob.factor_value(i,node_state);
+                        if (temp > best_val)
+                        {
+                            best_val = temp;
+                            best_state = s;
+                        }
+                    }
+                    map_assignment[i] = best_state;
+                }
+                return;
+            }
+
+
+            const unsigned long trellis_size = viterbi_pow(num_states, order);
+
+            array2d<impl::viterbi_data> trellis;
+            trellis.set_size(prob.number_of_nodes(), trellis_size);
+
+            viterbi_trellis_filler<map_problem> filler(prob, trellis);
+            for (unsigned long node = 0; node < prob.number_of_nodes(); ++node)
+                filler.fill_node(node, tp);
+
+
+            map_assignment.resize(prob.number_of_nodes());
+            // Figure out which state of the last node has the biggest value. 
+            unsigned long back_index = 0;
+            double best_val = -std::numeric_limits<double>::infinity();
+            for (long i = 0; i < trellis.nc(); ++i)
+            {
+                if (trellis[trellis.nr()-1][i].val > best_val)
+                {
+                    best_val = trellis[trellis.nr()-1][i].val;
+                    back_index = i;
+                }
+            }
+            // Follow the back links to find the decoding.
+            unsigned long init_ring_size = viterbi_pow(num_states, std::min<unsigned long>(order, map_assignment.size())-1);
+            for (long node = map_assignment.size()-1; node >= 0; --node)
+            {
+                map_assignment[node] = back_index/init_ring_size;
+                back_index = trellis[node][back_index].back_index;
+                if (node < (long)order)
+                    init_ring_size /= num_states;
+            }
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        struct viterbi_beam_entry
+        {
+            unsigned long index;
+            double val;
+            unsigned long back;
+        };
+
+        inline bool viterbi_beam_index_order (
+            const viterbi_beam_entry& a,
+            const viterbi_beam_entry& b
+        )
+        {
+            if (a.index != b.index)
+                return a.index < b.index;
+            if (a.val != b.val)
+                return a.val > b.val;
+            return a.back < b.back;
+        }
+
+        inline bool viterbi_beam_score_order (
+            const viterbi_beam_entry& a,
+            const viterbi_beam_entry& b
+        )
+        {
+            if (a.val != b.val)
+                return a.val > b.val;
+            return a.index < b.index;
+        }
+
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -60,167 +458,264 @@ namespace dlib
         const map_problem& prob,
         std::vector<unsigned long>& map_assignment
     )
+    {
+        impl::find_max_factor_graph_viterbi(prob, map_assignment, 0);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename map_problem
+        >
+    void find_max_factor_graph_viterbi_threaded (
+        const map_problem& prob,
+        std::vector<unsigned long>& map_assignment,
+        unsigned long num_threads
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(num_threads > 0,
+            "\t void find_max_factor_graph_viterbi_threaded()"
+            << "\n\t num_threads must be greater than 0"
+            );
+
+        if (num_threads == 1)
+        {
+            impl::find_max_factor_graph_viterbi(prob, map_assignment, 0);
+        }
+        else
+        {
+            thread_pool tp(num_threads);
+            impl::find_max_factor_graph_viterbi(prob, map_assignment, &tp);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename map_problem
+        >
+    void find_max_factor_graph_viterbi_beam (
+        const map_problem& prob,
+        std::vector<unsigned long>& map_assignment,
+        unsigned long beam_width
+    )
     {
         using namespace dlib::impl;
         const unsigned long order = prob.order();
         const unsigned long num_states = prob.num_states();
+        const unsigned long num_nodes = prob.number_of_nodes();
 
-
-        DLIB_ASSERT(prob.num_states() > 0,
-            "\t void find_max_factor_graph_viterbi()"
-            << "\n\t The nodes in a factor graph have to be able to take on more than 0 states."
+        // make sure requires clause is not broken
+        DLIB_ASSERT(prob.num_states() > 0 && beam_width > 0,
+            "\t void find_max_factor_graph_viterbi_beam()"
+            << "\n\t Invalid inputs were given to this function."
+            << "\n\t prob.num_states(): " << prob.num_states()
+            << "\n\t beam_width:        " << beam_width
             );
         DLIB_ASSERT(std::pow(num_states,(double)order) < std::numeric_limits<unsigned long>::max(),
-            "\t void find_max_factor_graph_viterbi()"
+            "\t void find_max_factor_graph_viterbi_beam()"
             << "\n\t The order is way too large for this algorithm to handle."
             << "\n\t order:      " << order
             << "\n\t num_states: " << num_states 
-            << "\n\t std::pow(num_states,order):                " << std::pow(num_states,(double)order) 
-            << "\n\t std::numeric_limits<unsigned long>::max(): " << std::numeric_limits<unsigned long>::max() 
             );
 
-        if (prob.number_of_nodes() == 0)
+        // Nothing gets pruned when there are no dependencies between the nodes.
+        if (order == 0 || num_nodes == 0)
         {
-            map_assignment.clear();
+            find_max_factor_graph_viterbi(prob, map_assignment);
             return;
         }
 
-        if (order == 0)
+        /*
+            This is the Viterbi algorithm except that at each node we only keep the
+            beam_width best partial labelings rather than all num_states^order of them.
+            The state of a beam entry is the labels of the last min(node+1,order) nodes,
+            encoded as a base num_states number with the label of the current node as the
+            most significant digit.  Partial labelings which end in the same state are
+            merged like in the normal Viterbi algorithm.
+        */
+        std::vector<std::vector<viterbi_beam_entry> > beams(num_nodes);
+        std::vector<viterbi_beam_entry> cands;
+        matrix<double> values;
+        matrix<unsigned long,1,0> node_states;
+        for (unsigned long node = 0; node < num_nodes; ++node)
         {
-            map_assignment.resize(prob.number_of_nodes());
-            for (unsigned long i = 0; i < map_assignment.size(); ++i)
+            const bool have_values = call_factor_values_if_exists(prob, node, values);
+            const unsigned long prev_len = std::min(node, order);
+            const unsigned long prev_size = viterbi_pow(num_states, prev_len);
+            DLIB_ASSERT(!have_values || (values.nr() == (long)num_states && values.nc() == (long)prev_size),
+                "\t void find_max_factor_graph_viterbi_beam()"
+                << "\n\t prob.factor_values() output a matrix of the wrong size."
+                << "\n\t node:          " << node
+                << "\n\t values.nr():   " << values.nr()
+                << "\n\t values.nc():   " << values.nc()
+                << "\n\t expected size: " << num_states << "x" << prev_size 
+                );
+
+            node_states.set_size(prev_len+1);
+            cands.clear();
+            if (node == 0)
             {
-                matrix<unsigned long,1,1> node_state;
-                unsigned long best_state = 0;
-                double best_val = -std::numeric_limits<double>::infinity();
                 for (unsigned long s = 0; s < num_states; ++s)
                 {
-                    node_state(0) = s;
-                    const double temp = prob.factor_value(i,node_state);
-                    if (temp > best_val)
+                    node_states(0) = s;
+                    viterbi_beam_entry e;
+                    e.index = s;
+                    e.val = have_values ? values(s,0) : prob.factor_value(node, node_states);
+                    e.back = 0;
+                    cands.push_back(e);
+                }
+            }
+            else
+            {
+                const std::vector<viterbi_beam_entry>& prev = beams[node-1];
+                // The state of this node drops the oldest label once we have order()
+                // labels.
+                const unsigned long shift = (node < order) ? prev_size : prev_size/num_states;
+                const unsigned long divisor = (node < order) ? 1 : num_states;
+                for (unsigned long p = 0; p < prev.size(); ++p)
+                {
+                    const unsigned long pidx = prev[p].index;
+                    if (!have_values)
+                        viterbi_decode_states(pidx, num_states, node_states);
+                    for (unsigned long s = 0; s < num_states; ++s)
                     {
-                        best_val = temp;
-                        best_state = s;
+                        double val;
+                        if (have_values)
+                        {
+                            val = values(s, pidx);
+                        }
+                        else
+                        {
+                            node_states(0) = s;
+                            val = prob.factor_value(node, node_states);
+                        }
+                        viterbi_beam_entry e;
+                        e.index = s*shift + pidx/divisor;
+                        e.val = prev[p].val + val;
+                        e.back = p;
+                        cands.push_back(e);
                     }
                 }
-                map_assignment[i] = best_state;
             }
-            return;
-        }
 
+            // merge entries with the same state, keeping the best one
+            std::sort(cands.begin(), cands.end(), viterbi_beam_index_order);
+            std::vector<viterbi_beam_entry>& beam = beams[node];
+            for (unsigned long i = 0; i < cands.size(); ++i)
+            {
+                if (i == 0 || cands[i].index != cands[i-1].index)
+                    beam.push_back(cands[i]);
+            }
 
-        const unsigned long trellis_size = static_cast<unsigned long>(std::pow(num_states,(double)order)); 
-        unsigned long init_ring_size = 1; 
+            if (beam.size() > beam_width)
+            {
+                std::partial_sort(beam.begin(), beam.begin()+beam_width, beam.end(), viterbi_beam_score_order);
+                beam.resize(beam_width);
+            }
+        }
 
-        array2d<impl::viterbi_data> trellis;
-        trellis.set_size(prob.number_of_nodes(), trellis_size);
+        // Find the best entry in the last beam and follow the back links.
+        const std::vector<viterbi_beam_entry>& last = beams.back();
+        unsigned long best = 0;
+        for (unsigned long i = 1; i < last.size(); ++i)
+        {
+            if (viterbi_beam_score_order(last[i], last[best]))
+                best = i;
+        }
+        map_assignment.resize(num_nodes);
+        for (long node = num_nodes-1; node >= 0; --node)
+        {
+            const unsigned long len = std::min<unsigned long>(node+1, order);
+            map_assignment[node] = beams[node][best].index/viterbi_pow(num_states, len-1);
+            best = beams[node][best].back;
+        }
+    }
 
+// ----------------------------------------------------------------------------------------
 
-        for (unsigned long node = 0; node < prob.number_of_nodes(); ++node)
+    namespace impl
+    {
+        template <
+            typename map_problem
+            >
+        struct viterbi_batch_helper
         {
+            viterbi_batch_helper (
+                const std::vector<map_problem>& probs_,
+                std::vector<std::vector<unsigned long> >& map_assignments_,
+                unsigned long beam_width_,
+                std::vector<char>& failed_
+            ) : probs(probs_), map_assignments(map_assignments_), beam_width(beam_width_), failed(failed_) {}
 
-            if (node < order)
+            const std::vector<map_problem>& probs;
+            std::vector<std::vector<unsigned long> >& map_assignments;
+            const unsigned long beam_width;
+            std::vector<char>& failed;
+
+            void decode (
+                long i
+            ) const
             {
-                matrix<unsigned long,1,0> node_states;
-                node_states.set_size(std::min<int>(node, order) + 1);
-                node_states = 0;
+                if (beam_width == 0)
+                    dlib::find_max_factor_graph_viterbi(probs[i], map_assignments[i]);
+                else
+                    dlib::find_max_factor_graph_viterbi_beam(probs[i], map_assignments[i], beam_width);
+            }
 
-                unsigned long idx = 0;
-                if (node == 0)
+            void operator() (
+                long i
+            ) const
+            {
+                try
                 {
-                    do 
-                    {
-                        trellis[node][idx].val = prob.factor_value(node,node_states);
-                        ++idx;
-                    } while(advance_state(node_states,num_states));
+                    decode(i);
                 }
-                else
+                catch (...)
                 {
-                    init_ring_size *= num_states;
-                    do 
-                    {
-                        const unsigned long back_index = idx%init_ring_size;
-                        trellis[node][idx].val = prob.factor_value(node,node_states) + trellis[node-1][back_index].val;
-                        trellis[node][idx].back_index = back_index;
-                        ++idx;
-                    } while(advance_state(node_states,num_states));
-
+                    failed[i] = 1;
                 }
             }
-            else if (order == 1)
-            {
-                /*
-                    WHAT'S THE DEAL WITH THIS PREPROCESSOR MACRO?
-                        Well, if we can declare the dimensions of node_states as a compile
-                        time constant then this function runs significantly faster.  So this macro
-                        is here to let us do that.  It just lets us avoid replicating this code
-                        block in the following if statements for different order sizes.
-                */
-#define DLIB_FMFGV_WORK                                                                                                     \
-                node_states = 0;                                                                                            \
-                unsigned long count = 0;                                                                                    \
-                for (unsigned long i = 0; i < trellis_size; ++i)                                                            \
-                {                                                                                                           \
-                    unsigned long back_index = 0;                                                                           \
-                    double best_score = -std::numeric_limits<double>::infinity();                                           \
-                    for (unsigned long s = 0; s < num_states; ++s)                                                          \
-                    {                                                                                                       \
-                        const double temp = prob.factor_value(node,node_states) + trellis[node-1][count%trellis_size].val;  \
-                        if (temp > best_score)                                                                              \
-                        {                                                                                                   \
-                            best_score = temp;                                                                              \
-                            back_index = count%trellis_size;                                                                \
-                        }                                                                                                   \
-                        advance_state(node_states,num_states);                                                              \
-                        ++count;                                                                                            \
-                    }                                                                                                       \
-                    trellis[node][i].val = best_score;                                                                      \
-                    trellis[node][i].back_index = back_index;                                                               \
-                }
-
-                matrix<unsigned long,1,2> node_states;
-                DLIB_FMFGV_WORK
-            }
-            else if (order == 2)
-            {
-                matrix<unsigned long,1,3> node_states;
-                DLIB_FMFGV_WORK
-            }
-            else if (order == 3)
-            {
-                matrix<unsigned long,1,4> node_states;
-                DLIB_FMFGV_WORK
-            }
-            else 
-            {
-                // The general case, here we don't define the size of node_states at compile time.
-                matrix<unsigned long,1,0> node_states(order+1);
-                DLIB_FMFGV_WORK
-            }
-        }
+        };
+    }
 
+    template <
+        typename map_problem
+        >
+    void find_max_factor_graph_viterbi_threaded (
+        const std::vector<map_problem>& probs,
+        std::vector<std::vector<unsigned long> >& map_assignments,
+        unsigned long num_threads,
+        unsigned long beam_width = 0
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(num_threads > 0,
+            "\t void find_max_factor_graph_viterbi_threaded()"
+            << "\n\t num_threads must be greater than 0"
+            );
 
-        map_assignment.resize(prob.number_of_nodes());
-        // Figure out which state of the last node has the biggest value. 
-        unsigned long back_index = 0;
-        double best_val = -std::numeric_limits<double>::infinity();
-        for (long i = 0; i < trellis.nc(); ++i)
+        map_assignments.resize(probs.size());
+        std::vector<char> failed(probs.size(), 0);
+        impl::viterbi_batch_helper<map_problem> helper(probs, map_assignments, beam_width, failed);
+        if (num_threads == 1)
         {
-            if (trellis[trellis.nr()-1][i].val > best_val)
-            {
-                best_val = trellis[trellis.nr()-1][i].val;
-                back_index = i;
-            }
+            for (unsigned long i = 0; i < probs.size(); ++i)
+                helper.decode(i);
         }
-        // Follow the back links to find the decoding.
-        for (long node = map_assignment.size()-1; node >= 0; --node)
+        else
         {
-            map_assignment[node] = back_index/init_ring_size;
-            back_index = trellis[node][back_index].back_index;
-            if (node < (long)order)
-                init_ring_size /= num_states;
-        }
+            parallel_for(num_threads, 0, probs.size(), helper, 1);
 
+            // Decode any sequence that threw in a worker thread again so that its
+            // exception comes out of this function with its original type.
+            for (unsigned long i = 0; i < probs.size(); ++i)
+            {
+                if (failed[i])
+                    helper.decode(i);
+            }
+        }
     }
 
 // ----------------------------------------------------------------------------------------
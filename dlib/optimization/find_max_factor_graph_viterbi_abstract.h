@@ -80,6 +80,30 @@ namespace dlib
                 - It is ok for this function to return a value of -std::numeric_limits<double>::infinity().
         !*/
 
+        void factor_values (
+            unsigned long node_id,
+            matrix<double>& values
+        ) const;
+        /*!
+            requires
+                - node_id < number_of_nodes()
+            ensures
+                - This function is optional.  If a map_problem defines it then the Viterbi
+                  routines call it once per node instead of calling factor_value() for
+                  each combination of states.  This is worth doing when a problem can
+                  compute all the factor values of a node at once much faster than one
+                  at a time, for instance with a few matrix operations.
+                - Let K == min(node_id, order())
+                - #values.nr() == num_states()
+                - #values.nc() == std::pow(num_states(), K)
+                - for all valid s and c:
+                    - #values(s,c) == factor_value(node_id, node_states), where
+                      node_states(0) == s and node_states(1) through node_states(K) are the
+                      digits of c written as a K digit base num_states() number with the
+                      most significant digit in node_states(1).  That is:
+                        c == node_states(1)*num_states()^(K-1) + ... + node_states(K)
+        !*/
+
     };
 
 // ----------------------------------------------------------------------------------------
@@ -119,6 +143,101 @@ namespace dlib
             - for all valid i:
                 - #map_assignment[i] < prob.num_states()
                 - #map_assignment[i] == The MAP assignment for node/variable i.
+            - If prob has a factor_values() member function then it is used to get the
+              factor values rather than factor_value().
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename map_problem
+        >
+    void find_max_factor_graph_viterbi_threaded (
+        const map_problem& prob,
+        std::vector<unsigned long>& map_assignment,
+        unsigned long num_threads
+    );
+    /*!
+        requires
+            - The requirements are the same as for find_max_factor_graph_viterbi(prob,map_assignment).
+            - num_threads > 0
+            - It must be safe to call prob.factor_value() from multiple threads at the
+              same time.
+        ensures
+            - Performs the same optimization as find_max_factor_graph_viterbi(prob,map_assignment)
+              and outputs exactly the same map_assignment.  However, the work at each node
+              is split over num_threads threads.  This is useful for problems with a large
+              number of states or a high order, where each node involves a lot of work.
+        throws
+            - Any exception thrown by prob propagates out of this function unchanged.
+              If it was thrown in one of the worker threads then the node being worked
+              on is filled in again by the calling thread so the exception can be
+              rethrown there.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename map_problem
+        >
+    void find_max_factor_graph_viterbi_threaded (
+        const std::vector<map_problem>& probs,
+        std::vector<std::vector<unsigned long> >& map_assignments,
+        unsigned long num_threads,
+        unsigned long beam_width = 0
+    );
+    /*!
+        requires
+            - for all valid i:
+                - probs[i] satisfies the requirements of find_max_factor_graph_viterbi().
+            - num_threads > 0
+            - It must be safe to use different elements of probs from different threads
+              at the same time.
+        ensures
+            - Solves each of the MAP problems in probs, with the different problems being
+              solved in parallel by num_threads threads.
+            - #map_assignments.size() == probs.size()
+            - for all valid i:
+                - if (beam_width == 0) then
+                    - #map_assignments[i] == the output of find_max_factor_graph_viterbi(probs[i], map_assignment)
+                - else
+                    - #map_assignments[i] == the output of find_max_factor_graph_viterbi_beam(probs[i], map_assignment, beam_width)
+        throws
+            - Any exception thrown by one of the problems propagates out of this
+              function unchanged.  When num_threads > 1 the problems whose decoding
+              threw are decoded a second time in the calling thread so that the
+              exception can be rethrown there.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename map_problem
+        >
+    void find_max_factor_graph_viterbi_beam (
+        const map_problem& prob,
+        std::vector<unsigned long>& map_assignment,
+        unsigned long beam_width
+    );
+    /*!
+        requires
+            - The requirements are the same as for find_max_factor_graph_viterbi(prob,map_assignment).
+            - beam_width > 0
+        ensures
+            - This function approximately solves the same optimization problem as 
+              find_max_factor_graph_viterbi().  It runs the Viterbi algorithm but only
+              keeps the beam_width best partial assignments at each node, rather than all
+              prob.num_states()^prob.order() of them.  So it looks at only
+              beam_width*prob.num_states() factor values per node (or calls
+              prob.factor_values() once per node if it exists) rather than
+              prob.num_states()^(prob.order()+1).  This makes it much faster when there
+              are a lot of states, but the assignment found might not be the best one.
+            - If beam_width >= std::pow(prob.num_states(), prob.order()) then nothing is
+              ever pruned and the assignment found has the same value as the output of
+              find_max_factor_graph_viterbi().
+            - #map_assignment.size() == prob.number_of_nodes()
+            - for all valid i:
+                - #map_assignment[i] < prob.num_states()
     !*/
 
 // ----------------------------------------------------------------------------------------
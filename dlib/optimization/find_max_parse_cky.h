@@ -8,7 +8,9 @@
 #include <string>
 #include <sstream>
 #include "../serialize.h" 
-#include "../array2d.h"
+#include "../threads.h"
+#include <limits>
+#include <algorithm>
 
 namespace dlib
 {
@@ -92,124 +94,400 @@ namespace dlib
         deserialize(item.score, in);
     }
 
+// -----------------------------------------------------------------------------------------
+
+    struct cky_parse_options
+    {
+        cky_parse_options (
+        ) :
+            num_threads(1),
+            beam_width(std::numeric_limits<unsigned long>::max()),
+            score_threshold(std::numeric_limits<double>::infinity())
+        {}
+
+        unsigned long num_threads;
+        unsigned long beam_width;
+        double score_threshold;
+    };
+
 // -----------------------------------------------------------------------------------------
 
     namespace impl
     {
+        template <typename T>
+        struct cky_chart_entry
+        {
+            T tag;
+            double score;
+            constituent<T> c;
+        };
+
+        template <typename T>
+        inline bool cky_tag_order (
+            const cky_chart_entry<T>& a,
+            const cky_chart_entry<T>& b
+        ) { return a.tag < b.tag; }
+
+        template <typename T>
+        class cky_chart
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is the CKY chart.  It holds a cell for each span [r, c] of the
+                    input.  All the entries are kept in one vector.  The cells are stored
+                    in it one after another, ordered by span length, so each cell is a
+                    run of entries sorted by tag.  The cells must be added with
+                    append_cell() in that same order.
+            !*/
+        public:
+            typedef cky_chart_entry<T> entry_type;
+
+            class cell_type
+            {
+            public:
+                cell_type (
+                    const entry_type* begin_,
+                    const entry_type* end_
+                ) : b(begin_), e(end_) {}
+
+                const entry_type* begin() const { return b; }
+                const entry_type* end() const { return e; }
+                unsigned long size() const { return e-b; }
+                const entry_type& operator[] (unsigned long i) const { return b[i]; }
+
+            private:
+                const entry_type* b;
+                const entry_type* e;
+            };
+
+            explicit cky_chart (
+                long n_
+            ) : n(n_) 
+            {
+                cell_starts.reserve(n*(n+1)/2 + 1);
+                cell_starts.push_back(0);
+            }
+
+            void append_cell (
+                const std::vector<entry_type>& cell
+            )
+            {
+                entries.insert(entries.end(), cell.begin(), cell.end());
+                cell_starts.push_back(entries.size());
+            }
+
+            cell_type operator() (
+                long r,
+                long c
+            ) const 
+            { 
+                const unsigned long i = offset(r,c);
+                DLIB_ASSERT(i+1 < cell_starts.size(), "\t cky_chart::operator(): cell " << r << "," << c << " hasn't been filled in");
+                const entry_type* base = entries.size() != 0 ? &entries[0] : 0;
+                return cell_type(base + cell_starts[i], base + cell_starts[i+1]);
+            }
+
+        private:
+            long offset (
+                long r,
+                long c
+            ) const
+            {
+                const long len = c-r;
+                return len*n - len*(len-1)/2 + r;
+            }
+
+            long n;
+            std::vector<entry_type> entries;
+            std::vector<unsigned long> cell_starts;
+        };
+
         template <typename T>
         unsigned long fill_parse_tree(
             std::vector<parse_tree_element<T> >& parse_tree, 
             const T& tag,
-            const array2d<std::map<T, parse_tree_element<T> > >& back, 
+            const cky_chart<T>& chart, 
             long r, long c
         )
         /*!
             requires
-                - back[r][c].size() == 0 || back[r][c].count(tag) != 0
+                - chart(r,c) contains an entry with the given tag
         !*/
         {
             // base case of the recursion 
-            if (back[r][c].size() == 0)
+            if (r == c)
             {
                 return END_OF_TREE;
             }
 
+            const typename cky_chart<T>::cell_type cell = chart(r,c);
+            cky_chart_entry<T> key;
+            key.tag = tag;
+            const cky_chart_entry<T>& entry = *std::lower_bound(cell.begin(), cell.end(), key, cky_tag_order<T>);
+
             const unsigned long idx = parse_tree.size();
-            const parse_tree_element<T>& item = back[r][c].find(tag)->second;
+            parse_tree_element<T> item;
+            item.c = entry.c;
+            item.tag = entry.tag;
+            item.score = entry.score;
             parse_tree.push_back(item);
 
             const long k = item.c.k;
-            const unsigned long idx_left  = fill_parse_tree(parse_tree, item.c.left_tag, back, r, k-1); 
-            const unsigned long idx_right = fill_parse_tree(parse_tree, item.c.right_tag, back, k, c); 
+            const unsigned long idx_left  = fill_parse_tree(parse_tree, item.c.left_tag, chart, r, k-1); 
+            const unsigned long idx_right = fill_parse_tree(parse_tree, item.c.right_tag, chart, k, c); 
             parse_tree[idx].left = idx_left;
             parse_tree[idx].right = idx_right;
             return idx;
         }
-    }
 
-    template <typename T, typename production_rule_function>
-    void find_max_parse_cky (
-        const std::vector<T>& sequence,
-        const production_rule_function& production_rules,
-        std::vector<parse_tree_element<T> >& parse_tree
-    )
-    {
-        parse_tree.clear();
-        if (sequence.size() == 0)
-            return;
+        template <typename T, typename production_rule_function>
+        class cky_chart_filler
+        {
+            /*!
+                This object fills in the chart one diagonal at a time.  The cells of a
+                diagonal only depend on cells spanning fewer words so they can be filled
+                in parallel.  Each cell is built in its own buffer, which is reused for
+                the following diagonals, and then the whole diagonal is copied into the
+                chart.
+            !*/
+        public:
+            cky_chart_filler (
+                const std::vector<T>& sequence_,
+                const production_rule_function& production_rules_,
+                const cky_parse_options& options_,
+                cky_chart<T>& chart_
+            ) : 
+                sequence(sequence_), 
+                production_rules(production_rules_), 
+                options(options_),
+                chart(chart_),
+                len(0),
+                cells(sequence_.size()),
+                failed(sequence_.size(), 0)
+            {}
+
+            void fill_diagonal (
+                thread_pool& tp,
+                long len_
+            )
+            {
+                len = len_;
+                const long num = sequence.size() - len;
+                std::vector<std::pair<T,double> > possible_tags;
+                std::vector<std::pair<double,long> > ranks;
+                if (tp.num_threads_in_pool() == 0)
+                {
+                    for (long r = 0; r < num; ++r)
+                        fill_cell(r, possible_tags, ranks);
+                }
+                else
+                {
+                    parallel_for_blocked(tp, 0, num, *this, &cky_chart_filler::fill_cells, 4);
 
-        array2d<std::map<T,double> > table(sequence.size(), sequence.size());
-        array2d<std::map<T,parse_tree_element<T> > > back(sequence.size(), sequence.size());
-        typedef typename std::map<T,double>::iterator itr;
-        typedef typename std::map<T,parse_tree_element<T> >::iterator itr_b;
+                    // If production_rules() threw inside the thread pool then the
+                    // exception was dropped there.  Build those cells again here so that
+                    // it reaches the caller of find_max_parse_cky().
+                    for (long r = 0; r < num; ++r)
+                    {
+                        if (failed[r])
+                        {
+                            fill_cell(r, possible_tags, ranks);
+                            failed[r] = 0;
+                        }
+                    }
+                }
 
-        for (long r = 0; r < table.nr(); ++r)
-            table[r][r][sequence[r]] = 0;
+                for (long r = 0; r < num; ++r)
+                    chart.append_cell(cells[r]);
+            }
 
-        std::vector<std::pair<T,double> > possible_tags;
+        private:
 
-        for (long r = table.nr()-2; r >= 0; --r)
-        {
-            for (long c = r+1; c < table.nc(); ++c)
+            static bool index_order (
+                const std::pair<double,long>& a,
+                const std::pair<double,long>& b
+            ) { return a.second < b.second; }
+
+            void fill_cells (
+                long begin,
+                long end
+            )
             {
+                std::vector<std::pair<T,double> > possible_tags;
+                std::vector<std::pair<double,long> > ranks;
+                for (long r = begin; r < end; ++r)
+                {
+                    try
+                    {
+                        fill_cell(r, possible_tags, ranks);
+                    }
+                    catch (...)
+                    {
+                        failed[r] = 1;
+                    }
+                }
+            }
+
+            void fill_cell (
+                long r,
+                std::vector<std::pair<T,double> >& possible_tags,
+                std::vector<std::pair<double,long> >& ranks
+            )
+            {
+                typedef typename std::vector<cky_chart_entry<T> >::iterator itr;
+                typedef const cky_chart_entry<T>* citr;
+
+                // The cell is kept sorted by tag while we build it, so it works like a
+                // std::map from tags to their best entry.
+                std::vector<cky_chart_entry<T> >& cell = cells[r];
+                cell.clear();
+                const long c = r + len;
+                cky_chart_entry<T> item;
                 for (long k = r; k < c; ++k)
                 {
-                    for (itr i = table[k+1][c].begin(); i != table[k+1][c].end(); ++i)
+                    const typename cky_chart<T>::cell_type left = chart(r,k);
+                    const typename cky_chart<T>::cell_type right = chart(k+1,c);
+                    for (citr i = right.begin(); i != right.end(); ++i)
                     {
-                        for (itr j = table[r][k].begin(); j != table[r][k].end(); ++j)
+                        for (citr j = left.begin(); j != left.end(); ++j)
                         {
                             constituent<T> con;
                             con.begin = r;
                             con.end = c+1;
                             con.k = k+1;
-                            con.left_tag = j->first;
-                            con.right_tag = i->first;
+                            con.left_tag = j->tag;
+                            con.right_tag = i->tag;
                             possible_tags.clear();
                             production_rules(sequence, con, possible_tags);
                             for (unsigned long m = 0; m < possible_tags.size(); ++m)
                             {
-                                const double score = possible_tags[m].second + i->second + j->second;
-                                itr match = table[r][c].find(possible_tags[m].first);
-                                if (match == table[r][c].end() || score > match->second)
+                                const double score = possible_tags[m].second + i->score + j->score;
+                                item.tag = possible_tags[m].first;
+                                itr match = std::lower_bound(cell.begin(), cell.end(), item, cky_tag_order<T>);
+                                if (match == cell.end() || item.tag < match->tag)
                                 {
-                                    table[r][c][possible_tags[m].first] = score;
-                                    parse_tree_element<T> item;
-                                    item.c = con;
                                     item.score = score;
-                                    item.tag = possible_tags[m].first;
-                                    item.left = END_OF_TREE;
-                                    item.right = END_OF_TREE;
-                                    back[r][c][possible_tags[m].first] = item;
+                                    item.c = con;
+                                    cell.insert(match, item);
+                                }
+                                else if (score > match->score)
+                                {
+                                    match->score = score;
+                                    match->c = con;
                                 }
                             }
                         }
                     }
                 }
+
+                if (cell.size() == 0)
+                    return;
+
+                // Find the entries which survive pruning.
+                double best_score = -std::numeric_limits<double>::infinity();
+                for (unsigned long i = 0; i < cell.size(); ++i)
+                    best_score = std::max(best_score, cell[i].score);
+                ranks.clear();
+                for (unsigned long i = 0; i < cell.size(); ++i)
+                {
+                    if (!(cell[i].score < best_score - options.score_threshold))
+                        ranks.push_back(std::make_pair(-cell[i].score, (long)i));
+                }
+                if (ranks.size() == cell.size() && ranks.size() <= options.beam_width)
+                    return;
+
+                if (ranks.size() > options.beam_width)
+                {
+                    std::partial_sort(ranks.begin(), ranks.begin()+options.beam_width, ranks.end());
+                    ranks.resize(options.beam_width);
+                    // put the survivors back in tag order
+                    std::sort(ranks.begin(), ranks.end(), index_order);
+                }
+
+                for (unsigned long i = 0; i < ranks.size(); ++i)
+                    cell[i] = cell[ranks[i].second];
+                cell.resize(ranks.size());
             }
+
+            const std::vector<T>& sequence;
+            const production_rule_function& production_rules;
+            const cky_parse_options& options;
+            cky_chart<T>& chart;
+            long len;
+            std::vector<std::vector<cky_chart_entry<T> > > cells;
+            std::vector<char> failed;
+        };
+    }
+
+    template <typename T, typename production_rule_function>
+    void find_max_parse_cky (
+        const std::vector<T>& sequence,
+        const production_rule_function& production_rules,
+        std::vector<parse_tree_element<T> >& parse_tree,
+        const cky_parse_options& options
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(options.num_threads > 0 && options.beam_width > 0 && options.score_threshold >= 0,
+            "\t void find_max_parse_cky()"
+            << "\n\t Invalid options were given to this function."
+            << "\n\t options.num_threads:     " << options.num_threads
+            << "\n\t options.beam_width:      " << options.beam_width
+            << "\n\t options.score_threshold: " << options.score_threshold
+            );
+
+        parse_tree.clear();
+        if (sequence.size() == 0)
+            return;
+
+        const long n = sequence.size();
+        impl::cky_chart<T> chart(n);
+
+        std::vector<impl::cky_chart_entry<T> > leaf(1);
+        for (long r = 0; r < n; ++r)
+        {
+            leaf[0].tag = sequence[r];
+            leaf[0].score = 0;
+            chart.append_cell(leaf);
         }
 
+        // Fill in the chart one diagonal at a time.  All the cells on a diagonal are
+        // independent of each other.
+        impl::cky_chart_filler<T,production_rule_function> filler(sequence, production_rules, options, chart);
+        thread_pool tp(options.num_threads > 1 ? options.num_threads : 0);
+        for (long len = 1; len < n; ++len)
+            filler.fill_diagonal(tp, len);
+
 
         // now use back pointers to build the parse trees
         const long r = 0;
-        const long c = back.nc()-1;
-        if (back[r][c].size() != 0)
+        const long c = n-1;
+        const typename impl::cky_chart<T>::cell_type root = chart(r,c);
+        if (c != 0 && root.size() != 0)
         {
-
-            // find the max scoring element in back[r][c]
-            itr_b max_i = back[r][c].begin();
-            itr_b i = max_i;
-            ++i;
-            for (; i != back[r][c].end(); ++i)
+            // find the max scoring element in the root cell
+            unsigned long max_i = 0;
+            for (unsigned long i = 1; i < root.size(); ++i)
             {
-                if (i->second.score > max_i->second.score)
+                if (root[i].score > root[max_i].score)
                     max_i = i;
             }
 
             parse_tree.reserve(c);
-            impl::fill_parse_tree(parse_tree, max_i->second.tag, back, r, c);
+            impl::fill_parse_tree(parse_tree, root[max_i].tag, chart, r, c);
         }
     }
 
+    template <typename T, typename production_rule_function>
+    void find_max_parse_cky (
+        const std::vector<T>& sequence,
+        const production_rule_function& production_rules,
+        std::vector<parse_tree_element<T> >& parse_tree
+    )
+    {
+        find_max_parse_cky(sequence, production_rules, parse_tree, cky_parse_options());
+    }
+
 // -----------------------------------------------------------------------------------------
 
     class parse_tree_to_string_error : public error
@@ -168,6 +168,44 @@ namespace dlib
               use with the find_max_parse_cky() routine defined below.
     !*/
 
+    struct cky_parse_options
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object controls how find_max_parse_cky() fills its chart.  The
+                fields have the following interpretations:
+                    - num_threads == the number of threads used to fill the chart.  The
+                      cells which span the same number of words don't depend on each
+                      other so they are filled in parallel.  The output of
+                      find_max_parse_cky() doesn't depend on num_threads.
+                    - beam_width == the maximum number of tags kept in each cell of the
+                      chart.  If a cell has more possible tags than this then only the
+                      beam_width highest scoring ones are kept.
+                    - score_threshold == a cell only keeps tags whose score is at least
+                      the score of the best tag in the cell minus score_threshold.
+
+                Pruning the cells with beam_width or score_threshold can make parsing
+                much faster with large grammars.  However, the parse tree found might
+                then not be the highest scoring one.
+        !*/
+
+        cky_parse_options(
+        );
+        /*!
+            ensures
+                - #num_threads == 1
+                - #beam_width == std::numeric_limits<unsigned long>::max()
+                - #score_threshold == std::numeric_limits<double>::infinity()
+                  (i.e. by default nothing is pruned)
+        !*/
+
+        unsigned long num_threads;
+        unsigned long beam_width;
+        double score_threshold;
+    };
+
+// -----------------------------------------------------------------------------------------
+
     template <
         typename T, 
         typename production_rule_function
@@ -175,13 +213,20 @@ namespace dlib
     void find_max_parse_cky (
         const std::vector<T>& words,
         const production_rule_function& production_rules,
-        std::vector<parse_tree_element<T> >& parse_tree
+        std::vector<parse_tree_element<T> >& parse_tree,
+        const cky_parse_options& options
     );
     /*!
         requires
             - production_rule_function == a function or function object with the same
               interface as example_production_rule_function defined above.
             - It must be possible to store T objects in a std::map.
+            - options.num_threads > 0
+            - options.beam_width > 0
+            - options.score_threshold >= 0
+            - if (options.num_threads > 1) then
+                - It must be safe to call production_rules() from multiple threads at
+                  the same time.
         ensures
             - Uses the CKY algorithm to find the most probable/highest scoring binary parse
               tree of the given vector of words.  
@@ -199,6 +244,34 @@ namespace dlib
             - This function uses production_rules() to find out what the allowed production
               rules are.  That is, production_rules() defines all properties of the grammar
               used by find_max_parse_cky(). 
+            - The chart is filled using options.num_threads threads and each chart cell is
+              pruned as described by options.  When nothing is pruned, #parse_tree is
+              exactly the same as the output of find_max_parse_cky(words, production_rules, parse_tree).
+        throws
+            - Any exception thrown by production_rules() propagates out of this function.
+              When a thread in the pool hits one, the chart cell it was working on is
+              built again in the calling thread and the exception is rethrown from
+              there.
+    !*/
+
+    template <
+        typename T, 
+        typename production_rule_function
+        >
+    void find_max_parse_cky (
+        const std::vector<T>& words,
+        const production_rule_function& production_rules,
+        std::vector<parse_tree_element<T> >& parse_tree
+    );
+    /*!
+        requires
+            - production_rule_function == a function or function object with the same
+              interface as example_production_rule_function defined above.
+            - It must be possible to store T objects in a std::map.
+        ensures
+            - invokes find_max_parse_cky(words, production_rules, parse_tree, cky_parse_options())
+              That is, finds the highest scoring parse tree using a single thread and
+              without any pruning.
     !*/
 
 // -----------------------------------------------------------------------------------------
@@ -0,0 +1,644 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_MAX_COST_ASSIgNMENT_SOLVER_H__
+#define DLIB_MAX_COST_ASSIgNMENT_SOLVER_H__
+
+#include "max_cost_assignment_solver_abstract.h"
+#include "../matrix.h"
+#include "../threads.h"
+#include "../graph_utils/ordered_sample_pair.h"
+#include <vector>
+#include <queue>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class max_cost_assignment_solver
+    {
+    public:
+
+        max_cost_assignment_solver (
+        ) :
+            num_threads(1),
+            auction(false),
+            auction_epsilon(0)
+        {}
+
+        void set_num_threads (
+            unsigned long num
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(num > 0,
+                "\t void max_cost_assignment_solver::set_num_threads()"
+                << "\n\t num must be greater than 0"
+                << "\n\t this: " << this
+                );
+            num_threads = num;
+        }
+
+        unsigned long get_num_threads (
+        ) const { return num_threads; }
+
+        void use_hungarian_algorithm (
+        ) { auction = false; }
+
+        void use_auction_algorithm (
+        ) { auction = true; }
+
+        bool uses_auction_algorithm (
+        ) const { return auction; }
+
+        void set_auction_epsilon (
+            double eps
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(eps >= 0,
+                "\t void max_cost_assignment_solver::set_auction_epsilon()"
+                << "\n\t eps can't be negative"
+                << "\n\t eps:  " << eps
+                << "\n\t this: " << this
+                );
+            auction_epsilon = eps;
+        }
+
+        double get_auction_epsilon (
+        ) const { return auction_epsilon; }
+
+        template <typename EXP>
+        void operator() (
+            const matrix_exp<EXP>& cost,
+            std::vector<long>& assignment
+        )
+        {
+            const long nr = cost.nr();
+            const long nc = cost.nc();
+            assignment.assign(nr, -1);
+            if (nr == 0 || nc == 0)
+                return;
+
+            // Copy the costs into our workspace such that there are no more rows than
+            // columns.
+            const bool transposed = nr > nc;
+            if (!transposed)
+            {
+                c.set_size(nr, nc);
+                for (long r = 0; r < nr; ++r)
+                {
+                    for (long k = 0; k < nc; ++k)
+                        c(r,k) = static_cast<double>(cost(r,k));
+                }
+            }
+            else
+            {
+                c.set_size(nc, nr);
+                for (long r = 0; r < nr; ++r)
+                {
+                    for (long k = 0; k < nc; ++k)
+                        c(k,r) = static_cast<double>(cost(r,k));
+                }
+            }
+
+            if (auction)
+                solve_auction(std::numeric_limits<typename EXP::type>::is_integer);
+            else
+                solve_hungarian();
+
+            for (unsigned long r = 0; r < row_match.size(); ++r)
+            {
+                if (transposed)
+                    assignment[row_match[r]] = r;
+                else
+                    assignment[r] = row_match[r];
+            }
+        }
+
+        void operator() (
+            const std::vector<ordered_sample_pair>& edges,
+            std::vector<long>& assignment
+        )
+        {
+            unsigned long num_rows = 0;
+            unsigned long num_cols = 0;
+            for (unsigned long i = 0; i < edges.size(); ++i)
+            {
+                num_rows = std::max(num_rows, edges[i].index1()+1);
+                num_cols = std::max(num_cols, edges[i].index2()+1);
+            }
+            assignment.assign(num_rows, -1);
+            if (num_rows == 0)
+                return;
+
+            solve_sparse(edges, num_rows, num_cols);
+
+            for (unsigned long r = 0; r < num_rows; ++r)
+            {
+                if (row_match[r] < (long)num_cols)
+                    assignment[r] = row_match[r];
+            }
+        }
+
+    private:
+
+        void process_bid (
+            long k
+        )
+        /*!
+            ensures
+                - computes the bid of the k-th unassigned row in the current auction round.
+        !*/
+        {
+            const long r = unassigned[k];
+            const long n = c.nc();
+            const double* row = &c(r,0);
+            double best = -std::numeric_limits<double>::infinity();
+            double second = -std::numeric_limits<double>::infinity();
+            long best_col = 0;
+            for (long j = 0; j < n; ++j)
+            {
+                const double val = row[j] - prices[j];
+                if (val > best)
+                {
+                    second = best;
+                    best = val;
+                    best_col = j;
+                }
+                else if (val > second)
+                {
+                    second = val;
+                }
+            }
+            bid_col[k] = best_col;
+            bid_value[k] = prices[best_col] + (best - second) + eps;
+        }
+
+        void solve_hungarian (
+        )
+        /*!
+            requires
+                - c.nr() <= c.nc()
+            ensures
+                - #row_match[r] == the column assigned to row r in an assignment which
+                  maximizes the sum of c(r,row_match[r]).
+        !*/
+        {
+            /*
+                This is the shortest augmenting path version of the Hungarian algorithm.
+                The rows are added to the matching one at a time.  Each time we run
+                Dijkstra's algorithm, using the dual variables u and v to keep the edge
+                costs non-negative, to find the cheapest way to fit the new row in.  This
+                takes O(nr*nr*nc) time but its correctness never depends on floating
+                point numbers comparing equal, so unlike max_cost_assignment() it works
+                with any kind of cost.
+
+                The arrays are 1 based.  Column 0 is a virtual column that holds the row
+                being added.
+            */
+            const long n = c.nr();
+            const long m = c.nc();
+            const double inf = std::numeric_limits<double>::infinity();
+
+            u.assign(n+1, 0);
+            v.assign(m+1, 0);
+            col_to_row.assign(m+1, 0);
+            way.assign(m+1, 0);
+
+            // Start with a row reduction.  Setting u[i] to the cheapest edge of row i
+            // keeps the duals feasible and leaves every v[j] at 0, as required when
+            // there are more columns than rows.  Each row whose cheapest column is
+            // still free is matched to it right away, so only the remaining rows need
+            // the Dijkstra search below.
+            row_match.assign(n, -1);
+            for (long i = 1; i <= n; ++i)
+            {
+                const double* row = &c(i-1,0);
+                double best = inf;
+                long best_j = 1;
+                for (long j = 1; j <= m; ++j)
+                {
+                    if (-row[j-1] < best || (-row[j-1] == best && col_to_row[j] == 0))
+                    {
+                        best = -row[j-1];
+                        best_j = j;
+                    }
+                }
+                u[i] = best;
+                if (col_to_row[best_j] == 0)
+                {
+                    col_to_row[best_j] = i;
+                    row_match[i-1] = best_j-1;
+                }
+            }
+
+            for (long i = 1; i <= n; ++i)
+            {
+                if (row_match[i-1] != -1)
+                    continue;
+
+                // Run Dijkstra's algorithm from row i.  minv[j] is the length of the
+                // shortest path to column j found so far.  Rather than updating the dual
+                // variables after each step we do it once the search reaches a free
+                // column, the same way solve_sparse() does.
+                col_to_row[0] = i;
+                minv.assign(m+1, inf);
+                used.assign(m+1, 0);
+                reached.resize(m+1);
+                popped.clear();
+                long j0 = 0;
+                double dist0 = 0;
+                for (;;)
+                {
+                    const long i0 = col_to_row[j0];
+                    const double* row = &c(i0-1,0);
+                    const double base = dist0 - u[i0];
+                    double delta = inf;
+                    long j1 = 0;
+                    for (long j = 1; j <= m; ++j)
+                    {
+                        if (!used[j])
+                        {
+                            // We are maximizing so the cost of an edge is -c.
+                            const double cur = base - row[j-1] - v[j];
+                            if (cur < minv[j])
+                            {
+                                minv[j] = cur;
+                                way[j] = j0;
+                                reached[j] = popped.size();
+                            }
+                            // When several columns are equally close, pick a free one
+                            // since that ends the search, or else the one reached
+                            // first.  Going through ties in this breadth first order
+                            // keeps the paths short, which matters a lot when many
+                            // costs are equal.  This only breaks ties, so the result
+                            // doesn't depend on the comparison.
+                            if (minv[j] < delta || (minv[j] == delta && col_to_row[j1] != 0 &&
+                                                    (col_to_row[j] == 0 || reached[j] < reached[j1])))
+                            {
+                                delta = minv[j];
+                                j1 = j;
+                            }
+                        }
+                    }
+
+                    j0 = j1;
+                    dist0 = delta;
+                    used[j0] = 1;
+                    if (col_to_row[j0] == 0)
+                        break;
+                    popped.push_back(j0);
+                }
+
+                // Update the dual variables.  This keeps all the reduced costs
+                // non-negative and makes the ones on the shortest path 0.
+                u[i] += dist0;
+                for (unsigned long k = 0; k < popped.size(); ++k)
+                {
+                    const long j = popped[k];
+                    u[col_to_row[j]] += dist0 - minv[j];
+                    v[j] -= dist0 - minv[j];
+                }
+
+                // flip the edges along the augmenting path
+                do
+                {
+                    const long j1 = way[j0];
+                    col_to_row[j0] = col_to_row[j1];
+                    j0 = j1;
+                } while (j0 != 0);
+            }
+
+            row_match.assign(n, -1);
+            for (long j = 1; j <= m; ++j)
+            {
+                if (col_to_row[j] != 0)
+                    row_match[col_to_row[j]-1] = j-1;
+            }
+        }
+
+        void solve_auction (
+            const bool integer_costs
+        )
+        /*!
+            requires
+                - c.nr() <= c.nc()
+            ensures
+                - #row_match[r] == the column assigned to row r by the auction algorithm.
+        !*/
+        {
+            /*
+                This is the auction algorithm from the paper The auction algorithm: A
+                distributed relaxation method for the assignment problem by Dimitri P.
+                Bertsekas, with epsilon scaling.  We use the Jacobi version, where all the
+                unassigned rows bid at the same time, since it lets us compute the bids in
+                parallel.  The bids are then resolved in row order, so the result doesn't
+                depend on the number of threads.
+
+                If there are fewer rows than columns we add rows which have 0 benefit for
+                every column so that the problem is square.
+            */
+            const long nr = c.nr();
+            const long n = c.nc();
+            if (nr < n)
+            {
+                // Add the extra rows.  set_size() would lose the contents of c so we
+                // build the new matrix in temp.
+                temp.set_size(n, n);
+                set_subm(temp, 0, 0, nr, n) = c;
+                set_subm(temp, nr, 0, n-nr, n) = 0;
+                temp.swap(c);
+            }
+
+            row_match.assign(n, -1);
+            col_to_row.assign(n, -1);
+            prices.assign(n, 0);
+            if (n == 1)
+            {
+                row_match[0] = 0;
+                row_match.resize(nr);
+                return;
+            }
+
+            const double range = max(c) - min(c);
+            double final_eps = auction_epsilon;
+            if (final_eps == 0)
+            {
+                // With integer costs any assignment within n*eps of the best is the best
+                // once eps < 1/n.
+                if (integer_costs)
+                    final_eps = 1.0/(n+1);
+                else
+                    final_eps = std::max(range, 1.0)*1e-9/n;
+            }
+            eps = std::max(range/2, final_eps);
+
+            thread_pool tp(num_threads > 1 ? num_threads : 0);
+            while (true)
+            {
+                row_match.assign(n, -1);
+                col_to_row.assign(n, -1);
+                unassigned.resize(n);
+                for (long r = 0; r < n; ++r)
+                    unassigned[r] = r;
+
+                while (unassigned.size() != 0)
+                {
+                    bid_col.resize(unassigned.size());
+                    bid_value.resize(unassigned.size());
+                    if (unassigned.size() < 64 || num_threads <= 1)
+                    {
+                        for (unsigned long k = 0; k < unassigned.size(); ++k)
+                            process_bid(k);
+                    }
+                    else
+                    {
+                        parallel_for(tp, 0, unassigned.size(), *this, &max_cost_assignment_solver::process_bid, 4);
+                    }
+
+                    // Find the winning bid for each column.
+                    winners.clear();
+                    for (unsigned long k = 0; k < unassigned.size(); ++k)
+                    {
+                        const long j = bid_col[k];
+                        const long w = col_to_row[j];
+                        // col_to_row holds -2-k for a column with a pending bid from the
+                        // k-th bidder.
+                        if (w > -2)
+                        {
+                            winners.push_back(j);
+                            col_to_row[j] = -2-(long)k;
+                            old_owner.push_back(w);
+                        }
+                        else if (bid_value[k] > bid_value[-2-w])
+                        {
+                            col_to_row[j] = -2-(long)k;
+                        }
+                    }
+
+                    next_unassigned.clear();
+                    for (unsigned long i = 0; i < winners.size(); ++i)
+                    {
+                        const long j = winners[i];
+                        const long k = -2-col_to_row[j];
+                        const long r = unassigned[k];
+                        if (old_owner[i] >= 0)
+                        {
+                            row_match[old_owner[i]] = -1;
+                            next_unassigned.push_back(old_owner[i]);
+                        }
+                        row_match[r] = j;
+                        col_to_row[j] = r;
+                        prices[j] = bid_value[k];
+                    }
+                    old_owner.clear();
+                    for (unsigned long k = 0; k < unassigned.size(); ++k)
+                    {
+                        if (row_match[unassigned[k]] == -1)
+                            next_unassigned.push_back(unassigned[k]);
+                    }
+                    unassigned.swap(next_unassigned);
+                }
+
+                if (eps <= final_eps)
+                    break;
+                eps = std::max(eps/4, final_eps);
+            }
+
+            row_match.resize(nr);
+        }
+
+        void solve_sparse (
+            const std::vector<ordered_sample_pair>& edges,
+            const unsigned long num_rows,
+            const unsigned long num_cols
+        )
+        {
+            /*
+                We find a maximum cost matching using the successive shortest path
+                algorithm.  To allow rows to be left unassigned each row r also gets a
+                private column num_cols+r with a cost of 0.  Then, just like in
+                solve_hungarian(), rows are added to the matching one at a time using
+                Dijkstra's algorithm with dual variables keeping the edge costs
+                non-negative.  Only the given edges are ever looked at so this takes
+                O(num_rows*edges.size()*log(num_rows+num_cols)) time in the worst case and
+                is usually much faster.
+            */
+            const unsigned long total_cols = num_cols + num_rows;
+            const double inf = std::numeric_limits<double>::infinity();
+
+            // Build the adjacency lists of the rows in compressed sparse row form.  We
+            // store the costs negated since we are minimizing.
+            offsets.assign(num_rows+1, 0);
+            for (unsigned long i = 0; i < edges.size(); ++i)
+                ++offsets[edges[i].index1()+1];
+            for (unsigned long r = 0; r < num_rows; ++r)
+                offsets[r+1] += offsets[r] + 1;
+            adj_cols.resize(edges.size()+num_rows);
+            adj_costs.resize(edges.size()+num_rows);
+            pos.assign(offsets.begin(), offsets.end()-1);
+            for (unsigned long i = 0; i < edges.size(); ++i)
+            {
+                const unsigned long r = edges[i].index1();
+                adj_cols[pos[r]] = edges[i].index2();
+                adj_costs[pos[r]] = -edges[i].distance();
+                ++pos[r];
+            }
+            u.assign(num_rows, 0);
+            for (unsigned long r = 0; r < num_rows; ++r)
+            {
+                adj_cols[pos[r]] = num_cols + r;
+                adj_costs[pos[r]] = 0;
+
+                // Initial dual variables which make all the reduced costs non-negative.
+                double min_cost = 0;
+                for (unsigned long e = offsets[r]; e < offsets[r+1]; ++e)
+                    min_cost = std::min(min_cost, adj_costs[e]);
+                u[r] = min_cost;
+            }
+
+            v.assign(total_cols, 0);
+            minv.assign(total_cols, inf);
+            used.assign(total_cols, 0);
+            way.assign(total_cols, 0);
+            col_to_row.assign(total_cols, -1);
+            row_match.assign(num_rows, -1);
+            row_dist.assign(num_rows, 0);
+
+            typedef std::pair<double,unsigned long> heap_item;
+            std::priority_queue<heap_item, std::vector<heap_item>, std::greater<heap_item> > heap;
+            for (unsigned long s = 0; s < num_rows; ++s)
+            {
+                touched.clear();
+                popped.clear();
+                visited_rows.clear();
+
+                visited_rows.push_back(s);
+                row_dist[s] = 0;
+                relax_row(s, 0, heap);
+
+                long target = -1;
+                double dist_target = 0;
+                while (heap.size() != 0)
+                {
+                    const heap_item item = heap.top();
+                    heap.pop();
+                    const unsigned long j = item.second;
+                    if (used[j] || item.first > minv[j])
+                        continue;
+                    used[j] = 1;
+                    popped.push_back(j);
+                    if (col_to_row[j] == -1)
+                    {
+                        target = j;
+                        dist_target = item.first;
+                        break;
+                    }
+                    const unsigned long r = col_to_row[j];
+                    row_dist[r] = item.first;
+                    visited_rows.push_back(r);
+                    relax_row(r, item.first, heap);
+                }
+                while (heap.size() != 0)
+                    heap.pop();
+
+                // Update the dual variables.  This keeps all the reduced costs
+                // non-negative and makes the ones on the shortest path 0.
+                for (unsigned long i = 0; i < popped.size(); ++i)
+                    v[popped[i]] += minv[popped[i]] - dist_target;
+                for (unsigned long i = 0; i < visited_rows.size(); ++i)
+                    u[visited_rows[i]] += dist_target - row_dist[visited_rows[i]];
+
+                // Flip the edges along the augmenting path.  There is always a path since
+                // s's private column is free.
+                for (long j = target; ; )
+                {
+                    const long r = way[j];
+                    const long next = row_match[r];
+                    row_match[r] = j;
+                    col_to_row[j] = r;
+                    if (r == (long)s)
+                        break;
+                    j = next;
+                }
+
+                for (unsigned long i = 0; i < touched.size(); ++i)
+                {
+                    minv[touched[i]] = inf;
+                    used[touched[i]] = 0;
+                }
+            }
+        }
+
+        template <typename heap_type>
+        void relax_row (
+            const unsigned long r,
+            const double dist,
+            heap_type& heap
+        )
+        {
+            for (unsigned long e = offsets[r]; e < offsets[r+1]; ++e)
+            {
+                const unsigned long j = adj_cols[e];
+                if (used[j])
+                    continue;
+                // The reduced cost is never negative except for rounding error.
+                const double d = dist + std::max(0.0, adj_costs[e] - u[r] - v[j]);
+                if (d < minv[j])
+                {
+                    if (minv[j] == std::numeric_limits<double>::infinity())
+                        touched.push_back(j);
+                    minv[j] = d;
+                    way[j] = r;
+                    heap.push(std::make_pair(d, j));
+                }
+            }
+        }
+
+        unsigned long num_threads;
+        bool auction;
+        double auction_epsilon;
+
+        // workspace shared by the different solvers
+        matrix<double> c;
+        matrix<double> temp;
+        std::vector<double> u;
+        std::vector<double> v;
+        std::vector<double> minv;
+        std::vector<char> used;
+        std::vector<long> way;
+        std::vector<long> col_to_row;
+        std::vector<long> row_match;
+        std::vector<unsigned long> popped;
+        std::vector<unsigned long> reached;
+
+        // workspace for the auction algorithm
+        double eps;
+        std::vector<double> prices;
+        std::vector<long> unassigned;
+        std::vector<long> next_unassigned;
+        std::vector<long> bid_col;
+        std::vector<double> bid_value;
+        std::vector<long> winners;
+        std::vector<long> old_owner;
+
+        // workspace for the sparse solver
+        std::vector<unsigned long> offsets;
+        std::vector<unsigned long> pos;
+        std::vector<unsigned long> adj_cols;
+        std::vector<double> adj_costs;
+        std::vector<double> row_dist;
+        std::vector<unsigned long> touched;
+        std::vector<unsigned long> visited_rows;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_MAX_COST_ASSIgNMENT_SOLVER_H__
+
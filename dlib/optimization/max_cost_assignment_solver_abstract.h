@@ -0,0 +1,188 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_MAX_COST_ASSIgNMENT_SOLVER_ABSTRACT_H__
+#ifdef DLIB_MAX_COST_ASSIgNMENT_SOLVER_ABSTRACT_H__
+
+#include "../matrix.h"
+#include "../graph_utils/ordered_sample_pair_abstract.h"
+#include <vector>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class max_cost_assignment_solver
+    {
+        /*!
+            INITIAL VALUE
+                - get_num_threads() == 1
+                - uses_auction_algorithm() == false
+                - get_auction_epsilon() == 0
+
+            WHAT THIS OBJECT REPRESENTS
+                This object is a tool for solving assignment problems.  It is a more
+                general version of the max_cost_assignment() routine.  In particular, it
+                can solve problems where:
+                    - the costs are floating point numbers,
+                    - the cost matrix isn't square, or
+                    - only some of the row/column pairs are allowed and so the costs are
+                      given as a sparse list of edges.
+
+                It also keeps its working memory between calls.  So if you need to solve
+                many assignment problems it is faster to reuse a single
+                max_cost_assignment_solver than to create a new one each time.
+
+                By default the dense problems are solved with the O(N*N*M) shortest
+                augmenting path version of the Hungarian algorithm.  Alternatively, the
+                auction algorithm can be used, which computes its bids with multiple
+                threads.
+
+            THREAD SAFETY
+                It is not safe to use a single instance of this object from multiple
+                threads at the same time.
+        !*/
+
+    public:
+
+        max_cost_assignment_solver (
+        );
+        /*!
+            ensures
+                - this object is properly initialized
+        !*/
+
+        void set_num_threads (
+            unsigned long num
+        );
+        /*!
+            requires
+                - num > 0
+            ensures
+                - #get_num_threads() == num
+        !*/
+
+        unsigned long get_num_threads (
+        ) const;
+        /*!
+            ensures
+                - returns the number of threads used by the auction algorithm.  The
+                  results of this object don't depend on this number, only the speed.
+        !*/
+
+        void use_hungarian_algorithm (
+        );
+        /*!
+            ensures
+                - #uses_auction_algorithm() == false
+        !*/
+
+        void use_auction_algorithm (
+        );
+        /*!
+            ensures
+                - #uses_auction_algorithm() == true
+        !*/
+
+        bool uses_auction_algorithm (
+        ) const;
+        /*!
+            ensures
+                - returns true if dense problems are solved using the Jacobi auction
+                  algorithm with epsilon scaling from the paper:
+                    The auction algorithm: A distributed relaxation method for the
+                    assignment problem by Dimitri P. Bertsekas
+                  The bids of the rows are computed in parallel with get_num_threads()
+                  threads.  This is usually faster than the Hungarian algorithm on large
+                  dense problems, especially when several threads are available.
+                - returns false if dense problems are solved using the Hungarian
+                  algorithm.
+        !*/
+
+        void set_auction_epsilon (
+            double eps
+        );
+        /*!
+            requires
+                - eps >= 0
+            ensures
+                - #get_auction_epsilon() == eps
+        !*/
+
+        double get_auction_epsilon (
+        ) const;
+        /*!
+            ensures
+                - returns the final epsilon used by the auction algorithm.  The assignment
+                  found by the auction algorithm has a cost within N*get_auction_epsilon()
+                  of the optimal cost, where N is the larger dimension of the cost matrix.
+                - If get_auction_epsilon() == 0 then it is picked automatically.  For
+                  integer costs it is set to 1/(N+1), which makes the auction algorithm
+                  find an optimal assignment.  For floating point costs it is set to
+                  1e-9*(max(cost)-min(cost))/N.
+        !*/
+
+        template <typename EXP>
+        void operator() (
+            const matrix_exp<EXP>& cost,
+            std::vector<long>& assignment
+        );
+        /*!
+            requires
+                - EXP::type == a built in integer or floating point type.
+            ensures
+                - Interprets cost(i,j) as the cost of assigning row i to column j and
+                  finds the assignment with the largest total cost subject to each row
+                  being assigned to at most one column and each column being assigned to
+                  at most one row.  Every row is assigned to a column when there are at
+                  least as many columns as rows.  Otherwise every column is assigned to a
+                  row.
+                - #assignment.size() == cost.nr()
+                - for all valid i:
+                    - if (row i is assigned to a column) then
+                        - #assignment[i] == the column row i is assigned to.
+                    - else
+                        - #assignment[i] == -1
+                - When cost is square and contains integers the assignment found by the
+                  Hungarian algorithm is as good as the one found by
+                  max_cost_assignment(cost).
+                - Rectangular matrices are solved directly rather than by padding them
+                  with zeros.  So the Hungarian algorithm takes O(N*N*M) time where N and
+                  M are the smaller and larger dimensions of the cost matrix.
+        !*/
+
+        void operator() (
+            const std::vector<ordered_sample_pair>& edges,
+            std::vector<long>& assignment
+        );
+        /*!
+            ensures
+                - Interprets each element of edges as a possible assignment of row
+                  edges[i].index1() to column edges[i].index2() with a cost of
+                  edges[i].distance().  Row/column pairs which don't appear in edges can't
+                  be assigned to each other.
+                - Finds the assignment with the largest total cost subject to each row
+                  being assigned to at most one column and each column being assigned to
+                  at most one row.  Rows don't have to be assigned at all.  So a row is
+                  only assigned to a column when that increases the total cost.
+                - #assignment.size() == 1 + the largest index1() value in edges (or 0 if
+                  edges is empty)
+                - for all valid i:
+                    - if (row i is assigned to a column) then
+                        - #assignment[i] == the column row i is assigned to.
+                    - else
+                        - #assignment[i] == -1
+                - This function uses the successive shortest path algorithm with a binary
+                  heap and only ever looks at the given edges.  So it is much faster than
+                  the dense solvers when each row has only a few allowed columns.
+                - This function always uses a single thread.
+        !*/
+
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_MAX_COST_ASSIgNMENT_SOLVER_ABSTRACT_H__
+
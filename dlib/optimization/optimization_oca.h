@@ -9,6 +9,8 @@
 #include "optimization_solve_qp_using_smo.h"
 #include <vector>
 #include "../sequence.h"
+#include "../threads.h"
+#include "../smart_pointers.h"
 
 // ----------------------------------------------------------------------------------------
 
@@ -61,6 +63,7 @@ namespace dlib
             sub_max_iter = 50000;
 
             inactive_thresh = 20;
+            num_threads = 1;
         }
 
         void set_subproblem_epsilon (
@@ -106,6 +109,13 @@ namespace dlib
         unsigned long get_inactive_plane_threshold (
         ) const { return inactive_thresh; }
 
+        void set_num_threads (
+            unsigned long num_threads_
+        ) { num_threads = num_threads_; }
+
+        unsigned long get_num_threads (
+        ) const { return num_threads; }
+
         template <
             typename matrix_type
             >
@@ -139,10 +149,15 @@ namespace dlib
 
             const scalar_type C = problem.get_c();
 
-            typename sequence<vect_type>::kernel_2a planes;
+            // The cutting planes are stored as the rows of planes and K holds their Gram
+            // matrix.  Only the first num_planes rows (and columns of K) are in use.  The
+            // rest is spare capacity so adding a plane doesn't require copying
+            // everything.
+            matrix<scalar_type,0,0,mem_manager_type,row_major_layout> planes, K;
+            long num_planes = 0;
             std::vector<scalar_type> bs, miss_count;
 
-            vect_type new_plane, alpha;
+            vect_type new_plane, alpha, krow;
 
             w.set_size(num_dims, 1);
             w = 0;
@@ -155,7 +170,10 @@ namespace dlib
             // a lower bound on the true optimal objective value.
             scalar_type cp_obj = 0;
 
-            matrix<scalar_type,0,0,mem_manager_type, layout_type> K, Ktmp;
+            // Only make threads if we are going to use them.
+            scoped_ptr<thread_pool> tp;
+            if (num_threads > 1)
+                tp.reset(new thread_pool(num_threads));
 
             scalar_type R_lower_bound;
             if (problem.risk_has_lower_bound(R_lower_bound))
@@ -164,11 +182,10 @@ namespace dlib
                 // what it is.
                 bs.push_back(R_lower_bound);
                 new_plane = zeros_matrix(w);
-                planes.add(0, new_plane);
+                add_plane(planes, K, num_planes, new_plane);
                 alpha = uniform_matrix<scalar_type>(1,1, C);
                 miss_count.push_back(0);
 
-                K.set_size(1,1);
                 K(0,0) = 0;
             }
 
@@ -197,7 +214,7 @@ namespace dlib
                 }
 
                 bs.push_back(cur_risk - dot(w,new_plane));
-                planes.add(planes.size(), new_plane);
+                add_plane(planes, K, num_planes, new_plane);
                 miss_count.push_back(0);
 
                 // If alpha is empty then initialize it (we must always have sum(alpha) == C).  
@@ -213,22 +230,31 @@ namespace dlib
                 // report current status
                 const scalar_type risk_gap = cur_risk - (cp_obj-wnorm)/C;
                 if (counter > 0 && problem.optimization_status(cur_obj, cur_obj - cp_obj, 
-                                                               cur_risk, risk_gap, planes.size(), counter))
+                                                               cur_risk, risk_gap, num_planes, counter))
                 {
                     break;
                 }
 
-                // compute kernel matrix for all the planes
-                K.swap(Ktmp);
-                K.set_size(planes.size(), planes.size());
-                // copy over the old K matrix
-                set_subm(K, 0,0, Ktmp.nr(), Ktmp.nc()) = Ktmp;
-
-                // now add the new row and column to K
-                for (unsigned long c = 0; c < planes.size(); ++c)
+                // Add the new row and column to K.  The rest of K is unchanged from the
+                // last iteration so this is the only part of the Gram matrix we need to
+                // compute.
+                const long last = num_planes-1;
+                krow.set_size(num_planes,1);
+                // Only bother with threads if there is enough work to be worth it.
+                if (tp && num_planes*(double)num_dims > 100000)
                 {
-                    K(c, Ktmp.nc()) = dot(planes[c], planes[planes.size()-1]);
-                    K(Ktmp.nc(), c) = K(c,Ktmp.nc());
+                    gram_row_updater<matrix<scalar_type,0,0,mem_manager_type,row_major_layout>,vect_type> 
+                        updater(planes, new_plane, krow);
+                    parallel_for_blocked(*tp, 0, num_planes, updater);
+                }
+                else
+                {
+                    krow = subm(planes, 0, 0, num_planes, num_dims)*new_plane;
+                }
+                for (long c = 0; c < num_planes; ++c)
+                {
+                    K(c, last) = krow(c);
+                    K(last, c) = krow(c);
                 }
 
 
@@ -242,22 +268,17 @@ namespace dlib
                 // iteration as the starting point.
                 if (num_nonnegative != 0)
                 {
-                    // copy planes into a matrix so we can call solve_qp4_using_smo()
-                    matrix<scalar_type,0,0,mem_manager_type, layout_type> planes_mat(num_nonnegative,planes.size());
-                    for (unsigned long i = 0; i < planes.size(); ++i)
-                        set_colm(planes_mat,i) = colm(planes[i],0,num_nonnegative);
-
-                    solve_qp4_using_smo(planes_mat, K, mat(bs), alpha, eps, sub_max_iter); 
+                    solve_qp4_using_smo(trans(subm(planes, 0, 0, num_planes, num_nonnegative)), 
+                                        subm(K, 0, 0, num_planes, num_planes), 
+                                        mat(bs), alpha, eps, sub_max_iter); 
                 }
                 else
                 {
-                    solve_qp_using_smo(K, mat(bs), alpha, eps, sub_max_iter); 
+                    solve_qp_using_smo(subm(K, 0, 0, num_planes, num_planes), mat(bs), alpha, eps, sub_max_iter); 
                 }
 
                 // construct the w that minimized the subproblem.
-                w = -alpha(0)*planes[0];
-                for (unsigned long i = 1; i < planes.size(); ++i)
-                    w -= alpha(i)*planes[i];
+                w = -trans(subm(planes, 0, 0, num_planes, num_dims))*alpha;
                 // threshold the first num_nonnegative w elements if necessary.
                 if (num_nonnegative != 0)
                     set_rowm(w,range(0,num_nonnegative-1)) = lowerbound(rowm(w,range(0,num_nonnegative-1)),0);
@@ -276,15 +297,13 @@ namespace dlib
 
 
                 // If it has been a while since a cutting plane was an active constraint then
-                // we should throw it away.
-                while (max(mat(miss_count)) >= inactive_thresh)
+                // we should throw it away.  We do this by moving the last plane into its
+                // slot, which only takes O(num_planes) work to patch up K.  Going backwards
+                // means the plane we move into slot i has already been checked.
+                for (long i = num_planes-1; i >= 0; --i)
                 {
-                    const long idx = index_of_max(mat(miss_count));
-                    bs.erase(bs.begin()+idx);
-                    miss_count.erase(miss_count.begin()+idx);
-                    K = removerc(K, idx, idx);
-                    alpha = remove_row(alpha,idx);
-                    planes.remove(idx, new_plane);
+                    if (miss_count[i] >= inactive_thresh)
+                        remove_plane(planes, K, num_planes, bs, miss_count, alpha, i);
                 }
 
                 ++counter;
@@ -298,11 +317,94 @@ namespace dlib
 
     private:
 
+        template <typename store_type, typename vect_type>
+        struct gram_row_updater
+        {
+            gram_row_updater (
+                const store_type& planes_,
+                const vect_type& new_plane_,
+                vect_type& krow_
+            ) : planes(planes_), new_plane(new_plane_), krow(krow_) {}
+
+            void operator() (
+                long begin,
+                long end
+            ) const
+            {
+                set_rowm(krow, range(begin,end-1)) = rowm(planes, range(begin,end-1))*new_plane;
+            }
+
+            const store_type& planes;
+            const vect_type& new_plane;
+            vect_type& krow;
+        };
+
+        template <typename store_type, typename vect_type>
+        static void add_plane (
+            store_type& planes,
+            store_type& K,
+            long& num_planes,
+            const vect_type& new_plane
+        )
+        {
+            // grow the storage geometrically if it is full
+            if (num_planes == planes.nr())
+            {
+                const long new_size = std::max<long>(16, 2*planes.nr());
+                store_type temp(new_size, new_plane.size());
+                if (num_planes != 0)
+                    set_subm(temp, 0, 0, num_planes, temp.nc()) = subm(planes, 0, 0, num_planes, planes.nc());
+                temp.swap(planes);
+
+                temp.set_size(new_size, new_size);
+                if (num_planes != 0)
+                    set_subm(temp, 0, 0, num_planes, num_planes) = subm(K, 0, 0, num_planes, num_planes);
+                temp.swap(K);
+            }
+
+            set_rowm(planes, num_planes) = trans(new_plane);
+            ++num_planes;
+        }
+
+        template <typename store_type, typename scalar_type, typename vect_type>
+        static void remove_plane (
+            store_type& planes,
+            store_type& K,
+            long& num_planes,
+            std::vector<scalar_type>& bs,
+            std::vector<scalar_type>& miss_count,
+            vect_type& alpha,
+            const long idx
+        )
+        {
+            const long last = num_planes-1;
+            if (idx != last)
+            {
+                set_rowm(planes, idx) = rowm(planes, last);
+                bs[idx] = bs[last];
+                miss_count[idx] = miss_count[last];
+                alpha(idx) = alpha(last);
+
+                for (long c = 0; c < last; ++c)
+                    K(idx, c) = K(last, c);
+                K(idx, idx) = K(last, last);
+                for (long c = 0; c < last; ++c)
+                    K(c, idx) = K(idx, c);
+            }
+
+            bs.pop_back();
+            miss_count.pop_back();
+            alpha = rowm(alpha, range(0, last-1));
+            --num_planes;
+        }
+
         double sub_eps;
 
         unsigned long sub_max_iter;
 
         unsigned long inactive_thresh;
+
+        unsigned long num_threads;
     };
 }
 
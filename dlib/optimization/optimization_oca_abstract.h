@@ -118,6 +118,7 @@ namespace dlib
                 - get_subproblem_epsilon() == 1e-2
                 - get_subproblem_max_iterations() == 50000
                 - get_inactive_plane_threshold() == 20
+                - get_num_threads() == 1
 
             WHAT THIS OBJECT REPRESENTS
                 This object is a tool for solving the optimization problem defined above
@@ -239,6 +240,25 @@ namespace dlib
                   inactivity required before a cutting plane is removed.
         !*/
 
+        void set_num_threads (
+            unsigned long num_threads
+        );
+        /*!
+            ensures
+                - #get_num_threads() == num_threads
+        !*/
+
+        unsigned long get_num_threads (
+        ) const;
+        /*!
+            ensures
+                - returns the number of threads used to compute the inner products between
+                  a new cutting plane and all the existing planes.  This is the dominant
+                  cost of each iteration when there are many high dimensional planes.
+                  Note that the Gram matrix of the cutting planes is updated
+                  incrementally, so each iteration only computes one new row of it.
+        !*/
+
     };
 }
 
@@ -0,0 +1,679 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_OPTIMIZATIoN_THREADED_H__
+#define DLIB_OPTIMIZATIoN_THREADED_H__
+
+#include "optimization_threaded_abstract.h"
+#include "optimization.h"
+#include "optimization_bobyqa.h"
+#include "../threads.h"
+#include "../rand.h"
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        template <typename funct, typename matrix_type>
+        struct central_differences_helper
+        {
+            /*!
+                Evaluates f at x plus (for even j) or minus (for odd j) eps along the
+                coordinate j/2 and stores the result into vals[j].
+            !*/
+            central_differences_helper (
+                const funct& f_,
+                const matrix_type& x_,
+                std::vector<double>& vals_,
+                std::vector<char>& failed_,
+                double eps_
+            ) : f(f_), x(x_), vals(vals_), failed(failed_), eps(eps_) {}
+
+            const funct& f;
+            const matrix_type& x;
+            std::vector<double>& vals;
+            std::vector<char>& failed;
+            const double eps;
+
+            void operator() (
+                long j
+            ) const
+            {
+                matrix_type e(x);
+                const long i = j/2;
+                const double old_val = e(i);
+                if ((j%2) == 0)
+                    e(i) = old_val + eps;
+                else
+                    e(i) = old_val - eps;
+                vals[j] = f(e);
+            }
+
+            void evaluate_in_pool (
+                long j
+            )
+            {
+                // Nothing may propagate out of a thread_pool task, so just note which
+                // evaluations threw.  The caller repeats them.
+                try
+                {
+                    (*this)(j);
+                }
+                catch (...)
+                {
+                    failed[j] = 1;
+                }
+            }
+        };
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename funct>
+    class central_differences_threaded
+    {
+    public:
+        central_differences_threaded(
+            const funct& f_,
+            double eps_,
+            thread_pool& tp_
+        ) : f(f_), eps(eps_), tp(tp_) {}
+
+        template <typename T>
+        typename T::matrix_type operator()(const T& x) const
+        {
+            // T must be some sort of dlib matrix
+            COMPILE_TIME_ASSERT(is_matrix<T>::value);
+
+            const typename T::matrix_type e(x);
+            std::vector<double> vals(2*x.size());
+            std::vector<char> failed(vals.size(), 0);
+            typedef impl::central_differences_helper<funct,typename T::matrix_type> helper_type;
+            helper_type helper(f, e, vals, failed, eps);
+            parallel_for(tp, 0, vals.size(), helper, &helper_type::evaluate_in_pool, 1);
+
+            // Evaluate any point where f threw again, this time in the calling thread.  If
+            // f throws again its exception reaches our caller with its original type.
+            for (unsigned long j = 0; j < failed.size(); ++j)
+            {
+                if (failed[j])
+                    helper(j);
+            }
+
+            typename T::matrix_type der(x.size());
+            for (long i = 0; i < x.size(); ++i)
+                der(i) = (vals[2*i] - vals[2*i+1])/(2*eps);
+
+            return der;
+        }
+
+        double operator()(const double& x) const
+        {
+            return (f(x+eps)-f(x-eps))/(2*eps);
+        }
+
+    private:
+        const funct& f;
+        const double eps;
+        thread_pool& tp;
+    };
+
+    template <typename funct>
+    const central_differences_threaded<funct> derivative(
+        const funct& f,
+        double eps,
+        thread_pool& tp
+    )
+    {
+        DLIB_ASSERT (
+            eps > 0,
+            "\tcentral_differences_threaded derivative(f,eps,tp)"
+            << "\n\tYou must give an epsilon > 0"
+            << "\n\teps:     " << eps
+        );
+        return central_differences_threaded<funct>(f,eps,tp);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename funct>
+    class function_evaluation_cache : noncopyable
+    {
+    public:
+
+        explicit function_evaluation_cache (
+            const funct& f_
+        ) :
+            f(f_),
+            s(m),
+            num_evaluations(0),
+            num_cache_hits(0)
+        {}
+
+        template <typename T>
+        double operator() (
+            const T& x
+        ) const
+        {
+            // T must be some sort of dlib matrix
+            COMPILE_TIME_ASSERT(is_matrix<T>::value);
+
+            const matrix<double,0,1> key = matrix_cast<double>(reshape_to_column_vector(x));
+
+            auto_mutex lock(m);
+            while (true)
+            {
+                typename cache_type::const_iterator i = cache.find(key);
+                if (i != cache.end())
+                {
+                    ++num_cache_hits;
+                    return i->second;
+                }
+
+                // If another thread is already evaluating this point then wait for it
+                // rather than evaluating it again.
+                if (pending.count(key) == 0)
+                    break;
+                s.wait();
+            }
+            pending.insert(key);
+            lock.unlock();
+
+            double val;
+            try
+            {
+                val = f(x);
+            }
+            catch (...)
+            {
+                auto_mutex lock2(m);
+                pending.erase(key);
+                s.broadcast();
+                throw;
+            }
+
+            auto_mutex lock2(m);
+            pending.erase(key);
+            cache[key] = val;
+            ++num_evaluations;
+            s.broadcast();
+            return val;
+        }
+
+        unsigned long number_of_evaluations (
+        ) const
+        {
+            auto_mutex lock(m);
+            return num_evaluations;
+        }
+
+        unsigned long number_of_cache_hits (
+        ) const
+        {
+            auto_mutex lock(m);
+            return num_cache_hits;
+        }
+
+        unsigned long size (
+        ) const
+        {
+            auto_mutex lock(m);
+            return cache.size();
+        }
+
+        void clear (
+        )
+        {
+            auto_mutex lock(m);
+            cache.clear();
+            num_evaluations = 0;
+            num_cache_hits = 0;
+        }
+
+    private:
+
+        struct point_compare
+        {
+            bool operator() (
+                const matrix<double,0,1>& a,
+                const matrix<double,0,1>& b
+            ) const
+            {
+                if (a.size() != b.size())
+                    return a.size() < b.size();
+                for (long i = 0; i < a.size(); ++i)
+                {
+                    if (a(i) != b(i))
+                        return a(i) < b(i);
+                }
+                return false;
+            }
+        };
+
+        typedef std::map<matrix<double,0,1>, double, point_compare> cache_type;
+
+        const funct& f;
+        mutex m;
+        signaler s;
+        mutable cache_type cache;
+        mutable std::set<matrix<double,0,1>, point_compare> pending;
+        mutable unsigned long num_evaluations;
+        mutable unsigned long num_cache_hits;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename search_strategy_type,
+        typename stop_strategy_type,
+        typename funct,
+        typename T
+        >
+    double find_min_using_approximate_derivatives (
+        search_strategy_type search_strategy,
+        stop_strategy_type stop_strategy,
+        const funct& f,
+        T& x,
+        double min_f,
+        double derivative_eps,
+        thread_pool& tp
+    )
+    {
+        COMPILE_TIME_ASSERT(is_matrix<T>::value);
+        // The starting point (i.e. x) must be a column vector.
+        COMPILE_TIME_ASSERT(T::NC <= 1);
+
+        DLIB_ASSERT (
+            is_col_vector(x) && derivative_eps > 0,
+            "\tdouble find_min_using_approximate_derivatives()"
+            << "\n\tYou have to supply column vectors to this function"
+            << "\n\tx.nc():         " << x.nc()
+            << "\n\tderivative_eps: " << derivative_eps
+        );
+
+        T g, s;
+
+        double f_value = f(x);
+        g = derivative(f,derivative_eps,tp)(x);
+
+        DLIB_ASSERT(is_finite(f_value), "The objective function generated non-finite outputs");
+        DLIB_ASSERT(is_finite(g), "The objective function generated non-finite outputs");
+
+        while(stop_strategy.should_continue_search(x, f_value, g) && f_value > min_f)
+        {
+            s = search_strategy.get_next_direction(x, f_value, g);
+
+            double alpha = line_search(
+                        make_line_search_function(f,x,s,f_value),
+                        f_value,
+                        derivative(make_line_search_function(f,x,s),derivative_eps),
+                        dot(g,s),
+                        search_strategy.get_wolfe_rho(), search_strategy.get_wolfe_sigma(), min_f,
+                        search_strategy.get_max_line_search_iterations()
+                        );
+
+            // Take the search step indicated by the above line search
+            x += alpha*s;
+
+            g = derivative(f,derivative_eps,tp)(x);
+
+            DLIB_ASSERT(is_finite(f_value), "The objective function generated non-finite outputs");
+            DLIB_ASSERT(is_finite(g), "The objective function generated non-finite outputs");
+        }
+
+        return f_value;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename search_strategy_type,
+        typename stop_strategy_type,
+        typename funct,
+        typename T
+        >
+    double find_max_using_approximate_derivatives (
+        search_strategy_type search_strategy,
+        stop_strategy_type stop_strategy,
+        const funct& f,
+        T& x,
+        double max_f,
+        double derivative_eps,
+        thread_pool& tp
+    )
+    {
+        COMPILE_TIME_ASSERT(is_matrix<T>::value);
+        // The starting point (i.e. x) must be a column vector.
+        COMPILE_TIME_ASSERT(T::NC <= 1);
+
+        DLIB_ASSERT (
+            is_col_vector(x) && derivative_eps > 0,
+            "\tdouble find_max_using_approximate_derivatives()"
+            << "\n\tYou have to supply column vectors to this function"
+            << "\n\tx.nc():         " << x.nc()
+            << "\n\tderivative_eps: " << derivative_eps
+        );
+
+        // Just negate the necessary things and call the find_min version of this function.
+        return -find_min_using_approximate_derivatives(
+            search_strategy,
+            stop_strategy,
+            negate_function(f),
+            x,
+            -max_f,
+            derivative_eps,
+            tp
+        );
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        template <typename funct>
+        struct recording_function
+        {
+            /*!
+                Calls f and, if f throws, saves the point it was called on into bad_x
+                before letting the exception continue.
+            !*/
+            recording_function (
+                const funct& f_,
+                matrix<double,0,1>& bad_x_
+            ) : f(f_), bad_x(bad_x_) {}
+
+            const funct& f;
+            matrix<double,0,1>& bad_x;
+
+            template <typename T>
+            double operator() (
+                const T& x
+            ) const
+            {
+                try
+                {
+                    return f(x);
+                }
+                catch (...)
+                {
+                    bad_x = matrix_cast<double>(x);
+                    throw;
+                }
+            }
+        };
+
+        template <typename funct, typename T, typename U>
+        struct bobyqa_multistart_helper
+        {
+            bobyqa_multistart_helper (
+                const funct& f_,
+                const std::vector<T>& starting_points_,
+                long npt_,
+                const U& x_lower_,
+                const U& x_upper_,
+                double rho_begin_,
+                double rho_end_,
+                long max_f_evals_
+            ) :
+                f(f_), starting_points(starting_points_), npt(npt_), x_lower(x_lower_),
+                x_upper(x_upper_), rho_begin(rho_begin_), rho_end(rho_end_),
+                max_f_evals(max_f_evals_), solutions(starting_points_),
+                values(starting_points_.size()), failed(starting_points_.size(), 0),
+                errors(starting_points_.size()), threw(starting_points_.size(), 0),
+                bad_points(starting_points_.size())
+            {}
+
+            const funct& f;
+            const std::vector<T>& starting_points;
+            const long npt;
+            const U& x_lower;
+            const U& x_upper;
+            const double rho_begin;
+            const double rho_end;
+            const long max_f_evals;
+
+            // The results of each run.  Each run writes only to its own elements.
+            std::vector<T> solutions;
+            std::vector<double> values;
+            std::vector<char> failed;
+            std::vector<std::string> errors;
+
+            // threw[i] is set if f threw something other than bobyqa_failure during run i.
+            // bad_points[i] is then the point f threw on.
+            std::vector<char> threw;
+            std::vector<matrix<double,0,1> > bad_points;
+
+            template <typename F>
+            void minimize (
+                const F& g,
+                long i
+            )
+            {
+                solutions[i] = starting_points[i];
+                try
+                {
+                    values[i] = find_min_bobyqa(g, solutions[i], npt, x_lower, x_upper,
+                                                rho_begin, rho_end, max_f_evals);
+                }
+                catch (bobyqa_failure& e)
+                {
+                    failed[i] = 1;
+                    errors[i] = e.what();
+                }
+            }
+
+            void run (
+                long i
+            )
+            {
+                try
+                {
+                    minimize(recording_function<funct>(f, bad_points[i]), i);
+                }
+                catch (...)
+                {
+                    threw[i] = 1;
+                }
+            }
+        };
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename funct,
+        typename T,
+        typename U
+        >
+    double find_min_bobyqa_multistart (
+        const funct& f,
+        const std::vector<T>& starting_points,
+        T& x,
+        long npt,
+        const U& x_lower,
+        const U& x_upper,
+        const double rho_begin,
+        const double rho_end,
+        const long max_f_evals,
+        thread_pool& tp
+    )
+    {
+        // The starting point (i.e. x) must be a column vector.
+        COMPILE_TIME_ASSERT(T::NC <= 1);
+
+        // Check the requirements here since find_min_bobyqa() would throw from inside a
+        // thread pool task.
+        DLIB_CASSERT(starting_points.size() > 0 && is_col_vector(x_lower) &&
+                     is_col_vector(x_upper) && x_lower.size() == x_upper.size() &&
+                     x_lower.size() > 1 && max_f_evals > 1 &&
+                     x_lower.size() + 2 <= npt && npt <= (x_lower.size()+1)*(x_lower.size()+2)/2 &&
+                     0 < rho_end && rho_end < rho_begin &&
+                     min(x_upper - x_lower) > 2*rho_begin,
+            "\tdouble find_min_bobyqa_multistart()"
+            << "\n\t Invalid arguments have been given to this function"
+            << "\n\t starting_points.size(): " << starting_points.size()
+            << "\n\t x_lower.size():         " << x_lower.size()
+            << "\n\t x_upper.size():         " << x_upper.size()
+            << "\n\t npt:                    " << npt
+            << "\n\t rho_begin:              " << rho_begin
+            << "\n\t rho_end:                " << rho_end
+            << "\n\t max_f_evals:            " << max_f_evals
+        );
+        for (unsigned long i = 0; i < starting_points.size(); ++i)
+        {
+            DLIB_CASSERT(is_col_vector(starting_points[i]) &&
+                         starting_points[i].size() == x_lower.size() &&
+                         min(starting_points[i] - x_lower) >= 0 &&
+                         min(x_upper - starting_points[i]) >= 0,
+                "\tdouble find_min_bobyqa_multistart()"
+                << "\n\t All the starting points must be column vectors inside the bounds."
+                << "\n\t i:                         " << i
+                << "\n\t starting_points[i].size(): " << starting_points[i].size()
+                << "\n\t x_lower.size():            " << x_lower.size()
+            );
+        }
+
+        impl::bobyqa_multistart_helper<funct,T,U> helper(f, starting_points, npt, x_lower,
+                                                         x_upper, rho_begin, rho_end, max_f_evals);
+        parallel_for(tp, 0, starting_points.size(), helper,
+                     &impl::bobyqa_multistart_helper<funct,T,U>::run, 1);
+
+        // The exceptions thrown by f inside the thread pool were swallowed.  So call f
+        // on the offending point again from this thread and let it throw here.  If it
+        // doesn't throw this time then redo the whole run serially, which either
+        // reproduces the exception or finishes the run normally.
+        for (unsigned long i = 0; i < starting_points.size(); ++i)
+        {
+            if (helper.threw[i])
+            {
+                f(helper.bad_points[i]);
+                helper.minimize(f, i);
+                helper.threw[i] = 0;
+            }
+        }
+
+        // Pick the best run.  Ties go to the earliest starting point so the result
+        // doesn't depend on the number of threads.
+        long best = -1;
+        for (unsigned long i = 0; i < starting_points.size(); ++i)
+        {
+            if (!helper.failed[i] && (best == -1 || helper.values[i] < helper.values[best]))
+                best = i;
+        }
+
+        if (best == -1)
+            throw bobyqa_failure(helper.errors[0]);
+
+        x = helper.solutions[best];
+        return helper.values[best];
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename funct,
+        typename T,
+        typename U
+        >
+    double find_max_bobyqa_multistart (
+        const funct& f,
+        const std::vector<T>& starting_points,
+        T& x,
+        long npt,
+        const U& x_lower,
+        const U& x_upper,
+        const double rho_begin,
+        const double rho_end,
+        const long max_f_evals,
+        thread_pool& tp
+    )
+    {
+        // The starting point (i.e. x) must be a column vector.
+        COMPILE_TIME_ASSERT(T::NC <= 1);
+
+        return -find_min_bobyqa_multistart(negate_function(f), starting_points, x, npt,
+                                           x_lower, x_upper, rho_begin, rho_end,
+                                           max_f_evals, tp);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename funct,
+        typename T,
+        typename U
+        >
+    double find_min_bobyqa_global (
+        const funct& f,
+        T& x,
+        unsigned long num_starts,
+        long npt,
+        const U& x_lower,
+        const U& x_upper,
+        const double rho_begin,
+        const double rho_end,
+        const long max_f_evals,
+        thread_pool& tp,
+        dlib::rand& rnd
+    )
+    {
+        // The starting point (i.e. x) must be a column vector.
+        COMPILE_TIME_ASSERT(T::NC <= 1);
+
+        DLIB_CASSERT(num_starts > 0 && is_col_vector(x) && x.size() == x_lower.size() &&
+                     x_lower.size() == x_upper.size(),
+            "\tdouble find_min_bobyqa_global()"
+            << "\n\t Invalid arguments have been given to this function"
+            << "\n\t num_starts:     " << num_starts
+            << "\n\t x.size():       " << x.size()
+            << "\n\t x_lower.size(): " << x_lower.size()
+            << "\n\t x_upper.size(): " << x_upper.size()
+        );
+
+        // Start from x and from points picked uniformly at random inside the bounds.
+        std::vector<T> starting_points(num_starts, x);
+        for (unsigned long i = 1; i < num_starts; ++i)
+        {
+            for (long j = 0; j < x.size(); ++j)
+                starting_points[i](j) = x_lower(j) + rnd.get_random_double()*(x_upper(j) - x_lower(j));
+        }
+
+        return find_min_bobyqa_multistart(f, starting_points, x, npt, x_lower, x_upper,
+                                          rho_begin, rho_end, max_f_evals, tp);
+    }
+
+    template <
+        typename funct,
+        typename T,
+        typename U
+        >
+    double find_min_bobyqa_global (
+        const funct& f,
+        T& x,
+        unsigned long num_starts,
+        long npt,
+        const U& x_lower,
+        const U& x_upper,
+        const double rho_begin,
+        const double rho_end,
+        const long max_f_evals,
+        thread_pool& tp
+    )
+    {
+        dlib::rand rnd;
+        return find_min_bobyqa_global(f, x, num_starts, npt, x_lower, x_upper, rho_begin,
+                                      rho_end, max_f_evals, tp, rnd);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_OPTIMIZATIoN_THREADED_H__
+
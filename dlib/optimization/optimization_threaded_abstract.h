@@ -0,0 +1,338 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_OPTIMIZATIoN_THREADED_ABSTRACT_H__
+#ifdef DLIB_OPTIMIZATIoN_THREADED_ABSTRACT_H__
+
+#include "optimization_abstract.h"
+#include "optimization_bobyqa_abstract.h"
+#include "../threads/thread_pool_extension_abstract.h"
+#include "../rand/rand_kernel_abstract.h"
+#include <vector>
+
+namespace dlib
+{
+
+/*
+    The tools in this file evaluate the objective function at several points at the
+    same time, using a thread_pool.  They are meant for objective functions which are
+    expensive to evaluate.  Therefore, unless stated otherwise, the objective
+    functions given to these tools must be safe to call from multiple threads at the
+    same time.
+*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename funct
+        >
+    const central_differences_threaded<funct> derivative(
+        const funct& f,
+        double eps,
+        thread_pool& tp
+    );
+    /*!
+        requires
+            - f == a function that returns a scalar
+            - f must take either double or a dlib::matrix that is a column vector
+            - eps > 0
+            - It must be safe to call f from multiple threads at the same time.
+        ensures
+            - This function is identical to derivative(f,eps) except that when f takes a
+              column vector the 2*N evaluations of f needed by the central differences
+              are done in parallel using the threads in tp.  The output is exactly the
+              same as the output of derivative(f,eps).
+            - The returned object keeps references to f and tp so they must remain valid
+              while it is in use.
+            - If f throws while being evaluated in tp then that evaluation is repeated
+              in the thread that called the returned object.  So an exception thrown by
+              f reaches the caller with its original type.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename funct
+        >
+    class function_evaluation_cache : noncopyable
+    {
+        /*!
+            REQUIREMENTS ON funct
+                funct must be a function or function object which takes a dlib::matrix
+                and returns a double.
+
+            WHAT THIS OBJECT REPRESENTS
+                This object is a function object which remembers the values of a function
+                at all the points it has been evaluated at.  So if you call it twice with
+                the same point the underlying function is only evaluated once.  This is
+                useful when optimizing an expensive function since optimizers often
+                revisit points, for example when several runs of a multi-start search 
+                begin at the same point.
+
+            THREAD SAFETY
+                It is safe to call operator() from multiple threads at the same time.  If
+                a thread asks for a point which another thread is currently evaluating it
+                waits for that evaluation to finish rather than evaluating the point
+                again.
+        !*/
+
+    public:
+
+        explicit function_evaluation_cache (
+            const funct& f
+        );
+        /*!
+            ensures
+                - #number_of_evaluations() == 0
+                - #number_of_cache_hits() == 0
+                - #size() == 0
+                - This object will evaluate f.  A reference to f is kept so it must
+                  remain valid while this object is in use.
+        !*/
+
+        template <typename T>
+        double operator() (
+            const T& x
+        ) const;
+        /*!
+            requires
+                - T == a dlib::matrix
+            ensures
+                - returns f(x)
+                - If f was already evaluated at a point exactly equal to x then the
+                  remembered value is returned and f isn't called.
+        !*/
+
+        unsigned long number_of_evaluations (
+        ) const;
+        /*!
+            ensures
+                - returns the number of times f has been evaluated by this object.
+        !*/
+
+        unsigned long number_of_cache_hits (
+        ) const;
+        /*!
+            ensures
+                - returns the number of times operator() returned a remembered value
+                  rather than evaluating f.
+        !*/
+
+        unsigned long size (
+        ) const;
+        /*!
+            ensures
+                - returns the number of points whose value is remembered.
+        !*/
+
+        void clear (
+        );
+        /*!
+            ensures
+                - forgets all the remembered values.
+                - #number_of_evaluations() == 0
+                - #number_of_cache_hits() == 0
+                - #size() == 0
+        !*/
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename search_strategy_type,
+        typename stop_strategy_type,
+        typename funct,
+        typename T
+        >
+    double find_min_using_approximate_derivatives (
+        search_strategy_type search_strategy,
+        stop_strategy_type stop_strategy,
+        const funct& f,
+        T& x,
+        double min_f,
+        double derivative_eps,
+        thread_pool& tp
+    );
+    /*!
+        requires
+            - The requirements are the same as for the version of
+              find_min_using_approximate_derivatives() that doesn't take a thread_pool.
+            - It must be safe to call f from multiple threads at the same time.
+        ensures
+            - This function is identical to find_min_using_approximate_derivatives(
+              search_strategy, stop_strategy, f, x, min_f, derivative_eps) except that the
+              gradients are computed using derivative(f,derivative_eps,tp).  So each
+              gradient evaluation runs in parallel.  The results are exactly the same.
+    !*/
+
+    template <
+        typename search_strategy_type,
+        typename stop_strategy_type,
+        typename funct,
+        typename T
+        >
+    double find_max_using_approximate_derivatives (
+        search_strategy_type search_strategy,
+        stop_strategy_type stop_strategy,
+        const funct& f,
+        T& x,
+        double max_f,
+        double derivative_eps,
+        thread_pool& tp
+    );
+    /*!
+        requires
+            - The requirements are the same as for the version of
+              find_max_using_approximate_derivatives() that doesn't take a thread_pool.
+            - It must be safe to call f from multiple threads at the same time.
+        ensures
+            - This function is identical to find_max_using_approximate_derivatives(
+              search_strategy, stop_strategy, f, x, max_f, derivative_eps) except that the
+              gradients are computed using derivative(f,derivative_eps,tp).  So each
+              gradient evaluation runs in parallel.  The results are exactly the same.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename funct,
+        typename T, 
+        typename U
+        >
+    double find_min_bobyqa_multistart (
+        const funct& f,
+        const std::vector<T>& starting_points,
+        T& x,
+        long npt,
+        const U& x_lower,
+        const U& x_upper,
+        const double rho_begin,
+        const double rho_end,
+        const long max_f_evals,
+        thread_pool& tp
+    );
+    /*!
+        requires
+            - starting_points.size() > 0
+            - for all valid i:
+                - starting_points[i] satisfies the requirements find_min_bobyqa() places
+                  on its starting point x.
+            - npt, x_lower, x_upper, rho_begin, rho_end, and max_f_evals satisfy the
+              requirements of find_min_bobyqa().
+            - It must be safe to call f from multiple threads at the same time.
+        ensures
+            - Runs find_min_bobyqa(f, starting_points[i], npt, x_lower, x_upper,
+              rho_begin, rho_end, max_f_evals) for each starting point.  The runs are done
+              in parallel using the threads in tp.  
+            - Runs which throw bobyqa_failure are ignored.  
+            - #x == the best point found by the runs that didn't fail.  If several runs
+              find equally good points then the one from the earliest starting point is
+              used.  So the output doesn't depend on the number of threads in tp.
+            - returns f(#x)
+            - If f is expensive you can wrap it in a function_evaluation_cache so that
+              points visited by several runs are only evaluated once.
+        throws
+            - bobyqa_failure
+                This exception is thrown if all the runs fail.  The message is the one
+                from the run using starting_points[0].
+            - Any other exception thrown by f propagates out of this function.  Since
+              it can't be moved out of the thread that threw it, f is called again on
+              the same point from the calling thread.  If that call doesn't throw then
+              the run which hit the exception is redone serially in the calling thread.
+    !*/
+
+    template <
+        typename funct,
+        typename T, 
+        typename U
+        >
+    double find_max_bobyqa_multistart (
+        const funct& f,
+        const std::vector<T>& starting_points,
+        T& x,
+        long npt,
+        const U& x_lower,
+        const U& x_upper,
+        const double rho_begin,
+        const double rho_end,
+        const long max_f_evals,
+        thread_pool& tp
+    );
+    /*!
+        requires
+            - The requirements are the same as for find_min_bobyqa_multistart().
+        ensures
+            - This function is identical to find_min_bobyqa_multistart() except that it
+              maximizes f rather than minimizing it.
+            - returns f(#x)
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename funct,
+        typename T, 
+        typename U
+        >
+    double find_min_bobyqa_global (
+        const funct& f,
+        T& x,
+        unsigned long num_starts,
+        long npt,
+        const U& x_lower,
+        const U& x_upper,
+        const double rho_begin,
+        const double rho_end,
+        const long max_f_evals,
+        thread_pool& tp,
+        dlib::rand& rnd
+    );
+    /*!
+        requires
+            - num_starts > 0
+            - x, npt, x_lower, x_upper, rho_begin, rho_end, and max_f_evals satisfy the
+              requirements of find_min_bobyqa().
+            - It must be safe to call f from multiple threads at the same time.
+        ensures
+            - Searches for the global minimum of f inside the box defined by x_lower and
+              x_upper.  This is done by calling find_min_bobyqa_multistart() with
+              num_starts starting points.  The first starting point is x and the others
+              are picked uniformly at random from inside the box using rnd.
+            - #x == the best point found.
+            - returns f(#x)
+        throws
+            - bobyqa_failure
+                This exception is thrown if all the runs fail.
+            - Exceptions thrown by f are propagated in the same way as they are by
+              find_min_bobyqa_multistart().
+    !*/
+
+    template <
+        typename funct,
+        typename T, 
+        typename U
+        >
+    double find_min_bobyqa_global (
+        const funct& f,
+        T& x,
+        unsigned long num_starts,
+        long npt,
+        const U& x_lower,
+        const U& x_upper,
+        const double rho_begin,
+        const double rho_end,
+        const long max_f_evals,
+        thread_pool& tp
+    );
+    /*!
+        ensures
+            - invokes find_min_bobyqa_global(f, x, num_starts, npt, x_lower, x_upper,
+              rho_begin, rho_end, max_f_evals, tp, rnd) where rnd is a default
+              initialized dlib::rand object.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_OPTIMIZATIoN_THREADED_ABSTRACT_H__
+
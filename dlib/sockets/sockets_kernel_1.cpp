@@ -29,6 +29,8 @@
 #endif
 
 #include "../assert.h"
+#include <fstream>
+#include <vector>
 
 namespace dlib
 {
@@ -280,6 +282,37 @@ namespace dlib
             return 0;
     }
 
+// ----------------------------------------------------------------------------------------
+
+    int connection::
+    enable_nagle()
+    {
+        int flag = 0;
+        int status = setsockopt( connection_socket, IPPROTO_TCP, TCP_NODELAY, (char *)&flag, sizeof(flag) );
+
+        if (status == SOCKET_ERROR) 
+            return OTHER_ERROR;
+        else
+            return 0;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    int connection::
+    cork()
+    {
+        // Windows doesn't have anything like TCP_CORK so there is nothing to do here.
+        return 0;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    int connection::
+    uncork()
+    {
+        return 0;
+    }
+
 // ----------------------------------------------------------------------------------------
 
     long connection::
@@ -372,6 +405,146 @@ namespace dlib
         return status;
     }
 
+// ----------------------------------------------------------------------------------------
+
+    long connection::
+    write (
+        const const_io_buffer* bufs,
+        unsigned long num_bufs
+    )
+    {
+        long total = 0;
+        std::vector<WSABUF> wsabufs;
+        wsabufs.reserve(num_bufs);
+        for (unsigned long i = 0; i < num_bufs; ++i)
+        {
+            if (bufs[i].size == 0)
+                continue;
+            WSABUF temp;
+            temp.buf = const_cast<char*>(bufs[i].data);
+            temp.len = bufs[i].size;
+            wsabufs.push_back(temp);
+            total += bufs[i].size;
+        }
+
+        unsigned long first = 0;
+        while (first < wsabufs.size())
+        {
+            DWORD sent = 0;
+            if (WSASend(connection_socket, &wsabufs[first], wsabufs.size()-first, &sent, 0, NULL, NULL) == SOCKET_ERROR)
+            {
+                if (sdo_called())
+                    return SHUTDOWN;
+                else
+                    return OTHER_ERROR;
+            }
+
+            // skip past the buffers that were completely written and adjust the
+            // one that was only partially written.
+            while (first < wsabufs.size() && sent >= wsabufs[first].len)
+            {
+                sent -= wsabufs[first].len;
+                ++first;
+            }
+            if (sent != 0)
+            {
+                wsabufs[first].buf += sent;
+                wsabufs[first].len -= sent;
+            }
+        }
+        return total;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    long connection::
+    read (
+        const io_buffer* bufs,
+        unsigned long num_bufs
+    )
+    {
+        std::vector<WSABUF> wsabufs;
+        wsabufs.reserve(num_bufs);
+        for (unsigned long i = 0; i < num_bufs; ++i)
+        {
+            if (bufs[i].size == 0)
+                continue;
+            WSABUF temp;
+            temp.buf = bufs[i].data;
+            temp.len = bufs[i].size;
+            wsabufs.push_back(temp);
+        }
+        if (wsabufs.size() == 0)
+            return OTHER_ERROR;
+
+        DWORD received = 0;
+        DWORD flags = 0;
+        if (WSARecv(connection_socket, &wsabufs[0], wsabufs.size(), &received, &flags, NULL, NULL) == SOCKET_ERROR)
+        {
+            // if this error is the result of a shutdown call then return SHUTDOWN
+            if (sd_called())
+                return SHUTDOWN;
+            else
+                return OTHER_ERROR;
+        }
+        else if (received == 0 && sd_called())
+        {
+            return SHUTDOWN;
+        }
+        return received;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    int64 connection::
+    send_file (
+        const std::string& filename
+    )
+    {
+        std::ifstream fin(filename.c_str(), std::ios::binary);
+        if (!fin)
+            return OTHER_ERROR;
+        fin.seekg(0, std::ios::end);
+        const uint64 size = fin.tellg();
+        fin.close();
+
+        return send_file(filename, 0, size);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    int64 connection::
+    send_file (
+        const std::string& filename,
+        uint64 offset,
+        uint64 num
+    )
+    {
+        // TransmitFile() would let us avoid the copy here but it requires linking with
+        // mswsock.lib so we just push the file through a buffer instead.
+        std::ifstream fin(filename.c_str(), std::ios::binary);
+        if (!fin)
+            return OTHER_ERROR;
+        fin.seekg(0, std::ios::end);
+        if (offset + num > static_cast<uint64>(fin.tellg()))
+            return OTHER_ERROR;
+        fin.seekg(offset);
+
+        const uint64 old_num = num;
+        std::vector<char> buf(64*1024);
+        while (num > 0)
+        {
+            const long length = static_cast<long>(std::min<uint64>(buf.size(), num));
+            if (!fin.read(&buf[0], length))
+                return OTHER_ERROR;
+            const long status = write(&buf[0], length);
+            if (status != length)
+                return status;
+            num -= length;
+        }
+        return static_cast<int64>(old_num);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     bool connection::
@@ -52,6 +52,26 @@ namespace dlib
         std::string& hostname
     );
 
+// ----------------------------------------------------------------------------------------
+
+    struct const_io_buffer
+    {
+        const_io_buffer() : data(0), size(0) {}
+        const_io_buffer(const char* data_, unsigned long size_) : data(data_), size(size_) {}
+
+        const char* data;
+        unsigned long size;
+    };
+
+    struct io_buffer
+    {
+        io_buffer() : data(0), size(0) {}
+        io_buffer(char* data_, unsigned long size_) : data(data_), size(size_) {}
+
+        char* data;
+        unsigned long size;
+    };
+
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
     // connection object
@@ -117,6 +137,26 @@ namespace dlib
             unsigned long timeout
         );
 
+        long write (
+            const const_io_buffer* bufs,
+            unsigned long num_bufs
+        );
+
+        long read (
+            const io_buffer* bufs,
+            unsigned long num_bufs
+        );
+
+        int64 send_file (
+            const std::string& filename
+        );
+
+        int64 send_file (
+            const std::string& filename,
+            uint64 offset,
+            uint64 num
+        );
+
         unsigned short get_local_port (
         ) const {  return connection_local_port; }
 
@@ -144,6 +184,15 @@ namespace dlib
         int disable_nagle(
         );
 
+        int enable_nagle(
+        );
+
+        int cork(
+        );
+
+        int uncork(
+        );
+
         socket_descriptor_type get_socket_descriptor (
         ) const;
 
@@ -12,6 +12,14 @@
 #include <fcntl.h>
 #include "../set.h"
 #include <netinet/tcp.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include <limits.h>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 
 
 
@@ -324,6 +332,58 @@ namespace dlib
         return 0;
     }
 
+// ----------------------------------------------------------------------------------------
+
+    int connection::
+    enable_nagle()
+    {
+        return set_tcp_option(TCP_NODELAY, 0);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    int connection::
+    cork()
+    {
+#if defined(TCP_CORK)
+        return set_tcp_option(TCP_CORK, 1);
+#elif defined(TCP_NOPUSH)
+        return set_tcp_option(TCP_NOPUSH, 1);
+#else
+        return 0;
+#endif
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    int connection::
+    uncork()
+    {
+#if defined(TCP_CORK)
+        return set_tcp_option(TCP_CORK, 0);
+#elif defined(TCP_NOPUSH)
+        return set_tcp_option(TCP_NOPUSH, 0);
+#else
+        return 0;
+#endif
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    int connection::
+    set_tcp_option (
+        int option,
+        int value
+    )
+    {
+        if(setsockopt( connection_socket, IPPROTO_TCP, option, (char *)&value, sizeof(value) ))
+        {
+            return OTHER_ERROR;
+        }
+
+        return 0;
+    }
+
 // ----------------------------------------------------------------------------------------
 
     long connection::
@@ -444,6 +504,230 @@ namespace dlib
         return status;
     }
 
+// ----------------------------------------------------------------------------------------
+
+    long connection::
+    write (
+        const const_io_buffer* bufs,
+        unsigned long num_bufs
+    )
+    {
+#ifdef IOV_MAX
+        const unsigned long max_iov = IOV_MAX;
+#else
+        const unsigned long max_iov = 16;
+#endif
+        long total = 0;
+        // Copy the buffer descriptors into an iovec array.  We need our own copy since
+        // partial writes require us to advance through the buffers and we aren't
+        // allowed to modify the caller's descriptors.
+        std::vector<iovec> iov;
+        iov.reserve(num_bufs);
+        for (unsigned long i = 0; i < num_bufs; ++i)
+        {
+            if (bufs[i].size == 0)
+                continue;
+            iovec temp;
+            temp.iov_base = const_cast<char*>(bufs[i].data);
+            temp.iov_len = bufs[i].size;
+            iov.push_back(temp);
+            total += bufs[i].size;
+        }
+
+        unsigned long first = 0;
+        while (first < iov.size())
+        {
+            const int count = static_cast<int>(std::min<unsigned long>(max_iov, iov.size()-first));
+            const ssize_t status = ::writev(connection_socket, &iov[first], count);
+            if (status <= 0)
+            {
+                // if writev was interupted by a signal then restart it
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                else
+                {
+                    if (sdo_called())
+                        return SHUTDOWN;
+                    else
+                        return OTHER_ERROR;
+                }
+            }
+
+            // skip past the buffers that were completely written and adjust the
+            // one that was only partially written.
+            size_t written = status;
+            while (first < iov.size() && written >= iov[first].iov_len)
+            {
+                written -= iov[first].iov_len;
+                ++first;
+            }
+            if (written != 0)
+            {
+                iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + written;
+                iov[first].iov_len -= written;
+            }
+        }
+        return total;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    long connection::
+    read (
+        const io_buffer* bufs,
+        unsigned long num_bufs
+    )
+    {
+#ifdef IOV_MAX
+        const unsigned long max_iov = IOV_MAX;
+#else
+        const unsigned long max_iov = 16;
+#endif
+        std::vector<iovec> iov;
+        iov.reserve(num_bufs);
+        for (unsigned long i = 0; i < num_bufs && iov.size() < max_iov; ++i)
+        {
+            if (bufs[i].size == 0)
+                continue;
+            iovec temp;
+            temp.iov_base = bufs[i].data;
+            temp.iov_len = bufs[i].size;
+            iov.push_back(temp);
+        }
+        if (iov.size() == 0)
+            return OTHER_ERROR;
+
+        while (true)
+        {
+            const long status = ::readv(connection_socket, &iov[0], static_cast<int>(iov.size()));
+            if (status == -1)
+            {
+                // if readv was interupted then try again
+                if (errno == EINTR)
+                    continue;
+                else
+                {
+                    if (sd_called())
+                        return SHUTDOWN;
+                    else
+                        return OTHER_ERROR;
+                }
+            }
+            else if (status == 0 && sd_called())
+            {
+                return SHUTDOWN;
+            }
+
+            return status;
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    int64 connection::
+    send_file (
+        const std::string& filename
+    )
+    {
+        const int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd == -1)
+            return OTHER_ERROR;
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0)
+        {
+            ::close(fd);
+            return OTHER_ERROR;
+        }
+
+        const int64 status = send_file_descriptor(fd, 0, info.st_size);
+        ::close(fd);
+        return status;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    int64 connection::
+    send_file (
+        const std::string& filename,
+        uint64 offset,
+        uint64 num
+    )
+    {
+        const int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd == -1)
+            return OTHER_ERROR;
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || offset + num > static_cast<uint64>(info.st_size))
+        {
+            ::close(fd);
+            return OTHER_ERROR;
+        }
+
+        const int64 status = send_file_descriptor(fd, offset, num);
+        ::close(fd);
+        return status;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    int64 connection::
+    send_file_descriptor (
+        int fd,
+        uint64 offset,
+        uint64 num
+    )
+    {
+        const uint64 old_num = num;
+        const uint64 max_send_length = 1024*1024*100;
+#ifdef __linux__
+        // Let the kernel copy the file contents straight from the page cache into the
+        // socket.  
+        off_t off = static_cast<off_t>(offset);
+        while (num > 0)
+        {
+            const size_t length = static_cast<size_t>(std::min(max_send_length, num));
+            const ssize_t status = ::sendfile(connection_socket, fd, &off, length);
+            if (status <= 0)
+            {
+                if (status == -1 && errno == EINTR)
+                    continue;
+
+                if (sdo_called())
+                    return SHUTDOWN;
+                else
+                    return OTHER_ERROR;
+            }
+            num -= status;
+        }
+#else
+        // There isn't a portable sendfile() so just push the file through a buffer.
+        if (::lseek(fd, static_cast<off_t>(offset), SEEK_SET) == (off_t)-1)
+            return OTHER_ERROR;
+
+        std::vector<char> buf(static_cast<size_t>(std::min<uint64>(64*1024, max_send_length)));
+        while (num > 0)
+        {
+            const size_t length = static_cast<size_t>(std::min<uint64>(buf.size(), num));
+            const ssize_t status = ::read(fd, &buf[0], length);
+            if (status <= 0)
+            {
+                if (status == -1 && errno == EINTR)
+                    continue;
+                return OTHER_ERROR;
+            }
+            const long wstatus = write(&buf[0], status);
+            if (wstatus != status)
+                return wstatus;
+            num -= status;
+        }
+#endif
+        return static_cast<int64>(old_num);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     bool connection::
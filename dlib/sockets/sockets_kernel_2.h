@@ -33,6 +33,7 @@
 #include "../threads.h"
 #include "../algs.h"
 #include "../smart_pointers.h"
+#include "../uintn.h"
 
 
 
@@ -71,6 +72,26 @@ namespace dlib
         std::string& hostname
     );
 
+// ----------------------------------------------------------------------------------------
+
+    struct const_io_buffer
+    {
+        const_io_buffer() : data(0), size(0) {}
+        const_io_buffer(const char* data_, unsigned long size_) : data(data_), size(size_) {}
+
+        const char* data;
+        unsigned long size;
+    };
+
+    struct io_buffer
+    {
+        io_buffer() : data(0), size(0) {}
+        io_buffer(char* data_, unsigned long size_) : data(data_), size(size_) {}
+
+        char* data;
+        unsigned long size;
+    };
+
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
     // connection object
@@ -139,6 +160,26 @@ namespace dlib
             unsigned long timeout
         );
 
+        long write (
+            const const_io_buffer* bufs,
+            unsigned long num_bufs
+        );
+
+        long read (
+            const io_buffer* bufs,
+            unsigned long num_bufs
+        );
+
+        int64 send_file (
+            const std::string& filename
+        );
+
+        int64 send_file (
+            const std::string& filename,
+            uint64 offset,
+            uint64 num
+        );
+
         int get_local_port (
         ) const { return connection_local_port; }
 
@@ -186,6 +227,15 @@ namespace dlib
         int disable_nagle(
         );
 
+        int enable_nagle(
+        );
+
+        int cork(
+        );
+
+        int uncork(
+        );
+
         typedef int socket_descriptor_type;
 
         socket_descriptor_type get_socket_descriptor (
@@ -193,6 +243,29 @@ namespace dlib
 
     private:
 
+        int set_tcp_option (
+            int option,
+            int value
+        );
+        /*!
+            ensures
+                - sets the given IPPROTO_TCP level socket option to value
+                - returns 0 upon success and OTHER_ERROR otherwise
+        !*/
+
+        int64 send_file_descriptor (
+            int fd,
+            uint64 offset,
+            uint64 num
+        );
+        /*!
+            requires
+                - fd is an open file descriptor for a file with at least offset+num bytes
+            ensures
+                - writes bytes [offset, offset+num) of the file to this connection
+                - returns num if successful, otherwise SHUTDOWN or OTHER_ERROR
+        !*/
+
         bool readable (
             unsigned long timeout 
         ) const;
@@ -5,6 +5,7 @@
 
 #include <string>
 #include "../threads.h"
+#include "../uintn.h"
 
 namespace dlib
 {
@@ -165,6 +166,42 @@ namespace dlib
         scoped_ptr smart pointer instead of a C pointer.
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    struct const_io_buffer
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object describes a contiguous block of size bytes starting at data.
+                An array of these objects is given to connection::write() when you want
+                to send several separate blocks of memory in a single call without
+                first copying them into one buffer (i.e. a gather write).
+        !*/
+
+        const_io_buffer() : data(0), size(0) {}
+        const_io_buffer(const char* data_, unsigned long size_) : data(data_), size(size_) {}
+
+        const char* data;
+        unsigned long size;
+    };
+
+    struct io_buffer
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object describes a writable block of size bytes starting at data.
+                An array of these objects is given to connection::read() when you want
+                incoming data to be scattered directly into several separate blocks of
+                memory.
+        !*/
+
+        io_buffer() : data(0), size(0) {}
+        io_buffer(char* data_, unsigned long size_) : data(data_), size(size_) {}
+
+        char* data;
+        unsigned long size;
+    };
+
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
     // connection object
@@ -304,6 +341,95 @@ namespace dlib
                 - returns SHUTDOWN if the connection has been shutdown locally
         !*/
 
+        long write (
+            const const_io_buffer* bufs,
+            unsigned long num_bufs
+        );
+        /*!
+            requires
+                - bufs points to an array of num_bufs const_io_buffer objects
+                - each bufs[i].data points to an array of at least bufs[i].size bytes
+            ensures
+                - Writes the contents of bufs[0], bufs[1], ..., bufs[num_bufs-1] to the
+                  connection, in that order, as if they had been concatenated into one
+                  buffer and given to write().  However, no such concatenation is
+                  performed.  The buffers are handed to the OS in a single gather write
+                  (e.g. writev() or WSASend()) whenever possible.
+                - will block until ONE of the following occurrs:
+                    - all the bytes in bufs have been written to the connection 
+                    - an error has occurred
+                    - the outgoing channel of the connection has been shutdown locally
+
+                - returns the total number of bytes in bufs if the write succeeded 
+                - returns OTHER_ERROR if there was an error (this could be due to a 
+                  connection close)
+                - returns SHUTDOWN if the outgoing channel of the connection has been 
+                  shutdown locally
+        !*/
+
+        long read (
+            const io_buffer* bufs,
+            unsigned long num_bufs
+        );
+        /*!
+            requires
+                - bufs points to an array of num_bufs io_buffer objects
+                - each bufs[i].data points to an array of at least bufs[i].size bytes
+                - at least one of the bufs[i].size values is > 0
+            ensures
+                - Reads data from the connection directly into the given buffers (i.e. a
+                  scatter read).  The buffers are filled in order, so bufs[i+1] only
+                  receives data once bufs[i] has been completely filled.
+                - read() blocks until ONE of the following happens:
+                    - there is some data available and it has been written into bufs 
+                    - the remote end of the connection is closed 
+                    - an error has occurred
+                    - the connection has been shutdown locally
+
+                - returns the number of bytes read into bufs if there was any data.
+                - returns 0 if the connection has ended/terminated and there is no more data.
+                - returns OTHER_ERROR if there was an error.
+                - returns SHUTDOWN if the connection has been shutdown locally
+        !*/
+
+        int64 send_file (
+            const std::string& filename
+        );
+        /*!
+            ensures
+                - Writes the entire contents of the file with the given name to the
+                  connection.  Where the OS supports it (e.g. sendfile() on Linux) the
+                  file data is copied by the kernel straight from the file into the
+                  socket without ever passing through user space.  On other platforms
+                  the file is pushed through a small internal buffer.
+                - will block until ONE of the following occurrs:
+                    - the whole file has been written to the connection 
+                    - an error has occurred
+                    - the outgoing channel of the connection has been shutdown locally
+
+                - returns the size of the file in bytes if the write succeeded
+                - returns OTHER_ERROR if the file can't be read or there was an error
+                  writing to the connection
+                - returns SHUTDOWN if the outgoing channel of the connection has been 
+                  shutdown locally
+        !*/
+
+        int64 send_file (
+            const std::string& filename,
+            uint64 offset,
+            uint64 num
+        );
+        /*!
+            ensures
+                - This function is identical to send_file(filename) except that it only
+                  writes the num bytes of the file which begin offset bytes into the file.
+                - returns num if the write succeeded
+                - returns OTHER_ERROR if the file can't be read, the file contains fewer
+                  than offset+num bytes, or there was an error writing to the connection
+                - returns SHUTDOWN if the outgoing channel of the connection has been 
+                  shutdown locally
+        !*/
+
         unsigned short get_local_port (
         ) const;
         /*!
@@ -375,6 +501,47 @@ namespace dlib
                 - returns OTHER_ERROR if there was an error 
         !*/
 
+        int enable_nagle(
+        );
+        /*!
+            ensures
+                - Clears the TCP_NODELAY socket option so that Nagle's algorithm is used
+                  again.  That is, this function undoes disable_nagle().  Note that
+                  Nagle's algorithm is enabled by default on new connections.
+
+                - returns 0 upon success
+                - returns OTHER_ERROR if there was an error 
+        !*/
+
+        int cork(
+        );
+        /*!
+            ensures
+                - Tells the OS to hold back partial TCP segments until uncork() is called
+                  (i.e. sets TCP_CORK on Linux or TCP_NOPUSH on BSD and OS X).  This lets
+                  you issue several small write() or send_file() calls, for example a
+                  message header followed by its body, and have them go out on the wire
+                  in as few packets as possible.
+                - On platforms which don't have any such socket option this function
+                  does nothing.
+
+                - returns 0 upon success
+                - returns OTHER_ERROR if there was an error 
+        !*/
+
+        int uncork(
+        );
+        /*!
+            ensures
+                - Undoes a previous call to cork().  Any data held back by the OS is sent
+                  immediately.
+                - On platforms which don't have any such socket option this function
+                  does nothing.
+
+                - returns 0 upon success
+                - returns OTHER_ERROR if there was an error 
+        !*/
+
         typedef platform_specific_type socket_descriptor_type;
         socket_descriptor_type get_socket_descriptor (
         ) const;
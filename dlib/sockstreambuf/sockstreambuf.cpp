@@ -56,6 +56,22 @@ namespace dlib
             pbump(static_cast<int>(num));
             return num;
         }
+        else if (num >= out_buffer_size)
+        {
+            // This is a big write so don't bother copying it into out_buffer.  Instead,
+            // send whatever is already buffered along with s in one gather write.
+            const_io_buffer bufs[2];
+            bufs[0] = const_io_buffer(pbase(), static_cast<unsigned long>(pptr()-pbase()));
+            bufs[1] = const_io_buffer(s, static_cast<unsigned long>(num));
+            const long total = static_cast<long>(bufs[0].size + bufs[1].size);
+            if (con.write(bufs,2) != total)
+            {
+                // the write was not successful so return that 0 bytes were written
+                return 0;
+            } 
+            pbump(-static_cast<int>(bufs[0].size));
+            return num;
+        }
         else
         {
             std::memcpy(pptr(),s,static_cast<size_t>(space_left));
@@ -69,21 +85,9 @@ namespace dlib
                 return 0;
             }
 
-            if (num_left < out_buffer_size)
-            {
-                std::memcpy(pptr(),s,static_cast<size_t>(num_left));
-                pbump(num_left);
-                return num;
-            }
-            else
-            {
-                if (con.write(s,num_left) != num_left)
-                {
-                    // the write was not successful so return that 0 bytes were written
-                    return 0;
-                } 
-                return num;
-            }
+            std::memcpy(pptr(),s,static_cast<size_t>(num_left));
+            pbump(num_left);
+            return num;
         }
     }
 
@@ -133,6 +137,49 @@ namespace dlib
         return static_cast<unsigned char>(*gptr());
     }
 
+// ---------------------------------------------------------------------------------------- 
+
+    int sockstreambuf::
+    read_directly (
+        char_type*& s, 
+        std::streamsize& n
+    )
+    {
+        if (flushes_output_on_read())
+        {
+            if (flush_out_buffer() == EOF)
+            {
+                // an error occurred
+                return EOF;
+            }
+        }
+
+        io_buffer bufs[2];
+        bufs[0] = io_buffer(s, static_cast<unsigned long>(n));
+        bufs[1] = io_buffer(in_buffer+max_putback, in_buffer_size-max_putback);
+        const long num = con.read(bufs,2);
+        if (num <= 0)
+        {
+            // an error occurred or the connection is over which is EOF
+            return EOF;
+        }
+
+        const std::streamsize num_to_s = std::min<std::streamsize>(num, n);
+        const std::streamsize num_to_buffer = num - num_to_s;
+        s += num_to_s;
+        n -= num_to_s;
+
+        // Put the last few bytes handed to the caller into the putback area so that
+        // putback still works the way it would if the data had come through in_buffer.
+        const std::streamsize num_put_back = std::min(num_to_s, max_putback);
+        std::memcpy(in_buffer+(max_putback-num_put_back), s-num_put_back, static_cast<size_t>(num_put_back));
+        setg (in_buffer+(max_putback-num_put_back),
+              in_buffer+max_putback,
+              in_buffer+max_putback+num_to_buffer);
+
+        return static_cast<int>(num);
+    }
+
 // ---------------------------------------------------------------------------------------- 
 
     std::streamsize sockstreambuf::
@@ -156,6 +203,15 @@ namespace dlib
             // read more data into our buffer  
             if (num == 0)
             {
+                if (n >= in_buffer_size-max_putback)
+                {
+                    // This is a big read so scatter the incoming data directly into s
+                    // and only let whatever doesn't fit in s land in in_buffer.
+                    if (read_directly(s,n) == EOF)
+                        break;
+                    continue;
+                }
+
                 if (underflow() == EOF)
                     break;
                 continue;
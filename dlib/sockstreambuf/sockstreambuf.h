@@ -149,6 +149,23 @@ namespace dlib
 
     private:
 
+        int read_directly (
+            char_type*& s, 
+            std::streamsize& n
+        );
+        /*!
+            requires
+                - gptr() == egptr()
+                  (i.e. there is no buffered input data)
+                - n > 0
+            ensures
+                - reads from con directly into s and puts any bytes beyond the first n
+                  into in_buffer. 
+                - #s and #n are advanced past the bytes written into s.
+                - returns the number of bytes read or EOF if there was an error or the
+                  connection has ended.
+        !*/
+
         // member data
         connection&  con;
         static const std::streamsize max_putback = 4;
@@ -0,0 +1,403 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_KERNEL_APPROXIMATIoN_H__
+#define DLIB_KERNEL_APPROXIMATIoN_H__
+
+#include "kernel_approximation_abstract.h"
+#include <cmath>
+#include <vector>
+#include "../matrix.h"
+#include "../algs.h"
+#include "../rand.h"
+#include "../serialize.h"
+#include "../numeric_constants.h"
+#include "../threads.h"
+#include "kernel.h"
+#include "function.h"
+#include "empirical_kernel_map.h"
+#include "kernel_matrix_threaded.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename kern_type>
+    class random_fourier_features
+    {
+    public:
+
+        typedef kern_type kernel_type;
+        typedef typename kernel_type::sample_type sample_type;
+        typedef typename kernel_type::scalar_type scalar_type;
+        typedef typename kernel_type::mem_manager_type mem_manager_type;
+        typedef matrix<scalar_type,0,1,mem_manager_type> result_type;
+
+        // This object only works with the radial_basis_kernel on dense column vectors.
+        COMPILE_TIME_ASSERT((is_same_type<kernel_type, radial_basis_kernel<sample_type> >::value));
+        COMPILE_TIME_ASSERT(is_matrix<sample_type>::value && sample_type::NC == 1);
+
+        void clear (
+        )
+        {
+            random_fourier_features().swap(*this);
+        }
+
+        void load (
+            const kernel_type& kernel_,
+            long in_vector_size_,
+            long num_features,
+            dlib::rand& rnd
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(in_vector_size_ > 0 && num_features > 0,
+                "\t void random_fourier_features::load()"
+                << "\n\t Invalid inputs to this function."
+                << "\n\t in_vector_size_: " << in_vector_size_
+                << "\n\t num_features:    " << num_features
+                << "\n\t this: " << this
+                );
+
+            kernel = kernel_;
+
+            // The RBF kernel exp(-gamma*||a-b||^2) is the Fourier transform of a Gaussian
+            // with a variance of 2*gamma.  So draw the frequencies from that Gaussian and
+            // the phases uniformly from [0, 2*pi).
+            const scalar_type stddev = std::sqrt(2*kernel.gamma);
+            w.set_size(num_features, in_vector_size_);
+            b.set_size(num_features);
+            for (long r = 0; r < w.nr(); ++r)
+            {
+                for (long c = 0; c < w.nc(); ++c)
+                    w(r,c) = stddev*rnd.get_random_gaussian();
+                b(r) = 2*pi*rnd.get_random_double();
+            }
+            scale = std::sqrt(2.0/num_features);
+        }
+
+        const kernel_type get_kernel (
+        ) const
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(out_vector_size() > 0,
+                "\tconst kernel_type random_fourier_features::get_kernel()"
+                << "\n\t You have to load this object with a kernel before you can call this function"
+                << "\n\t this: " << this
+                );
+
+            return kernel;
+        }
+
+        long in_vector_size (
+        ) const { return w.nc(); }
+
+        long out_vector_size (
+        ) const { return w.nr(); }
+
+        const result_type& operator() (
+            const sample_type& samp
+        ) const { return project(samp); }
+
+        const result_type& project (
+            const sample_type& samp
+        ) const
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(out_vector_size() != 0 && samp.size() == in_vector_size(),
+                "\tconst matrix random_fourier_features::project()"
+                << "\n\t Invalid inputs to this function."
+                << "\n\t out_vector_size(): " << out_vector_size()
+                << "\n\t in_vector_size():  " << in_vector_size()
+                << "\n\t samp.size():       " << samp.size()
+                << "\n\t this: " << this
+                );
+
+            temp = w*samp + b;
+            for (long i = 0; i < temp.size(); ++i)
+                temp(i) = scale*std::cos(temp(i));
+            return temp;
+        }
+
+        template <typename EXP>
+        void project_block (
+            const matrix_exp<EXP>& samples,
+            matrix<scalar_type,0,0,mem_manager_type>& out
+        ) const
+        /*!
+            requires
+                - samples contains one sample in each row
+            ensures
+                - #out.nr() == samples.nr()
+                - #out.nc() == out_vector_size()
+                - rowm(#out,i) == trans(project(trans(rowm(samples,i))))
+        !*/
+        {
+            out = samples*trans(w);
+            for (long r = 0; r < out.nr(); ++r)
+            {
+                for (long c = 0; c < out.nc(); ++c)
+                    out(r,c) = scale*std::cos(out(r,c) + b(c));
+            }
+        }
+
+        void swap (
+            random_fourier_features& item
+        )
+        {
+            std::swap(kernel, item.kernel);
+            w.swap(item.w);
+            b.swap(item.b);
+            std::swap(scale, item.scale);
+            temp.swap(item.temp);
+        }
+
+        friend void serialize (
+            const random_fourier_features& item,
+            std::ostream& out
+        )
+        {
+            int version = 1;
+            serialize(version, out);
+            serialize(item.kernel, out);
+            serialize(item.w, out);
+            serialize(item.b, out);
+            serialize(item.scale, out);
+        }
+
+        friend void deserialize (
+            random_fourier_features& item,
+            std::istream& in
+        )
+        {
+            int version = 0;
+            deserialize(version, in);
+            if (version != 1)
+                throw serialization_error("Unexpected version found while deserializing dlib::random_fourier_features.");
+            deserialize(item.kernel, in);
+            deserialize(item.w, in);
+            deserialize(item.b, in);
+            deserialize(item.scale, in);
+        }
+
+        random_fourier_features (
+        ) : scale(0) {}
+
+    private:
+
+        kernel_type kernel;
+        matrix<scalar_type,0,0,mem_manager_type> w;
+        matrix<scalar_type,0,1,mem_manager_type> b;
+        scalar_type scale;
+
+        mutable result_type temp;
+    };
+
+    template <typename kernel_type>
+    void swap (
+        random_fourier_features<kernel_type>& a,
+        random_fourier_features<kernel_type>& b
+    ) { a.swap(b); }
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        template <typename K, typename sample_vector_type>
+        class project_samples_job
+        {
+            /*!
+                This object projects blocks of samples through a projection_function.  For
+                each block we compute the kernel matrix between the samples and the basis
+                vectors and then multiply it by the weights.
+            !*/
+            typedef typename K::scalar_type scalar_type;
+            typedef typename K::mem_manager_type mem_manager_type;
+            typedef matrix<scalar_type,0,1,mem_manager_type> result_type;
+        public:
+            project_samples_job (
+                const projection_function<K>& proj_,
+                const sample_vector_type& samples_,
+                std::vector<result_type>& out_,
+                long block_size_
+            ) : proj(proj_), samples(samples_), out(out_), block_size(block_size_)
+            {
+                out.resize(samples.size());
+            }
+
+            void do_block (
+                long i
+            )
+            {
+                const long begin = i*block_size;
+                const long end = std::min<long>(begin+block_size, samples.size());
+                matrix<scalar_type,0,0,mem_manager_type> kern_mat, Z;
+                kernel_matrix_threaded(proj.kernel_function,
+                                       rowm(mat(samples), range(begin, end-1)),
+                                       proj.basis_vectors, kern_mat, 1);
+                Z = kern_mat*trans(proj.weights);
+                for (long r = 0; r < Z.nr(); ++r)
+                    out[begin+r] = trans(rowm(Z,r));
+            }
+
+        private:
+            const projection_function<K>& proj;
+            const sample_vector_type& samples;
+            std::vector<result_type>& out;
+            const long block_size;
+        };
+
+        template <typename K, typename sample_vector_type>
+        class project_samples_rff_job
+        {
+            /*!
+                The same as project_samples_job except for random_fourier_features.  Each
+                block of samples is packed into the rows of a matrix and sent through
+                random_fourier_features::project_block().
+            !*/
+            typedef typename K::scalar_type scalar_type;
+            typedef typename K::mem_manager_type mem_manager_type;
+            typedef matrix<scalar_type,0,1,mem_manager_type> result_type;
+        public:
+            project_samples_rff_job (
+                const random_fourier_features<K>& rff_,
+                const sample_vector_type& samples_,
+                std::vector<result_type>& out_,
+                long block_size_
+            ) : rff(rff_), samples(samples_), out(out_), block_size(block_size_)
+            {
+                out.resize(samples.size());
+            }
+
+            void do_block (
+                long i
+            )
+            {
+                const long begin = i*block_size;
+                const long end = std::min<long>(begin+block_size, samples.size());
+                matrix<scalar_type,0,0,mem_manager_type> X, Z;
+                X.set_size(end-begin, rff.in_vector_size());
+                for (long r = begin; r < end; ++r)
+                {
+                    // make sure requires clause is not broken
+                    DLIB_ASSERT(samples[r].size() == rff.in_vector_size(),
+                        "\t std::vector project_samples()"
+                        << "\n\t All the samples must have rff.in_vector_size() dimensions."
+                        << "\n\t samples[r].size():     " << samples[r].size()
+                        << "\n\t rff.in_vector_size(): " << rff.in_vector_size()
+                        << "\n\t r: " << r
+                        );
+                    set_rowm(X,r-begin) = trans(samples[r]);
+                }
+                rff.project_block(X, Z);
+                for (long r = 0; r < Z.nr(); ++r)
+                    out[begin+r] = trans(rowm(Z,r));
+            }
+
+        private:
+            const random_fourier_features<K>& rff;
+            const sample_vector_type& samples;
+            std::vector<result_type>& out;
+            const long block_size;
+        };
+
+        template <typename job_type>
+        void run_project_samples_job (
+            job_type& job,
+            long num_samples,
+            long block_size,
+            unsigned long num_threads
+        )
+        {
+            const long num_blocks = (num_samples + block_size - 1)/block_size;
+            if (num_threads <= 1)
+            {
+                for (long i = 0; i < num_blocks; ++i)
+                    job.do_block(i);
+            }
+            else
+            {
+                parallel_for(num_threads, 0, num_blocks, job, &job_type::do_block, 2);
+            }
+        }
+
+        const long project_samples_block_size = 256;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename kernel_type, typename alloc>
+    const std::vector<matrix<typename kernel_type::scalar_type,0,1,typename kernel_type::mem_manager_type> >
+    project_samples (
+        const projection_function<kernel_type>& proj,
+        const std::vector<typename kernel_type::sample_type,alloc>& samples,
+        unsigned long num_threads = 1
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(proj.out_vector_size() > 0 &&
+                    proj.weights.nc() == proj.basis_vectors.size(),
+            "\t std::vector project_samples()"
+            << "\n\t Invalid inputs to this function."
+            << "\n\t proj.out_vector_size():     " << proj.out_vector_size()
+            << "\n\t proj.weights.nc():          " << proj.weights.nc()
+            << "\n\t proj.basis_vectors.size():  " << proj.basis_vectors.size()
+            );
+
+        typedef std::vector<typename kernel_type::sample_type,alloc> sample_vector_type;
+        std::vector<matrix<typename kernel_type::scalar_type,0,1,typename kernel_type::mem_manager_type> > out;
+        const long block_size = impl::project_samples_block_size;
+        impl::project_samples_job<kernel_type,sample_vector_type> job(proj, samples, out, block_size);
+        impl::run_project_samples_job(job, samples.size(), block_size, num_threads);
+        return out;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename kernel_type, typename alloc>
+    const std::vector<matrix<typename kernel_type::scalar_type,0,1,typename kernel_type::mem_manager_type> >
+    project_samples (
+        const empirical_kernel_map<kernel_type>& ekm,
+        const std::vector<typename kernel_type::sample_type,alloc>& samples,
+        unsigned long num_threads = 1
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(ekm.out_vector_size() > 0,
+            "\t std::vector project_samples()"
+            << "\n\t You have to load the empirical_kernel_map before you can use it."
+            );
+
+        return project_samples(ekm.get_projection_function(), samples, num_threads);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename kernel_type, typename alloc>
+    const std::vector<matrix<typename kernel_type::scalar_type,0,1,typename kernel_type::mem_manager_type> >
+    project_samples (
+        const random_fourier_features<kernel_type>& rff,
+        const std::vector<typename kernel_type::sample_type,alloc>& samples,
+        unsigned long num_threads = 1
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(rff.out_vector_size() > 0,
+            "\t std::vector project_samples()"
+            << "\n\t You have to load the random_fourier_features before you can use it."
+            );
+
+        typedef std::vector<typename kernel_type::sample_type,alloc> sample_vector_type;
+        std::vector<matrix<typename kernel_type::scalar_type,0,1,typename kernel_type::mem_manager_type> > out;
+        const long block_size = impl::project_samples_block_size;
+        impl::project_samples_rff_job<kernel_type,sample_vector_type> job(rff, samples, out, block_size);
+        impl::run_project_samples_job(job, samples.size(), block_size, num_threads);
+        return out;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_KERNEL_APPROXIMATIoN_H__
+
@@ -0,0 +1,261 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_KERNEL_APPROXIMATIoN_ABSTRACT_H__
+#ifdef DLIB_KERNEL_APPROXIMATIoN_ABSTRACT_H__
+
+#include <vector>
+#include "../matrix.h"
+#include "../rand.h"
+#include "kernel_abstract.h"
+#include "function_abstract.h"
+#include "empirical_kernel_map_abstract.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename kern_type>
+    class random_fourier_features
+    {
+        /*!
+            REQUIREMENTS ON kern_type
+                kern_type must be a radial_basis_kernel whose sample_type is a dense column
+                vector (e.g. radial_basis_kernel<matrix<double,0,1> >).
+
+            INITIAL VALUE
+                - out_vector_size() == 0
+                - in_vector_size() == 0
+
+            WHAT THIS OBJECT REPRESENTS
+                This object is an approximate feature map for the radial_basis_kernel.  It
+                maps each sample to a vector of random Fourier features (see the paper
+                Random Features for Large-Scale Kernel Machines by Rahimi and Recht).  The
+                key property is that for any two samples A and B:
+                    dot(project(A), project(B)) ~= get_kernel()(A,B)
+                and the approximation gets better as out_vector_size() grows.
+
+                So this object serves the same purpose as the empirical_kernel_map.  That
+                is, you can project your data with it and then run a linear algorithm (e.g.
+                the svm_c_linear_trainer) on the output to get an approximately kernelized
+                version of that algorithm.  However, unlike the empirical_kernel_map it
+                doesn't need any basis samples and the cost of projecting a sample doesn't
+                depend on the size of the training data.
+        !*/
+
+    public:
+
+        typedef kern_type kernel_type;
+        typedef typename kernel_type::sample_type sample_type;
+        typedef typename kernel_type::scalar_type scalar_type;
+        typedef typename kernel_type::mem_manager_type mem_manager_type;
+        typedef matrix<scalar_type,0,1,mem_manager_type> result_type;
+
+        random_fourier_features (
+        );
+        /*!
+            ensures
+                - this object is properly initialized
+        !*/
+
+        void clear (
+        );
+        /*!
+            ensures
+                - this object has its initial value
+        !*/
+
+        void load (
+            const kernel_type& kernel,
+            long in_vector_size,
+            long num_features,
+            dlib::rand& rnd
+        );
+        /*!
+            requires
+                - in_vector_size > 0
+                - num_features > 0
+            ensures
+                - #get_kernel() == kernel
+                - #in_vector_size() == in_vector_size
+                - #out_vector_size() == num_features
+                - Draws num_features random frequencies and phases using rnd.  So if you
+                  want two random_fourier_features objects to be the same then load them
+                  with identically seeded random number generators.
+        !*/
+
+        const kernel_type get_kernel (
+        ) const;
+        /*!
+            requires
+                - out_vector_size() != 0
+            ensures
+                - returns the kernel this object approximates
+        !*/
+
+        long in_vector_size (
+        ) const;
+        /*!
+            ensures
+                - returns the dimensionality of the samples this object can project.
+        !*/
+
+        long out_vector_size (
+        ) const;
+        /*!
+            ensures
+                - returns the dimensionality of the vectors output by project().
+        !*/
+
+        const result_type& project (
+            const sample_type& samp
+        ) const;
+        /*!
+            requires
+                - out_vector_size() != 0
+                - samp.size() == in_vector_size()
+            ensures
+                - returns the random Fourier features for samp.  That is, a vector R such
+                  that R.size() == out_vector_size() and dot(project(A),project(B)) is
+                  approximately get_kernel()(A,B).
+                - Note that the returned vector is stored inside this object and will be
+                  overwritten by the next call to project().  So you should copy it if you
+                  need to keep it.
+        !*/
+
+        const result_type& operator() (
+            const sample_type& samp
+        ) const;
+        /*!
+            requires
+                - out_vector_size() != 0
+                - samp.size() == in_vector_size()
+            ensures
+                - returns project(samp)
+        !*/
+
+        template <typename EXP>
+        void project_block (
+            const matrix_exp<EXP>& samples,
+            matrix<scalar_type,0,0,mem_manager_type>& out
+        ) const;
+        /*!
+            requires
+                - out_vector_size() != 0
+                - samples.nc() == in_vector_size()
+            ensures
+                - Projects all the samples in the rows of samples with a single matrix
+                  multiply.  That is:
+                    - #out.nr() == samples.nr()
+                    - #out.nc() == out_vector_size()
+                    - for all valid i: rowm(#out,i) == trans(project(trans(rowm(samples,i))))
+        !*/
+
+        void swap (
+            random_fourier_features& item
+        );
+        /*!
+            ensures
+                - swaps the state of *this and item
+        !*/
+    };
+
+    template <typename kernel_type>
+    void swap (
+        random_fourier_features<kernel_type>& a,
+        random_fourier_features<kernel_type>& b
+    ) { a.swap(b); }
+    /*!
+        provides a global swap function
+    !*/
+
+    template <typename kernel_type>
+    void serialize (
+        const random_fourier_features<kernel_type>& item,
+        std::ostream& out
+    );
+    /*!
+        provides serialization support for random_fourier_features objects
+    !*/
+
+    template <typename kernel_type>
+    void deserialize (
+        random_fourier_features<kernel_type>& item,
+        std::istream& in
+    );
+    /*!
+        provides serialization support for random_fourier_features objects
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename kernel_type, typename alloc>
+    const std::vector<matrix<typename kernel_type::scalar_type,0,1,typename kernel_type::mem_manager_type> >
+    project_samples (
+        const projection_function<kernel_type>& proj,
+        const std::vector<typename kernel_type::sample_type,alloc>& samples,
+        unsigned long num_threads = 1
+    );
+    /*!
+        requires
+            - proj.out_vector_size() > 0
+            - proj.weights.nc() == proj.basis_vectors.size()
+        ensures
+            - returns a vector R such that:
+                - R.size() == samples.size()
+                - for all valid i: R[i] == proj(samples[i])
+            - The samples are processed in blocks.  For each block the kernel matrix
+              between the samples and the basis vectors is computed with
+              kernel_matrix_threaded() and then multiplied by proj.weights.  So for dense
+              radial_basis_kernel, linear_kernel, polynomial_kernel, and sigmoid_kernel
+              samples all the work is done with matrix multiplies.  The blocks are
+              processed in parallel using num_threads threads.
+            - Note that since kernel_matrix_threaded() may compute kernels slightly
+              differently from the kernel objects themselves the outputs may differ from
+              proj(samples[i]) by a small amount of rounding error.
+    !*/
+
+    template <typename kernel_type, typename alloc>
+    const std::vector<matrix<typename kernel_type::scalar_type,0,1,typename kernel_type::mem_manager_type> >
+    project_samples (
+        const empirical_kernel_map<kernel_type>& ekm,
+        const std::vector<typename kernel_type::sample_type,alloc>& samples,
+        unsigned long num_threads = 1
+    );
+    /*!
+        requires
+            - ekm.out_vector_size() > 0
+        ensures
+            - returns project_samples(ekm.get_projection_function(), samples, num_threads)
+              (i.e. returns the Nystrom projections of all the samples.  This is the
+              same as calling ekm.project() on each sample except that it is much faster.)
+            - The basis of ekm can be any set of landmark samples.  Good choices are
+              a random subset of the data (see randomly_subsample()) or the centers
+              found by k-means (see find_clusters_using_kmeans()).
+    !*/
+
+    template <typename kernel_type, typename alloc>
+    const std::vector<matrix<typename kernel_type::scalar_type,0,1,typename kernel_type::mem_manager_type> >
+    project_samples (
+        const random_fourier_features<kernel_type>& rff,
+        const std::vector<typename kernel_type::sample_type,alloc>& samples,
+        unsigned long num_threads = 1
+    );
+    /*!
+        requires
+            - rff.out_vector_size() > 0
+            - for all valid i: samples[i].size() == rff.in_vector_size()
+        ensures
+            - returns a vector R such that:
+                - R.size() == samples.size()
+                - for all valid i: R[i] == rff.project(samples[i])
+            - The samples are projected in blocks with rff.project_block() and the
+              blocks are processed in parallel using num_threads threads.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_KERNEL_APPROXIMATIoN_ABSTRACT_H__
+
@@ -0,0 +1,380 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_KERNEL_MATRIX_THREADeD_H__
+#define DLIB_KERNEL_MATRIX_THREADeD_H__
+
+#include "kernel_matrix_threaded_abstract.h"
+#include <cmath>
+#include <vector>
+#include "kernel_matrix.h"
+#include "kernel.h"
+#include "../matrix.h"
+#include "../algs.h"
+#include "../threads.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        /*
+            The kernels below are all functions of the dot products between samples (and
+            in the case of the RBF kernel, the squared norms of the samples since
+            ||a-b||^2 == ||a||^2 + ||b||^2 - 2*dot(a,b)).  So for dense samples we can
+            compute a whole block of the kernel matrix with one matrix multiply and then
+            transform the dot products into kernel values.  gemm_kernel_traits tells us
+            which kernels we can do this for.
+        */
+
+        template <typename kernel_type>
+        struct gemm_kernel_traits
+        {
+            const static bool value = false;
+        };
+
+        template <typename T, long NR, typename MM, typename L>
+        struct gemm_kernel_traits<radial_basis_kernel<matrix<T,NR,1,MM,L> > >
+        {
+            const static bool value = true;
+            const static bool needs_norms = true;
+
+            static T eval (
+                const radial_basis_kernel<matrix<T,NR,1,MM,L> >& kern,
+                const T dot,
+                const T norm1,
+                const T norm2
+            )
+            {
+                // Rounding can make the distance come out slightly negative for samples
+                // that are very close together so clamp it at 0.
+                const T d = std::max<T>(norm1 + norm2 - 2*dot, 0);
+                return std::exp(-kern.gamma*d);
+            }
+        };
+
+        template <typename T, long NR, typename MM, typename L>
+        struct gemm_kernel_traits<linear_kernel<matrix<T,NR,1,MM,L> > >
+        {
+            const static bool value = true;
+            const static bool needs_norms = false;
+
+            static T eval (
+                const linear_kernel<matrix<T,NR,1,MM,L> >& ,
+                const T dot,
+                const T ,
+                const T
+            )
+            {
+                return dot;
+            }
+        };
+
+        template <typename T, long NR, typename MM, typename L>
+        struct gemm_kernel_traits<polynomial_kernel<matrix<T,NR,1,MM,L> > >
+        {
+            const static bool value = true;
+            const static bool needs_norms = false;
+
+            static T eval (
+                const polynomial_kernel<matrix<T,NR,1,MM,L> >& kern,
+                const T dot,
+                const T ,
+                const T
+            )
+            {
+                return std::pow(kern.gamma*dot + kern.coef, kern.degree);
+            }
+        };
+
+        template <typename T, long NR, typename MM, typename L>
+        struct gemm_kernel_traits<sigmoid_kernel<matrix<T,NR,1,MM,L> > >
+        {
+            const static bool value = true;
+            const static bool needs_norms = false;
+
+            static T eval (
+                const sigmoid_kernel<matrix<T,NR,1,MM,L> >& kern,
+                const T dot,
+                const T ,
+                const T
+            )
+            {
+                return std::tanh(kern.gamma*dot + kern.coef);
+            }
+        };
+
+    // ------------------------------------------------------------------------------------
+
+        struct kernel_matrix_block
+        {
+            long r_begin, r_end;
+            long c_begin, c_end;
+        };
+
+        inline void make_kernel_matrix_blocks (
+            std::vector<kernel_matrix_block>& blocks,
+            const long nr,
+            const long nc,
+            const bool symmetric,
+            const long block_size
+        )
+        /*!
+            ensures
+                - #blocks tiles the nr by nc output matrix.  If symmetric then only the
+                  blocks on or above the diagonal are included.
+        !*/
+        {
+            blocks.clear();
+            for (long r = 0; r < nr; r += block_size)
+            {
+                for (long c = (symmetric ? r : 0); c < nc; c += block_size)
+                {
+                    kernel_matrix_block b;
+                    b.r_begin = r;
+                    b.r_end = std::min(r+block_size, nr);
+                    b.c_begin = c;
+                    b.c_end = std::min(c+block_size, nc);
+                    blocks.push_back(b);
+                }
+            }
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        template <
+            typename K,
+            typename V1,
+            typename V2,
+            typename dest_type,
+            bool use_gemm = gemm_kernel_traits<K>::value
+            >
+        class kernel_matrix_job
+        {
+            /*!
+                This is the general version.  It just calls the kernel for each element of
+                the blocks.
+            !*/
+        public:
+            kernel_matrix_job (
+                const K& kern_,
+                const V1& v1_,
+                const V2& v2_,
+                dest_type& dest_,
+                const bool symmetric_
+            ) : kern(kern_), v1(v1_), v2(v2_), dest(dest_), symmetric(symmetric_)
+            {
+                make_kernel_matrix_blocks(blocks, dest.nr(), dest.nc(), symmetric, 64);
+            }
+
+            long num_blocks() const { return blocks.size(); }
+
+            void do_block (
+                long i
+            )
+            {
+                const kernel_matrix_block& b = blocks[i];
+                for (long r = b.r_begin; r < b.r_end; ++r)
+                {
+                    const long c_begin = (symmetric && b.c_begin == b.r_begin) ? r : b.c_begin;
+                    for (long c = c_begin; c < b.c_end; ++c)
+                    {
+                        dest(r,c) = kern(access<K>(v1,r), access<K>(v2,c));
+                        if (symmetric)
+                            dest(c,r) = dest(r,c);
+                    }
+                }
+            }
+
+        private:
+            const K& kern;
+            const V1& v1;
+            const V2& v2;
+            dest_type& dest;
+            const bool symmetric;
+            std::vector<kernel_matrix_block> blocks;
+        };
+
+        template <
+            typename K,
+            typename V1,
+            typename V2,
+            typename dest_type
+            >
+        class kernel_matrix_job<K,V1,V2,dest_type,true>
+        {
+            /*!
+                This is the version for kernels that can be evaluated in blocks with a
+                matrix multiply.
+            !*/
+            typedef typename K::scalar_type scalar_type;
+            typedef typename K::mem_manager_type mem_manager_type;
+            typedef gemm_kernel_traits<K> traits;
+        public:
+            kernel_matrix_job (
+                const K& kern_,
+                const V1& v1,
+                const V2& v2,
+                dest_type& dest_,
+                const bool symmetric_
+            ) : kern(kern_), dest(dest_), symmetric(symmetric_)
+            {
+                make_kernel_matrix_blocks(blocks, dest.nr(), dest.nc(), symmetric, 128);
+
+                // Pack the samples into the rows of X1 and X2.  Then each block of the
+                // kernel matrix is a function of subm(X1)*trans(subm(X2)).
+                load(v1, X1, norms1);
+                if (!symmetric)
+                    load(v2, X2, norms2);
+            }
+
+            long num_blocks() const { return blocks.size(); }
+
+            void do_block (
+                long i
+            )
+            {
+                const kernel_matrix_block& b = blocks[i];
+                const matrix<scalar_type,0,0,mem_manager_type>& Y1 = X1;
+                const matrix<scalar_type,0,0,mem_manager_type>& Y2 = symmetric ? X1 : X2;
+                const matrix<scalar_type,0,1,mem_manager_type>& n1 = norms1;
+                const matrix<scalar_type,0,1,mem_manager_type>& n2 = symmetric ? norms1 : norms2;
+
+                matrix<scalar_type,0,0,mem_manager_type> dots;
+                dots = subm(Y1, b.r_begin, 0, b.r_end-b.r_begin, Y1.nc()) *
+                       trans(subm(Y2, b.c_begin, 0, b.c_end-b.c_begin, Y2.nc()));
+
+                for (long r = b.r_begin; r < b.r_end; ++r)
+                {
+                    const long c_begin = (symmetric && b.c_begin == b.r_begin) ? r : b.c_begin;
+                    for (long c = c_begin; c < b.c_end; ++c)
+                    {
+                        dest(r,c) = traits::eval(kern, dots(r-b.r_begin, c-b.c_begin),
+                                                 traits::needs_norms ? n1(r) : 0,
+                                                 traits::needs_norms ? n2(c) : 0);
+                        if (symmetric)
+                            dest(c,r) = dest(r,c);
+                    }
+                }
+            }
+
+        private:
+
+            template <typename V>
+            void load (
+                const V& v,
+                matrix<scalar_type,0,0,mem_manager_type>& X,
+                matrix<scalar_type,0,1,mem_manager_type>& norms
+            ) const
+            {
+                const long n = size<K>(v);
+                if (n == 0)
+                    return;
+
+                const long dims = access<K>(v,0).size();
+                X.set_size(n, dims);
+                if (traits::needs_norms)
+                    norms.set_size(n);
+                for (long i = 0; i < n; ++i)
+                {
+                    // make sure requires clause is not broken
+                    DLIB_ASSERT(access<K>(v,i).size() == dims,
+                        "\t void kernel_matrix_threaded()"
+                        << "\n\t All the samples must have the same dimensionality."
+                        << "\n\t access<K>(v,i).size(): " << access<K>(v,i).size()
+                        << "\n\t dims: " << dims
+                        << "\n\t i:    " << i
+                        );
+
+                    set_rowm(X,i) = trans(access<K>(v,i));
+                    if (traits::needs_norms)
+                        norms(i) = length_squared(access<K>(v,i));
+                }
+            }
+
+            const K& kern;
+            dest_type& dest;
+            const bool symmetric;
+            std::vector<kernel_matrix_block> blocks;
+
+            matrix<scalar_type,0,0,mem_manager_type> X1, X2;
+            matrix<scalar_type,0,1,mem_manager_type> norms1, norms2;
+        };
+
+        template <typename job_type>
+        void run_kernel_matrix_job (
+            job_type& job,
+            unsigned long num_threads
+        )
+        {
+            if (num_threads <= 1)
+            {
+                for (long i = 0; i < job.num_blocks(); ++i)
+                    job.do_block(i);
+            }
+            else
+            {
+                parallel_for(num_threads, 0, job.num_blocks(), job, &job_type::do_block, 4);
+            }
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename kernel_type,
+        typename V,
+        typename T,
+        typename MM,
+        typename L
+        >
+    void kernel_matrix_threaded (
+        const kernel_type& kern,
+        const V& v,
+        matrix<T,0,0,MM,L>& K,
+        unsigned long num_threads
+    )
+    {
+        impl::assert_is_vector(v);
+
+        const long n = impl::size<kernel_type>(v);
+        K.set_size(n, n);
+
+        impl::kernel_matrix_job<kernel_type,V,V,matrix<T,0,0,MM,L> > job(kern, v, v, K, true);
+        impl::run_kernel_matrix_job(job, num_threads);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename kernel_type,
+        typename V1,
+        typename V2,
+        typename T,
+        typename MM,
+        typename L
+        >
+    void kernel_matrix_threaded (
+        const kernel_type& kern,
+        const V1& v1,
+        const V2& v2,
+        matrix<T,0,0,MM,L>& K,
+        unsigned long num_threads
+    )
+    {
+        impl::assert_is_vector(v1);
+        impl::assert_is_vector(v2);
+
+        K.set_size(impl::size<kernel_type>(v1), impl::size<kernel_type>(v2));
+
+        impl::kernel_matrix_job<kernel_type,V1,V2,matrix<T,0,0,MM,L> > job(kern, v1, v2, K, false);
+        impl::run_kernel_matrix_job(job, num_threads);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_KERNEL_MATRIX_THREADeD_H__
+
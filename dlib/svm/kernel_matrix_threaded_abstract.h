@@ -0,0 +1,98 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_KERNEL_MATRIX_THREADeD_ABSTRACT_H__
+#ifdef DLIB_KERNEL_MATRIX_THREADeD_ABSTRACT_H__
+
+#include "kernel_matrix_abstract.h"
+#include "../matrix/matrix_abstract.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename kernel_type,
+        typename V,
+        typename T,
+        typename MM,
+        typename L
+        >
+    void kernel_matrix_threaded (
+        const kernel_type& kern,
+        const V& v,
+        matrix<T,0,0,MM,L>& K,
+        unsigned long num_threads
+    );
+    /*!
+        requires
+            - kern == a kernel function object as defined by the file dlib/svm/kernel_abstract.h.
+              This kernel must also be capable of operating on the contents of v.
+            - V == dlib::matrix, std::vector, dlib::std_vector_c, dlib::random_subset_selector,
+              dlib::linearly_independent_subset_finder, or kernel_type::sample_type.
+            - if (V is a dlib::matrix) then
+                - is_vector(v) == true
+            - T == float or double.  Note that T doesn't need to be the same as
+              kernel_type::scalar_type.  So for instance, you can store a double precision
+              kernel matrix in a matrix<float> to use half the memory.
+        ensures
+            - #K == matrix_cast<T>(kernel_matrix(kern, v))
+              (i.e. #K contains the kernel matrix for the samples in v)
+            - The matrix is computed in blocks using num_threads threads.  Since the kernel
+              matrix is symmetric only the blocks on or above the diagonal are computed and
+              the others are filled in by copying.
+            - if (kernel_type is a radial_basis_kernel, linear_kernel, polynomial_kernel,
+              or sigmoid_kernel and its sample_type is a dense column vector) then
+                - The dot products between the samples are computed one block at a time
+                  with a matrix multiply (which uses BLAS if DLIB_USE_BLAS is defined) and
+                  then transformed into kernel values.  For the radial_basis_kernel this
+                  uses the identity ||a-b||^2 == ||a||^2 + ||b||^2 - 2*dot(a,b).  This is
+                  much faster than calling the kernel for each element but the results can
+                  differ from kernel_matrix() by a small amount of rounding error.
+                - All the samples in v must have the same dimensionality.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename kernel_type,
+        typename V1,
+        typename V2,
+        typename T,
+        typename MM,
+        typename L
+        >
+    void kernel_matrix_threaded (
+        const kernel_type& kern,
+        const V1& v1,
+        const V2& v2,
+        matrix<T,0,0,MM,L>& K,
+        unsigned long num_threads
+    );
+    /*!
+        requires
+            - kern == a kernel function object as defined by the file dlib/svm/kernel_abstract.h.
+              This kernel must also be capable of operating on the contents of v1 and v2.
+            - V1 == dlib::matrix, std::vector, dlib::std_vector_c, dlib::random_subset_selector,
+              dlib::linearly_independent_subset_finder, or kernel_type::sample_type.
+            - V2 == dlib::matrix, std::vector, dlib::std_vector_c, dlib::random_subset_selector,
+              dlib::linearly_independent_subset_finder, or kernel_type::sample_type.
+            - if (V1 is a dlib::matrix) then
+                - is_vector(v1) == true
+            - if (V2 is a dlib::matrix) then
+                - is_vector(v2) == true
+            - T == float or double
+        ensures
+            - #K == matrix_cast<T>(kernel_matrix(kern, v1, v2))
+            - This function is just like the version of kernel_matrix_threaded() defined
+              above except that it computes a rectangular kernel matrix between two sets of
+              samples.  So no use is made of symmetry but all the other speedups still
+              apply.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_KERNEL_MATRIX_THREADeD_ABSTRACT_H__
+
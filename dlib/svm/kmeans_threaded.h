@@ -0,0 +1,630 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_KMEANS_THREADeD_H__
+#define DLIB_KMEANS_THREADeD_H__
+
+#include "kmeans_threaded_abstract.h"
+#include <cmath>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include "../matrix.h"
+#include "../algs.h"
+#include "../rand.h"
+#include "../threads.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        template <typename T, typename U>
+        inline double kmeans_squared_distance (
+            const T& a,
+            const U& b
+        )
+        {
+            // Always accumulate in double so float samples don't lose precision.
+            double sum = 0;
+            for (long k = 0; k < a.size(); ++k)
+            {
+                const double d = static_cast<double>(a(k)) - static_cast<double>(b(k));
+                sum += d*d;
+            }
+            return sum;
+        }
+
+        template <typename vector_type>
+        void check_kmeans_samples (
+            const vector_type& samples
+        )
+        {
+#ifdef ENABLE_ASSERTS
+            const long nr = samples[0].nr();
+            const long nc = samples[0].nc();
+            for (unsigned long i = 0; i < samples.size(); ++i)
+            {
+                DLIB_ASSERT(is_vector(samples[i]) && samples[i].nr() == nr && samples[i].nc() == nc,
+                    "\tvoid find_clusters_using_kmeans()"
+                    << "\n\t You passed invalid arguments to this function"
+                    << "\n\t is_vector(samples[i]): " << is_vector(samples[i])
+                    << "\n\t samples[i].nr():       " << samples[i].nr()
+                    << "\n\t nr:                    " << nr
+                    << "\n\t samples[i].nc():       " << samples[i].nc()
+                    << "\n\t nc:                    " << nc
+                    << "\n\t i:                     " << i
+                    );
+            }
+#else
+            // avoid unused parameter warnings
+            (void)samples;
+#endif
+        }
+
+        const long kmeans_block_size = 1024;
+
+    // ------------------------------------------------------------------------------------
+
+        template <
+            typename vector_type,
+            typename sample_type,
+            typename alloc
+            >
+        class hamerly_kmeans
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This object runs Lloyd's k-means algorithm using the bounds from the
+                    paper Making k-means even faster by Greg Hamerly.  For each sample we
+                    keep an upper bound on the distance to its assigned center and a lower
+                    bound on the distance to every other center.  Each time the centers
+                    move the bounds are loosened by how far the centers moved.  Then a
+                    sample only needs to be compared to all the centers when its upper
+                    bound is no longer below its lower bound (or half the distance from
+                    its center to the nearest other center).  This gives the same
+                    assignments as comparing every sample to every center but usually
+                    skips the vast majority of the distance computations.
+
+                    Unlike Elkan's algorithm, which keeps one lower bound for each sample
+                    and center pair, this only needs O(samples.size()) extra memory.  So
+                    it is usable with millions of samples and thousands of centers.
+
+                    The assignment step is done in parallel over blocks of samples and the
+                    center update in parallel over centers.  Each center is always
+                    computed by summing its samples in order, so the results don't depend
+                    on the number of threads.
+            !*/
+        public:
+            hamerly_kmeans (
+                const vector_type& samples_,
+                std::vector<sample_type,alloc>& centers_,
+                const unsigned long num_threads
+            ) :
+                samples(samples_),
+                centers(centers_),
+                num_blocks((samples_.size()+kmeans_block_size-1)/kmeans_block_size),
+                first_pass(true),
+                tp(num_threads > 1 ? num_threads : 0)
+            {
+                const unsigned long n = samples.size();
+                const unsigned long k = centers.size();
+                assignments.assign(n, 0);
+                upper.assign(n, 0);
+                lower.assign(n, 0);
+                half_separation.assign(k, 0);
+                moved.assign(k, 0);
+                block_changed.assign(num_blocks, 0);
+                counts.assign(k, 0);
+                starts.assign(k+1, 0);
+                members.resize(n);
+                max_moved = 0;
+                second_max_moved = 0;
+                max_moved_idx = 0;
+            }
+
+            void run (
+                const unsigned long max_iter
+            )
+            {
+                for (unsigned long iter = 0; iter < max_iter; ++iter)
+                {
+                    parallel_for(tp, 0, num_blocks, *this, &hamerly_kmeans::assign_block, 4);
+                    const bool changed = std::find(block_changed.begin(), block_changed.end(), 1) != block_changed.end();
+                    if (!changed && !first_pass)
+                        break;
+                    first_pass = false;
+
+                    update_centers();
+                }
+            }
+
+            const std::vector<unsigned long>& get_assignments (
+            ) const { return assignments; }
+
+            void assign_block (
+                long b
+            )
+            {
+                const unsigned long begin = b*kmeans_block_size;
+                const unsigned long end = std::min<unsigned long>(begin+kmeans_block_size, samples.size());
+                char changed = 0;
+                for (unsigned long i = begin; i < end; ++i)
+                {
+                    if (!first_pass)
+                    {
+                        const unsigned long a = assignments[i];
+                        upper[i] += moved[a];
+                        lower[i] -= (a == max_moved_idx) ? second_max_moved : max_moved;
+
+                        const double m = std::max(half_separation[a], lower[i]);
+                        if (upper[i] <= m)
+                            continue;
+                        // tighten the upper bound and check again
+                        upper[i] = std::sqrt(kmeans_squared_distance(samples[i], centers[a]));
+                        if (upper[i] <= m)
+                            continue;
+                    }
+
+                    // Compare the sample to all the centers.
+                    double best = std::numeric_limits<double>::infinity();
+                    double second_best = std::numeric_limits<double>::infinity();
+                    unsigned long best_center = 0;
+                    for (unsigned long j = 0; j < centers.size(); ++j)
+                    {
+                        const double dist = kmeans_squared_distance(samples[i], centers[j]);
+                        if (dist < best)
+                        {
+                            second_best = best;
+                            best = dist;
+                            best_center = j;
+                        }
+                        else if (dist < second_best)
+                        {
+                            second_best = dist;
+                        }
+                    }
+
+                    if (first_pass || assignments[i] != best_center)
+                    {
+                        assignments[i] = best_center;
+                        changed = 1;
+                    }
+                    upper[i] = std::sqrt(best);
+                    lower[i] = std::sqrt(second_best);
+                }
+                block_changed[b] = changed;
+            }
+
+            void update_center (
+                long j
+            )
+            {
+                if (counts[j] == 0)
+                {
+                    // Leave centers without any samples where they are.
+                    moved[j] = 0;
+                    return;
+                }
+
+                sample_type& c = centers[j];
+                matrix<double,0,1> sum(c.size());
+                sum = 0;
+                for (unsigned long m = starts[j]; m < starts[j+1]; ++m)
+                {
+                    const typename vector_type::value_type& samp = samples[members[m]];
+                    for (long k = 0; k < sum.size(); ++k)
+                        sum(k) += samp(k);
+                }
+
+                typedef typename sample_type::type scalar_type;
+                double dist = 0;
+                for (long k = 0; k < sum.size(); ++k)
+                {
+                    const scalar_type val = static_cast<scalar_type>(sum(k)/counts[j]);
+                    const double d = static_cast<double>(val) - static_cast<double>(c(k));
+                    dist += d*d;
+                    c(k) = val;
+                }
+                moved[j] = std::sqrt(dist);
+            }
+
+            void compute_separation (
+                long j
+            )
+            {
+                double best = std::numeric_limits<double>::infinity();
+                for (unsigned long i = 0; i < centers.size(); ++i)
+                {
+                    if (i != (unsigned long)j)
+                        best = std::min(best, kmeans_squared_distance(centers[i], centers[j]));
+                }
+                half_separation[j] = 0.5*std::sqrt(best);
+            }
+
+        private:
+
+            void update_centers (
+            )
+            {
+                const unsigned long k = centers.size();
+
+                // Bucket the samples by center so each center can be summed up
+                // independently.
+                counts.assign(k, 0);
+                for (unsigned long i = 0; i < assignments.size(); ++i)
+                    ++counts[assignments[i]];
+                starts[0] = 0;
+                for (unsigned long j = 0; j < k; ++j)
+                    starts[j+1] = starts[j] + counts[j];
+                pos.assign(starts.begin(), starts.end()-1);
+                for (unsigned long i = 0; i < assignments.size(); ++i)
+                    members[pos[assignments[i]]++] = i;
+
+                parallel_for(tp, 0, k, *this, &hamerly_kmeans::update_center, 4);
+                parallel_for(tp, 0, k, *this, &hamerly_kmeans::compute_separation, 4);
+
+                max_moved = 0;
+                second_max_moved = 0;
+                max_moved_idx = 0;
+                for (unsigned long j = 0; j < k; ++j)
+                {
+                    if (moved[j] > max_moved)
+                    {
+                        second_max_moved = max_moved;
+                        max_moved = moved[j];
+                        max_moved_idx = j;
+                    }
+                    else if (moved[j] > second_max_moved)
+                    {
+                        second_max_moved = moved[j];
+                    }
+                }
+            }
+
+            const vector_type& samples;
+            std::vector<sample_type,alloc>& centers;
+            const unsigned long num_blocks;
+            bool first_pass;
+
+            std::vector<unsigned long> assignments;
+            std::vector<double> upper;
+            std::vector<double> lower;
+            std::vector<double> half_separation;
+            std::vector<double> moved;
+            std::vector<char> block_changed;
+            double max_moved;
+            double second_max_moved;
+            unsigned long max_moved_idx;
+
+            std::vector<unsigned long> counts;
+            std::vector<unsigned long> starts;
+            std::vector<unsigned long> pos;
+            std::vector<unsigned long> members;
+
+            thread_pool tp;
+        };
+
+    // ------------------------------------------------------------------------------------
+
+        template <
+            typename vector_type1,
+            typename vector_type2
+            >
+        class kmeanspp_helper
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This object keeps track of the squared distance from each sample to
+                    its nearest center during kmeans++ seeding.  The distances are
+                    updated and summed over fixed blocks of samples in parallel.  Since the
+                    blocks don't depend on the number of threads neither do the sums, so
+                    the same centers are picked regardless of the number of threads.
+            !*/
+        public:
+            kmeanspp_helper (
+                const vector_type1& centers_,
+                const vector_type2& samples_
+            ) :
+                centers(centers_),
+                samples(samples_),
+                num_blocks((samples_.size()+kmeans_block_size-1)/kmeans_block_size),
+                dists(samples_.size(), std::numeric_limits<double>::infinity()),
+                block_sums(num_blocks, 0)
+            {}
+
+            void add_center (
+                thread_pool& tp
+            )
+            {
+                parallel_for(tp, 0, num_blocks, *this, &kmeanspp_helper::update_block, 4);
+            }
+
+            unsigned long pick_sample (
+                dlib::rand& rnd
+            ) const
+            /*!
+                ensures
+                    - returns a random sample index, chosen with probability proportional
+                      to the squared distance between the sample and its nearest center.
+            !*/
+            {
+                double total = 0;
+                for (unsigned long b = 0; b < num_blocks; ++b)
+                    total += block_sums[b];
+
+                // If all the samples are on top of the centers then any sample will do.
+                if (!(total > 0))
+                    return rnd.get_random_64bit_number()%samples.size();
+
+                double r = rnd.get_random_double()*total;
+                unsigned long b = 0;
+                while (b+1 < num_blocks && r >= block_sums[b])
+                {
+                    r -= block_sums[b];
+                    ++b;
+                }
+
+                const unsigned long begin = b*kmeans_block_size;
+                const unsigned long end = std::min<unsigned long>(begin+kmeans_block_size, samples.size());
+                unsigned long last = begin;
+                for (unsigned long i = begin; i < end; ++i)
+                {
+                    if (dists[i] > 0)
+                    {
+                        last = i;
+                        if (r < dists[i])
+                            return i;
+                        r -= dists[i];
+                    }
+                }
+                // We can only get here because of rounding error.
+                return last;
+            }
+
+            void update_block (
+                long b
+            )
+            {
+                const unsigned long begin = b*kmeans_block_size;
+                const unsigned long end = std::min<unsigned long>(begin+kmeans_block_size, samples.size());
+                const typename vector_type1::value_type& c = centers[centers.size()-1];
+                double sum = 0;
+                for (unsigned long i = begin; i < end; ++i)
+                {
+                    dists[i] = std::min(dists[i], kmeans_squared_distance(samples[i], c));
+                    sum += dists[i];
+                }
+                block_sums[b] = sum;
+            }
+
+        private:
+            const vector_type1& centers;
+            const vector_type2& samples;
+            const unsigned long num_blocks;
+            std::vector<double> dists;
+            std::vector<double> block_sums;
+        };
+
+    // ------------------------------------------------------------------------------------
+
+        template <
+            typename vector_type,
+            typename sample_type,
+            typename alloc
+            >
+        class minibatch_assigner
+        {
+        public:
+            minibatch_assigner (
+                const vector_type& samples_,
+                const std::vector<sample_type,alloc>& centers_,
+                const std::vector<unsigned long>& batch_,
+                std::vector<unsigned long>& assignments_
+            ) : samples(samples_), centers(centers_), batch(batch_), assignments(assignments_) {}
+
+            void assign (
+                long i
+            )
+            {
+                const typename vector_type::value_type& samp = samples[batch[i]];
+                double best = std::numeric_limits<double>::infinity();
+                unsigned long best_center = 0;
+                for (unsigned long j = 0; j < centers.size(); ++j)
+                {
+                    const double dist = kmeans_squared_distance(samp, centers[j]);
+                    if (dist < best)
+                    {
+                        best = dist;
+                        best_center = j;
+                    }
+                }
+                assignments[i] = best_center;
+            }
+
+        private:
+            const vector_type& samples;
+            const std::vector<sample_type,alloc>& centers;
+            const std::vector<unsigned long>& batch;
+            std::vector<unsigned long>& assignments;
+        };
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename vector_type1, 
+        typename vector_type2
+        >
+    void pick_initial_centers_kmeanspp (
+        long num_centers, 
+        vector_type1& centers, 
+        const vector_type2& samples, 
+        const unsigned long num_threads,
+        dlib::rand& rnd
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(num_centers > 0 && samples.size() > 0 && num_threads > 0,
+            "\tvoid pick_initial_centers_kmeanspp()"
+            << "\n\tYou passed invalid arguments to this function"
+            << "\n\tnum_centers:     " << num_centers 
+            << "\n\tsamples.size():  " << samples.size() 
+            << "\n\tnum_threads:     " << num_threads 
+            );
+
+        centers.clear();
+        centers.push_back(samples[rnd.get_random_64bit_number()%samples.size()]);
+
+        thread_pool tp(num_threads > 1 ? num_threads : 0);
+        impl::kmeanspp_helper<vector_type1,vector_type2> helper(centers, samples);
+        for (long i = 1; i < num_centers; ++i)
+        {
+            helper.add_center(tp);
+            centers.push_back(samples[helper.pick_sample(rnd)]);
+        }
+    }
+
+    template <
+        typename vector_type1, 
+        typename vector_type2
+        >
+    void pick_initial_centers_kmeanspp (
+        long num_centers, 
+        vector_type1& centers, 
+        const vector_type2& samples, 
+        const unsigned long num_threads = 1
+    )
+    {
+        dlib::rand rnd;
+        pick_initial_centers_kmeanspp(num_centers, centers, samples, num_threads, rnd);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename vector_type, 
+        typename sample_type,
+        typename alloc
+        >
+    void find_clusters_using_kmeans_threaded (
+        const vector_type& samples,
+        std::vector<sample_type, alloc>& centers,
+        std::vector<unsigned long>& assignments,
+        const unsigned long num_threads,
+        unsigned long max_iter = 1000
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(samples.size() > 0 && centers.size() > 0 && num_threads > 0,
+            "\tvoid find_clusters_using_kmeans_threaded()"
+            << "\n\tYou passed invalid arguments to this function"
+            << "\n\t samples.size(): " << samples.size() 
+            << "\n\t centers.size(): " << centers.size() 
+            << "\n\t num_threads:    " << num_threads 
+            );
+        impl::check_kmeans_samples(samples);
+
+        impl::hamerly_kmeans<vector_type,sample_type,alloc> km(samples, centers, num_threads);
+        km.run(max_iter);
+        assignments = km.get_assignments();
+    }
+
+    template <
+        typename vector_type, 
+        typename sample_type,
+        typename alloc
+        >
+    void find_clusters_using_kmeans_threaded (
+        const vector_type& samples,
+        std::vector<sample_type, alloc>& centers,
+        const unsigned long num_threads,
+        unsigned long max_iter = 1000
+    )
+    {
+        std::vector<unsigned long> assignments;
+        find_clusters_using_kmeans_threaded(samples, centers, assignments, num_threads, max_iter);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename vector_type, 
+        typename sample_type,
+        typename alloc
+        >
+    void find_clusters_using_minibatch_kmeans (
+        const vector_type& samples,
+        std::vector<sample_type, alloc>& centers,
+        const unsigned long batch_size,
+        const unsigned long num_iterations,
+        const unsigned long num_threads,
+        dlib::rand& rnd
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(samples.size() > 0 && centers.size() > 0 && batch_size > 0 && num_threads > 0,
+            "\tvoid find_clusters_using_minibatch_kmeans()"
+            << "\n\tYou passed invalid arguments to this function"
+            << "\n\t samples.size(): " << samples.size() 
+            << "\n\t centers.size(): " << centers.size() 
+            << "\n\t batch_size:     " << batch_size 
+            << "\n\t num_threads:    " << num_threads 
+            );
+        impl::check_kmeans_samples(samples);
+
+        typedef typename sample_type::type scalar_type;
+
+        std::vector<unsigned long> batch(batch_size), batch_assignments(batch_size);
+        std::vector<double> center_counts(centers.size(), 0);
+        thread_pool tp(num_threads > 1 ? num_threads : 0);
+        impl::minibatch_assigner<vector_type,sample_type,alloc> assigner(samples, centers, batch, batch_assignments);
+
+        for (unsigned long iter = 0; iter < num_iterations; ++iter)
+        {
+            for (unsigned long i = 0; i < batch.size(); ++i)
+                batch[i] = rnd.get_random_64bit_number()%samples.size();
+
+            // Assign the batch to the current centers, which is where all the time goes,
+            // in parallel.
+            parallel_for(tp, 0, batch.size(), assigner, &impl::minibatch_assigner<vector_type,sample_type,alloc>::assign, 4);
+
+            // Then move each center toward its samples with a per center learning rate of
+            // 1/(number of samples the center has seen so far).  This way each center is
+            // the running average of all the samples assigned to it.
+            for (unsigned long i = 0; i < batch.size(); ++i)
+            {
+                const unsigned long j = batch_assignments[i];
+                const double eta = 1/++center_counts[j];
+                sample_type& c = centers[j];
+                const typename vector_type::value_type& samp = samples[batch[i]];
+                for (long k = 0; k < c.size(); ++k)
+                    c(k) = static_cast<scalar_type>((1-eta)*c(k) + eta*samp(k));
+            }
+        }
+    }
+
+    template <
+        typename vector_type, 
+        typename sample_type,
+        typename alloc
+        >
+    void find_clusters_using_minibatch_kmeans (
+        const vector_type& samples,
+        std::vector<sample_type, alloc>& centers,
+        const unsigned long batch_size,
+        const unsigned long num_iterations,
+        const unsigned long num_threads = 1
+    )
+    {
+        dlib::rand rnd;
+        find_clusters_using_minibatch_kmeans(samples, centers, batch_size, num_iterations, num_threads, rnd);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_KMEANS_THREADeD_H__
+
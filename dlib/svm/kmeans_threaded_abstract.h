@@ -0,0 +1,210 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_KMEANS_THREADeD_ABSTRACT_H__
+#ifdef DLIB_KMEANS_THREADeD_ABSTRACT_H__
+
+#include <vector>
+#include "../matrix.h"
+#include "../rand.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename vector_type1,
+        typename vector_type2
+        >
+    void pick_initial_centers_kmeanspp (
+        long num_centers,
+        vector_type1& centers,
+        const vector_type2& samples,
+        const unsigned long num_threads,
+        dlib::rand& rnd
+    );
+    /*!
+        requires
+            - num_centers > 0
+            - samples.size() > 0
+            - num_threads > 0
+            - samples == a bunch of row or column vectors and they all must be of the
+              same length.
+            - vector_type1 == something with an interface compatible with std::vector
+            - vector_type2 == something with an interface compatible with std::vector
+            - centers must be able to contain the objects in samples.
+        ensures
+            - picks num_centers initial cluster centers from samples using the kmeans++
+              algorithm described in the paper:
+                kmeans++: The Advantages of Careful Seeding by Arthur and Vassilvitskii
+              That is, the first center is a random sample and each following center is a
+              random sample picked with probability proportional to its squared distance
+              to the nearest center already picked.
+            - The distances from the samples to the centers are updated using num_threads
+              threads.  The centers picked only depend on samples and the state of rnd,
+              not on num_threads.
+            - Unlike pick_initial_centers(), this function only works with vectors in
+              Euclidean space rather than with an arbitrary kernel.
+            - #centers.size() == num_centers
+            - #centers == a vector containing the centers found
+    !*/
+
+    template <
+        typename vector_type1,
+        typename vector_type2
+        >
+    void pick_initial_centers_kmeanspp (
+        long num_centers,
+        vector_type1& centers,
+        const vector_type2& samples,
+        const unsigned long num_threads = 1
+    );
+    /*!
+        requires
+            - The requirements are the same as for the above version of
+              pick_initial_centers_kmeanspp().
+        ensures
+            - invokes pick_initial_centers_kmeanspp(num_centers, centers, samples, num_threads, rnd)
+              where rnd is a default initialized dlib::rand object.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename vector_type,
+        typename sample_type,
+        typename alloc
+        >
+    void find_clusters_using_kmeans_threaded (
+        const vector_type& samples,
+        std::vector<sample_type, alloc>& centers,
+        std::vector<unsigned long>& assignments,
+        const unsigned long num_threads,
+        unsigned long max_iter = 1000
+    );
+    /*!
+        requires
+            - samples.size() > 0
+            - samples == a bunch of row or column vectors and they all must be of the
+              same length.
+            - centers.size() > 0
+            - num_threads > 0
+            - vector_type == something with an interface compatible with std::vector
+              and it must contain row or column vectors capable of being stored in
+              sample_type objects
+            - sample_type == a dlib::matrix capable of representing vectors
+        ensures
+            - performs the same linear kmeans clustering as find_clusters_using_kmeans().
+              That is, the clustering begins with the initial set of
+              centers given as an argument to this function and when it finishes #centers
+              will contain the resulting centers.
+            - Triangle inequality bounds (from the paper Making k-means even faster by
+              Greg Hamerly) are used to skip most of the distance computations between
+              samples and centers.  The assignment and center update steps are done using
+              num_threads threads.  Only O(samples.size() + centers.size()) extra memory
+              is used.
+            - Distances and center sums are accumulated in double precision.  So samples
+              may be stored as float vectors to save memory without losing accuracy.
+            - The results don't depend on num_threads.
+            - Centers which end up without any samples keep their previous value.
+            - #assignments.size() == samples.size()
+            - for all valid i:
+                - #assignments[i] == the index of the center in #centers that samples[i]
+                  was assigned to in the last iteration.
+            - no more than max_iter iterations will be performed before this function
+              terminates.
+    !*/
+
+    template <
+        typename vector_type,
+        typename sample_type,
+        typename alloc
+        >
+    void find_clusters_using_kmeans_threaded (
+        const vector_type& samples,
+        std::vector<sample_type, alloc>& centers,
+        const unsigned long num_threads,
+        unsigned long max_iter = 1000
+    );
+    /*!
+        requires
+            - The requirements are the same as for the above version of
+              find_clusters_using_kmeans_threaded().
+        ensures
+            - This function is identical to the above version of
+              find_clusters_using_kmeans_threaded() except that it doesn't output the
+              assignments.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename vector_type,
+        typename sample_type,
+        typename alloc
+        >
+    void find_clusters_using_minibatch_kmeans (
+        const vector_type& samples,
+        std::vector<sample_type, alloc>& centers,
+        const unsigned long batch_size,
+        const unsigned long num_iterations,
+        const unsigned long num_threads,
+        dlib::rand& rnd
+    );
+    /*!
+        requires
+            - samples.size() > 0
+            - samples == a bunch of row or column vectors and they all must be of the
+              same length.
+            - centers.size() > 0
+            - batch_size > 0
+            - num_threads > 0
+            - vector_type == something with an interface compatible with std::vector
+              and it must contain row or column vectors capable of being stored in
+              sample_type objects
+            - sample_type == a dlib::matrix capable of representing vectors
+        ensures
+            - performs approximate kmeans clustering using the mini-batch algorithm from
+              the paper Web-Scale K-Means Clustering by D. Sculley.  That is, the
+              clustering begins with the initial set of centers given as an argument to
+              this function.  Then num_iterations times, batch_size random samples are
+              assigned to their nearest centers and each center is moved toward its
+              samples using a learning rate of 1/(the number of samples the center has
+              been assigned so far).
+            - Each iteration only looks at batch_size samples rather than the whole
+              dataset.  So this is much faster than find_clusters_using_kmeans_threaded()
+              on very large datasets at the expense of somewhat worse centers.
+            - The batch samples are assigned to the centers using num_threads threads.
+              The results only depend on the inputs and the state of rnd, not on
+              num_threads.
+            - #centers == the resulting centers.
+    !*/
+
+    template <
+        typename vector_type,
+        typename sample_type,
+        typename alloc
+        >
+    void find_clusters_using_minibatch_kmeans (
+        const vector_type& samples,
+        std::vector<sample_type, alloc>& centers,
+        const unsigned long batch_size,
+        const unsigned long num_iterations,
+        const unsigned long num_threads = 1
+    );
+    /*!
+        requires
+            - The requirements are the same as for the above version of
+              find_clusters_using_minibatch_kmeans().
+        ensures
+            - invokes find_clusters_using_minibatch_kmeans(samples, centers, batch_size, num_iterations, num_threads, rnd)
+              where rnd is a default initialized dlib::rand object.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_KMEANS_THREADeD_ABSTRACT_H__
+
+
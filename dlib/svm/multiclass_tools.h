@@ -59,6 +59,32 @@ namespace dlib
         return missing_pairs;
     }
 
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        template <
+            typename trainer_type,
+            typename sample_vector_type,
+            typename label_vector_type
+            >
+        typename trainer_type::trained_function_type train_binary_classifier (
+            const trainer_type& trainer,
+            const sample_vector_type& samples,
+            const label_vector_type& labels,
+            bool from_several_threads
+        )
+        {
+            if (!from_several_threads)
+                return trainer.train(samples, labels);
+
+            // Use our own copy of the trainer so we don't need to worry about whether
+            // it's safe to call from several threads at once.
+            trainer_type temp(trainer);
+            return temp.train(samples, labels);
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
 
 }
@@ -14,6 +14,8 @@
 #include <iostream>
 
 #include "../any.h"
+#include "../threads.h"
+#include "../misc_api.h"
 #include <map>
 #include <set>
 
@@ -39,7 +41,8 @@ namespace dlib
 
         one_vs_all_trainer (
         ) : 
-            verbose(false)
+            verbose(false),
+            num_threads(1)
         {}
 
         void set_trainer (
@@ -70,6 +73,34 @@ namespace dlib
             verbose = false;
         }
 
+        void set_num_threads (
+            unsigned long num
+        )
+        {
+            if (num == num_threads)
+                return;
+
+            num_threads = num;
+            // The pool is made here, not in train(), so that calling train() many times
+            // doesn't keep starting and stopping threads.
+            if (num_threads > 1)
+                tp.reset(new thread_pool(num_threads));
+            else
+                tp.reset();
+        }
+
+        unsigned long get_num_threads (
+        ) const
+        {
+            return num_threads;
+        }
+
+        struct subproblem_timing
+        {
+            label_type l;
+            double seconds;
+        };
+
         struct invalid_label : public dlib::error 
         { 
             invalid_label(const std::string& msg, const label_type& l_
@@ -85,6 +116,16 @@ namespace dlib
             const std::vector<sample_type>& all_samples,
             const std::vector<label_type>& all_labels
         ) const
+        {
+            std::vector<subproblem_timing> timing;
+            return train(all_samples, all_labels, timing);
+        }
+
+        trained_function_type train (
+            const std::vector<sample_type>& all_samples,
+            const std::vector<label_type>& all_labels,
+            std::vector<subproblem_timing>& timing
+        ) const
         {
             // make sure requires clause is not broken
             DLIB_ASSERT(is_learning_problem(all_samples,all_labels),
@@ -96,42 +137,23 @@ namespace dlib
 
             const std::vector<label_type> distinct_labels = select_all_distinct_labels(all_labels);
 
-            std::vector<scalar_type> labels;
-
-
-            typename trained_function_type::binary_function_table dfs;
-
+            mutex verbose_mutex;
+            std::vector<job> jobs;
+            jobs.reserve(distinct_labels.size());
             for (unsigned long i = 0; i < distinct_labels.size(); ++i)
             {
-                labels.clear();
-
                 const label_type l = distinct_labels[i];
 
-                // setup one of the one vs all training sets
-                for (unsigned long k = 0; k < all_samples.size(); ++k)
-                {
-                    if (all_labels[k] == l)
-                        labels.push_back(+1);
-                    else 
-                        labels.push_back(-1);
-                }
-
-
-                if (verbose)
-                {
-                    std::cout << "Training classifier for " << l << " vs. all" << std::endl;
-                }
-
-                // now train a binary classifier using the samples we selected
+                // figure out which trainer to use for this class
+                const any_trainer* trainer;
                 const typename binary_function_table::const_iterator itr = trainers.find(l);
-
                 if (itr != trainers.end())
                 {
-                    dfs[l] = itr->second.train(all_samples, labels);
+                    trainer = &itr->second;
                 }
                 else if (default_trainer.is_empty() == false)
                 {
-                    dfs[l] = default_trainer.train(all_samples, labels);
+                    trainer = &default_trainer;
                 }
                 else
                 {
@@ -139,6 +161,41 @@ namespace dlib
                     sout << "In one_vs_all_trainer, no trainer registered for the " << l << " label.";
                     throw invalid_label(sout.str(), l);
                 }
+
+                jobs.push_back(job(*this, verbose_mutex, l, *trainer, all_samples, all_labels));
+            }
+
+            if (num_threads <= 1)
+            {
+                for (unsigned long i = 0; i < jobs.size(); ++i)
+                    jobs[i].train();
+            }
+            else
+            {
+                // Every problem uses all the samples so there isn't any point trying to
+                // order them by size.  The thread pool gives each task to whichever
+                // thread is free so the load still balances.
+                for (unsigned long i = 0; i < jobs.size(); ++i)
+                    tp->add_task(jobs[i], &job::train_and_catch);
+                tp->wait_for_all_tasks();
+
+                // There isn't a portable way to move an exception from one thread to
+                // another.  So if a binary trainer threw then train it again here, in the
+                // calling thread, and let the exception come out with its original type.
+                for (unsigned long i = 0; i < jobs.size(); ++i)
+                {
+                    if (jobs[i].failed)
+                        jobs[i].train();
+                }
+            }
+
+            typename trained_function_type::binary_function_table dfs;
+            timing.resize(jobs.size());
+            for (unsigned long i = 0; i < jobs.size(); ++i)
+            {
+                dfs[jobs[i].l].swap(jobs[i].df);
+                timing[i].l = jobs[i].l;
+                timing[i].seconds = jobs[i].seconds;
             }
 
             return trained_function_type(dfs);
@@ -151,7 +208,81 @@ namespace dlib
         typedef std::map<label_type, any_trainer> binary_function_table;
         binary_function_table trainers;
 
+        struct job
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is one of the binary classification problems we need to solve.
+            !*/
+
+            job (
+                const one_vs_all_trainer& self_,
+                const mutex& verbose_mutex_,
+                const label_type& l_,
+                const any_trainer& trainer_,
+                const std::vector<sample_type>& all_samples_,
+                const std::vector<label_type>& all_labels_
+            ) : self(&self_), verbose_mutex(&verbose_mutex_), l(l_), trainer(&trainer_), 
+                all_samples(&all_samples_), all_labels(&all_labels_), seconds(0), failed(false) {}
+
+            void train (
+            )
+            {
+                // setup one of the one vs all training sets
+                std::vector<scalar_type> labels;
+                labels.reserve(all_labels->size());
+                for (unsigned long k = 0; k < all_labels->size(); ++k)
+                {
+                    if ((*all_labels)[k] == l)
+                        labels.push_back(+1);
+                    else 
+                        labels.push_back(-1);
+                }
+
+                if (self->verbose)
+                {
+                    auto_mutex lock(*verbose_mutex);
+                    std::cout << "Training classifier for " << l << " vs. all" << std::endl;
+                }
+
+                timestamper ts;
+                const uint64 start = ts.get_timestamp();
+                // now train a binary classifier using the samples we selected
+                df = impl::train_binary_classifier(*trainer, *all_samples, labels, self->num_threads > 1);
+                seconds = (ts.get_timestamp() - start)/1e6;
+            }
+
+            void train_and_catch (
+            )
+            {
+                try
+                {
+                    failed = false;
+                    train();
+                }
+                catch (...)
+                {
+                    failed = true;
+                }
+            }
+
+            const one_vs_all_trainer* self;
+            const mutex* verbose_mutex;
+            label_type l;
+            const any_trainer* trainer;
+            const std::vector<sample_type>* all_samples;
+            const std::vector<label_type>* all_labels;
+
+            typename any_trainer::trained_function_type df;
+            double seconds;
+            bool failed;
+        };
+
         bool verbose;
+        unsigned long num_threads;
+        // Copies of this trainer share the pool.  That's fine since
+        // wait_for_all_tasks() only waits on the calling thread's own tasks.
+        shared_ptr_thread_safe<thread_pool> tp;
 
     };
 
@@ -96,6 +96,38 @@ namespace dlib
                 - this object will not print anything to standard out
         !*/
 
+        void set_num_threads (
+            unsigned long num
+        );
+        /*!
+            ensures
+                - #get_num_threads() == num
+        !*/
+
+        unsigned long get_num_threads (
+        ) const;
+        /*!
+            ensures
+                - returns the number of threads used to train the binary classifiers.
+                  If this is 1 (the default) they are all trained in the calling thread.
+                  Otherwise, they are trained in parallel by a thread pool which
+                  set_num_threads() starts once and which is kept for all subsequent
+                  calls to train().  Copies of this object use the same pool.  Each
+                  thread uses its own copy of the relevant any_trainer.
+                - Each thread takes the next binary problem as soon as it finishes
+                  one.
+        !*/
+
+        struct subproblem_timing
+        {
+            /*!
+                This object records how long it took to train the binary classifier
+                for the l vs. all problem.
+            !*/
+            label_type l;
+            double seconds;
+        };
+
         struct invalid_label : public dlib::error 
         { 
             /*!
@@ -133,6 +165,30 @@ namespace dlib
                   via invalid_label::what().
         !*/
 
+        trained_function_type train (
+            const std::vector<sample_type>& all_samples,
+            const std::vector<label_type>& all_labels,
+            std::vector<subproblem_timing>& timing
+        ) const;
+        /*!
+            requires
+                - is_learning_problem(all_samples, all_labels)
+            ensures
+                - performs the same training as train(all_samples, all_labels) and returns
+                  the same thing.
+                - #timing contains one element for each binary classifier that was
+                  trained, listed in the order they were started.  So you can use it to
+                  see which of the binary problems are expensive.
+            throws
+                - invalid_label
+                  This exception is thrown under the same conditions as in the train()
+                  routine above.  It is thrown before any training begins.
+                - Any exception thrown by one of the binary trainers propagates out of
+                  this function unchanged.  When get_num_threads() > 1 the failing
+                  binary problem is trained a second time in the calling thread so that
+                  its exception can be rethrown there.
+        !*/
+
     };
 
 // ----------------------------------------------------------------------------------------
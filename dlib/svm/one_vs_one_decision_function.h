@@ -14,6 +14,10 @@
 #include "../any.h"
 #include "../unordered_pair.h"
 #include "null_df.h"
+#include "function.h"
+#include "../matrix.h"
+#include <vector>
+#include <algorithm>
 
 namespace dlib
 {
@@ -282,6 +286,203 @@ namespace dlib
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename K,
+        typename result_type_ = double
+        >
+    class compiled_one_vs_one_decision_function
+    {
+    public:
+        typedef K kernel_type;
+        typedef result_type_ result_type;
+        typedef typename K::sample_type sample_type;
+        typedef typename K::scalar_type scalar_type;
+        typedef typename K::mem_manager_type mem_manager_type;
+
+        compiled_one_vs_one_decision_function (
+        ) {}
+
+        template <typename ovo_df>
+        explicit compiled_one_vs_one_decision_function (
+            const ovo_df& df
+        )
+        {
+            typedef typename ovo_df::binary_function_table binary_function_table;
+            const binary_function_table& dfs = df.get_binary_decision_functions();
+
+            labels = df.get_labels();
+
+            // Give each distinct basis vector an index.  We compare basis vectors by their
+            // serialized form so this works for any sample type, dense or sparse.
+            std::map<std::string, unsigned long> basis_index;
+            std::vector<sample_type> basis;
+            std::ostringstream sout;
+
+            pair_start.push_back(0);
+            for (typename binary_function_table::const_iterator i = dfs.begin(); i != dfs.end(); ++i)
+            {
+                // make sure requires clause is not broken
+                DLIB_ASSERT(i->second.template contains<decision_function<K> >(),
+                    "\t compiled_one_vs_one_decision_function::compiled_one_vs_one_decision_function(df)"
+                    << "\n\t All the binary decision functions must be decision_function<K> objects."
+                    << "\n\t this: " << this
+                    );
+
+                const decision_function<K>& bdf = any_cast<decision_function<K> >(i->second);
+
+                if (i == dfs.begin())
+                    kernel = bdf.kernel_function;
+
+                DLIB_ASSERT(kernel == bdf.kernel_function,
+                    "\t compiled_one_vs_one_decision_function::compiled_one_vs_one_decision_function(df)"
+                    << "\n\t All the binary decision functions must use the same kernel."
+                    << "\n\t this: " << this
+                    );
+
+                first.push_back(std::lower_bound(labels.begin(), labels.end(), i->first.first) - labels.begin());
+                second.push_back(std::lower_bound(labels.begin(), labels.end(), i->first.second) - labels.begin());
+                bias.push_back(bdf.b);
+
+                for (long j = 0; j < bdf.alpha.size(); ++j)
+                {
+                    sout.str("");
+                    serialize(bdf.basis_vectors(j), sout);
+                    const std::pair<typename std::map<std::string,unsigned long>::iterator,bool> res = 
+                        basis_index.insert(std::make_pair(sout.str(), basis.size()));
+                    if (res.second)
+                        basis.push_back(bdf.basis_vectors(j));
+
+                    sv_index.push_back(res.first->second);
+                    sv_alpha.push_back(bdf.alpha(j));
+                }
+                pair_start.push_back(sv_index.size());
+            }
+
+            basis_vectors = mat(basis);
+        }
+
+        unsigned long number_of_classes (
+        ) const
+        {
+            return labels.size();
+        }
+
+        const std::vector<result_type>& get_labels (
+        ) const
+        {
+            return labels;
+        }
+
+        unsigned long number_of_basis_vectors (
+        ) const
+        {
+            return basis_vectors.size();
+        }
+
+        result_type operator() (
+            const sample_type& sample
+        ) const
+        {
+            DLIB_ASSERT(number_of_classes() != 0, 
+                "\t void compiled_one_vs_one_decision_function::operator()"
+                << "\n\t You can't make predictions with an empty decision function."
+                << "\n\t this: " << this
+                );
+
+            // Evaluate the kernel against each distinct basis vector just once.
+            matrix<scalar_type,0,1,mem_manager_type> kvals(basis_vectors.size());
+            for (long i = 0; i < kvals.size(); ++i)
+                kvals(i) = kernel(sample, basis_vectors(i));
+
+            std::vector<int> votes(labels.size(), 0);
+            for (unsigned long p = 0; p < bias.size(); ++p)
+            {
+                // This adds things up in the same order as decision_function does, so
+                // we get exactly the same scores as the uncompiled classifiers.
+                scalar_type score = 0;
+                for (unsigned long j = pair_start[p]; j < pair_start[p+1]; ++j)
+                    score += sv_alpha[j]*kvals(sv_index[j]);
+                score -= bias[p];
+
+                if (score > 0)
+                    votes[first[p]] += 1;
+                else
+                    votes[second[p]] += 1;
+            }
+
+            // now figure out who had the most votes
+            result_type best_label = result_type();
+            int best_votes = 0;
+            for (unsigned long i = 0; i < votes.size(); ++i)
+            {
+                if (votes[i] > best_votes)
+                {
+                    best_votes = votes[i];
+                    best_label = labels[i];
+                }
+            }
+
+            return best_label;
+        }
+
+        friend void serialize (
+            const compiled_one_vs_one_decision_function& item,
+            std::ostream& out
+        )
+        {
+            const int version = 1;
+            serialize(version, out);
+            serialize(item.labels, out);
+            serialize(item.kernel, out);
+            serialize(item.basis_vectors, out);
+            serialize(item.first, out);
+            serialize(item.second, out);
+            serialize(item.bias, out);
+            serialize(item.pair_start, out);
+            serialize(item.sv_index, out);
+            serialize(item.sv_alpha, out);
+        }
+
+        friend void deserialize (
+            compiled_one_vs_one_decision_function& item,
+            std::istream& in 
+        )
+        {
+            int version = 0;
+            deserialize(version, in);
+            if (version != 1)
+                throw serialization_error("Unexpected version found while deserializing compiled_one_vs_one_decision_function.");
+            deserialize(item.labels, in);
+            deserialize(item.kernel, in);
+            deserialize(item.basis_vectors, in);
+            deserialize(item.first, in);
+            deserialize(item.second, in);
+            deserialize(item.bias, in);
+            deserialize(item.pair_start, in);
+            deserialize(item.sv_index, in);
+            deserialize(item.sv_alpha, in);
+        }
+
+    private:
+
+        std::vector<result_type> labels;
+        K kernel;
+        matrix<sample_type,0,1,mem_manager_type> basis_vectors;
+
+        // The p-th binary classifier votes between labels[first[p]] and
+        // labels[second[p]].  Its alpha values are sv_alpha[pair_start[p]] through
+        // sv_alpha[pair_start[p+1]-1] and go with the basis vectors indicated by
+        // sv_index.
+        std::vector<unsigned long> first;
+        std::vector<unsigned long> second;
+        std::vector<scalar_type> bias;
+        std::vector<unsigned long> pair_start;
+        std::vector<unsigned long> sv_index;
+        std::vector<scalar_type> sv_alpha;
+    };
+
 // ----------------------------------------------------------------------------------------
 
 }
@@ -203,6 +203,123 @@ namespace dlib
               template arguments.
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename K,
+        typename result_type_ = double
+        >
+    class compiled_one_vs_one_decision_function
+    {
+        /*!
+            REQUIREMENTS ON K
+                K must be a kernel function object type as defined at the
+                top of dlib/svm/kernel_abstract.h
+
+            REQUIREMENTS ON result_type_
+                result_type_ must be the label_type of the one vs. one classifiers
+                this object is built from.
+
+            WHAT THIS OBJECT REPRESENTS
+                This object is a faster version of a one_vs_one_decision_function
+                where all the binary classifiers are decision_function<K> objects
+                with the same kernel.  In that case the binary classifiers usually
+                share most of their basis vectors, since each training sample can be a
+                support vector in every classifier involving its class.  So this object
+                stores each distinct basis vector once, evaluates the kernel against it
+                once per prediction, and then forms the output of each binary classifier
+                from those kernel values.  The cost of a prediction is then
+                proportional to the number of distinct basis vectors rather than the
+                total number over all the binary classifiers.
+
+                It gives exactly the same outputs as the one_vs_one_decision_function
+                it was made from.
+        !*/
+
+    public:
+        typedef K kernel_type;
+        typedef result_type_ result_type;
+        typedef typename K::sample_type sample_type;
+        typedef typename K::scalar_type scalar_type;
+        typedef typename K::mem_manager_type mem_manager_type;
+
+        compiled_one_vs_one_decision_function (
+        );
+        /*!
+            ensures
+                - #number_of_classes() == 0
+                - #number_of_basis_vectors() == 0
+        !*/
+
+        template <typename ovo_df>
+        explicit compiled_one_vs_one_decision_function (
+            const ovo_df& df
+        );
+        /*!
+            requires
+                - ovo_df == an instantiation of one_vs_one_decision_function 
+                - every element of df.get_binary_decision_functions() contains a 
+                  decision_function<K> and they all have the same kernel_function.
+            ensures
+                - #*this makes the same predictions as df.
+                - #number_of_classes() == df.number_of_classes()
+                - #get_labels() == df.get_labels()
+                - #number_of_basis_vectors() == the number of distinct basis vectors in
+                  all the binary decision functions in df.
+        !*/
+
+        unsigned long number_of_classes (
+        ) const;
+        /*!
+            ensures
+                - returns the number of different labels predicted by this object
+        !*/
+
+        const std::vector<result_type>& get_labels (
+        ) const;
+        /*!
+            ensures
+                - returns a sorted vector of the labels predicted by this object
+        !*/
+
+        unsigned long number_of_basis_vectors (
+        ) const;
+        /*!
+            ensures
+                - returns the number of distinct basis vectors stored in this object.
+                  This is the number of kernel evaluations performed by operator().
+        !*/
+
+        result_type operator() (
+            const sample_type& sample
+        ) const;
+        /*!
+            requires
+                - number_of_classes() != 0
+            ensures
+                - returns the label predicted for sample.  This is the same label the
+                  one_vs_one_decision_function used to create *this would predict.
+        !*/
+    };
+
+    template <typename K, typename result_type_>
+    void serialize (
+        const compiled_one_vs_one_decision_function<K,result_type_>& item,
+        std::ostream& out
+    );
+    /*!
+        provides serialization support
+    !*/
+
+    template <typename K, typename result_type_>
+    void deserialize (
+        compiled_one_vs_one_decision_function<K,result_type_>& item,
+        std::istream& in 
+    );
+    /*!
+        provides deserialization support
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
 }
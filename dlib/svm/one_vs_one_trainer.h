@@ -15,8 +15,11 @@
 #include <iostream>
 
 #include "../any.h"
+#include "../threads.h"
+#include "../misc_api.h"
 #include <map>
 #include <set>
+#include <algorithm>
 
 namespace dlib
 {
@@ -40,7 +43,8 @@ namespace dlib
 
         one_vs_one_trainer (
         ) : 
-            verbose(false)
+            verbose(false),
+            num_threads(1)
         {}
 
         void set_trainer (
@@ -72,6 +76,36 @@ namespace dlib
             verbose = false;
         }
 
+        void set_num_threads (
+            unsigned long num
+        )
+        {
+            if (num == num_threads)
+                return;
+
+            num_threads = num;
+            // The pool is made here, not in train(), so that calling train() many times
+            // doesn't keep starting and stopping threads.
+            if (num_threads > 1)
+                tp.reset(new thread_pool(num_threads));
+            else
+                tp.reset();
+        }
+
+        unsigned long get_num_threads (
+        ) const
+        {
+            return num_threads;
+        }
+
+        struct subproblem_timing
+        {
+            label_type l1;
+            label_type l2;
+            unsigned long num_samples;
+            double seconds;
+        };
+
         struct invalid_label : public dlib::error 
         { 
             invalid_label(const std::string& msg, const label_type& l1_, const label_type& l2_
@@ -87,6 +121,16 @@ namespace dlib
             const std::vector<sample_type>& all_samples,
             const std::vector<label_type>& all_labels
         ) const
+        {
+            std::vector<subproblem_timing> timing;
+            return train(all_samples, all_labels, timing);
+        }
+
+        trained_function_type train (
+            const std::vector<sample_type>& all_samples,
+            const std::vector<label_type>& all_labels,
+            std::vector<subproblem_timing>& timing
+        ) const
         {
             // make sure requires clause is not broken
             DLIB_ASSERT(is_learning_problem(all_samples,all_labels),
@@ -98,52 +142,31 @@ namespace dlib
 
             const std::vector<label_type> distinct_labels = select_all_distinct_labels(all_labels);
 
-            std::vector<sample_type> samples;
-            std::vector<scalar_type> labels;
-
-
-            typename trained_function_type::binary_function_table dfs;
+            // Find the samples in each class just once rather than scanning the whole
+            // dataset for every pair of classes.
+            std::map<label_type, std::vector<unsigned long> > class_samples;
+            for (unsigned long k = 0; k < all_labels.size(); ++k)
+                class_samples[all_labels[k]].push_back(k);
 
+            mutex verbose_mutex;
+            std::vector<job> jobs;
+            jobs.reserve(distinct_labels.size()*(distinct_labels.size()-1)/2);
             for (unsigned long i = 0; i < distinct_labels.size(); ++i)
             {
                 for (unsigned long j = i+1; j < distinct_labels.size(); ++j)
                 {
-                    samples.clear();
-                    labels.clear();
-
                     const unordered_pair<label_type> p(distinct_labels[i], distinct_labels[j]);
 
-                    // pick out the samples corresponding to these two classes
-                    for (unsigned long k = 0; k < all_samples.size(); ++k)
-                    {
-                        if (all_labels[k] == p.first)
-                        {
-                            samples.push_back(all_samples[k]);
-                            labels.push_back(+1);
-                        }
-                        else if (all_labels[k] == p.second)
-                        {
-                            samples.push_back(all_samples[k]);
-                            labels.push_back(-1);
-                        }
-                    }
-
-
-                    if (verbose)
-                    {
-                        std::cout << "Training classifier for " << p.first << " vs. " << p.second << std::endl;
-                    }
-
-                    // now train a binary classifier using the samples we selected
+                    // figure out which trainer to use for these two classes
+                    const any_trainer* trainer;
                     const typename binary_function_table::const_iterator itr = trainers.find(p);
-
                     if (itr != trainers.end())
                     {
-                        dfs[p] = itr->second.train(samples, labels);
+                        trainer = &itr->second;
                     }
                     else if (default_trainer.is_empty() == false)
                     {
-                        dfs[p] = default_trainer.train(samples, labels);
+                        trainer = &default_trainer;
                     }
                     else
                     {
@@ -151,9 +174,48 @@ namespace dlib
                         sout << "In one_vs_one_trainer, no trainer registered for the (" << p.first << ", " << p.second << ") label pair.";
                         throw invalid_label(sout.str(), p.first, p.second);
                     }
+
+                    jobs.push_back(job(*this, verbose_mutex, p, *trainer, all_samples, class_samples[p.first], class_samples[p.second]));
+                }
+            }
+
+            // Start the biggest problems first.  The thread pool hands tasks to
+            // whichever thread is free, so this way we don't end up waiting on one big
+            // problem at the end while the other threads sit idle.
+            std::stable_sort(jobs.begin(), jobs.end(), job::bigger);
+
+            if (num_threads <= 1)
+            {
+                for (unsigned long i = 0; i < jobs.size(); ++i)
+                    jobs[i].train();
+            }
+            else
+            {
+                for (unsigned long i = 0; i < jobs.size(); ++i)
+                    tp->add_task(jobs[i], &job::train_and_catch);
+                tp->wait_for_all_tasks();
+
+                // There isn't a portable way to move an exception from one thread to
+                // another.  So if a binary trainer threw then train it again here, in the
+                // calling thread, and let the exception come out with its original type.
+                for (unsigned long i = 0; i < jobs.size(); ++i)
+                {
+                    if (jobs[i].failed)
+                        jobs[i].train();
                 }
             }
 
+            typename trained_function_type::binary_function_table dfs;
+            timing.resize(jobs.size());
+            for (unsigned long i = 0; i < jobs.size(); ++i)
+            {
+                dfs[make_unordered_pair(jobs[i].l1, jobs[i].l2)].swap(jobs[i].df);
+                timing[i].l1 = jobs[i].l1;
+                timing[i].l2 = jobs[i].l2;
+                timing[i].num_samples = jobs[i].size();
+                timing[i].seconds = jobs[i].seconds;
+            }
+
             return trained_function_type(dfs);
         }
 
@@ -164,7 +226,104 @@ namespace dlib
         typedef std::map<unordered_pair<label_type>, any_trainer> binary_function_table;
         binary_function_table trainers;
 
+        struct job
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is one of the binary classification problems we need to solve.
+            !*/
+
+            job (
+                const one_vs_one_trainer& self_,
+                const mutex& verbose_mutex_,
+                const unordered_pair<label_type>& p,
+                const any_trainer& trainer_,
+                const std::vector<sample_type>& all_samples_,
+                const std::vector<unsigned long>& first_,
+                const std::vector<unsigned long>& second_
+            ) : self(&self_), verbose_mutex(&verbose_mutex_), l1(p.first), l2(p.second), trainer(&trainer_), all_samples(&all_samples_), 
+                first(&first_), second(&second_), seconds(0), failed(false) {}
+
+            unsigned long size (
+            ) const { return first->size() + second->size(); }
+
+            static bool bigger (
+                const job& a,
+                const job& b
+            ) { return a.size() > b.size(); }
+
+            void train (
+            )
+            {
+                std::vector<sample_type> samples;
+                std::vector<scalar_type> labels;
+                samples.reserve(size());
+                labels.reserve(size());
+
+                // pick out the samples corresponding to these two classes, keeping them
+                // in the same order they had in all_samples.
+                unsigned long i = 0, j = 0;
+                while (i < first->size() || j < second->size())
+                {
+                    if (j == second->size() || (i < first->size() && (*first)[i] < (*second)[j]))
+                    {
+                        samples.push_back((*all_samples)[(*first)[i++]]);
+                        labels.push_back(+1);
+                    }
+                    else
+                    {
+                        samples.push_back((*all_samples)[(*second)[j++]]);
+                        labels.push_back(-1);
+                    }
+                }
+
+                if (self->verbose)
+                {
+                    auto_mutex lock(*verbose_mutex);
+                    std::cout << "Training classifier for " << l1 << " vs. " << l2 << std::endl;
+                }
+
+                timestamper ts;
+                const uint64 start = ts.get_timestamp();
+                // now train a binary classifier using the samples we selected
+                df = impl::train_binary_classifier(*trainer, samples, labels, self->num_threads > 1);
+                seconds = (ts.get_timestamp() - start)/1e6;
+            }
+
+            void train_and_catch (
+            )
+            {
+                try
+                {
+                    failed = false;
+                    train();
+                }
+                catch (...)
+                {
+                    failed = true;
+                }
+            }
+
+            const one_vs_one_trainer* self;
+            const mutex* verbose_mutex;
+            // the label pair, l1 < l2
+            label_type l1;
+            label_type l2;
+            const any_trainer* trainer;
+            const std::vector<sample_type>* all_samples;
+            const std::vector<unsigned long>* first;
+            const std::vector<unsigned long>* second;
+
+            typename any_trainer::trained_function_type df;
+            double seconds;
+            bool failed;
+        };
+
         bool verbose;
+        unsigned long num_threads;
+        // Copies of this trainer share the pool.  That's fine since
+        // wait_for_all_tasks() only waits on the calling thread's own tasks.
+        shared_ptr_thread_safe<thread_pool> tp;
 
     };
 
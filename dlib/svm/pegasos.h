@@ -10,6 +10,10 @@
 #include "kernel.h"
 #include "kcentroid.h"
 #include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <string>
+#include <vector>
 #include "../smart_pointers.h"
 
 namespace dlib
@@ -706,6 +710,128 @@ namespace dlib
         long cache_size = 100
     ) { return batch_trainer<trainer_type>(trainer, min_learning_rate, true, true, cache_size); }
 
+// ----------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        template <
+            typename trainer_type
+            >
+        void save_stream_training_checkpoint (
+            const std::string& checkpoint_file,
+            const trainer_type& trainer,
+            unsigned long num_shards,
+            unsigned long pass,
+            unsigned long shard
+        )
+        {
+            // Write to a temporary file first so that a crash while saving never leaves
+            // us without a usable checkpoint.
+            const std::string temp_file = checkpoint_file + ".tmp";
+            {
+                std::ofstream fout(temp_file.c_str(), std::ios::binary);
+                int version = 1;
+                serialize(version, fout);
+                serialize(num_shards, fout);
+                serialize(pass, fout);
+                serialize(shard, fout);
+                serialize(trainer, fout);
+                if (!fout)
+                    throw error("Unable to write checkpoint file " + temp_file);
+            }
+            // On POSIX systems rename() atomically replaces the old checkpoint, so there
+            // is always a complete checkpoint on disk.  Windows' rename() won't overwrite
+            // an existing file, so there we have to delete the old one, which is only
+            // done now that the new one has been completely written.
+#ifdef WIN32
+            std::remove(checkpoint_file.c_str());
+#endif
+            if (std::rename(temp_file.c_str(), checkpoint_file.c_str()) != 0)
+                throw error("Unable to rename " + temp_file + " to " + checkpoint_file);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename trainer_type,
+        typename sample_stream_type
+        >
+    void train_from_sample_stream (
+        trainer_type& trainer,
+        sample_stream_type& stream,
+        unsigned long num_passes,
+        const std::string& checkpoint_file = "",
+        unsigned long minibatch_size = 1000
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(minibatch_size > 0,
+            "\t void train_from_sample_stream()"
+            << "\n\t minibatch_size must be greater than 0"
+            );
+
+        unsigned long pass = 0;
+        unsigned long shard = 0;
+
+        // pick up where a previous run left off if there is a checkpoint
+        if (checkpoint_file.size() != 0)
+        {
+            std::ifstream fin(checkpoint_file.c_str(), std::ios::binary);
+            if (fin)
+            {
+                int version = 0;
+                unsigned long num_shards = 0;
+                deserialize(version, fin);
+                if (version != 1)
+                    throw serialization_error("Unexpected version found while deserializing checkpoint " + checkpoint_file);
+                deserialize(num_shards, fin);
+                deserialize(pass, fin);
+                deserialize(shard, fin);
+                deserialize(trainer, fin);
+
+                if (num_shards != stream.number_of_shards() || shard > num_shards)
+                    throw error("The checkpoint " + checkpoint_file + " was made with a different sample stream.");
+            }
+        }
+
+        if (pass >= num_passes)
+            return;
+
+        stream.start_pass(pass, shard);
+
+        std::vector<typename sample_stream_type::sample_type> samples;
+        std::vector<typename sample_stream_type::label_type> labels;
+        while (pass < num_passes)
+        {
+            while (stream.next_minibatch(samples, labels, minibatch_size))
+            {
+                for (unsigned long i = 0; i < samples.size(); ++i)
+                    trainer.train(samples[i], labels[i]);
+
+                if (stream.shards_completed() != shard)
+                {
+                    shard = stream.shards_completed();
+                    if (stream.end_of_pass())
+                        break;
+
+                    if (checkpoint_file.size() != 0)
+                        impl::save_stream_training_checkpoint(checkpoint_file, trainer, 
+                                                              stream.number_of_shards(), pass, shard);
+                }
+            }
+
+            ++pass;
+            shard = 0;
+            if (checkpoint_file.size() != 0)
+                impl::save_stream_training_checkpoint(checkpoint_file, trainer, 
+                                                      stream.number_of_shards(), pass, shard);
+            if (pass < num_passes)
+                stream.start_pass(pass);
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
 
 }
@@ -505,6 +505,51 @@ namespace dlib
     !*/
 
 // ----------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename trainer_type,
+        typename sample_stream_type
+        >
+    void train_from_sample_stream (
+        trainer_type& trainer,
+        sample_stream_type& stream,
+        unsigned long num_passes,
+        const std::string& checkpoint_file = "",
+        unsigned long minibatch_size = 1000
+    );
+    /*!
+        requires
+            - minibatch_size > 0
+            - trainer_type == some kind of online trainer object (e.g. svm_pegasos).  That
+              is, it must have a train(sample,label) member function and be serializable.
+            - sample_stream_type == an object with the interface of the
+              sample_shard_stream defined in dlib/data_io/sample_shard_stream_abstract.h
+        ensures
+            - Trains the given online trainer by making num_passes passes over the data in
+              stream.  Each sample is given to trainer.train() and the data is read in
+              minibatches of at most minibatch_size samples.  Therefore, the dataset does
+              not need to fit in RAM.  Only the shards the stream is currently holding are
+              ever in memory.
+            - if (checkpoint_file != "") then
+                - Each time a shard of the stream has been fully processed, and at the end
+                  of each pass, the state of trainer along with the current position in the
+                  stream is saved into checkpoint_file.  
+                - If checkpoint_file already exists when this function is called then the
+                  state of trainer is loaded from it and training resumes from the saved
+                  position.  So if a previous call was interrupted you can call this
+                  function again with the same arguments and get the same result as an
+                  uninterrupted run (assuming the stream visits the data in the same order,
+                  which sample_shard_stream does).  If the checkpoint says that num_passes
+                  passes have already been made then this function just loads trainer and
+                  returns.
+        throws
+            - dlib::error or serialization_error if the checkpoint file can't be written or
+              doesn't match stream.
+            - any exceptions thrown by the stream, e.g. sample_data_io_error.
+    !*/
+
+// ----------------------------------------------------------------------------------------
 
 
 }
@@ -15,8 +15,12 @@
 #include "../threads.h"
 #include "../pipe.h"
 #include "../type_safe_union.h"
+#include "../timer.h"
+#include "../rand.h"
+#include "../string.h"
 #include <iostream>
 #include <vector>
+#include <deque>
 
 namespace dlib
 {
@@ -26,6 +30,78 @@ namespace dlib
     namespace impl
     {
 
+        template <typename matrix_type>
+        void serialize_maybe_sparse (
+            const matrix_type& item,
+            std::ostream& out
+        )
+        /*!
+            ensures
+                - serializes item, which is a column vector.  If most of its elements are
+                  zero then only the non-zero elements are written.
+        !*/
+        {
+            long nnz = 0;
+            for (long i = 0; i < item.size(); ++i)
+            {
+                if (item(i) != 0)
+                    ++nnz;
+            }
+
+            // Each sparse element needs an index as well as a value.
+            const bool use_sparse = 3*nnz < item.size();
+            dlib::serialize(use_sparse, out);
+            if (!use_sparse)
+            {
+                serialize(item, out);
+                return;
+            }
+
+            dlib::serialize(item.size(), out);
+            dlib::serialize(nnz, out);
+            for (long i = 0; i < item.size(); ++i)
+            {
+                if (item(i) != 0)
+                {
+                    dlib::serialize(i, out);
+                    dlib::serialize(item(i), out);
+                }
+            }
+        }
+
+        template <typename matrix_type>
+        void deserialize_maybe_sparse (
+            matrix_type& item,
+            std::istream& in
+        )
+        {
+            bool use_sparse;
+            dlib::deserialize(use_sparse, in);
+            if (!use_sparse)
+            {
+                deserialize(item, in);
+                return;
+            }
+
+            long size, nnz;
+            dlib::deserialize(size, in);
+            dlib::deserialize(nnz, in);
+            if (size < 0 || nnz < 0 || nnz > size)
+                throw serialization_error("Error deserializing a sparse oracle response");
+            item.set_size(size,1);
+            item = 0;
+            for (long j = 0; j < nnz; ++j)
+            {
+                long i;
+                dlib::deserialize(i, in);
+                if (i < 0 || i >= size)
+                    throw serialization_error("Error deserializing a sparse oracle response");
+                dlib::deserialize(item(i), in);
+            }
+        }
+
+    // ----------------------------------------------------------------------------------------
+
         template <typename matrix_type>
         struct oracle_response
         {
@@ -33,27 +109,37 @@ namespace dlib
 
             matrix_type subgradient;
             scalar_type loss;
+            // The number of samples this response covers.  A value < 0 indicates the
+            // node didn't have the solution vector the request referred to.
             long num;
+            uint64 iteration;
+            long chunk;
 
             friend void swap (oracle_response& a, oracle_response& b)
             {
                 a.subgradient.swap(b.subgradient);
                 std::swap(a.loss, b.loss);
                 std::swap(a.num, b.num);
+                std::swap(a.iteration, b.iteration);
+                std::swap(a.chunk, b.chunk);
             }
 
             friend void serialize (const oracle_response& item, std::ostream& out)
             {
-                serialize(item.subgradient, out);
+                serialize_maybe_sparse(item.subgradient, out);
                 dlib::serialize(item.loss, out);
                 dlib::serialize(item.num, out);
+                dlib::serialize(item.iteration, out);
+                dlib::serialize(item.chunk, out);
             }
 
             friend void deserialize (oracle_response& item, std::istream& in)
             {
-                deserialize(item.subgradient, in);
+                deserialize_maybe_sparse(item.subgradient, in);
                 dlib::deserialize(item.loss, in);
                 dlib::deserialize(item.num, in);
+                dlib::deserialize(item.iteration, in);
+                dlib::deserialize(item.chunk, in);
             }
         };
 
@@ -64,10 +150,16 @@ namespace dlib
         {
             typedef typename matrix_type::type scalar_type;
 
+            // This is empty if the node should use the current_solution from the last
+            // request with the same iteration number.
             matrix_type current_solution;
             scalar_type cur_risk_lower_bound;
             double eps;
             bool skip_cache;
+            uint64 iteration;
+            long chunk;
+            long begin;
+            long end;
 
             friend void swap (oracle_request& a, oracle_request& b)
             {
@@ -75,6 +167,10 @@ namespace dlib
                 std::swap(a.cur_risk_lower_bound, b.cur_risk_lower_bound);
                 std::swap(a.eps, b.eps);
                 std::swap(a.skip_cache, b.skip_cache);
+                std::swap(a.iteration, b.iteration);
+                std::swap(a.chunk, b.chunk);
+                std::swap(a.begin, b.begin);
+                std::swap(a.end, b.end);
             }
 
             friend void serialize (const oracle_request& item, std::ostream& out)
@@ -83,6 +179,10 @@ namespace dlib
                 dlib::serialize(item.cur_risk_lower_bound, out);
                 dlib::serialize(item.eps, out);
                 dlib::serialize(item.skip_cache, out);
+                dlib::serialize(item.iteration, out);
+                dlib::serialize(item.chunk, out);
+                dlib::serialize(item.begin, out);
+                dlib::serialize(item.end, out);
             }
 
             friend void deserialize (oracle_request& item, std::istream& in)
@@ -91,9 +191,90 @@ namespace dlib
                 dlib::deserialize(item.cur_risk_lower_bound, in);
                 dlib::deserialize(item.eps, in);
                 dlib::deserialize(item.skip_cache, in);
+                dlib::deserialize(item.iteration, in);
+                dlib::deserialize(item.chunk, in);
+                dlib::deserialize(item.begin, in);
+                dlib::deserialize(item.end, in);
+            }
+        };
+
+    // ----------------------------------------------------------------------------------------
+
+        template <typename matrix_type>
+        struct node_info
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is what a processing node sends to the controller whenever a new
+                    connection is established.  Nodes with the same dataset_id hold the
+                    same training data and so can process each other's samples.
+            !*/
+
+            long num_dims;
+            long num_samples;
+            uint64 dataset_id;
+            // minus the sum of the true joint feature vectors of all the samples
+            matrix_type psi_true;
+
+            friend void swap (node_info& a, node_info& b)
+            {
+                std::swap(a.num_dims, b.num_dims);
+                std::swap(a.num_samples, b.num_samples);
+                std::swap(a.dataset_id, b.dataset_id);
+                a.psi_true.swap(b.psi_true);
+            }
+
+            friend void serialize (const node_info& item, std::ostream& out)
+            {
+                dlib::serialize(item.num_dims, out);
+                dlib::serialize(item.num_samples, out);
+                dlib::serialize(item.dataset_id, out);
+                serialize_maybe_sparse(item.psi_true, out);
+            }
+
+            friend void deserialize (node_info& item, std::istream& in)
+            {
+                dlib::deserialize(item.num_dims, in);
+                dlib::deserialize(item.num_samples, in);
+                dlib::deserialize(item.dataset_id, in);
+                deserialize_maybe_sparse(item.psi_true, in);
+            }
+        };
+
+    // ----------------------------------------------------------------------------------------
+
+        struct node_heartbeat
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    Processing nodes send this once a second, even while they are busy
+                    evaluating separation oracles, so the controller can tell a slow node
+                    from a dead one.
+            !*/
+
+            friend void swap (node_heartbeat& , node_heartbeat& ) {}
+            friend void serialize (const node_heartbeat& , std::ostream& out) { dlib::serialize('h', out); }
+            friend void deserialize (node_heartbeat& , std::istream& in) 
+            { 
+                char temp; 
+                dlib::deserialize(temp, in); 
             }
         };
 
+        // The interval between heartbeats, in milliseconds.
+        const unsigned long node_heartbeat_interval = 1000;
+
+        inline bridge_options oracle_bridge_options (
+        )
+        {
+            // batch and compress the oracle traffic
+            bridge_options opts;
+            opts.batched_framing = true;
+            opts.max_batch_delay = 0;
+            opts.compression_threshold = 4096;
+            return opts;
+        }
+
     }
 
 // ----------------------------------------------------------------------------------------
@@ -123,11 +304,45 @@ namespace dlib
                 << "\n\t this: " << this
                 );
 
-            the_problem.reset(new node_type<T,U>(problem, port, num_threads));
+            // Make up a dataset id that no other node will be using.
+            dlib::rand rnd;
+            rnd.set_seed(cast_to_string(timestamper().get_timestamp()) + cast_to_string(port) + 
+                         cast_to_string((void*)this));
+            the_problem.reset(new node_type<T,U>(problem, port, num_threads, rnd.get_random_64bit_number()));
+        }
+
+        template <
+            typename T,
+            typename U 
+            >
+        svm_struct_processing_node (
+            const structural_svm_problem<T,U>& problem,
+            unsigned short port,
+            unsigned short num_threads,
+            uint64 dataset_id
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(port != 0 && problem.get_num_samples() != 0 &&
+                        problem.get_num_dimensions() != 0,
+                "\t svm_struct_processing_node()"
+                << "\n\t Invalid arguments were given to this function"
+                << "\n\t port: " << port 
+                << "\n\t problem.get_num_samples():    " << problem.get_num_samples() 
+                << "\n\t problem.get_num_dimensions(): " << problem.get_num_dimensions() 
+                << "\n\t this: " << this
+                );
+
+            the_problem.reset(new node_type<T,U>(problem, port, num_threads, dataset_id));
         }
 
     private:
 
+        template <typename T, typename U>
+        static void update_cache_eviction_threshold (
+            const structural_svm_problem<T,U>& problem
+        ) { problem.update_cache_eviction_threshold(); }
+
         struct base
         {
             virtual ~base(){}
@@ -145,16 +360,21 @@ namespace dlib
             node_type(
                 const structural_svm_problem<matrix_type,feature_vector_type>& prob,
                 unsigned short port,
-                unsigned long num_threads
-            ) : in(3),out(3), problem(prob), tp(num_threads)
+                unsigned long num_threads,
+                uint64 dataset_id_
+            ) : in(3),out(3), problem(prob), tp(num_threads), dataset_id(dataset_id_),
+                solution_iteration(0), heartbeat_timer(*this, &node_type::send_heartbeat)
             {
-                b.reconfigure(listen_on_port(port), receive(in), transmit(out));
+                b.reconfigure(listen_on_port(port), receive(in), transmit(out), impl::oracle_bridge_options());
 
                 start();
+                heartbeat_timer.set_delay_time(impl::node_heartbeat_interval);
+                heartbeat_timer.start();
             }
 
             ~node_type()
             {
+                heartbeat_timer.stop_and_wait();
                 in.disable();
                 out.disable();
                 wait();
@@ -162,6 +382,16 @@ namespace dlib
 
         private:
 
+            void send_heartbeat (
+            )
+            {
+                tsu_out temp;
+                temp.template get<impl::node_heartbeat>();
+                // If the pipe is full then messages are flowing anyway so there is no need
+                // to wait.
+                out.enqueue_or_timeout(temp,0);
+            }
+
             void thread()
             {
                 using namespace impl;
@@ -199,7 +429,11 @@ namespace dlib
                     if (msg.template contains<bridge_status>() && 
                         msg.template get<bridge_status>().is_connected)
                     {
-                        temp = problem.get_num_dimensions();
+                        node_info<matrix_type>& info = temp.template get<node_info<matrix_type> >();
+                        info.num_dims = problem.get_num_dimensions();
+                        info.num_samples = problem.get_num_samples();
+                        info.dataset_id = dataset_id;
+                        info.psi_true = psi_true;
                         out.enqueue(temp);
 
                     }
@@ -207,14 +441,38 @@ namespace dlib
                     {
                         ++num_iterations_executed;
 
-                        const oracle_request<matrix_type>& req = msg.template get<oracle_request<matrix_type> >();
+                        oracle_request<matrix_type>& req = msg.template get<oracle_request<matrix_type> >();
 
                         oracle_response<matrix_type>& data = temp.template get<oracle_response<matrix_type> >();
-
-                        data.subgradient = psi_true;
+                        data.iteration = req.iteration;
+                        data.chunk = req.chunk;
                         data.loss = 0;
 
-                        data.num = problem.get_num_samples();
+                        if (req.current_solution.size() != 0)
+                        {
+                            // The first solution of each iteration ends the previous one.
+                            // So adjust the cache eviction threshold like
+                            // structural_svm_problem::get_risk() does after each iteration.
+                            if (solution_iteration != req.iteration)
+                                update_cache_eviction_threshold(problem);
+                            solution.swap(req.current_solution);
+                            solution_iteration = req.iteration;
+                        }
+
+                        const long begin = std::max<long>(0, req.begin);
+                        const long end = std::min<long>(problem.get_num_samples(), req.end);
+                        if (solution_iteration != req.iteration || begin > end)
+                        {
+                            // We don't have the weight vector this request is talking about.
+                            data.subgradient.set_size(0,1);
+                            data.num = -1;
+                            out.enqueue(temp);
+                            continue;
+                        }
+
+                        data.subgradient.set_size(problem.get_num_dimensions(),1);
+                        data.subgradient = 0;
+                        data.num = end-begin;
 
                         const uint64 start_time = ts.get_timestamp();
 
@@ -228,8 +486,8 @@ namespace dlib
                             buffer_subgradients_locally = !buffer_subgradients_locally;
                         }
 
-                        binder b(*this, req, data, buffer_subgradients_locally);
-                        parallel_for_blocked(tp, 0, data.num, b, &binder::call_oracle);
+                        binder b(*this, req, solution, data, buffer_subgradients_locally);
+                        parallel_for_blocked(tp, begin, end, b, &binder::call_oracle);
 
                         const uint64 stop_time = ts.get_timestamp();
                         if (buffer_subgradients_locally)
@@ -247,9 +505,10 @@ namespace dlib
                 binder (
                     const node_type& self_,
                     const impl::oracle_request<matrix_type>& req_,
+                    const matrix_type& current_solution_,
                     impl::oracle_response<matrix_type>& data_,
                     bool buffer_subgradients_locally_
-                ) : self(self_), req(req_), data(data_),
+                ) : self(self_), req(req_), current_solution(current_solution_), data(data_),
                     buffer_subgradients_locally(buffer_subgradients_locally_) {}
 
                 void call_oracle (
@@ -272,7 +531,7 @@ namespace dlib
                         {
                             self.cache[i].separation_oracle_cached(req.skip_cache, 
                                                                    req.cur_risk_lower_bound,
-                                                                   req.current_solution,
+                                                                   current_solution,
                                                                    loss,
                                                                    ftemp);
 
@@ -294,7 +553,7 @@ namespace dlib
                             scalar_type loss_temp;
                             self.cache[i].separation_oracle_cached(req.skip_cache, 
                                                                    req.cur_risk_lower_bound,
-                                                                   req.current_solution,
+                                                                   current_solution,
                                                                    loss_temp,
                                                                    ftemp);
                             loss += loss_temp;
@@ -309,6 +568,7 @@ namespace dlib
 
                 const node_type& self;
                 const impl::oracle_request<matrix_type>& req;
+                const matrix_type& current_solution;
                 impl::oracle_response<matrix_type>& data;
                 bool buffer_subgradients_locally;
             };
@@ -316,7 +576,7 @@ namespace dlib
 
 
             typedef type_safe_union<impl::oracle_request<matrix_type>, bridge_status> tsu_in;
-            typedef type_safe_union<impl::oracle_response<matrix_type> , long> tsu_out;
+            typedef type_safe_union<impl::oracle_response<matrix_type>, impl::node_info<matrix_type>, impl::node_heartbeat> tsu_out;
 
             pipe<tsu_in> in;
             pipe<tsu_out> out;
@@ -328,6 +588,12 @@ namespace dlib
 
             mutable thread_pool tp;
             mutex accum_mutex;
+
+            const uint64 dataset_id;
+            matrix_type solution;
+            uint64 solution_iteration;
+
+            timer<node_type> heartbeat_timer;
         };
 
 
@@ -344,9 +610,37 @@ namespace dlib
         ) :
             eps(0.001),
             verbose(false),
-            C(1)
+            C(1),
+            node_timeout(30000)
         {}
 
+        unsigned long get_num_node_failures (
+        ) const { return counts.node_failures; }
+
+        unsigned long get_num_reassigned_chunks (
+        ) const { return counts.reassigned_chunks; }
+
+        unsigned long get_num_node_reconnections (
+        ) const { return counts.reconnections; }
+
+        void set_node_timeout (
+            unsigned long milliseconds
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(milliseconds > impl::node_heartbeat_interval,
+                "\t void svm_struct_controller_node::set_node_timeout()"
+                << "\n\t The timeout must be longer than the heartbeat interval."
+                << "\n\t milliseconds: " << milliseconds 
+                << "\n\t this: " << this
+                );
+
+            node_timeout = milliseconds;
+        }
+
+        unsigned long get_node_timeout (
+        ) const { return node_timeout; }
+
         void set_epsilon (
             double eps_
         )
@@ -453,7 +747,8 @@ namespace dlib
                         << "\n\t this: " << this
             );
 
-            problem_type<matrix_type> problem(nodes,eps,verbose,C);
+            counts = failure_counts();
+            problem_type<matrix_type> problem(nodes,eps,verbose,C,node_timeout,counts);
 
             return solver(problem, w);
         }
@@ -469,9 +764,28 @@ namespace dlib
 
     private:
 
+        struct failure_counts
+        {
+            failure_counts() : node_failures(0), reassigned_chunks(0), reconnections(0) {}
+            unsigned long node_failures;
+            unsigned long reassigned_chunks;
+            unsigned long reconnections;
+        };
+
         template <typename matrix_type_>
         class problem_type : public oca_problem<matrix_type_>
         {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    Each call to get_risk() splits the samples of each dataset into chunks
+                    and hands them out to the processing nodes holding that dataset as
+                    they become idle, so faster nodes end up doing more of the work.  If
+                    a node disconnects, or stops sending heartbeats for node_timeout
+                    milliseconds, its outstanding chunks go back into the queue for the
+                    other nodes with the same dataset.  The bridges reconnect to lost
+                    nodes automatically and a reconnected node starts getting work again
+                    once it has told us what data it has.
+            !*/
         public:
             typedef typename matrix_type_::type scalar_type;
             typedef matrix_type_ matrix_type;
@@ -480,59 +794,47 @@ namespace dlib
                 const std::vector<network_address>& nodes_,
                 double eps_,
                 bool verbose_,
-                double C_
+                double C_,
+                unsigned long node_timeout_,
+                failure_counts& counts_
             ) :
-                nodes(nodes_),
                 eps(eps_),
                 verbose(verbose_),
                 C(C_),
-                in(3),
+                node_timeout(node_timeout_),
+                counts(counts_),
+                in(100),
                 cur_risk_lower_bound(0),
                 skip_cache(true),
-                num_dims(0)
+                num_dims(0),
+                iteration(0)
             {
-
-                // initialize all the transmit pipes
-                out_pipes.resize(nodes.size());
-                for (unsigned long i = 0; i < out_pipes.size(); ++i)
-                {
-                    out_pipes[i].reset(new pipe<tsu_out>(3));
-                }
-
                 // make bridges that connect to all our remote processing nodes
-                bridges.resize(nodes.size());
-                for (unsigned long i = 0; i< bridges.size(); ++i)
-                {
-                    bridges[i].reset(new bridge(connect_to(nodes[i]), 
-                                                receive(in), transmit(*out_pipes[i])));
-                }
-
+                nodes.resize(nodes_.size());
+                for (unsigned long i = 0; i < nodes.size(); ++i)
+                    nodes[i].reset(new node_connection(nodes_[i], i, in));
 
-
-                // The remote processing nodes are supposed to all send the problem dimensionality
-                // upon connection. So get that and make sure everyone agrees on what it's supposed to be.
-                tsu_in temp;
+                // The remote processing nodes are supposed to all send a description of
+                // their data upon connection.  Wait until we have heard from all of them so
+                // we know about every dataset before we start. 
                 unsigned long responses = 0;
-                bool seen_dim = false;
+                tagged_message msg;
                 while (responses < nodes.size())
                 {
-                    in.dequeue(temp);
-                    if (temp.template contains<long>())
-                    {
+                    in.dequeue(msg);
+                    if (msg.data.template contains<impl::node_info<matrix_type> >() && !nodes[msg.node]->seen_info)
                         ++responses;
-                        // if this new dimension doesn't match what we have seen previously
-                        if (seen_dim && num_dims != temp.template get<long>())
-                        {
-                            throw invalid_problem("remote hosts disagree on the number of dimensions!");
-                        }
-                        seen_dim = true;
-                        num_dims = temp.template get<long>();
-                    }
+                    handle_message(msg);
                 }
-
             }
 
-
+            ~problem_type (
+            )
+            {
+                // Stop all the forwarding threads before the in pipe goes away.
+                in.disable();
+                nodes.clear();
+            }
 
             virtual bool risk_has_lower_bound (
                 scalar_type& lower_bound
@@ -560,6 +862,11 @@ namespace dlib
                     cout << "risk gap:      " << current_risk_gap << endl;
                     cout << "num planes:    " << num_cutting_planes << endl;
                     cout << "iter:          " << num_iterations << endl;
+                    for (unsigned long i = 0; i < nodes.size(); ++i)
+                    {
+                        cout << "node " << nodes[i]->addr << ": " << (nodes[i]->alive ? "" : "(down) ") 
+                             << nodes[i]->samples_processed << " samples" << endl;
+                    }
                     cout << endl;
                 }
 
@@ -605,37 +912,88 @@ namespace dlib
                 matrix_type& subgradient
             ) const 
             {
-                using namespace impl;
+                ++iteration;
                 subgradient.set_size(w.size(),1);
                 subgradient = 0;
+                long num = 0;
+                scalar_type total_loss = 0;
 
-                // send out all the oracle requests
-                tsu_out temp_out;
-                for (unsigned long i = 0; i < out_pipes.size(); ++i)
+                // Split each dataset into chunks.  When a dataset is on several nodes we
+                // use a few chunks per node so the work can be balanced between them.
+                chunks.clear();
+                pending.assign(datasets.size(), std::deque<long>());
+                for (unsigned long d = 0; d < datasets.size(); ++d)
                 {
-                    temp_out.template get<oracle_request<matrix_type> >().current_solution = w;
-                    temp_out.template get<oracle_request<matrix_type> >().eps = eps;
-                    temp_out.template get<oracle_request<matrix_type> >().cur_risk_lower_bound = cur_risk_lower_bound;
-                    temp_out.template get<oracle_request<matrix_type> >().skip_cache = skip_cache;
-                    out_pipes[i]->enqueue(temp_out);
+                    subgradient += datasets[d].psi_true;
+                    num += datasets[d].num_samples;
+
+                    const long num_chunks = datasets[d].num_nodes > 1 ? 
+                        std::min<long>(4*datasets[d].num_nodes, datasets[d].num_samples) : 1;
+                    for (long c = 0; c < num_chunks; ++c)
+                    {
+                        chunk ch;
+                        ch.dataset = d;
+                        ch.begin = datasets[d].num_samples*c/num_chunks;
+                        ch.end = datasets[d].num_samples*(c+1)/num_chunks;
+                        pending[d].push_back(chunks.size());
+                        chunks.push_back(ch);
+                    }
                 }
 
-                // collect all the oracle responses  
-                long num = 0;
-                scalar_type total_loss = 0;
-                tsu_in temp_in;
-                unsigned long responses = 0;
-                while (responses < out_pipes.size())
+                // We weren't listening to the nodes while the solver was running so don't
+                // hold that time against them.
+                const uint64 now = ts.get_timestamp();
+                for (unsigned long i = 0; i < nodes.size(); ++i)
+                {
+                    nodes[i]->last_heard = now;
+                    nodes[i]->samples_processed = 0;
+                    nodes[i]->outstanding.clear();
+                }
+
+                unsigned long num_remaining = chunks.size();
+                tagged_message msg;
+                while (num_remaining != 0)
                 {
-                    in.dequeue(temp_in);
-                    if (temp_in.template contains<oracle_response<matrix_type> >())
+                    dispatch_chunks(w);
+
+                    if (in.dequeue_or_timeout(msg, 100))
                     {
-                        ++responses;
-                        const oracle_response<matrix_type>& data = temp_in.template get<oracle_response<matrix_type> >();
-                        subgradient += data.subgradient; 
-                        total_loss += data.loss;
-                        num += data.num;
+                        if (msg.data.template contains<impl::oracle_response<matrix_type> >())
+                        {
+                            impl::oracle_response<matrix_type>& data = msg.data.template get<impl::oracle_response<matrix_type> >();
+                            node_connection& node = *nodes[msg.node];
+                            node.last_heard = ts.get_timestamp();
+                            if (data.iteration != iteration || data.chunk < 0 || data.chunk >= (long)chunks.size())
+                                continue;
+
+                            node.remove_outstanding(data.chunk);
+                            chunk& ch = chunks[data.chunk];
+                            if (data.num < 0)
+                            {
+                                // The node didn't have our current solution so send it
+                                // again along with this chunk.
+                                node.solution_sent = 0;
+                                if (!ch.done)
+                                    pending[ch.dataset].push_front(data.chunk);
+                            }
+                            else if (!ch.done && data.num == ch.end-ch.begin && data.subgradient.size() == w.size())
+                            {
+                                ch.done = true;
+                                --num_remaining;
+                                subgradient += data.subgradient;
+                                total_loss += data.loss;
+                                node.samples_processed += data.num;
+                            }
+                        }
+                        else
+                        {
+                            handle_message(msg);
+                        }
                     }
+
+                    // Only look for timeouts when we are caught up on our messages.
+                    if (in.size() == 0)
+                        check_for_dead_nodes();
                 }
 
                 subgradient /= num;
@@ -643,27 +1001,294 @@ namespace dlib
                 risk = total_loss + dot(subgradient,w);
             }
 
-            std::vector<network_address> nodes;
+        private:
+
+            typedef type_safe_union<impl::oracle_request<matrix_type> > tsu_out;
+            typedef type_safe_union<impl::oracle_response<matrix_type>, impl::node_info<matrix_type>, 
+                                    impl::node_heartbeat, bridge_status> tsu_in;
+
+            struct tagged_message
+            {
+                long node;
+                tsu_in data;
+
+                friend void swap (tagged_message& a, tagged_message& b)
+                {
+                    std::swap(a.node, b.node);
+                    a.data.swap(b.data);
+                }
+            };
+
+            class node_connection : public threaded_object
+            {
+                /*!
+                    WHAT THIS OBJECT REPRESENTS
+                        This is our connection to one processing node.  Its thread
+                        forwards everything the node sends into the shared pipe, tagged
+                        with the node's index.
+                !*/
+            public:
+                node_connection (
+                    const network_address& addr_,
+                    long idx_,
+                    pipe<tagged_message>& shared_
+                ) : 
+                    addr(addr_), alive(false), seen_info(false), dataset(-1), last_heard(0),
+                    solution_sent(0), samples_processed(0), 
+                    node_in(4), node_out(4), idx(idx_), shared(shared_)
+                {
+                    reconnect();
+                    start();
+                }
+
+                ~node_connection (
+                )
+                {
+                    node_in.disable();
+                    b.reset();
+                    wait();
+                }
+
+                void reconnect (
+                )
+                {
+                    b.reset();
+                    node_out.empty();
+                    b.reset(new bridge(connect_to(addr), receive(node_in), transmit(node_out), 
+                                       impl::oracle_bridge_options()));
+                }
+
+                void remove_outstanding (
+                    long c
+                )
+                {
+                    for (unsigned long i = 0; i < outstanding.size(); ++i)
+                    {
+                        if (outstanding[i] == c)
+                        {
+                            outstanding.erase(outstanding.begin()+i);
+                            return;
+                        }
+                    }
+                }
+
+                const network_address addr;
+                bool alive;
+                bool seen_info;
+                long dataset;
+                uint64 last_heard;
+                // the iteration whose solution we last sent to this node
+                uint64 solution_sent;
+                long samples_processed;
+                std::vector<long> outstanding;
+
+                pipe<tsu_in> node_in;
+                pipe<tsu_out> node_out;
+                scoped_ptr<bridge> b;
+
+            private:
+                void thread (
+                )
+                {
+                    tagged_message msg;
+                    while (node_in.dequeue(msg.data))
+                    {
+                        msg.node = idx;
+                        if (!shared.enqueue(msg))
+                            break;
+                    }
+                }
+
+                const long idx;
+                pipe<tagged_message>& shared;
+            };
+
+            struct dataset_info
+            {
+                uint64 id;
+                long num_samples;
+                long num_nodes;
+                matrix_type psi_true;
+            };
+
+            struct chunk
+            {
+                chunk() : dataset(0), begin(0), end(0), done(false) {}
+                long dataset;
+                long begin;
+                long end;
+                bool done;
+            };
+
+            void handle_message (
+                tagged_message& msg
+            ) const
+            {
+                node_connection& node = *nodes[msg.node];
+                node.last_heard = ts.get_timestamp();
+
+                if (msg.data.template contains<bridge_status>())
+                {
+                    if (!msg.data.template get<bridge_status>().is_connected)
+                        mark_dead(node);
+                }
+                else if (msg.data.template contains<impl::node_info<matrix_type> >())
+                {
+                    impl::node_info<matrix_type>& info = msg.data.template get<impl::node_info<matrix_type> >();
+
+                    // if this new dimension doesn't match what we have seen previously
+                    if (num_dims != 0 && num_dims != info.num_dims)
+                        throw invalid_problem("remote hosts disagree on the number of dimensions!");
+                    num_dims = info.num_dims;
+
+                    long d = 0;
+                    while (d < (long)datasets.size() && datasets[d].id != info.dataset_id)
+                        ++d;
+                    if (d == (long)datasets.size())
+                    {
+                        dataset_info temp;
+                        temp.id = info.dataset_id;
+                        temp.num_samples = info.num_samples;
+                        temp.num_nodes = 0;
+                        temp.psi_true.swap(info.psi_true);
+                        datasets.push_back(temp);
+                        pending.resize(datasets.size());
+                    }
+                    else if (datasets[d].num_samples != info.num_samples)
+                    {
+                        throw invalid_problem("remote hosts with the same dataset id disagree on the number of samples!");
+                    }
+
+                    if (node.seen_info && !node.alive)
+                        ++counts.reconnections;
+
+                    if (node.dataset != d)
+                    {
+                        // A node that came back with different data is an error since
+                        // we would lose track of the samples it used to have.
+                        if (node.dataset != -1)
+                            throw invalid_problem("a remote host reconnected with a different dataset!");
+                        node.dataset = d;
+                        ++datasets[d].num_nodes;
+                    }
+
+                    node.seen_info = true;
+                    node.alive = true;
+                    node.solution_sent = 0;
+                }
+            }
+
+            void mark_dead (
+                node_connection& node
+            ) const
+            /*!
+                ensures
+                    - puts the node's outstanding chunks back in the queue and stops
+                      sending it work until it reconnects.
+            !*/
+            {
+                if (node.alive)
+                    ++counts.node_failures;
+                node.alive = false;
+                node.solution_sent = 0;
+                for (unsigned long i = 0; i < node.outstanding.size(); ++i)
+                {
+                    const long c = node.outstanding[i];
+                    if (!chunks[c].done)
+                    {
+                        pending[chunks[c].dataset].push_front(c);
+                        ++counts.reassigned_chunks;
+                    }
+                }
+                node.outstanding.clear();
+                node.node_out.empty();
+            }
+
+            void check_for_dead_nodes (
+            ) const
+            {
+                const uint64 now = ts.get_timestamp();
+                for (unsigned long i = 0; i < nodes.size(); ++i)
+                {
+                    node_connection& node = *nodes[i];
+                    if (node.alive && now > node.last_heard + node_timeout*(uint64)1000)
+                    {
+                        // The node is connected but isn't responding.  So drop the
+                        // connection and make a new one.
+                        mark_dead(node);
+                        node.reconnect();
+                        node.last_heard = now;
+                    }
+                }
+            }
+
+            void dispatch_chunks (
+                const matrix_type& w
+            ) const
+            {
+                // Keep up to two chunks queued at each node so they never sit idle waiting
+                // for a round trip.
+                for (unsigned long i = 0; i < nodes.size(); ++i)
+                {
+                    node_connection& node = *nodes[i];
+                    if (!node.alive)
+                        continue;
+
+                    std::deque<long>& q = pending[node.dataset];
+                    while (node.outstanding.size() < 2 && q.size() != 0)
+                    {
+                        const long c = q.front();
+                        q.pop_front();
+                        if (chunks[c].done)
+                            continue;
+
+                        tsu_out temp;
+                        impl::oracle_request<matrix_type>& req = temp.template get<impl::oracle_request<matrix_type> >();
+                        // Only send the weight vector once per iteration.
+                        if (node.solution_sent != iteration)
+                        {
+                            req.current_solution = w;
+                            node.solution_sent = iteration;
+                        }
+                        req.eps = eps;
+                        req.cur_risk_lower_bound = cur_risk_lower_bound;
+                        req.skip_cache = skip_cache;
+                        req.iteration = iteration;
+                        req.chunk = c;
+                        req.begin = chunks[c].begin;
+                        req.end = chunks[c].end;
+                        node.outstanding.push_back(c);
+                        node.node_out.enqueue(temp);
+                    }
+                }
+            }
+
             double eps;
             mutable bool verbose;
             double C;
+            const unsigned long node_timeout;
+            failure_counts& counts;
 
-            typedef type_safe_union<impl::oracle_request<matrix_type> > tsu_out;
-            typedef type_safe_union<impl::oracle_response<matrix_type>, long> tsu_in;
-
-            std::vector<shared_ptr<pipe<tsu_out> > > out_pipes;
-            mutable pipe<tsu_in> in;
-            std::vector<shared_ptr<bridge> > bridges;
+            mutable pipe<tagged_message> in;
+            std::vector<shared_ptr<node_connection> > nodes;
 
             mutable scalar_type cur_risk_lower_bound;
             mutable bool skip_cache;
-            long num_dims;
+            mutable long num_dims;
+
+            mutable std::vector<dataset_info> datasets;
+            mutable std::vector<chunk> chunks;
+            mutable std::vector<std::deque<long> > pending;
+            mutable uint64 iteration;
+            mutable timestamper ts;
         };
 
         std::vector<network_address> nodes;
         double eps;
         mutable bool verbose;
         double C;
+        unsigned long node_timeout;
+        mutable failure_counts counts;
     };
 
 // ----------------------------------------------------------------------------------------
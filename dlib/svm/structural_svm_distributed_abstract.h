@@ -49,8 +49,38 @@ namespace dlib
                     - problem.get_epsilon()
                     - weather the problem is verbose or not
                   Instead, they are defined by the svm_struct_controller_node. Note, however,
-                  that the problem.get_max_cache_size() parameter is meaningful and controls
-                  the size of the separation oracle cache within a svm_struct_processing_node.
+                  that the problem.get_max_cache_size() and problem.get_max_cache_memory()
+                  parameters are meaningful and control the size of the separation oracle
+                  cache within a svm_struct_processing_node.  The node adapts its cache
+                  eviction threshold once per iteration, just as the problem would when
+                  solved directly.
+                - This node is given a randomly generated dataset id.  So no other node
+                  will be treated as holding the same data as this one.
+        !*/
+
+        template <
+            typename T,
+            typename U 
+            >
+        svm_struct_processing_node (
+            const structural_svm_problem<T,U>& problem,
+            unsigned short port,
+            unsigned short num_threads,
+            uint64 dataset_id
+        );
+        /*!
+            requires
+                - port != 0
+                - problem.get_num_samples() != 0
+                - problem.get_num_dimensions() != 0
+            ensures
+                - This constructor is identical to the one above except that the node
+                  reports the given dataset_id to the controller.  Processing nodes that
+                  report the same dataset_id must contain exactly the same training
+                  samples, in the same order.  The controller treats such nodes as
+                  replicas of each other and splits the work for that data between
+                  them, giving more of it to the faster nodes.  If one of them goes
+                  down then the others take over its samples.
         !*/
     };
 
@@ -63,6 +93,10 @@ namespace dlib
                 - get_num_processing_nodes() == 0
                 - get_epsilon() == 0.001
                 - get_c() == 1
+                - get_node_timeout() == 30000
+                - get_num_node_failures() == 0
+                - get_num_reassigned_chunks() == 0
+                - get_num_node_reconnections() == 0
                 - This object will not be verbose
 
             WHAT THIS OBJECT REPRESENTS
@@ -108,6 +142,16 @@ namespace dlib
                         cin.get();
                     }
 
+                While the optimization runs the controller hands out the samples in
+                chunks to whichever nodes are idle, so if some nodes hold the same data
+                (see the dataset_id argument to the svm_struct_processing_node's
+                constructor) the faster ones will end up processing more of it.  The
+                processing nodes also send a heartbeat message every second.  If a node
+                disconnects, or doesn't send anything for get_node_timeout()
+                milliseconds, the controller gives its outstanding work to the other
+                nodes with the same dataset_id and keeps trying to reconnect to it in
+                the background.  Note that if every node holding some part of the data is
+                down then the optimization waits until one of them comes back.
         !*/
 
     public:
@@ -208,6 +252,27 @@ namespace dlib
                 - invokes: add_processing_node(network_address(ip_or_hostname, port))
         !*/
 
+        void set_node_timeout (
+            unsigned long milliseconds
+        );
+        /*!
+            requires
+                - milliseconds > 1000
+            ensures
+                - #get_node_timeout() == milliseconds
+        !*/
+
+        unsigned long get_node_timeout (
+        ) const;
+        /*!
+            ensures
+                - returns the number of milliseconds a connected processing node may go
+                  without sending anything to this object before it is considered dead.
+                  When that happens the connection is dropped, the node's outstanding
+                  work is given to other nodes holding the same data, and this object
+                  attempts to reconnect to it.
+        !*/
+
         unsigned long get_num_processing_nodes (
         ) const;
         /*!
@@ -216,6 +281,33 @@ namespace dlib
                   registered with this object.
         !*/
 
+        unsigned long get_num_node_failures (
+        ) const;
+        /*!
+            ensures
+                - returns the number of times, during the last call to operator(), that
+                  a connected processing node disconnected or was considered dead
+                  because it exceeded get_node_timeout().
+        !*/
+
+        unsigned long get_num_reassigned_chunks (
+        ) const;
+        /*!
+            ensures
+                - returns the number of chunks of samples, during the last call to
+                  operator(), that were sent to a node which then failed and so were
+                  put back in the queue to be processed by another node.
+        !*/
+
+        unsigned long get_num_node_reconnections (
+        ) const;
+        /*!
+            ensures
+                - returns the number of times, during the last call to operator(), that
+                  a processing node which had failed was connected to again and started
+                  getting work.
+        !*/
+
         void remove_processing_nodes (
         );
         /*!
@@ -243,7 +335,9 @@ namespace dlib
                 - invalid_problem
                   This exception is thrown if the svm_struct_processing_nodes disagree
                   on the dimensionality of the problem.  That is, if they disagree on
-                  the value of structural_svm_problem::get_num_dimensions().
+                  the value of structural_svm_problem::get_num_dimensions().  It is
+                  also thrown if two nodes with the same dataset_id report a different
+                  number of samples or if a node reconnects with a different dataset_id.
         !*/
 
     };
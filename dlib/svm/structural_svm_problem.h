@@ -10,10 +10,15 @@
 #include "../matrix.h"
 #include "sparse_vector.h"
 #include <iostream>
+#include "../threads/threads_kernel.h"
+#include "../threads/auto_mutex_extension.h"
+#include "../uintn.h"
 
 namespace dlib
 {
 
+    class svm_struct_processing_node;
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -24,7 +29,8 @@ namespace dlib
     public:
 
         cache_element_structural_svm (
-        ) : prob(0), sample_idx(0), last_true_risk_computed(std::numeric_limits<double>::infinity()) {}
+        ) : prob(0), sample_idx(0), last_true_risk_computed(std::numeric_limits<double>::infinity()),
+            num_hits(0), num_misses(0), bytes_used(0) {}
 
         typedef typename structural_svm_problem::scalar_type scalar_type;
         typedef typename structural_svm_problem::matrix_type matrix_type;
@@ -40,12 +46,22 @@ namespace dlib
                   structural_svm_problem.
         !*/
         {
+            // The cached deltas use 32bit indices.
+            DLIB_ASSERT(prob_->get_max_cache_size() == 0 || 
+                        prob_->get_num_dimensions() <= (long)std::numeric_limits<uint32>::max(),
+                "\t void cache_element_structural_svm::init()"
+                << "\n\t The separation oracle cache can't be used with this many dimensions."
+                << "\n\t prob_->get_num_dimensions(): " << prob_->get_num_dimensions() 
+                );
+
             prob = prob_;
             sample_idx = idx;
 
-            loss.clear();
-            psi.clear();
-            lru_count.clear();
+            release_memory(bytes_used);
+            entries.clear();
+            num_hits = 0;
+            num_misses = 0;
+            bytes_used = 0;
 
             if (prob->get_max_cache_size() != 0)
             {
@@ -64,6 +80,18 @@ namespace dlib
                 prob->get_truth_joint_feature_vector(sample_idx, psi);
         }
 
+        unsigned long get_num_hits (
+        ) const { return num_hits; }
+
+        unsigned long get_num_misses (
+        ) const { return num_misses; }
+
+        unsigned long get_num_entries (
+        ) const { return entries.size(); }
+
+        size_t get_memory_usage (
+        ) const { return bytes_used; }
+
         void separation_oracle_cached (
             const bool skip_cache,
             const scalar_type& saved_current_risk_gap,
@@ -74,26 +102,25 @@ namespace dlib
         {
             const bool cache_enabled = prob->get_max_cache_size() != 0;
 
-            // Don't waste time computing this if the cache isn't going to be used.
-            const scalar_type dot_true_psi = cache_enabled ? dot(true_psi, current_solution) : 0;
-
             scalar_type best_risk = -std::numeric_limits<scalar_type>::infinity();
             unsigned long best_idx = 0;
-            long max_lru_count = 0;
             if (cache_enabled)
             {
-                // figure out which element in the cache is the best (i.e. has the biggest risk)
-                for (unsigned long i = 0; i < loss.size(); ++i)
+                evict_useless_entries();
+
+                // figure out which element in the cache is the best (i.e. has the biggest
+                // risk).  Since the entries store psi-true_psi the risk is just the loss
+                // plus the dot product with the delta.
+                for (unsigned long i = 0; i < entries.size(); ++i)
                 {
-                    const scalar_type risk = loss[i] + dot(psi[i], current_solution) - dot_true_psi;
+                    const scalar_type risk = entries[i].loss + dot_delta(entries[i], current_solution);
                     if (risk > best_risk)
                     {
                         best_risk = risk;
-                        out_loss = loss[i];
+                        out_loss = entries[i].loss;
                         best_idx = i;
                     }
-                    if (lru_count[i] > max_lru_count)
-                        max_lru_count = lru_count[i];
+                    entries[i].usefulness *= 0.9f;
                 }
 
                 if (!skip_cache)
@@ -105,8 +132,8 @@ namespace dlib
                     if (best_risk + saved_current_risk_gap > last_true_risk_computed &&
                         best_risk >= 0)
                     {
-                        out_psi = psi[best_idx];
-                        lru_count[best_idx] = max_lru_count + 1;
+                        use_entry(best_idx, out_psi);
+                        ++num_hits;
                         return;
                     }
                 }
@@ -118,8 +145,11 @@ namespace dlib
             if (!cache_enabled)
                 return;
 
+            ++num_misses;
             compact_sparse_vector(out_psi);
 
+            // Don't waste time computing this if the cache isn't going to be used.
+            const scalar_type dot_true_psi = dot(true_psi, current_solution);
             last_true_risk_computed = out_loss + dot(out_psi, current_solution) - dot_true_psi;
 
             // If the separation oracle is only solved approximately then the result might
@@ -135,39 +165,272 @@ namespace dlib
             // element from the cache.
             else if (last_true_risk_computed < best_risk) 
             {
-                out_psi = psi[best_idx];
-                out_loss = loss[best_idx];
-                lru_count[best_idx] = max_lru_count + 1;
+                out_loss = entries[best_idx].loss;
+                use_entry(best_idx, out_psi);
             }
-            // if the cache is full
-            else if (loss.size() >= prob->get_max_cache_size())
+            else
+            {
+                entry temp;
+                temp.loss = out_loss;
+                temp.usefulness = 1;
+                make_delta(out_psi, temp);
+                const size_t temp_bytes = entry_bytes(temp);
+
+                // if the cache is full then make room by dropping the least useful entry
+                // for this sample.
+                if (entries.size() >= prob->get_max_cache_size())
+                    remove_entry(index_of_least_useful());
+
+                // If the global memory budget is used up then evict one of our own
+                // entries and try again.  Other samples will give up their memory as
+                // their unused entries age past the eviction threshold.
+                bool fits = reserve_memory(temp_bytes);
+                if (!fits && entries.size() != 0)
+                {
+                    remove_entry(index_of_least_useful());
+                    prob->count_cache_evictions(1);
+                    fits = reserve_memory(temp_bytes);
+                }
+
+                if (fits)
+                {
+                    entries.push_back(entry());
+                    entries.back().swap(temp);
+                    bytes_used += temp_bytes;
+                }
+            }
+        }
+
+    private:
+
+        struct entry
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is a cached output of the separation oracle.  It is stored as
+                    the difference from true_psi, in single precision.  If idx.size() ==
+                    val.size() then the delta is sparse and the non-zero elements are
+                    val[i] at index idx[i].  Otherwise val is the entire dense delta.
+            !*/
+            scalar_type loss;
+            float usefulness;
+            std::vector<uint32> idx;
+            std::vector<float> val;
+
+            void swap (entry& item)
             {
-                // find least recently used cache entry for idx-th sample
-                const long i       = index_of_min(mat(lru_count));
+                std::swap(loss, item.loss);
+                std::swap(usefulness, item.usefulness);
+                idx.swap(item.idx);
+                val.swap(item.val);
+            }
+        };
 
-                // save our new data in the cache
-                loss[i] = out_loss;
-                psi[i]  = out_psi;
+        static size_t entry_bytes (
+            const entry& e
+        ) 
+        {
+            return sizeof(entry) + e.idx.capacity()*sizeof(uint32) + e.val.capacity()*sizeof(float);
+        }
 
-                const long max_use = max(mat(lru_count));
-                // Make sure this new cache entry has the best lru count since we have used
-                // it most recently.
-                lru_count[i] = max_use + 1;
+        static scalar_type dot_delta (
+            const entry& e,
+            const matrix_type& w
+        )
+        {
+            scalar_type temp = 0;
+            if (e.idx.size() == e.val.size())
+            {
+                for (unsigned long i = 0; i < e.idx.size(); ++i)
+                    temp += e.val[i]*w(e.idx[i]);
             }
             else
             {
-                // In this case we just append the new psi into the cache.
-
-                loss.push_back(out_loss);
-                psi.push_back(out_psi);
-                long max_use = 1;
-                if (lru_count.size() != 0)
-                    max_use = max(mat(lru_count)) + 1;
-                lru_count.push_back(max_use);
+                for (unsigned long i = 0; i < e.val.size(); ++i)
+                    temp += e.val[i]*w(i);
             }
+            return temp;
+        }
+
+        void use_entry (
+            unsigned long i,
+            feature_vector_type& out_psi
+        ) const
+        {
+            entries[i].usefulness += 1;
+            add_delta(entries[i], out_psi);
+        }
+
+        unsigned long index_of_least_useful (
+        ) const
+        {
+            unsigned long best = 0;
+            for (unsigned long i = 1; i < entries.size(); ++i)
+            {
+                if (entries[i].usefulness < entries[best].usefulness)
+                    best = i;
+            }
+            return best;
+        }
+
+        void remove_entry (
+            unsigned long i
+        ) const
+        {
+            const size_t bytes = entry_bytes(entries[i]);
+            release_memory(bytes);
+            bytes_used -= bytes;
+            if (i+1 != entries.size())
+                entries[i].swap(entries.back());
+            entries.pop_back();
+        }
+
+        void evict_useless_entries (
+        ) const
+        {
+            const float thresh = prob->get_cache_eviction_threshold();
+            if (thresh == 0)
+                return;
+            unsigned long num_evicted = 0;
+            for (unsigned long i = 0; i < entries.size(); )
+            {
+                if (entries[i].usefulness < thresh)
+                {
+                    remove_entry(i);
+                    ++num_evicted;
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+            if (num_evicted != 0)
+                prob->count_cache_evictions(num_evicted);
+        }
+
+        bool reserve_memory (
+            size_t bytes
+        ) const { return prob->reserve_cache_memory(bytes); }
+
+        void release_memory (
+            size_t bytes
+        ) const 
+        { 
+            if (prob && bytes != 0) 
+                prob->release_cache_memory(bytes); 
+        }
+
+        template <typename T, long NR, long NC, typename MM, typename L>
+        void make_delta (
+            const matrix<T,NR,NC,MM,L>& psi,
+            entry& e
+        ) const
+        {
+            unsigned long nnz = 0;
+            for (long i = 0; i < psi.size(); ++i)
+            {
+                if (psi(i) != true_psi(i))
+                    ++nnz;
+            }
+
+            // store the delta densely if that takes less space
+            if (2*nnz >= (unsigned long)psi.size() && psi.size() != 0)
+            {
+                e.val.resize(psi.size());
+                for (long i = 0; i < psi.size(); ++i)
+                    e.val[i] = psi(i) - true_psi(i);
+                return;
+            }
+
+            e.idx.reserve(nnz);
+            e.val.reserve(nnz);
+            for (long i = 0; i < psi.size(); ++i)
+            {
+                if (psi(i) != true_psi(i))
+                {
+                    e.idx.push_back(i);
+                    e.val.push_back(psi(i) - true_psi(i));
+                }
+            }
+        }
+
+        template <typename T>
+        void make_delta (
+            const T& psi,
+            entry& e
+        ) const
+        {
+            // T is a sparse vector so merge psi and -true_psi to get the delta.
+            std::vector<std::pair<unsigned long,scalar_type> > temp;
+            temp.reserve(psi.size() + true_psi.size());
+            for (typename T::const_iterator i = psi.begin(); i != psi.end(); ++i)
+                temp.push_back(std::make_pair(i->first, i->second));
+            for (typename T::const_iterator i = true_psi.begin(); i != true_psi.end(); ++i)
+                temp.push_back(std::make_pair(i->first, -i->second));
+            make_sparse_vector_inplace(temp);
+
+            unsigned long nnz = 0;
+            for (unsigned long i = 0; i < temp.size(); ++i)
+            {
+                if (temp[i].second != 0)
+                    ++nnz;
+            }
+            e.idx.reserve(nnz);
+            e.val.reserve(nnz);
+            for (unsigned long i = 0; i < temp.size(); ++i)
+            {
+                if (temp[i].second != 0)
+                {
+                    e.idx.push_back(temp[i].first);
+                    e.val.push_back(temp[i].second);
+                }
+            }
+        }
+
+        template <typename T, long NR, long NC, typename MM, typename L>
+        void add_delta (
+            const entry& e,
+            matrix<T,NR,NC,MM,L>& out_psi
+        ) const
+        {
+            out_psi = true_psi;
+            if (e.idx.size() == e.val.size())
+            {
+                for (unsigned long i = 0; i < e.idx.size(); ++i)
+                    out_psi(e.idx[i]) += e.val[i];
+            }
+            else
+            {
+                for (unsigned long i = 0; i < e.val.size(); ++i)
+                    out_psi(i) += e.val[i];
+            }
+        }
+
+        template <typename T, typename U, typename alloc>
+        void add_delta (
+            const entry& e,
+            std::vector<std::pair<T,U>,alloc>& out_psi
+        ) const
+        {
+            out_psi.clear();
+            out_psi.reserve(true_psi.size() + e.idx.size());
+            out_psi.assign(true_psi.begin(), true_psi.end());
+            for (unsigned long i = 0; i < e.idx.size(); ++i)
+                out_psi.push_back(std::make_pair(e.idx[i], e.val[i]));
+            make_sparse_vector_inplace(out_psi);
+        }
+
+        template <typename T>
+        void add_delta (
+            const entry& e,
+            T& out_psi
+        ) const
+        {
+            out_psi = true_psi;
+            for (unsigned long i = 0; i < e.idx.size(); ++i)
+                out_psi[e.idx[i]] += e.val[i];
         }
 
-    private:
         // Do nothing if T isn't actually a sparse vector
         template <typename T> void compact_sparse_vector( T& ) const { }
 
@@ -195,10 +458,11 @@ namespace dlib
         long sample_idx;
 
         mutable feature_vector_type true_psi;
-        mutable std::vector<scalar_type> loss;
-        mutable std::vector<feature_vector_type> psi;
-        mutable std::vector<long> lru_count;
+        mutable std::vector<entry> entries;
         mutable double last_true_risk_computed;
+        mutable unsigned long num_hits;
+        mutable unsigned long num_misses;
+        mutable size_t bytes_used;
     };
 
 // ----------------------------------------------------------------------------------------
@@ -219,6 +483,15 @@ namespace dlib
                       oracle. Instead, we will directly call the user supplied separation_oracle().
 
                 - get_max_cache_size() == max_cache_size
+                - get_max_cache_memory() == max_cache_memory
+                - cache_bytes_used == the number of bytes currently used by the cache
+                  elements for storing separation oracle outputs.
+                - eviction_threshold == the value returned by
+                  get_cache_eviction_threshold().  Cache elements drop any entries with a
+                  usefulness below this value.  It is increased whenever the cache runs
+                  out of memory and decreased when there is memory to spare.
+                - cache_pressure == true if some cache element failed to get the memory it
+                  wanted since the last time eviction_threshold was updated.
 
                 - if (cache.size() != 0) then
                     - cache.size() == get_num_samples()
@@ -238,7 +511,12 @@ namespace dlib
             skip_cache(true),
             count_below_eps(0),
             max_cache_size(5),
-            C(1)
+            C(1),
+            max_cache_memory(0),
+            cache_bytes_used(0),
+            eviction_threshold(0),
+            cache_pressure(false),
+            num_cache_evictions(0)
         {}
 
         void set_epsilon (
@@ -269,6 +547,35 @@ namespace dlib
         unsigned long get_max_cache_size (
         ) const { return max_cache_size; }
 
+        void set_max_cache_memory (
+            uint64 num_bytes
+        )
+        {
+            auto_mutex lock(cache_mutex);
+            max_cache_memory = num_bytes;
+        }
+
+        uint64 get_max_cache_memory (
+        ) const 
+        { 
+            auto_mutex lock(cache_mutex);
+            return max_cache_memory; 
+        }
+
+        uint64 get_cache_memory_usage (
+        ) const
+        {
+            auto_mutex lock(cache_mutex);
+            return cache_bytes_used;
+        }
+
+        uint64 get_num_cache_evictions (
+        ) const
+        {
+            auto_mutex lock(cache_mutex);
+            return num_cache_evictions;
+        }
+
         void be_verbose (
         ) 
         {
@@ -327,6 +634,8 @@ namespace dlib
             return true; 
         }
 
+    protected:
+
         virtual bool optimization_status (
             scalar_type current_objective_value,
             scalar_type current_error_gap,
@@ -345,6 +654,21 @@ namespace dlib
                 cout << "risk gap:      " << current_risk_gap << endl;
                 cout << "num planes:    " << num_cutting_planes << endl;
                 cout << "iter:          " << num_iterations << endl;
+                if (max_cache_size != 0 && cache.size() != 0)
+                {
+                    uint64 hits = 0, misses = 0, entries = 0, bytes = 0;
+                    for (unsigned long i = 0; i < cache.size(); ++i)
+                    {
+                        hits += cache[i].get_num_hits();
+                        misses += cache[i].get_num_misses();
+                        entries += cache[i].get_num_entries();
+                        bytes += cache[i].get_memory_usage();
+                    }
+                    cout << "cache hit rate: " << (double)hits/std::max<uint64>(hits+misses,1) << endl;
+                    cout << "cache entries:  " << entries << endl;
+                    cout << "cache memory:   " << bytes << " bytes" << endl;
+                    cout << "cache evictions: " << get_num_cache_evictions() << endl;
+                }
                 cout << endl;
             }
 
@@ -379,6 +703,8 @@ namespace dlib
             return false;
         }
 
+    private:
+
         virtual void get_risk (
             matrix_type& w,
             scalar_type& risk,
@@ -410,6 +736,8 @@ namespace dlib
             scalar_type total_loss = 0;
             call_separation_oracle_on_all_samples(w,subgradient,total_loss);
 
+            update_cache_eviction_threshold();
+
             subgradient /= num;
             total_loss /= num;
             risk = total_loss + dot(subgradient,w);
@@ -446,8 +774,95 @@ namespace dlib
                                                 loss,
                                                 psi);
         }
+
+        void get_oracle_cache_parameters (
+            bool& skip_cache_,
+            scalar_type& current_risk_gap
+        ) const
+        {
+            skip_cache_ = skip_cache;
+            current_risk_gap = saved_current_risk_gap;
+        }
+
+        void separation_oracle_cached (
+            const bool skip_cache_,
+            const scalar_type& current_risk_gap,
+            const long idx,
+            const matrix_type& current_solution,
+            scalar_type& loss,
+            feature_vector_type& psi
+        ) const 
+        {
+            cache[idx].separation_oracle_cached(skip_cache_, 
+                                                current_risk_gap,
+                                                current_solution,
+                                                loss,
+                                                psi);
+        }
     private:
 
+        friend class cache_element_structural_svm<structural_svm_problem>;
+        // The processing nodes keep their own separation oracle caches, so they need to
+        // update the eviction threshold themselves.
+        friend class svm_struct_processing_node;
+
+        float get_cache_eviction_threshold (
+        ) const
+        {
+            auto_mutex lock(cache_mutex);
+            return eviction_threshold;
+        }
+
+        bool reserve_cache_memory (
+            uint64 num_bytes
+        ) const
+        {
+            auto_mutex lock(cache_mutex);
+            if (max_cache_memory != 0 && cache_bytes_used + num_bytes > max_cache_memory)
+            {
+                cache_pressure = true;
+                return false;
+            }
+            cache_bytes_used += num_bytes;
+            return true;
+        }
+
+        void release_cache_memory (
+            uint64 num_bytes
+        ) const
+        {
+            auto_mutex lock(cache_mutex);
+            cache_bytes_used -= num_bytes;
+        }
+
+        void count_cache_evictions (
+            unsigned long num
+        ) const
+        {
+            auto_mutex lock(cache_mutex);
+            num_cache_evictions += num;
+        }
+
+        void update_cache_eviction_threshold (
+        ) const
+        {
+            auto_mutex lock(cache_mutex);
+            if (cache_pressure)
+            {
+                // Each unused entry loses 10% of its usefulness every iteration so
+                // doubling the threshold evicts entries that have gone unused for about 7
+                // fewer iterations.
+                eviction_threshold = std::min(1.0f, std::max(0.01f, 2*eviction_threshold));
+            }
+            else if (cache_bytes_used < 0.9*max_cache_memory)
+            {
+                eviction_threshold /= 2;
+                if (eviction_threshold < 0.01f)
+                    eviction_threshold = 0;
+            }
+            cache_pressure = false;
+        }
+
 
         mutable scalar_type saved_current_risk_gap;
         mutable matrix_type psi_true;
@@ -461,6 +876,13 @@ namespace dlib
         unsigned long max_cache_size;
 
         scalar_type C;
+
+        mutex cache_mutex;
+        uint64 max_cache_memory;
+        mutable uint64 cache_bytes_used;
+        mutable float eviction_threshold;
+        mutable bool cache_pressure;
+        mutable uint64 num_cache_evictions;
     };
 
 // ----------------------------------------------------------------------------------------
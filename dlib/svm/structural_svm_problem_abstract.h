@@ -30,6 +30,7 @@ namespace dlib
             INITIAL VALUE
                 - get_epsilon() == 0.001
                 - get_max_cache_size() == 5
+                - get_max_cache_memory() == 0
                 - get_c() == 1
                 - This object will not be verbose
 
@@ -135,6 +136,54 @@ namespace dlib
                   calls to the user supplied separation_oracle() function.  Note that a 
                   value of 0 means that caching is not used at all.  This is appropriate 
                   if the separation oracle is cheap to evaluate. 
+                - Cached joint feature vectors are stored in single precision as the
+                  difference between them and the sample's true joint feature vector.  So
+                  when psi is mostly the same as the truth very little memory is used.
+                - When the cache for a sample is full the entry which has been least useful
+                  recently (i.e. least often selected as the best cached psi) is replaced.
+        !*/
+
+        void set_max_cache_memory (
+            uint64 num_bytes
+        );
+        /*!
+            ensures
+                - #get_max_cache_memory() == num_bytes
+        !*/
+
+        uint64 get_max_cache_memory (
+        ) const;
+        /*!
+            ensures
+                - Returns the maximum number of bytes the separation oracle cache may use to
+                  store joint feature vectors, summed over all the training samples.  A
+                  value of 0 means there is no limit other than get_max_cache_size().
+                - When this budget is used up, cache entries which haven't been useful
+                  recently are evicted, from any sample, to make room for new ones.  So
+                  the memory goes to the samples where the cache is actually saving calls
+                  to separation_oracle().
+                - If this object is verbose then the cache hit rate and memory usage are
+                  printed at each iteration.
+        !*/
+
+        uint64 get_cache_memory_usage (
+        ) const;
+        /*!
+            ensures
+                - Returns the number of bytes currently used by the separation oracle
+                  cache to store joint feature vectors, summed over all the training
+                  samples.  
+                - if (get_max_cache_memory() != 0) then
+                    - get_cache_memory_usage() <= get_max_cache_memory()
+        !*/
+
+        uint64 get_num_cache_evictions (
+        ) const;
+        /*!
+            ensures
+                - Returns the number of cache entries which have been evicted to stay
+                  within get_max_cache_memory().  This doesn't count entries replaced
+                  because a sample's cache already held get_max_cache_size() entries.
         !*/
 
         void be_verbose (
@@ -13,6 +13,10 @@
 #include "../threads.h"
 #include "../misc_api.h"
 #include "../statistics.h"
+#include "../smart_pointers_thread_safe.h"
+#include <algorithm>
+#include <limits>
+#include <utility>
 
 namespace dlib
 {
@@ -35,14 +39,318 @@ namespace dlib
             unsigned long num_threads
         ) :
             tp(num_threads),
-            num_iterations_executed(0)
+            num_iterations_executed(0),
+            max_staleness(0),
+            async_workers_running(false),
+            async_stop(false),
+            async_s(async_m),
+            force_exact_iteration(false),
+            last_iteration_was_stale(false),
+            async_threshold(0),
+            num_unsatisfied(0),
+            failed_idx(-1),
+            async_loop(*this)
         {}
 
+        ~structural_svm_problem_threaded (
+        )
+        {
+            stop_async_workers();
+        }
+
         unsigned long get_num_threads (
         ) const { return tp.num_threads_in_pool(); }
 
+        void set_max_oracle_staleness (
+            unsigned long max_staleness_
+        )
+        {
+            stop_async_workers();
+            max_staleness = max_staleness_;
+        }
+
+        unsigned long get_max_oracle_staleness (
+        ) const { return max_staleness; }
+
     private:
 
+        struct async_result
+        {
+            async_result() : loss(0), computed_at(-1), in_flight(false), est_time(0), has_time(false) {}
+
+            scalar_type loss;
+            feature_vector_type psi;
+            // the iteration whose weight vector produced loss and psi, or -1 if none has.
+            long computed_at;
+            // true if this sample is queued or currently being processed by a worker.
+            bool in_flight;
+            // exponentially weighted average of the time spent on this sample's oracle.
+            double est_time;
+            bool has_time;
+        };
+
+        struct async_context
+        {
+            matrix_type w;
+            long iteration;
+            bool skip_cache;
+            scalar_type risk_gap;
+        };
+
+        struct async_loop_binder
+        {
+            async_loop_binder(const structural_svm_problem_threaded& self_) : self(self_) {}
+            void run() { self.async_worker_loop(); }
+            const structural_svm_problem_threaded& self;
+        };
+
+        class scoped_unlock
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This object unlocks a mutex, which the caller must hold, for as long
+                    as it exists.  It relocks the mutex when destroyed, even if an
+                    exception is thrown.
+            !*/
+        public:
+            explicit scoped_unlock(const mutex& m_) : m(m_) { m.unlock(); }
+            ~scoped_unlock() { m.lock(); }
+        private:
+            const mutex& m;
+        };
+
+        void async_worker_loop (
+        ) const
+        {
+            scalar_type loss;
+            feature_vector_type psi;
+
+            auto_mutex lock(async_m);
+            while (!async_stop)
+            {
+                if (ready.size() == 0)
+                {
+                    async_s.wait();
+                    continue;
+                }
+
+                // pop the sample we expect to take the longest
+                std::pop_heap(ready.begin(), ready.end());
+                const long idx = ready.back().second;
+                ready.pop_back();
+                shared_ptr_thread_safe<const async_context> ctx = current_ctx;
+
+                bool failed = false;
+                double elapsed = 0;
+                {
+                    scoped_unlock unlock(async_m);
+                    const uint64 start_time = ts.get_timestamp();
+                    // An exception escaping this thread pool task would kill the program,
+                    // so we just note which call failed and let the thread waiting on the
+                    // results deal with it.
+                    try
+                    {
+                        this->separation_oracle_cached(ctx->skip_cache, ctx->risk_gap, idx, ctx->w, loss, psi);
+                    }
+                    catch (...)
+                    {
+                        failed = true;
+                    }
+                    elapsed = ts.get_timestamp() - start_time;
+                }
+
+                async_result& r = results[idx];
+                if (failed)
+                {
+                    r.in_flight = false;
+                    if (failed_idx == -1)
+                    {
+                        failed_idx = idx;
+                        failed_ctx = ctx;
+                    }
+                    async_s.broadcast();
+                    continue;
+                }
+
+                const bool was_satisfied = r.computed_at >= async_threshold;
+                r.loss = loss;
+                r.psi.swap(psi);
+                r.computed_at = ctx->iteration;
+                if (r.has_time)
+                    r.est_time = 0.7*r.est_time + 0.3*elapsed;
+                else
+                    r.est_time = elapsed;
+                r.has_time = true;
+
+                if (r.computed_at >= async_threshold)
+                {
+                    r.in_flight = false;
+                    if (!was_satisfied)
+                        --num_unsatisfied;
+                }
+                else
+                {
+                    // The result is already too stale for the iteration waiting on it so
+                    // run it again against the newest weight vector.
+                    push_ready(idx);
+                }
+                async_s.broadcast();
+            }
+        }
+
+        void push_ready (
+            long idx
+        ) const
+        /*!
+            requires
+                - async_m is locked
+        !*/
+        {
+            // Samples we have never timed go first since they might be slow.
+            const double key = results[idx].has_time ? results[idx].est_time : std::numeric_limits<double>::max();
+            ready.push_back(std::make_pair(key, idx));
+            std::push_heap(ready.begin(), ready.end());
+        }
+
+        void stop_async_workers (
+        ) const
+        {
+            async_m.lock();
+            if (!async_workers_running)
+            {
+                async_m.unlock();
+                return;
+            }
+            async_stop = true;
+            ready.clear();
+            async_s.broadcast();
+            async_m.unlock();
+
+            tp.wait_for_all_tasks();
+
+            auto_mutex lock(async_m);
+            async_stop = false;
+            async_workers_running = false;
+            force_exact_iteration = false;
+            for (unsigned long i = 0; i < results.size(); ++i)
+                results[i].in_flight = false;
+            current_ctx.reset();
+            failed_idx = -1;
+            failed_ctx.reset();
+        }
+
+        virtual bool optimization_status (
+            scalar_type current_objective_value,
+            scalar_type current_error_gap,
+            scalar_type current_risk_value,
+            scalar_type current_risk_gap,
+            unsigned long num_cutting_planes,
+            unsigned long num_iterations
+        ) const 
+        {
+            const bool done = base::optimization_status(current_objective_value, current_error_gap,
+                                                        current_risk_value, current_risk_gap,
+                                                        num_cutting_planes, num_iterations);
+            if (!async_workers_running)
+                return done;
+
+            // Stale cutting planes are still valid lower bounds on the risk but the risk
+            // value computed from them isn't exact.  So we only accept convergence on an
+            // iteration where every oracle call used the current weight vector.
+            if (done && last_iteration_was_stale)
+            {
+                force_exact_iteration = true;
+                return false;
+            }
+
+            force_exact_iteration = false;
+            if (done)
+                stop_async_workers();
+            return done;
+        }
+
+        void call_separation_oracle_async (
+            const matrix_type& w,
+            matrix_type& subgradient,
+            scalar_type& total_loss
+        ) const
+        {
+            const long num = this->get_num_samples();
+
+            shared_ptr_thread_safe<async_context> ctx(new async_context);
+            ctx->w = w;
+            ctx->iteration = num_iterations_executed;
+            this->get_oracle_cache_parameters(ctx->skip_cache, ctx->risk_gap);
+
+            const long staleness = force_exact_iteration ? 0 : max_staleness;
+
+            while (true)
+            {
+                long idx;
+                shared_ptr_thread_safe<const async_context> fctx;
+                {
+                    auto_mutex lock(async_m);
+                    if (!async_workers_running)
+                    {
+                        results.resize(num);
+                        async_workers_running = true;
+                        for (unsigned long i = 0; i < tp.num_threads_in_pool(); ++i)
+                            tp.add_task(async_loop, &async_loop_binder::run);
+                    }
+
+                    current_ctx = ctx;
+                    // Iterations are numbered starting at 1 so a threshold of at least 1
+                    // also makes us wait for samples which have never been evaluated.
+                    async_threshold = std::max(1L, ctx->iteration - staleness);
+                    num_unsatisfied = 0;
+                    for (long i = 0; i < num; ++i)
+                    {
+                        if (results[i].computed_at < async_threshold)
+                            ++num_unsatisfied;
+                        if (!results[i].in_flight)
+                        {
+                            results[i].in_flight = true;
+                            push_ready(i);
+                        }
+                    }
+                    async_s.broadcast();
+
+                    while (num_unsatisfied != 0 && failed_idx == -1)
+                        async_s.wait();
+
+                    if (failed_idx == -1)
+                    {
+                        last_iteration_was_stale = false;
+                        for (long i = 0; i < num; ++i)
+                        {
+                            total_loss += results[i].loss;
+                            add_to(subgradient, results[i].psi);
+                            if (results[i].computed_at != ctx->iteration)
+                                last_iteration_was_stale = true;
+                        }
+                        return;
+                    }
+
+                    idx = failed_idx;
+                    fctx = failed_ctx;
+                }
+
+                // A worker's oracle call threw.  We can't move an exception between
+                // threads, so we repeat the call here, which lets the exception reach our
+                // caller with its original type.  
+                stop_async_workers();
+                scalar_type loss;
+                feature_vector_type psi;
+                this->separation_oracle_cached(fctx->skip_cache, fctx->risk_gap, idx, fctx->w, loss, psi);
+
+                // The call worked this time so keep its result and carry on.
+                auto_mutex lock(async_m);
+                results[idx].loss = loss;
+                results[idx].psi.swap(psi);
+                results[idx].computed_at = fctx->iteration;
+            }
+        }
+
         struct binder
         {
             binder (
@@ -117,6 +425,13 @@ namespace dlib
         {
             ++num_iterations_executed;
 
+            if (max_staleness != 0 && tp.num_threads_in_pool() != 0)
+            {
+                call_separation_oracle_async(w, subgradient, total_loss);
+                return;
+            }
+            stop_async_workers();
+
             const uint64 start_time = ts.get_timestamp();
 
             bool buffer_subgradients_locally = with_buffer_time.mean() < without_buffer_time.mean();
@@ -146,6 +461,25 @@ namespace dlib
         mutable running_stats<double> with_buffer_time;
         mutable running_stats<double> without_buffer_time;
         mutable unsigned long num_iterations_executed;
+
+        typedef structural_svm_problem<matrix_type_,feature_vector_type_> base;
+
+        unsigned long max_staleness;
+        mutable bool async_workers_running;
+        mutable bool async_stop;
+        mutable mutex async_m;
+        mutable signaler async_s;
+        mutable bool force_exact_iteration;
+        mutable bool last_iteration_was_stale;
+        mutable long async_threshold;
+        mutable long num_unsatisfied;
+        // the index and context of the first oracle call which threw, or -1 if none has.
+        mutable long failed_idx;
+        mutable shared_ptr_thread_safe<const async_context> failed_ctx;
+        mutable std::vector<async_result> results;
+        mutable std::vector<std::pair<double,long> > ready;
+        mutable shared_ptr_thread_safe<const async_context> current_ctx;
+        mutable async_loop_binder async_loop;
     };
 
 // ----------------------------------------------------------------------------------------
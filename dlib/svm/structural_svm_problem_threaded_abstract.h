@@ -56,6 +56,47 @@ namespace dlib
                   calls to the separation_oracle() function.
         !*/
 
+        void set_max_oracle_staleness (
+            unsigned long max_staleness
+        );
+        /*!
+            ensures
+                - #get_max_oracle_staleness() == max_staleness
+        !*/
+
+        unsigned long get_max_oracle_staleness (
+        ) const;
+        /*!
+            ensures
+                - Returns the maximum number of solver iterations by which the separation
+                  oracle results used to build a cutting plane may lag behind the current
+                  weight vector.  
+                - If get_max_oracle_staleness() == 0 then every iteration calls the
+                  separation oracle on all samples with the current weight vector and
+                  waits for all the calls to finish.  This is the default.
+                - If get_max_oracle_staleness() > 0 and get_num_threads() > 0 then the
+                  separation oracle is evaluated asynchronously.  That is, each iteration
+                  queues oracle calls for every sample not already being processed and
+                  then only waits until every sample has a result computed from a weight
+                  vector at most get_max_oracle_staleness() iterations old.  The
+                  remaining calls keep running while the solver works on the cutting
+                  plane subproblem.  Stale results still produce valid cutting planes, so
+                  this lets slow samples overlap with the solver rather than stalling
+                  every thread at the end of each iteration.  Convergence is only
+                  accepted on an iteration where every result was computed from the
+                  current weight vector.  However, since the solver sees different
+                  cutting planes along the way, the solution it finds is not necessarily
+                  the same as the one found in the synchronous mode.
+                - If a separation oracle call made by a worker thread throws then the
+                  asynchronous calls are stopped and the call is repeated in the thread
+                  running the solver.  This way the exception is thrown from the solver
+                  with its original type.
+                - In the asynchronous mode, queued oracle calls are dispatched
+                  longest-first, based on a running estimate of how long each sample's
+                  separation oracle takes to run.  Also note that the most recent psi
+                  vector for each sample is kept in memory.
+        !*/
+
     };
 
 // ----------------------------------------------------------------------------------------
@@ -17,7 +17,10 @@
 #include <vector>
 #include "../smart_pointers.h"
 #include "../pipe.h"
+#include "svm_c_linear_dcd_trainer.h"
 #include <iostream>
+#include <algorithm>
+#include <string>
 
 namespace dlib
 {
@@ -72,6 +75,100 @@ namespace dlib
                 }
             }
         };
+
+        template <
+            typename in_sample_vector_type,
+            typename in_scalar_vector_type,
+            typename sample_vector_type,
+            typename scalar_vector_type
+            >
+        void load_fold (
+            const in_sample_vector_type& x,
+            const in_scalar_vector_type& y,
+            const long num_pos,
+            const long num_neg,
+            const long folds,
+            long& pos_idx,
+            long& neg_idx,
+            sample_vector_type& x_test,
+            scalar_vector_type& y_test,
+            sample_vector_type& x_train,
+            scalar_vector_type& y_train
+        )
+        /*!
+            ensures
+                - loads the next fold of a stratified cross validation into x_test, 
+                  y_test, x_train, and y_train.  The test samples start at pos_idx and
+                  neg_idx and these indices are advanced past them.
+        !*/
+        {
+            // figure out how many positive and negative examples we will have in each fold
+            const long num_pos_test_samples = num_pos/folds; 
+            const long num_pos_train_samples = num_pos - num_pos_test_samples; 
+            const long num_neg_test_samples = num_neg/folds; 
+            const long num_neg_train_samples = num_neg - num_neg_test_samples; 
+
+            x_test.set_size (num_pos_test_samples  + num_neg_test_samples);
+            y_test.set_size (num_pos_test_samples  + num_neg_test_samples);
+            x_train.set_size(num_pos_train_samples + num_neg_train_samples);
+            y_train.set_size(num_pos_train_samples + num_neg_train_samples);
+
+            long cur = 0;
+
+            // load up our positive test samples
+            while (cur < num_pos_test_samples)
+            {
+                if (y(pos_idx) == +1.0)
+                {
+                    x_test(cur) = x(pos_idx);
+                    y_test(cur) = +1.0;
+                    ++cur;
+                }
+                pos_idx = (pos_idx+1)%x.nr();
+            }
+
+            // load up our negative test samples
+            while (cur < x_test.nr())
+            {
+                if (y(neg_idx) == -1.0)
+                {
+                    x_test(cur) = x(neg_idx);
+                    y_test(cur) = -1.0;
+                    ++cur;
+                }
+                neg_idx = (neg_idx+1)%x.nr();
+            }
+
+            // load the training data from the data following whatever we loaded
+            // as the testing data
+            long train_pos_idx = pos_idx;
+            long train_neg_idx = neg_idx;
+            cur = 0;
+
+            // load up our positive train samples
+            while (cur < num_pos_train_samples)
+            {
+                if (y(train_pos_idx) == +1.0)
+                {
+                    x_train(cur) = x(train_pos_idx);
+                    y_train(cur) = +1.0;
+                    ++cur;
+                }
+                train_pos_idx = (train_pos_idx+1)%x.nr();
+            }
+
+            // load up our negative train samples
+            while (cur < x_train.nr())
+            {
+                if (y(train_neg_idx) == -1.0)
+                {
+                    x_train(cur) = x(train_neg_idx);
+                    y_train(cur) = -1.0;
+                    ++cur;
+                }
+                train_neg_idx = (train_neg_idx+1)%x.nr();
+            }
+        }
     }
 
     template <
@@ -123,13 +220,6 @@ namespace dlib
                 ++num_neg;
         }
 
-        // figure out how many positive and negative examples we will have in each fold
-        const long num_pos_test_samples = num_pos/folds; 
-        const long num_pos_train_samples = num_pos - num_pos_test_samples; 
-        const long num_neg_test_samples = num_neg/folds; 
-        const long num_neg_train_samples = num_neg - num_neg_test_samples; 
-
-
         long pos_idx = 0;
         long neg_idx = 0;
 
@@ -143,67 +233,8 @@ namespace dlib
         {
             job<trainer_type>& j = jobs[i].get();
 
-            j.x_test.set_size (num_pos_test_samples  + num_neg_test_samples);
-            j.y_test.set_size (num_pos_test_samples  + num_neg_test_samples);
-            j.x_train.set_size(num_pos_train_samples + num_neg_train_samples);
-            j.y_train.set_size(num_pos_train_samples + num_neg_train_samples);
             j.trainer = trainer;
-
-            long cur = 0;
-
-            // load up our positive test samples
-            while (cur < num_pos_test_samples)
-            {
-                if (y(pos_idx) == +1.0)
-                {
-                    j.x_test(cur) = x(pos_idx);
-                    j.y_test(cur) = +1.0;
-                    ++cur;
-                }
-                pos_idx = (pos_idx+1)%x.nr();
-            }
-
-            // load up our negative test samples
-            while (cur < j.x_test.nr())
-            {
-                if (y(neg_idx) == -1.0)
-                {
-                    j.x_test(cur) = x(neg_idx);
-                    j.y_test(cur) = -1.0;
-                    ++cur;
-                }
-                neg_idx = (neg_idx+1)%x.nr();
-            }
-
-            // load the training data from the data following whatever we loaded
-            // as the testing data
-            long train_pos_idx = pos_idx;
-            long train_neg_idx = neg_idx;
-            cur = 0;
-
-            // load up our positive train samples
-            while (cur < num_pos_train_samples)
-            {
-                if (y(train_pos_idx) == +1.0)
-                {
-                    j.x_train(cur) = x(train_pos_idx);
-                    j.y_train(cur) = +1.0;
-                    ++cur;
-                }
-                train_pos_idx = (train_pos_idx+1)%x.nr();
-            }
-
-            // load up our negative train samples
-            while (cur < j.x_train.nr())
-            {
-                if (y(train_neg_idx) == -1.0)
-                {
-                    j.x_train(cur) = x(train_neg_idx);
-                    j.y_train(cur) = -1.0;
-                    ++cur;
-                }
-                train_neg_idx = (train_neg_idx+1)%x.nr();
-            }
+            load_fold(x, y, num_pos, num_neg, folds, pos_idx, neg_idx, j.x_test, j.y_test, j.x_train, j.y_train);
 
             // finally spawn a task to process this job
             tp.add_task(mytask, jobs[i], results[i]);
@@ -245,6 +276,314 @@ namespace dlib
 
 // ----------------------------------------------------------------------------------------
 
+    namespace cvps_helpers
+    {
+        template <typename trainer_type>
+        struct warm_start
+        {
+            /*!
+                This is the default case, used for trainers that can't be warm started.
+            !*/
+            const static bool value = false;
+            struct state_type {};
+
+            template <typename T, typename U>
+            static matrix<double,1,2> train_and_test (
+                const trainer_type& trainer,
+                const T& x_train,
+                const U& y_train,
+                state_type& ,
+                const T& x_test,
+                const U& y_test
+            ) 
+            {
+                return matrix_cast<double>(test_binary_decision_function(trainer.train(x_train, y_train), x_test, y_test));
+            }
+        };
+
+        template <typename K>
+        struct warm_start<svm_c_linear_dcd_trainer<K> >
+        {
+            /*!
+                The dcd trainer can continue from the solution for a smaller C since the
+                old dual variables are still feasible.
+            !*/
+            const static bool value = true;
+            typedef typename svm_c_linear_dcd_trainer<K>::optimizer_state state_type;
+
+            template <typename T, typename U>
+            static matrix<double,1,2> train_and_test (
+                const svm_c_linear_dcd_trainer<K>& trainer,
+                const T& x_train,
+                const U& y_train,
+                state_type& state,
+                const T& x_test,
+                const U& y_test
+            ) 
+            {
+                return matrix_cast<double>(test_binary_decision_function(trainer.train(x_train, y_train, state), x_test, y_test));
+            }
+        };
+
+        template <
+            typename trainer_type,
+            typename param_setter,
+            typename sample_vector_type,
+            typename scalar_vector_type
+            >
+        struct search_job
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is one unit of work for cross_validate_parameter_search_threaded().
+                    It trains and tests, on a single fold, each of the parameter settings
+                    in cols.  They are done in order so each one can be warm started from
+                    the one before it.
+            !*/
+
+            const trainer_type* trainer;
+            const param_setter* set_params;
+            const matrix<double>* params;
+            std::vector<long> cols;
+            long fold;
+            const sample_vector_type* x_test;
+            const scalar_vector_type* y_test;
+            const sample_vector_type* x_train;
+            const scalar_vector_type* y_train;
+            // results[cols[i]](fold) is where the result for cols[i] goes.
+            std::vector<matrix<double,0,2> >* results;
+            std::string error;
+
+            void run (
+            )
+            {
+                typedef warm_start<trainer_type> ws;
+                typename ws::state_type state;
+                trainer_type trainer_copy(*trainer);
+                for (unsigned long i = 0; i < cols.size(); ++i)
+                {
+                    matrix<double,0,2>& res = (*results)[cols[i]];
+                    try
+                    {
+                        const matrix<double,0,1> p = colm(*params, cols[i]);
+                        (*set_params)(trainer_copy, p);
+                        set_rowm(res, fold) = ws::train_and_test(trainer_copy, *x_train, *y_train, state, *x_test, *y_test);
+                    }
+                    catch (invalid_nu_error&)
+                    {
+                        // Just like in cross_validate_trainer_threaded(), an invalid nu
+                        // value gets a score of 0.
+                        set_rowm(res, fold) = 0;
+                    }
+                    catch (std::exception& e)
+                    {
+                        error = e.what();
+                        return;
+                    }
+                }
+            }
+        };
+
+        inline bool differ_only_in_last_row_and_increase (
+            const matrix<double>& params,
+            long a,
+            long b
+        )
+        {
+            const long last = params.nr()-1;
+            for (long r = 0; r < last; ++r)
+            {
+                if (params(r,a) != params(r,b))
+                    return false;
+            }
+            return params(last,a) <= params(last,b);
+        }
+    }
+
+    template <
+        typename trainer_type,
+        typename param_setter,
+        typename in_sample_vector_type,
+        typename in_scalar_vector_type
+        >
+    const matrix<double> cross_validate_parameter_search_threaded_impl (
+        const trainer_type& trainer,
+        const param_setter& set_params,
+        const matrix<double>& params,
+        const in_sample_vector_type& x,
+        const in_scalar_vector_type& y,
+        const long folds,
+        const long num_threads,
+        const double keep_fraction
+    )
+    {
+        using namespace dlib::cvps_helpers;
+        typedef typename trainer_type::scalar_type scalar_type;
+        typedef typename trainer_type::sample_type sample_type;
+        typedef typename trainer_type::mem_manager_type mem_manager_type;
+        typedef matrix<sample_type,0,1,mem_manager_type> sample_vector_type;
+        typedef matrix<scalar_type,0,1,mem_manager_type> scalar_vector_type;
+        typedef search_job<trainer_type,param_setter,sample_vector_type,scalar_vector_type> job_type;
+
+        // make sure requires clause is not broken
+        DLIB_ASSERT(is_binary_classification_problem(x,y) == true &&
+                    1 < folds && folds <= x.nr() &&
+                    num_threads > 0 && params.size() > 0 &&
+                    0 < keep_fraction && keep_fraction <= 1,
+            "\tmatrix cross_validate_parameter_search_threaded()"
+            << "\n\t invalid inputs were given to this function"
+            << "\n\t x.nr(): " << x.nr() 
+            << "\n\t folds:  " << folds 
+            << "\n\t num_threads:  " << num_threads 
+            << "\n\t params.size(): " << params.size() 
+            << "\n\t keep_fraction: " << keep_fraction 
+            << "\n\t is_binary_classification_problem(x,y): " << ((is_binary_classification_problem(x,y))? "true":"false")
+            );
+
+        // count the number of positive and negative examples
+        long num_pos = 0;
+        long num_neg = 0;
+        for (long r = 0; r < y.nr(); ++r)
+        {
+            if (y(r) == +1.0)
+                ++num_pos;
+            else
+                ++num_neg;
+        }
+
+        // Split the data into folds just once.  Every parameter setting uses the same
+        // folds so there is no reason to make a copy of the data for each job.
+        std::vector<sample_vector_type> x_test(folds), x_train(folds);
+        std::vector<scalar_vector_type> y_test(folds), y_train(folds);
+        long pos_idx = 0;
+        long neg_idx = 0;
+        for (long i = 0; i < folds; ++i)
+            cvtti_helpers::load_fold(x, y, num_pos, num_neg, folds, pos_idx, neg_idx, x_test[i], y_test[i], x_train[i], y_train[i]);
+
+        std::vector<matrix<double,0,2> > results(params.nc());
+        for (unsigned long i = 0; i < results.size(); ++i)
+        {
+            results[i].set_size(folds,2);
+            results[i] = 0;
+        }
+
+        std::vector<long> num_folds_done(params.nc(), 0);
+        std::vector<long> alive(params.nc());
+        for (unsigned long i = 0; i < alive.size(); ++i)
+            alive[i] = i;
+
+        thread_pool tp(num_threads);
+
+        // We do successive halving.  Each round evaluates the surviving parameter
+        // settings on some more folds, doubling the number of folds done so far, and then
+        // throws away all but the best keep_fraction of them.  If we aren't throwing
+        // anything away then just do all the folds in one round.
+        long folds_done = 0;
+        long round_end = (keep_fraction < 1) ? 1 : folds;
+        while (true)
+        {
+            // Group the surviving columns into chains where each can be warm started from
+            // the previous one.
+            std::vector<std::vector<long> > chains;
+            for (unsigned long i = 0; i < alive.size(); ++i)
+            {
+                if (warm_start<trainer_type>::value && chains.size() != 0 &&
+                    differ_only_in_last_row_and_increase(params, chains.back().back(), alive[i]))
+                {
+                    chains.back().push_back(alive[i]);
+                }
+                else
+                {
+                    chains.push_back(std::vector<long>(1, alive[i]));
+                }
+            }
+
+            std::vector<job_type> jobs(chains.size()*(round_end-folds_done));
+            for (unsigned long c = 0, j = 0; c < chains.size(); ++c)
+            {
+                for (long f = folds_done; f < round_end; ++f, ++j)
+                {
+                    jobs[j].trainer = &trainer;
+                    jobs[j].set_params = &set_params;
+                    jobs[j].params = &params;
+                    jobs[j].cols = chains[c];
+                    jobs[j].fold = f;
+                    jobs[j].x_test = &x_test[f];
+                    jobs[j].y_test = &y_test[f];
+                    jobs[j].x_train = &x_train[f];
+                    jobs[j].y_train = &y_train[f];
+                    jobs[j].results = &results;
+                }
+            }
+            for (unsigned long j = 0; j < jobs.size(); ++j)
+                tp.add_task(jobs[j], &job_type::run);
+            tp.wait_for_all_tasks();
+
+            for (unsigned long j = 0; j < jobs.size(); ++j)
+            {
+                if (jobs[j].error.size() != 0)
+                    throw dlib::error("An exception was thrown by trainer.train() in cross_validate_parameter_search_threaded(): " + jobs[j].error);
+            }
+
+            folds_done = round_end;
+            for (unsigned long i = 0; i < alive.size(); ++i)
+                num_folds_done[alive[i]] = folds_done;
+            if (folds_done == folds)
+                break;
+
+            // Now keep only the most promising parameter settings.
+            std::vector<std::pair<double,long> > scores(alive.size());
+            for (unsigned long i = 0; i < alive.size(); ++i)
+                scores[i] = std::make_pair(-sum(rowm(results[alive[i]], range(0,folds_done-1))), alive[i]);
+            std::stable_sort(scores.begin(), scores.end());
+            const unsigned long num_keep = std::max<unsigned long>(1, static_cast<unsigned long>(std::ceil(keep_fraction*alive.size())));
+            alive.clear();
+            for (unsigned long i = 0; i < num_keep && i < scores.size(); ++i)
+                alive.push_back(scores[i].second);
+            // keep the columns in their original order so the warm start chains still work.
+            std::sort(alive.begin(), alive.end());
+
+            round_end = std::min(folds, 2*round_end);
+        }
+
+        // Now build the score table.
+        matrix<double> table(params.nc(), 3);
+        for (long col = 0; col < params.nc(); ++col)
+        {
+            const long n = num_folds_done[col];
+            set_rowm(table,col) = join_rows(sum_rows(rowm(results[col], range(0,n-1)))/n, uniform_matrix<double>(1,1,n));
+        }
+
+        return table;
+    }
+
+    template <
+        typename trainer_type,
+        typename param_setter,
+        typename in_sample_vector_type,
+        typename in_scalar_vector_type
+        >
+    const matrix<double> cross_validate_parameter_search_threaded (
+        const trainer_type& trainer,
+        const param_setter& set_params,
+        const matrix<double>& params,
+        const in_sample_vector_type& x,
+        const in_scalar_vector_type& y,
+        const long folds,
+        const long num_threads,
+        const double keep_fraction = 1
+    )
+    {
+        return cross_validate_parameter_search_threaded_impl(trainer,
+                                                             set_params,
+                                                             params,
+                                                             mat(x),
+                                                             mat(y),
+                                                             folds,
+                                                             num_threads,
+                                                             keep_fraction);
+    }
+
 }
 
 #endif // DLIB_SVm_THREADED_
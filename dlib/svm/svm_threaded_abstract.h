@@ -48,6 +48,82 @@ namespace dlib
             - std::bad_alloc
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename trainer_type,
+        typename param_setter,
+        typename in_sample_vector_type,
+        typename in_scalar_vector_type
+        >
+    const matrix<double> cross_validate_parameter_search_threaded (
+        const trainer_type& trainer,
+        const param_setter& set_params,
+        const matrix<double>& params,
+        const in_sample_vector_type& x,
+        const in_scalar_vector_type& y,
+        const long folds,
+        const long num_threads,
+        const double keep_fraction = 1
+    );
+    /*!
+        requires
+            - is_binary_classification_problem(x,y) == true
+            - 1 < folds <= x.nr()
+            - trainer_type == some kind of trainer object (e.g. svm_nu_trainer)
+            - num_threads > 0
+            - params.size() > 0
+            - 0 < keep_fraction <= 1
+            - set_params == a function object with this signature:
+                void set_params(trainer_type& trainer, const matrix<double,0,1>& p)
+              It configures trainer according to the parameter vector p.  For example,
+              it might do: trainer.set_kernel(kernel_type(p(0))); trainer.set_c(p(1));
+        ensures
+            - Each column of params is a parameter setting.  For each of them, this
+              function makes a copy of trainer, calls set_params(copy, colm(params,i)),
+              and evaluates it with k-fold cross validation just like
+              cross_validate_trainer_threaded().  A grid of settings can be made with
+              cartesian_product() while a random search just uses randomly generated
+              columns.
+            - The (parameter setting, fold) pairs are all scheduled on a single pool of
+              num_threads threads and the folds are only split up once, so a whole
+              parameter sweep runs in parallel rather than just the folds of one
+              setting.
+            - returns a matrix R such that:
+                - R.nr() == params.nc()
+                - R.nc() == 3
+                - R(i,0) and R(i,1) are the average fraction of +1 and -1 examples
+                  correctly classified by the i-th parameter setting, over the folds it
+                  was tested on.
+                - R(i,2) == the number of folds the i-th parameter setting was tested
+                  on.
+            - if (keep_fraction == 1) then
+                - every setting is tested on every fold.  That is, R(i,2) == folds for
+                  all i and the first two columns of R are what
+                  cross_validate_trainer_threaded() would report for each setting.
+            - else
+                - This function performs successive halving.  That is, every setting is
+                  first tested on 1 fold.  Then only the best keep_fraction of them, as
+                  measured by R(i,0)+R(i,1), are tested on more folds until 2 have been
+                  done, then the best keep_fraction of those go on to 4 folds, and so on
+                  until the survivors are tested on all the folds.  So unpromising
+                  settings are abandoned early and R(i,2) may be less than folds for
+                  them.  At least one setting is always tested on all the folds.
+            - If trainer_type is a svm_c_linear_dcd_trainer then consecutive columns of
+              params that differ only in their last element, and where that element
+              doesn't decrease, are trained one after another on each fold with each
+              one warm started from the previous solution.  So if you put C in the last
+              row of params, in increasing order, the path of C values on each fold
+              costs little more than training with the largest C.  Note that
+              cartesian_product() puts the values from its last argument in this
+              order.
+        throws
+            - dlib::error
+              This is thrown if trainer.train() throws an exception.  The message
+              includes the message from the original exception.
+            - std::bad_alloc
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
 }
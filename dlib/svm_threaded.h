@@ -5,6 +5,9 @@
 
 #include "svm.h"
 #include "svm/svm_threaded.h"
+#include "svm/kernel_matrix_threaded.h"
+#include "svm/kmeans_threaded.h"
+#include "svm/kernel_approximation.h"
 #include "svm/structural_svm_problem_threaded.h"
 #include "svm/structural_svm_distributed.h"
 #include "svm/structural_svm_object_detection_problem.h"
@@ -7,6 +7,7 @@
 #include <ctime>
 #include <dlib/bridge.h>
 #include <dlib/type_safe_union.h>
+#include <dlib/string.h>
 
 #include "tester.h"
 
@@ -220,6 +221,75 @@ namespace
         dlib::sleep(100);
     }
 
+    void do_test7(
+        bool use_compression,
+        unsigned long window
+    )
+    {
+        bridge_options opts;
+        opts.batched_framing = true;
+        opts.max_batch_size = 1000;
+        opts.max_batch_delay = 5;
+        if (use_compression)
+            opts.compression_threshold = 100;
+        opts.flow_control_window = window;
+
+        dlib::pipe<std::string> in(10), out(10), echo_pipe(10);
+
+        bridge b2(listen_on_port(testing_port), transmit(out), receive(in), opts);
+        bridge echo(connect_to_ip_and_port("127.0.0.1",testing_port), receive(echo_pipe), transmit(echo_pipe), opts);
+
+        const int num = 2000;
+        // Run a producer on this thread and check the echoed messages come back in order.
+        // The messages are highly compressible so any batches over the threshold should
+        // get compressed.
+        int num_received = 0;
+        for (int i = 0; i < num; ++i)
+        {
+            std::string val = cast_to_string(i) + std::string(i%50, 'x');
+            out.enqueue(val);
+            while (in.dequeue_or_timeout(val,0))
+            {
+                DLIB_TEST(val == cast_to_string(num_received) + std::string(num_received%50, 'x'));
+                ++num_received;
+            }
+        }
+        std::string val;
+        while (num_received < num && in.dequeue(val))
+        {
+            DLIB_TEST(val == cast_to_string(num_received) + std::string(num_received%50, 'x'));
+            ++num_received;
+        }
+        DLIB_TEST(num_received == num);
+
+        bridge_stats stats = b2.get_bridge_stats();
+        dlog << LINFO << "messages_sent: " << stats.messages_sent;
+        dlog << LINFO << "batches_sent:  " << stats.batches_sent;
+        dlog << LINFO << "bytes_sent:    " << stats.bytes_sent;
+        dlog << LINFO << "uncompressed_bytes_sent: " << stats.uncompressed_bytes_sent;
+        DLIB_TEST(stats.messages_sent == num);
+        DLIB_TEST(stats.messages_received == num);
+        // The producer enqueues messages far faster than max_batch_delay so the bridge
+        // must have put more than one message into at least some of the batches.
+        DLIB_TEST(stats.batches_sent > 0 && stats.batches_sent < stats.messages_sent);
+        DLIB_TEST(stats.batches_received > 0);
+        if (use_compression)
+        {
+            DLIB_TEST(stats.bytes_sent < stats.uncompressed_bytes_sent);
+        }
+        else
+        {
+            DLIB_TEST(stats.bytes_sent == stats.uncompressed_bytes_sent);
+        }
+        if (window != 0)
+        {
+            DLIB_TEST(stats.available_credits <= window);
+        }
+
+        DLIB_TEST(echo.get_bridge_stats().messages_received == num);
+        DLIB_TEST(bridge().get_bridge_stats().messages_sent == 0);
+    }
+
     class test_bridge : public tester
     {
     public:
@@ -248,6 +318,14 @@ namespace
             do_test5_5(1);
             print_spinner();
             do_test6();
+            print_spinner();
+            do_test7(false, 0);
+            print_spinner();
+            do_test7(true, 0);
+            print_spinner();
+            do_test7(true, 2);
+            print_spinner();
+            do_test7(false, 1);
         }
     } a;
 
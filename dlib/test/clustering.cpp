@@ -2,6 +2,7 @@
 // License: Boost Software License   See LICENSE.txt for the full license.
 
 #include <dlib/clustering.h>
+#include <map>
 
 #include "tester.h"
 
@@ -59,6 +60,57 @@ namespace
 
     }
 
+    void make_sparse_test_graph(
+        dlib::rand& rnd,
+        std::vector<sample_pair>& edges,
+        std::vector<unsigned long>& labels,
+        const int groups,
+        const int group_size,
+        const int links_per_node
+    )
+    /*!
+        ensures
+            - #labels == the group of each of the groups*group_size nodes.
+            - #edges == a graph where each node is linked to links_per_node random other
+              nodes in its own group.  There are no edges between groups.  Unlike the
+              graphs made by make_test_graph() these are big enough that the threaded
+              clustering routines really hand their work to a thread pool.
+    !*/
+    {
+        labels.resize(groups*group_size);
+        for (unsigned long i = 0; i < labels.size(); ++i)
+            labels[i] = i/group_size;
+
+        edges.clear();
+        for (unsigned long i = 0; i < labels.size(); ++i)
+        {
+            for (int k = 0; k < links_per_node; ++k)
+            {
+                const unsigned long j = labels[i]*group_size + rnd.get_random_32bit_number()%group_size;
+                if (i != j)
+                    edges.push_back(sample_pair(i, j, 1));
+            }
+        }
+    }
+
+    void check_clusters_inside_groups (
+        const std::vector<unsigned long>& groups,
+        const std::vector<unsigned long>& labels
+    )
+    /*!
+        ensures
+            - tests that no cluster in labels contains nodes from two different groups.
+    !*/
+    {
+        std::map<unsigned long, unsigned long> group_of_cluster;
+        for (unsigned long i = 0; i < labels.size(); ++i)
+        {
+            if (group_of_cluster.count(labels[i]) == 0)
+                group_of_cluster[labels[i]] = groups[i];
+            DLIB_TEST(group_of_cluster[labels[i]] == groups[i]);
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
 
     void make_modularity_matrices (
@@ -220,6 +272,120 @@ namespace
         }
     }
 
+    void check_same_partition (
+        const std::vector<unsigned long>& labels,
+        const std::vector<unsigned long>& labels2
+    )
+    {
+        DLIB_TEST(labels.size() == labels2.size());
+        for (unsigned long i = 0; i < labels.size(); ++i)
+        {
+            for (unsigned long j = 0; j < labels.size(); ++j)
+            {
+                if (labels[i] == labels[j])
+                {
+                    DLIB_TEST(labels2[i] == labels2[j]);
+                }
+                else
+                {
+                    DLIB_TEST(labels2[i] != labels2[j]);
+                }
+            }
+        }
+    }
+
+    void test_chinese_whispers_threaded(dlib::rand& rnd)
+    {
+        print_spinner();
+        std::vector<sample_pair> edges;
+        std::vector<unsigned long> labels;
+
+        make_test_graph(rnd, edges, labels, 5, 30, 3, 0.10);
+        if (rnd.get_random_double() < 0.5)
+            remove_duplicate_edges(edges);
+
+        const chinese_whispers_mode modes[] = {chinese_whispers_asynchronous, chinese_whispers_synchronous};
+        for (int m = 0; m < 2; ++m)
+        {
+            std::vector<unsigned long> labels2, labels3;
+            DLIB_TEST(chinese_whispers_threaded(edges, labels2, 200, 1, modes[m]) == 5);
+            check_same_partition(labels, labels2);
+
+            // The results don't depend on the number of threads.
+            DLIB_TEST(chinese_whispers_threaded(edges, labels3, 200, 4, modes[m]) == 5);
+            DLIB_TEST(labels2 == labels3);
+        }
+
+        // That graph is too small for the work to be given to the thread pool, so do the
+        // same check on one which is big enough.
+        std::vector<unsigned long> groups;
+        make_sparse_test_graph(rnd, edges, groups, 500, 20, 4);
+        for (int m = 0; m < 2; ++m)
+        {
+            std::vector<unsigned long> labels2, labels3;
+            const unsigned long num_clusters = chinese_whispers_threaded(edges, labels2, 100, 1, modes[m]);
+            DLIB_TEST(chinese_whispers_threaded(edges, labels3, 100, 4, modes[m]) == num_clusters);
+            DLIB_TEST(labels2 == labels3);
+            DLIB_TEST(num_clusters >= 500);
+            check_clusters_inside_groups(groups, labels2);
+        }
+    }
+
+    void test_louvain_cluster(dlib::rand& rnd)
+    {
+        print_spinner();
+        std::vector<sample_pair> edges;
+        std::vector<unsigned long> labels;
+
+        make_test_graph(rnd, edges, labels, 5, 30, 3, 0.10);
+        if (rnd.get_random_double() < 0.5)
+            remove_duplicate_edges(edges);
+
+        std::vector<unsigned long> labels2, labels3;
+        DLIB_TEST(louvain_cluster(edges, labels2) == 5);
+        check_same_partition(labels, labels2);
+
+        // The results don't depend on the number of threads.
+        DLIB_TEST(louvain_cluster(edges, labels3, 4) == 5);
+        DLIB_TEST(labels2 == labels3);
+
+        // The graphs above are too small for louvain_cluster() to bother using its
+        // thread pool.  So check that the threaded node moving on a big sparse graph also
+        // gives the same result as the serial version.
+        std::vector<unsigned long> groups;
+        make_sparse_test_graph(rnd, edges, groups, 500, 20, 4);
+        const unsigned long num_clusters = louvain_cluster(edges, labels2);
+        DLIB_TEST(louvain_cluster(edges, labels3, 4) == num_clusters);
+        DLIB_TEST(labels2 == labels3);
+        DLIB_TEST(num_clusters >= 500);
+        check_clusters_inside_groups(groups, labels2);
+
+        // On a noisier graph louvain_cluster() should find a clustering that is at least
+        // about as good as the one newman_cluster() finds.
+        make_test_graph(rnd, edges, labels, 6, 20, 30, 0.5);
+        newman_cluster(edges, labels2);
+        louvain_cluster(edges, labels3, 2);
+        dlog << LINFO << "newman modularity: " << modularity(edges, labels2)
+                      << "  louvain modularity: " << modularity(edges, labels3);
+        DLIB_TEST(modularity(edges, labels3) >= modularity(edges, labels2) - 0.01);
+
+        // When louvain_cluster() stops, moving any single node into the cluster of one
+        // of its neighbors shouldn't increase the modularity by more than eps.
+        const double q = modularity(edges, labels3);
+        for (unsigned long i = 0; i < edges.size(); ++i)
+        {
+            for (int j = 0; j < 2; ++j)
+            {
+                const unsigned long n = j == 0 ? edges[i].index1() : edges[i].index2();
+                const unsigned long other = j == 0 ? edges[i].index2() : edges[i].index1();
+                const unsigned long old_label = labels3[n];
+                labels3[n] = labels3[other];
+                DLIB_TEST(modularity(edges, labels3) < q + 1e-6);
+                labels3[n] = old_label;
+            }
+        }
+    }
+
     class test_clustering : public tester
     {
     public:
@@ -264,6 +430,31 @@ namespace
             DLIB_TEST(labels.size() == 2);
             DLIB_TEST(chinese_whispers(edges, labels) == 2);
             DLIB_TEST(labels.size() == 2);
+            DLIB_TEST(chinese_whispers_threaded(edges, labels, 100, 2) == 2);
+            DLIB_TEST(labels.size() == 2);
+
+            edges.clear();
+            DLIB_TEST(chinese_whispers_threaded(edges, labels, 100, 2) == 0);
+            DLIB_TEST(labels.size() == 0);
+            edges.push_back(sample_pair(0,1,1));
+            DLIB_TEST(chinese_whispers_threaded(edges, labels, 100, 2) == 1);
+            DLIB_TEST(labels.size() == 2);
+            DLIB_TEST(chinese_whispers_threaded(edges, labels, 100, 2, chinese_whispers_synchronous) == 1);
+            DLIB_TEST(labels.size() == 2);
+
+            edges.clear();
+            DLIB_TEST(louvain_cluster(edges, labels) == 0);
+            DLIB_TEST(labels.size() == 0);
+            edges.push_back(sample_pair(0,1,1));
+            DLIB_TEST(louvain_cluster(edges, labels, 2) == 1);
+            DLIB_TEST(labels.size() == 2);
+            edges.clear();
+            edges.push_back(sample_pair(1,1,1));
+            DLIB_TEST(louvain_cluster(edges, labels) == 2);
+            DLIB_TEST(labels.size() == 2);
+            edges.push_back(sample_pair(0,2,0));
+            DLIB_TEST(louvain_cluster(edges, labels) == 3);
+            DLIB_TEST(labels.size() == 3);
 
 
             for (int i = 0; i < 10; ++i)
@@ -275,6 +466,12 @@ namespace
             for (int i = 0; i < 10; ++i)
                 test_chinese_whispers(rnd);
 
+            for (int i = 0; i < 10; ++i)
+                test_chinese_whispers_threaded(rnd);
+
+            for (int i = 0; i < 10; ++i)
+                test_louvain_cluster(rnd);
+
 
         }
     } a;
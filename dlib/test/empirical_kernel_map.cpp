@@ -2,7 +2,9 @@
 // License: Boost Software License   See LICENSE.txt for the full license.
 
 #include "tester.h"
-#include <dlib/svm.h>
+#include <dlib/svm_threaded.h>
+#include <dlib/statistics.h>
+#include "checkerboard.h"
 #include <dlib/rand.h>
 #include <dlib/string.h>
 #include <vector>
@@ -413,6 +415,92 @@ namespace
             }
         }
 
+        void test_kernel_approximation (
+        )
+        {
+            dlog << LINFO << "test kernel approximation";
+            typedef matrix<double,2,1> sample_type;
+            typedef radial_basis_kernel<sample_type> kernel_type;
+            typedef matrix<double,0,1> feature_type;
+            typedef linear_kernel<feature_type> lin_kernel;
+            const kernel_type kern(2.0);
+
+            std::vector<sample_type> x, test_x;
+            std::vector<double> y, test_y;
+            get_checkerboard_problem(x, y, 1000, 3);
+            get_checkerboard_problem(test_x, test_y, 500, 3);
+
+            // The batched Nystrom projection should agree with ekm.project().  Use k-means
+            // to pick the landmarks.
+            print_spinner();
+            std::vector<sample_type> centers;
+            pick_initial_centers(60, centers, x, linear_kernel<sample_type>());
+            find_clusters_using_kmeans(x, centers);
+            empirical_kernel_map<kernel_type> ekm;
+            ekm.load(kern, centers);
+            for (unsigned long num_threads = 1; num_threads <= 4; num_threads *= 4)
+            {
+                const std::vector<feature_type> proj = project_samples(ekm, x, num_threads);
+                DLIB_TEST(proj.size() == x.size());
+                for (unsigned long i = 0; i < x.size(); ++i)
+                {
+                    DLIB_TEST(proj[i].size() == ekm.out_vector_size());
+                    DLIB_TEST_MSG(max(abs(proj[i] - ekm.project(x[i]))) < 1e-8, max(abs(proj[i] - ekm.project(x[i]))));
+                }
+            }
+
+            // A linear SVM on the Nystrom features should solve the checkerboard problem.
+            svm_c_linear_trainer<lin_kernel> trainer;
+            trainer.set_c(1000);
+            decision_function<lin_kernel> df = trainer.train(project_samples(ekm, x, 2), y);
+            std::vector<feature_type> test_proj = project_samples(ekm, test_x, 2);
+            matrix<double> acc = test_binary_decision_function(df, test_proj, test_y);
+            dlog << LINFO << "nystrom accuracy: " << acc;
+            DLIB_TEST(acc(0) > 0.9 && acc(1) > 0.9);
+
+            // Now check the random Fourier features.  Their dot products should
+            // approximate the kernel.
+            print_spinner();
+            dlib::rand rnd;
+            random_fourier_features<kernel_type> rff;
+            DLIB_TEST(rff.out_vector_size() == 0);
+            rff.load(kern, 2, 2000, rnd);
+            DLIB_TEST(rff.out_vector_size() == 2000);
+            DLIB_TEST(rff.in_vector_size() == 2);
+            DLIB_TEST(rff.get_kernel() == kern);
+            running_stats<double> rs;
+            for (unsigned long i = 0; i+1 < 200; ++i)
+            {
+                const feature_type a = rff.project(x[i]);
+                const feature_type b = rff(x[i+1]);
+                rs.add(std::abs(dot(a,b) - kern(x[i],x[i+1])));
+            }
+            dlog << LINFO << "rff mean kernel error: " << rs.mean();
+            DLIB_TEST(rs.mean() < 0.05);
+
+            for (unsigned long num_threads = 1; num_threads <= 4; num_threads *= 4)
+            {
+                const std::vector<feature_type> proj = project_samples(rff, x, num_threads);
+                DLIB_TEST(proj.size() == x.size());
+                for (unsigned long i = 0; i < x.size(); ++i)
+                    DLIB_TEST(max(abs(proj[i] - rff.project(x[i]))) < 1e-10);
+            }
+
+            ostringstream sout;
+            serialize(rff, sout);
+            random_fourier_features<kernel_type> rff2;
+            istringstream sin(sout.str());
+            deserialize(rff2, sin);
+            DLIB_TEST(rff2.out_vector_size() == rff.out_vector_size());
+            DLIB_TEST(max(abs(rff2.project(x[0]) - rff.project(x[0]))) == 0);
+
+            df = trainer.train(project_samples(rff, x, 2), y);
+            test_proj = project_samples(rff, test_x, 2);
+            acc = test_binary_decision_function(df, test_proj, test_y);
+            dlog << LINFO << "rff accuracy: " << acc;
+            DLIB_TEST(acc(0) > 0.9 && acc(1) > 0.9);
+        }
+
         void perform_test (
         )
         {
@@ -430,6 +518,7 @@ namespace
             dlog << LINFO << "test with rbf kernel";
             test_with_kernel(radial_basis_kernel<sample_type>(0.2));
             print_spinner();
+            test_kernel_approximation();
         }
     };
 
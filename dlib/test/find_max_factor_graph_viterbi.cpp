@@ -69,6 +69,69 @@ namespace
         matrix<double> data;
     };
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename base_problem
+        >
+    class batched_map_problem : public base_problem
+    {
+        /*!
+            This is a map problem which also provides the optional factor_values()
+            member function.  The values are computed using factor_value() so they
+            should be identical to what find_max_factor_graph_viterbi() would get by
+            calling factor_value().
+        !*/
+    public:
+        void factor_values (
+            unsigned long node_id,
+            matrix<double>& values
+        ) const
+        {
+            const unsigned long ns = this->num_states();
+            const unsigned long k = std::min(node_id, this->order());
+            const long nc = (long)std::pow((double)ns, (double)k);
+            values.set_size(ns, nc);
+            matrix<unsigned long,1,0> node_states(k+1);
+            for (unsigned long s = 0; s < ns; ++s)
+            {
+                for (long c = 0; c < nc; ++c)
+                {
+                    node_states(0) = s;
+                    unsigned long temp = c;
+                    for (long i = k; i > 0; --i)
+                    {
+                        node_states(i) = temp%ns;
+                        temp /= ns;
+                    }
+                    values(s,c) = this->factor_value(node_id, node_states);
+                }
+            }
+        }
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename map_problem
+        >
+    double map_assignment_value (
+        const map_problem& prob,
+        const std::vector<unsigned long>& assign
+    )
+    {
+        DLIB_TEST(assign.size() == prob.number_of_nodes());
+        matrix<unsigned long,1,0> states = trans(mat(assign));
+        double score = 0;
+        for (unsigned long i = 0; i < assign.size(); ++i)
+        {
+            DLIB_TEST(assign[i] < prob.num_states());
+            const unsigned long o = std::min<unsigned long>(prob.order(), i);
+            score += prob.factor_value(i, colm(states, range(i, i-o)));
+        }
+        return score;
+    }
+
 
 // ----------------------------------------------------------------------------------------
 
@@ -135,9 +198,126 @@ namespace
                           trans(mat(assign))
                           << trans(mat(assign2))
                           );
+
+            // The threaded and batched versions should give exactly the same output.
+            find_max_factor_graph_viterbi_threaded(prob, assign2, 3);
+            DLIB_TEST(mat(assign) == mat(assign2));
+            batched_map_problem<map_problem<order,num_states,num_nodes,all_negative> > bprob;
+            bprob.data = prob.data;
+            find_max_factor_graph_viterbi(bprob, assign2);
+            DLIB_TEST(mat(assign) == mat(assign2));
+            find_max_factor_graph_viterbi_threaded(bprob, assign2, 2);
+            DLIB_TEST(mat(assign) == mat(assign2));
+
+            // A wide enough beam doesn't prune anything.
+            const unsigned long full_width = (unsigned long)std::pow((double)num_states, (double)order);
+            find_max_factor_graph_viterbi_beam(prob, assign2, full_width);
+            DLIB_TEST(mat(assign) == mat(assign2));
+            find_max_factor_graph_viterbi_beam(bprob, assign2, full_width+1);
+            DLIB_TEST(mat(assign) == mat(assign2));
+
+            // Smaller beams should still give valid assignments.
+            const double best_val = map_assignment_value(prob, assign);
+            for (unsigned long width = 1; width < full_width; width *= 2)
+            {
+                find_max_factor_graph_viterbi_beam(prob, assign2, width);
+                DLIB_TEST(map_assignment_value(prob, assign2) <= best_val);
+                std::vector<unsigned long> assign3;
+                find_max_factor_graph_viterbi_beam(bprob, assign3, width);
+                DLIB_TEST(mat(assign2) == mat(assign3));
+            }
+        }
+
+        // Solve a few problems at once.
+        std::vector<map_problem<order,num_states,num_nodes,all_negative> > probs(5);
+        std::vector<std::vector<unsigned long> > assigns;
+        find_max_factor_graph_viterbi_threaded(probs, assigns, 2);
+        DLIB_TEST(assigns.size() == probs.size());
+        for (unsigned long i = 0; i < probs.size(); ++i)
+        {
+            std::vector<unsigned long> assign;
+            find_max_factor_graph_viterbi(probs[i], assign);
+            DLIB_TEST(mat(assign) == mat(assigns[i]));
+        }
+        find_max_factor_graph_viterbi_threaded(probs, assigns, 3, 2);
+        DLIB_TEST(assigns.size() == probs.size());
+        for (unsigned long i = 0; i < probs.size(); ++i)
+        {
+            std::vector<unsigned long> assign;
+            find_max_factor_graph_viterbi_beam(probs[i], assign, 2);
+            DLIB_TEST(mat(assign) == mat(assigns[i]));
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    struct viterbi_failure {};
+
+    class throwing_map_problem
+    {
+        /*!
+            A second order problem whose factor_value() throws viterbi_failure for some
+            of the states of node bad_node.  It is big enough that the threaded version
+            of find_max_factor_graph_viterbi() splits each node over the threads.
+        !*/
+    public:
+        throwing_map_problem(unsigned long bad_node_) : bad_node(bad_node_) {}
+
+        unsigned long order() const { return 2; }
+        unsigned long num_states() const { return 12; }
+        unsigned long number_of_nodes() const { return 6; }
+
+        template <
+            typename EXP 
+            >
+        double factor_value (
+            unsigned long node_id,
+            const matrix_exp<EXP>& node_states
+        ) const
+        {
+            if (node_id == bad_node && node_states(0) == 5)
+                throw viterbi_failure();
+            double val = node_id*node_states(0)%7;
+            for (long i = 1; i < node_states.size(); ++i)
+                val -= (node_states(i)+node_states(i-1))%3;
+            return val;
+        }
+
+        unsigned long bad_node;
+    };
+
+    void test_factor_value_exception()
+    {
+        print_spinner();
+        std::vector<unsigned long> assign, assign2;
+        std::vector<std::vector<unsigned long> > assigns;
+        for (unsigned long num_threads = 1; num_threads <= 3; num_threads += 2)
+        {
+            // The exception should come out with its type intact even when it was
+            // thrown in one of the worker threads.
+            bool caught = false;
+            try { find_max_factor_graph_viterbi_threaded(throwing_map_problem(3), assign, num_threads); }
+            catch (viterbi_failure&) { caught = true; }
+            DLIB_TEST(caught);
+
+            std::vector<throwing_map_problem> probs;
+            probs.push_back(throwing_map_problem(100));
+            probs.push_back(throwing_map_problem(4));
+            probs.push_back(throwing_map_problem(100));
+            caught = false;
+            try { find_max_factor_graph_viterbi_threaded(probs, assigns, num_threads); }
+            catch (viterbi_failure&) { caught = true; }
+            DLIB_TEST(caught);
+        }
+
+        find_max_factor_graph_viterbi(throwing_map_problem(100), assign);
+        find_max_factor_graph_viterbi_threaded(throwing_map_problem(100), assign2, 3);
+        DLIB_TEST(assign.size() == 6);
+        DLIB_TEST(mat(assign) == mat(assign2));
+    }
+
+// ----------------------------------------------------------------------------------------
+
     template <
         unsigned long order,
         unsigned long num_states,
@@ -207,6 +387,8 @@ namespace
             do_test<2,1,8>();
             do_test<3,1,8>();
             do_test<0,1,8>();
+
+            test_factor_value_exception();
         }
     } a;
 
@@ -1132,6 +1132,86 @@ namespace
         DLIB_TEST(labels[5][5]);
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <typename T>
+    class random_potts_grid_problem
+    {
+    public:
+        random_potts_grid_problem(
+            long nr_,
+            long nc_,
+            dlib::rand& rnd
+        ) : nr__(nr_), nc__(nc_), seed(rnd.get_random_32bit_number())
+        {
+            unary.set_size(nr_*nc_);
+            for (long i = 0; i < unary.size(); ++i)
+                unary(i) = static_cast<T>(rnd.get_random_gaussian()*20);
+        }
+
+        long nr() const { return nr__;}
+        long nc() const { return nc__;}
+
+        typedef T value_type;
+
+        value_type factor_value(unsigned long idx) const
+        {
+            return unary(idx);
+        }
+
+        value_type factor_value_disagreement(unsigned long idx1, unsigned long idx2) const
+        {
+            // Any symmetric function of idx1 and idx2 will do.
+            const uint32 h = murmur_hash3_2(std::min(idx1,idx2), std::max(idx1,idx2)^seed);
+            return static_cast<value_type>(h%16);
+        }
+
+    private:
+        long nr__;
+        long nc__;
+        uint32 seed;
+        matrix<T,0,1> unary;
+    };
+
+    template <typename T>
+    void test_grid_min_cut (
+        dlib::rand& rnd,
+        long nr,
+        long nc
+    )
+    {
+        print_spinner();
+        random_potts_grid_problem<T> prob(nr, nc, rnd);
+        array2d<node_label> labels, other_labels(nr,nc);
+        find_max_factor_graph_potts(prob, labels);
+        DLIB_TEST(labels.nr() == nr);
+        DLIB_TEST(labels.nc() == nc);
+
+        if (nr >= 3 && nc >= 3)
+        {
+            // The grid version of find_max_factor_graph_potts() should find the same
+            // labels as running the general min_cut object on the same grid graph.
+            dlib::impl::potts_grid_problem<array2d<node_label>,random_potts_grid_problem<T> > model(other_labels, prob);
+            find_max_factor_graph_potts(model);
+
+            DLIB_TEST(std::abs((double)potts_model_score(prob, labels) - (double)potts_model_score(prob, other_labels)) < 1e-6);
+            for (long r = 0; r < nr; ++r)
+            {
+                for (long c = 0; c < nc; ++c)
+                {
+                    DLIB_TEST((labels[r][c] != 0) == (other_labels[r][c] != 0));
+                }
+            }
+        }
+        else
+        {
+            // In very thin grids some neighbors are the same node, which the general
+            // potts problem interface can't represent.  So check against brute force.
+            brute_force_potts_grid_problem(prob, other_labels);
+            DLIB_TEST(std::abs((double)potts_model_score(prob, labels) - (double)potts_model_score(prob, other_labels)) < 1e-6);
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
@@ -1154,6 +1234,17 @@ namespace
             test_potts_pair_grid();
             test_inf();
 
+            for (int i = 0; i < 50; ++i)
+            {
+                test_grid_min_cut<double>(rnd, rnd.get_random_32bit_number()%30+3, rnd.get_random_32bit_number()%30+3);
+                test_grid_min_cut<int>(rnd, rnd.get_random_32bit_number()%30+3, rnd.get_random_32bit_number()%30+3);
+                test_grid_min_cut<short>(rnd, rnd.get_random_32bit_number()%5+3, rnd.get_random_32bit_number()%5+3);
+                test_grid_min_cut<double>(rnd, 1, rnd.get_random_32bit_number()%12+1);
+                test_grid_min_cut<int>(rnd, rnd.get_random_32bit_number()%12+1, 1);
+                test_grid_min_cut<double>(rnd, 2, rnd.get_random_32bit_number()%6+1);
+                test_grid_min_cut<int>(rnd, rnd.get_random_32bit_number()%6+1, 2);
+            }
+
             for (int i = 0; i < 500; ++i)
             {
                 array2d<unsigned char> labels, brute_labels;
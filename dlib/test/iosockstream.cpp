@@ -9,6 +9,8 @@
 #include <dlib/iosockstream.h>
 #include <dlib/server.h>
 #include <vector>
+#include <fstream>
+#include <cstdio>
 
 #include "tester.h"
 
@@ -93,6 +95,61 @@ namespace
 
     };
 
+// ----------------------------------------------------------------------------------------
+
+    const unsigned long block_size = 100000;
+    const unsigned long file_size = 50000;
+
+    std::string make_block (
+        unsigned long size,
+        unsigned long seed
+    )
+    {
+        std::string block(size, ' ');
+        for (unsigned long i = 0; i < block.size(); ++i)
+            block[i] = static_cast<char>((i*seed)%253);
+        return block;
+    }
+
+    class serv3 : public server_iostream
+    {
+        virtual void on_connect (
+            std::istream& in,
+            std::ostream& out,
+            const std::string& ,
+            const std::string& ,
+            unsigned short ,
+            unsigned short ,
+            uint64 
+        )
+        {
+            try
+            {
+                dlog << LINFO << "serv3: serving connection";
+
+                // These big reads and writes go around the sockstreambuf's buffers.
+                std::vector<char> block(block_size);
+                std::vector<char> file(file_size);
+                in.read(&block[0], block.size());
+                in.read(&file[0], file.size());
+                DLIB_TEST(in.gcount() == (std::streamsize)file.size());
+                out.write(&file[0], file.size());
+                out.write(&block[0], block.size());
+                out.flush();
+            }
+            catch (error& e)
+            {
+                error_string = e.what();
+            }
+
+        }
+
+
+    public:
+        std::string error_string;
+
+    };
+
 // ----------------------------------------------------------------------------------------
 
     void test1()
@@ -157,6 +214,54 @@ namespace
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    void test3()
+    {
+        dlog << LINFO << "in test3()";
+        serv3 theserv;
+        theserv.set_listening_port(12345);
+        theserv.start_async();
+
+        const std::string block = make_block(block_size, 7);
+        const std::string file = make_block(file_size, 13);
+        const std::string filename = "iosockstream_send_file_test.dat";
+        {
+            std::ofstream fout(filename.c_str(), std::ios::binary);
+            fout.write(file.data(), file.size());
+        }
+
+        // wait a little bit to make sure the server has started listening before we try 
+        // to connect to it.
+        dlib::sleep(500);
+
+        for (int i = 0; i < 20; ++i)
+        {
+            dlog << LINFO << "i: " << i;
+            print_spinner();
+            iosockstream stream("localhost:12345");
+
+            stream.cork();
+            stream.write(block.data(), block.size());
+            stream.send_file(filename);
+            stream.uncork();
+            DLIB_TEST(stream.good());
+
+            std::vector<char> temp(file_size + block_size);
+            stream.read(&temp[0], temp.size());
+            DLIB_TEST(stream.gcount() == (std::streamsize)temp.size());
+            DLIB_TEST(std::string(temp.begin(), temp.begin()+file_size) == file);
+            DLIB_TEST(std::string(temp.begin()+file_size, temp.end()) == block);
+        }
+
+        std::remove(filename.c_str());
+
+        dlib::sleep(500);
+
+        if (theserv.error_string.size() != 0)
+            throw error(theserv.error_string);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     class test_iosockstream : public tester
@@ -173,6 +278,7 @@ namespace
         {
             test1();
             test2();
+            test3();
         }
     } a;
 
@@ -2,7 +2,8 @@
 // License: Boost Software License   See LICENSE.txt for the full license.
 
 #include "tester.h"
-#include <dlib/svm.h>
+#include <dlib/svm_threaded.h>
+#include <map>
 #include <vector>
 #include <sstream>
 
@@ -13,6 +14,77 @@ namespace
     using namespace std;
     dlib::logger dlog("test.kernel_matrix");
 
+    template <typename kernel_type, typename sample_type>
+    void check_kernel_matrix_threaded (
+        const kernel_type& kern,
+        const std::vector<sample_type>& samples1,
+        const std::vector<sample_type>& samples2,
+        double eps
+    )
+    {
+        print_spinner();
+        const matrix<double> truth = kernel_matrix(kern, samples1);
+        const matrix<double> truth2 = kernel_matrix(kern, samples1, samples2);
+        for (unsigned long num_threads = 1; num_threads <= 4; num_threads *= 4)
+        {
+            matrix<double> K;
+            kernel_matrix_threaded(kern, samples1, K, num_threads);
+            DLIB_TEST(K.nr() == truth.nr() && K.nc() == truth.nc());
+            DLIB_TEST_MSG(max(abs(K - truth)) <= eps, max(abs(K - truth)));
+            DLIB_TEST(K == trans(K));
+
+            matrix<float> Kf;
+            kernel_matrix_threaded(kern, samples1, Kf, num_threads);
+            DLIB_TEST(Kf.nr() == truth.nr() && Kf.nc() == truth.nc());
+            DLIB_TEST(max(abs(matrix_cast<double>(Kf) - truth)) < 1e-5*max(abs(truth)));
+
+            kernel_matrix_threaded(kern, mat(samples1), samples2, K, num_threads);
+            DLIB_TEST(K.nr() == truth2.nr() && K.nc() == truth2.nc());
+            DLIB_TEST_MSG(max(abs(K - truth2)) <= eps, max(abs(K - truth2)));
+        }
+    }
+
+    std::map<unsigned long,double> to_sparse (
+        const matrix<double,0,1>& v
+    )
+    {
+        std::map<unsigned long,double> temp;
+        for (long i = 0; i < v.size(); ++i)
+            temp[i] = v(i);
+        return temp;
+    }
+
+    void test_kernel_matrix_threaded (
+    )
+    {
+        typedef matrix<double,0,1> sample_type;
+        typedef std::map<unsigned long,double> sparse_sample_type;
+
+        dlib::rand rnd;
+        std::vector<sample_type> samples1, samples2;
+        std::vector<sparse_sample_type> sparse1, sparse2;
+        for (int i = 0; i < 300; ++i)
+        {
+            samples1.push_back(matrix_cast<double>(randm(7,1,rnd)));
+            sparse1.push_back(to_sparse(samples1.back()));
+        }
+        // include a duplicate so the RBF kernel sees a distance of exactly 0
+        samples1[10] = samples1[200];
+        sparse1[10] = sparse1[200];
+        for (int i = 0; i < 150; ++i)
+        {
+            samples2.push_back(matrix_cast<double>(randm(7,1,rnd)));
+            sparse2.push_back(to_sparse(samples2.back()));
+        }
+
+        check_kernel_matrix_threaded(radial_basis_kernel<sample_type>(0.1), samples1, samples2, 1e-12);
+        check_kernel_matrix_threaded(linear_kernel<sample_type>(), samples1, samples2, 1e-12);
+        check_kernel_matrix_threaded(polynomial_kernel<sample_type>(0.5, 1, 3), samples1, samples2, 1e-12);
+        check_kernel_matrix_threaded(sigmoid_kernel<sample_type>(0.1, -1), samples1, samples2, 1e-12);
+        check_kernel_matrix_threaded(histogram_intersection_kernel<sample_type>(), samples1, samples2, 0);
+        check_kernel_matrix_threaded(sparse_radial_basis_kernel<sparse_sample_type>(0.1), sparse1, sparse2, 0);
+    }
+
 
     class kernel_matrix_tester : public tester
     {
@@ -147,6 +219,8 @@ namespace
 
             samp3 += trans(kernel_matrix(kern, samp, vect2));
             DLIB_TEST(equal(samp3, 2*trans(kernel_matrix(kern, samp, vect2))));
+
+            test_kernel_matrix_threaded();
         }
     };
 
@@ -5,7 +5,7 @@
 #include <string>
 #include <cstdlib>
 #include <ctime>
-#include <dlib/svm.h>
+#include <dlib/svm_threaded.h>
 #include <dlib/matrix.h>
 
 #include "tester.h"
@@ -46,9 +46,29 @@ namespace
 
         std::vector<sample_type> centers;
         pick_initial_centers(seed_centers.size(), centers, samples, linear_kernel<sample_type>());
+        std::vector<sample_type> centers2(centers), centers3(centers);
 
         find_clusters_using_kmeans(samples, centers);
 
+        // The threaded version should find the same centers.
+        std::vector<unsigned long> assignments, assignments2;
+        find_clusters_using_kmeans_threaded(samples, centers2, assignments, 1);
+        find_clusters_using_kmeans_threaded(samples, centers3, assignments2, 3);
+        DLIB_TEST(assignments.size() == samples.size());
+        DLIB_TEST(assignments == assignments2);
+        for (unsigned long j = 0; j < centers.size(); ++j)
+        {
+            DLIB_TEST_MSG(max(abs(centers[j] - centers2[j])) < 1e-4, centers[j] - centers2[j]);
+            DLIB_TEST(max(abs(centers2[j] - centers3[j])) == 0);
+        }
+        for (unsigned long i = 0; i < samples.size(); ++i)
+        {
+            for (unsigned long j = 0; j < centers2.size(); ++j)
+            {
+                DLIB_TEST(length(samples[i]-centers2[assignments[i]]) <= length(samples[i]-centers2[j]));
+            }
+        }
+
         DLIB_TEST(centers.size() == seed_centers.size());
 
         std::vector<int> hits(centers.size(),0);
@@ -71,8 +91,92 @@ namespace
         {
             DLIB_TEST(hits[i] == 250);
         }
+
+        // kmeans++ seeding followed by mini-batch kmeans should also find the clusters.
+        dlib::rand rnd2;
+        pick_initial_centers_kmeanspp(seed_centers.size(), centers, samples, 2, rnd2);
+        DLIB_TEST(centers.size() == seed_centers.size());
+        find_clusters_using_minibatch_kmeans(samples, centers, 50, 40, 2, rnd2);
+        hits.assign(centers.size(), 0);
+        for (unsigned long i = 0; i < samples.size(); ++i)
+        {
+            unsigned long best_idx = 0;
+            double best_dist = 1e100;
+            for (unsigned long j = 0; j < centers.size(); ++j)
+            {
+                if (length(samples[i] - centers[j]) < best_dist)
+                {
+                    best_dist = length(samples[i] - centers[j]);
+                    best_idx = j;
+                }
+            }
+            hits[best_idx]++;
+        }
+        for (unsigned long i = 0; i < hits.size(); ++i)
+        {
+            DLIB_TEST(hits[i] == 250);
+        }
+    }
+
+    template <typename sample_type, typename alloc>
+    double kmeans_error (
+        const std::vector<sample_type>& samples,
+        const std::vector<sample_type,alloc>& centers
+    )
+    {
+        // The average squared distance from each sample to its nearest center.
+        double total = 0;
+        for (unsigned long i = 0; i < samples.size(); ++i)
+        {
+            double best = std::numeric_limits<double>::infinity();
+            for (unsigned long j = 0; j < centers.size(); ++j)
+                best = std::min<double>(best, length_squared(samples[i] - centers[j]));
+            total += best;
+        }
+        return total/samples.size();
     }
 
+    void test_kmeans_threaded_determinism (
+    )
+    {
+        print_spinner();
+        typedef matrix<float,0,1> sample_type;
+        std::vector<sample_type> samples;
+        for (int i = 0; i < 3000; ++i)
+            samples.push_back(matrix_cast<float>(randm(5,1,rnd)));
+
+        std::vector<sample_type> centers1, centers2, centers3, centers4;
+        dlib::rand rnd1, rnd2;
+        pick_initial_centers_kmeanspp(20, centers1, samples, 1, rnd1);
+        pick_initial_centers_kmeanspp(20, centers2, samples, 4, rnd2);
+        DLIB_TEST(centers1.size() == 20);
+        for (unsigned long j = 0; j < centers1.size(); ++j)
+            DLIB_TEST(centers1[j] == centers2[j]);
+
+        centers3 = centers1;
+        centers4 = centers1;
+        find_clusters_using_minibatch_kmeans(samples, centers1, 100, 20, 1, rnd1);
+        find_clusters_using_minibatch_kmeans(samples, centers2, 100, 20, 4, rnd2);
+        for (unsigned long j = 0; j < centers1.size(); ++j)
+            DLIB_TEST(centers1[j] == centers2[j]);
+
+        std::vector<unsigned long> assignments3, assignments4;
+        find_clusters_using_kmeans_threaded(samples, centers3, assignments3, 1);
+        find_clusters_using_kmeans_threaded(samples, centers4, assignments4, 4);
+        DLIB_TEST(assignments3 == assignments4);
+        for (unsigned long j = 0; j < centers3.size(); ++j)
+            DLIB_TEST(centers3[j] == centers4[j]);
+        // Lloyd's algorithm should have converged to a better clustering than the
+        // mini-batch one.
+        DLIB_TEST(kmeans_error(samples, centers3) <= kmeans_error(samples, centers1));
+
+        // Every sample must be assigned to its nearest center.
+        for (unsigned long i = 0; i < samples.size(); ++i)
+        {
+            for (unsigned long j = 0; j < centers3.size(); ++j)
+                DLIB_TEST(length_squared(samples[i]-centers3[assignments3[i]]) <= length_squared(samples[i]-centers3[j]) + 1e-5);
+        }
+    }
 
     class test_kmeans : public tester
     {
@@ -120,7 +224,7 @@ namespace
                 run_test(seed_centers);
             }
 
-
+            test_kmeans_threaded_determinism();
         }
     } a;
 
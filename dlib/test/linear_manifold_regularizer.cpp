@@ -77,7 +77,274 @@ namespace
         test_find_k_nearest_neighbors_lsh<hash_similar_angles_512>(samples);
     }
 
+    template <typename samples_type, typename distance_function_type>
+    void test_find_k_nearest_neighbors_threaded(
+        const samples_type& samples,
+        const distance_function_type& dist_funct,
+        const unsigned long k
+    )
+    {
+        std::vector<sample_pair> edges1, edges2, edges3;
+
+        find_k_nearest_neighbors(samples, dist_funct, k, edges1);
+        find_k_nearest_neighbors_threaded(samples, dist_funct, k, 1, edges2);
+        find_k_nearest_neighbors_threaded(samples, dist_funct, k, 3, edges3);
+
+        std::sort(edges1.begin(), edges1.end(), order_by_index<sample_pair>);
+
+        DLIB_TEST_MSG(edges1.size() == edges2.size(), edges1.size() << "    " << edges2.size());
+        DLIB_TEST_MSG(edges1.size() == edges3.size(), edges1.size() << "    " << edges3.size());
+        for (unsigned long i = 0; i < edges1.size(); ++i)
+        {
+            DLIB_TEST(edges1[i] == edges2[i]);
+            DLIB_TEST(edges1[i].distance() == edges2[i].distance());
+            DLIB_TEST(edges1[i] == edges3[i]);
+            DLIB_TEST(edges1[i].distance() == edges3[i].distance());
+        }
+
+        // Now check the version that streams the neighbors of each sample to disk.
+        std::ostringstream sout;
+        find_k_nearest_neighbors_threaded(samples, dist_funct, k, 2, sout);
+        std::istringstream sin(sout.str());
+        std::vector<sample_pair> edges4;
+        std::vector<ordered_sample_pair> neighbors;
+        for (unsigned long i = 0; i < samples.size(); ++i)
+        {
+            deserialize(neighbors, sin);
+            DLIB_TEST(neighbors.size() <= k);
+            for (unsigned long j = 0; j < neighbors.size(); ++j)
+            {
+                DLIB_TEST(neighbors[j].index1() == i);
+                if (j > 0)
+                    DLIB_TEST(neighbors[j-1].distance() <= neighbors[j].distance());
+                edges4.push_back(sample_pair(i, neighbors[j].index2(), neighbors[j].distance()));
+            }
+        }
+        DLIB_TEST(sin.peek() == EOF);
+        remove_duplicate_edges(edges4);
+        DLIB_TEST(edges4.size() == edges1.size());
+        for (unsigned long i = 0; i < edges1.size() && i < edges4.size(); ++i)
+        {
+            DLIB_TEST(edges1[i] == edges4[i]);
+            DLIB_TEST(edges1[i].distance() == edges4[i].distance());
+        }
+    }
+
+    template <typename scalar_type>
+    void test_knn_threaded()
+    {
+        dlib::rand rnd;
+        std::vector<matrix<scalar_type,0,1> > samples;
+        std::vector<std::map<unsigned long,scalar_type> > sparse_samples;
+        // use enough samples that the distance matrix is split into several blocks
+        samples.resize(300);
+        sparse_samples.resize(samples.size());
+        for (unsigned int i = 0; i < samples.size(); ++i)
+        {
+            samples[i].set_size(4);
+            for (long j = 0; j < samples[i].size(); ++j)
+            {
+                samples[i](j) = rnd.get_random_gaussian();
+                sparse_samples[i][2*j] = samples[i](j);
+            }
+        }
+
+        test_find_k_nearest_neighbors_threaded(samples, squared_euclidean_distance(), 1);
+        test_find_k_nearest_neighbors_threaded(samples, squared_euclidean_distance(), 5);
+        test_find_k_nearest_neighbors_threaded(samples, squared_euclidean_distance(0.5, 3), 5);
+        test_find_k_nearest_neighbors_threaded(samples, cosine_distance(), 4);
+        test_find_k_nearest_neighbors_threaded(samples, negative_dot_product_distance(), 3);
+        test_find_k_nearest_neighbors_threaded(sparse_samples, negative_dot_product_distance(), 5);
+        test_find_k_nearest_neighbors_threaded(sparse_samples, cosine_distance(), 4);
+
+        // check the degenerate cases
+        std::vector<sample_pair> edges;
+        samples.resize(1);
+        find_k_nearest_neighbors_threaded(samples, squared_euclidean_distance(), 3, 2, edges);
+        DLIB_TEST(edges.size() == 0);
+        samples.resize(2);
+        samples[1] = 2*samples[0];
+        find_k_nearest_neighbors_threaded(samples, squared_euclidean_distance(), 3, 2, edges);
+        DLIB_TEST(edges.size() == 1);
+    }
 
+    void test_knn_threaded_far_from_origin()
+    {
+        // Far from the origin the distances computed from the dot products are mostly
+        // rounding error.  The neighbors should still come out right.
+        print_spinner();
+        std::vector<matrix<double,0,1> > samples(300);
+        for (unsigned int i = 0; i < samples.size(); ++i)
+            samples[i] = 1e6 + gaussian_randm(4,1,i)/100;
+
+        test_find_k_nearest_neighbors_threaded(samples, squared_euclidean_distance(), 5);
+        test_find_k_nearest_neighbors_threaded(samples, negative_dot_product_distance(), 3);
+    }
+
+    double hnsw_recall (
+        const hnsw_index<matrix<double,0,1> >& index,
+        const std::vector<matrix<double,0,1> >& queries,
+        const unsigned long k,
+        const unsigned long num_threads
+    )
+    {
+        std::vector<ordered_sample_pair> neighbors;
+        index.find_nearest_neighbors(queries, k, num_threads, neighbors);
+        DLIB_TEST(neighbors.size() <= queries.size()*k);
+
+        unsigned long hits = 0;
+        unsigned long n = 0;
+        std::vector<double> dists(index.size());
+        for (unsigned long i = 0; i < queries.size(); ++i)
+        {
+            // find the true k nearest neighbors by brute force
+            for (unsigned long j = 0; j < index.size(); ++j)
+                dists[j] = length_squared(queries[i] - index[j]);
+            std::vector<double> sorted_dists(dists);
+            std::nth_element(sorted_dists.begin(), sorted_dists.begin()+k-1, sorted_dists.end());
+            const double kth_dist = sorted_dists[k-1];
+
+            // The neighbors are grouped by query.  A query might get fewer than k of
+            // them, in which case the missing ones count as misses.
+            const unsigned long begin = n;
+            for (; n < neighbors.size() && neighbors[n].index1() == i; ++n)
+            {
+                DLIB_TEST(n-begin < k);
+                DLIB_TEST(neighbors[n].distance() == dists[neighbors[n].index2()]);
+                if (n > begin)
+                    DLIB_TEST(neighbors[n-1].distance() <= neighbors[n].distance());
+                if (neighbors[n].distance() <= kth_dist)
+                    ++hits;
+            }
+        }
+        // Every neighbor should belong to one of the queries.
+        DLIB_TEST(n == neighbors.size());
+        return hits/(double)(queries.size()*k);
+    }
+
+    void test_hnsw_index()
+    {
+        print_spinner();
+        std::vector<matrix<double,0,1> > samples(3000), queries(100);
+        for (unsigned long i = 0; i < samples.size(); ++i)
+            samples[i] = gaussian_randm(8,1,i);
+        for (unsigned long i = 0; i < queries.size(); ++i)
+            queries[i] = gaussian_randm(8,1,i+samples.size());
+
+        typedef hnsw_index<matrix<double,0,1> > index_type;
+        index_type index;
+        DLIB_TEST(index.size() == 0);
+        std::vector<ordered_sample_pair> neighbors;
+        index.find_nearest_neighbors(queries[0], 5, neighbors);
+        DLIB_TEST(neighbors.size() == 0);
+
+        index.add(samples, 1);
+        DLIB_TEST(index.size() == samples.size());
+        for (unsigned long i = 0; i < samples.size(); ++i)
+            DLIB_TEST(index[i] == samples[i]);
+
+        double recall = hnsw_recall(index, queries, 10, 1);
+        dlog << LINFO << "hnsw recall: " << recall;
+        DLIB_TEST_MSG(recall > 0.95, recall);
+
+        // querying with more threads gives the same answer
+        std::vector<ordered_sample_pair> neighbors1, neighbors2;
+        index.find_nearest_neighbors(queries, 10, 1, neighbors1);
+        index.find_nearest_neighbors(queries, 10, 3, neighbors2);
+        DLIB_TEST(neighbors1 == neighbors2);
+
+        // A bigger search size gives better results and a small one worse results.
+        index.set_search_size(200);
+        double recall2 = hnsw_recall(index, queries, 10, 2);
+        dlog << LINFO << "hnsw recall with search size 200: " << recall2;
+        DLIB_TEST_MSG(recall2 >= recall && recall2 > 0.99, recall2);
+        index.set_search_size(10);
+        recall2 = hnsw_recall(index, queries, 10, 2);
+        dlog << LINFO << "hnsw recall with search size 10: " << recall2;
+        DLIB_TEST_MSG(recall2 <= recall && recall2 > 0.5, recall2);
+        index.set_search_size(50);
+
+        // Adding the samples one at a time is the same as adding them with one thread.
+        index_type index2;
+        for (unsigned long i = 0; i < samples.size(); ++i)
+            DLIB_TEST(index2.add(samples[i]) == i);
+        std::vector<ordered_sample_pair> graph1, graph2;
+        index.get_graph(graph1);
+        index2.get_graph(graph2);
+        DLIB_TEST(graph1.size() > samples.size());
+        DLIB_TEST(graph1 == graph2);
+        for (unsigned long i = 0; i < graph1.size(); ++i)
+        {
+            DLIB_TEST(graph1[i].index1() != graph1[i].index2());
+            if (i > 0)
+                DLIB_TEST(graph1[i-1].index1() <= graph1[i].index1());
+        }
+
+        // check serialization
+        std::ostringstream sout;
+        serialize(index, sout);
+        std::istringstream sin(sout.str());
+        index_type index3;
+        deserialize(index3, sin);
+        DLIB_TEST(index3.size() == index.size());
+        DLIB_TEST(index3.get_search_size() == 50);
+        index3.find_nearest_neighbors(queries, 10, 2, neighbors2);
+        DLIB_TEST(neighbors1 == neighbors2);
+
+        // The distance function isn't saved so deserializing keeps the one the index
+        // already has.
+        index_type index5(squared_euclidean_distance(0, 1e10));
+        std::istringstream sin2(sout.str());
+        deserialize(index5, sin2);
+        DLIB_TEST(index5.size() == index.size());
+        DLIB_TEST(index5.get_distance_function().upper == 1e10);
+
+        // Build the index with several threads.  The graph may not be identical but it
+        // should be just as good.
+        index_type index4;
+        index4.add(samples, 4);
+        DLIB_TEST(index4.size() == samples.size());
+        recall2 = hnsw_recall(index4, queries, 10, 4);
+        dlog << LINFO << "hnsw recall, built with 4 threads: " << recall2;
+        DLIB_TEST_MSG(recall2 > 0.95, recall2);
+
+        // Samples can be added after querying.
+        index4.add(queries, 2);
+        DLIB_TEST(index4.size() == samples.size() + queries.size());
+        for (unsigned long i = 0; i < queries.size(); ++i)
+        {
+            index4.find_nearest_neighbors(queries[i], 1, neighbors, 7);
+            DLIB_TEST(neighbors.size() == 1);
+            DLIB_TEST(neighbors[0].index1() == 7);
+            DLIB_TEST(neighbors[0].index2() == samples.size()+i);
+            DLIB_TEST(neighbors[0].distance() == 0);
+        }
+    }
+
+    void test_find_k_nearest_neighbors_hnsw()
+    {
+        std::vector<matrix<double,0,1> > samples(1000);
+        for (unsigned long i = 0; i < samples.size(); ++i)
+            samples[i] = gaussian_randm(5,1,i);
+
+        std::vector<sample_pair> edges1, edges2;
+        find_k_nearest_neighbors(samples, squared_euclidean_distance(), 5, edges1);
+        find_k_nearest_neighbors_hnsw(samples, squared_euclidean_distance(), 5, 2, edges2);
+        DLIB_TEST(contains_duplicate_pairs(edges2) == false);
+
+        std::sort(edges1.begin(), edges1.end(), order_by_index<sample_pair>);
+        std::sort(edges2.begin(), edges2.end(), order_by_index<sample_pair>);
+        std::vector<sample_pair> common;
+        std::set_intersection(edges1.begin(), edges1.end(), edges2.begin(), edges2.end(),
+                              std::back_inserter(common), order_by_index<sample_pair>);
+        dlog << LINFO << "find_k_nearest_neighbors_hnsw() accuracy: " << common.size()/(double)edges1.size();
+        DLIB_TEST(common.size() > 0.95*edges1.size());
+        for (unsigned long i = 0; i < edges2.size(); ++i)
+        {
+            DLIB_TEST(edges2[i].index1() != edges2[i].index2());
+            DLIB_TEST(edges2[i].distance() == length_squared(samples[edges2[i].index1()] - samples[edges2[i].index2()]));
+        }
+    }
 
     class linear_manifold_regularizer_tester : public tester
     {
@@ -392,6 +659,11 @@ namespace
             test_knn_lsh_sparse<float>();
             test_knn_lsh_dense<double>();
             test_knn_lsh_dense<float>();
+            test_knn_threaded<double>();
+            test_knn_threaded<float>();
+            test_knn_threaded_far_from_origin();
+            test_hnsw_index();
+            test_find_k_nearest_neighbors_hnsw();
 
         }
     };
@@ -0,0 +1,275 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+
+// Compile out everything below LINFO when using DLIB_LOG() in this file.
+#define DLIB_LOG_MIN_PRIORITY 0
+
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+#include <dlib/logger.h>
+#include <dlib/threads.h>
+#include <dlib/string.h>
+
+#include "tester.h"
+
+namespace  
+{
+    using namespace test;
+    using namespace dlib;
+    using namespace std;
+
+    logger dlog("test.logger");
+
+// ----------------------------------------------------------------------------------------
+
+    void simple_header (
+        std::ostream& out,
+        const std::string& logger_name,
+        const log_level& ,
+        const uint64 
+    )
+    {
+        out << logger_name << ": ";
+    }
+
+    const int num_threads = 4;
+    const int msgs_per_thread = 1000;
+    logger tlog("test_logger_async");
+
+    void log_some_messages (
+        long thread_idx
+    )
+    {
+        for (int i = 0; i < msgs_per_thread; ++i)
+            tlog << LINFO << "thread " << thread_idx << " msg " << i;
+    }
+
+    void check_messages (
+        const std::string& text
+    )
+    {
+        std::istringstream sin(text);
+        std::string line;
+        std::vector<int> next(num_threads, 0);
+        int count = 0;
+        while (std::getline(sin, line))
+        {
+            std::vector<std::string> tok = split(line);
+            DLIB_TEST_MSG(tok.size() == 5, line);
+            DLIB_TEST(tok[0] == "test_logger_async:");
+            const int t = string_cast<int>(tok[2]);
+            const int i = string_cast<int>(tok[4]);
+            DLIB_TEST(0 <= t && t < num_threads);
+            // messages from any one thread must come out in the order they were logged
+            DLIB_TEST(next[t] == i);
+            next[t] = i+1;
+            ++count;
+        }
+        DLIB_TEST(count == num_threads*msgs_per_thread);
+    }
+
+    void test_async_streams (
+    )
+    {
+        print_spinner();
+        std::ostringstream sout;
+        tlog.set_output_stream(sout);
+        tlog.set_logger_header(simple_header);
+        tlog.set_level(LALL);
+
+        enable_async_logging(1000);
+        DLIB_TEST(async_logging_enabled());
+
+        thread_function t0(log_some_messages, 0), t1(log_some_messages, 1);
+        thread_function t2(log_some_messages, 2), t3(log_some_messages, 3);
+        t0.wait(); t1.wait(); t2.wait(); t3.wait();
+
+        flush_async_logging();
+        check_messages(sout.str());
+        DLIB_TEST(num_dropped_log_messages() == 0);
+
+        // Messages logged after disabling async logging are written immediately.
+        disable_async_logging();
+        DLIB_TEST(!async_logging_enabled());
+        sout.str("");
+        tlog << LINFO << "thread 0 msg 0";
+        DLIB_TEST(sout.str() == "test_logger_async: thread 0 msg 0\n");
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    int count_lines (
+        const std::string& text,
+        const std::string& expected_line
+    )
+    {
+        std::istringstream sin(text);
+        std::string line;
+        int count = 0;
+        while (std::getline(sin, line))
+        {
+            DLIB_TEST_MSG(line == expected_line, line);
+            ++count;
+        }
+        return count;
+    }
+
+    void test_async_output_changes (
+    )
+    {
+        print_spinner();
+        enable_async_logging();
+
+        std::ostringstream sout1, sout2, sout3;
+        {
+            logger temp("test_logger_async_temp");
+            temp.set_output_stream(sout1);
+            temp.set_logger_header(simple_header);
+            temp.set_level(LALL);
+
+            for (int i = 0; i < 100; ++i)
+                temp << LINFO << "message";
+            // Messages still in the queue go to the new stream since the writer thread
+            // looks up the stream when it outputs them.
+            temp.set_output_stream(sout2);
+            for (int i = 0; i < 100; ++i)
+                temp << LINFO << "message";
+            flush_async_logging();
+            DLIB_TEST(count_lines(sout1.str(), "test_logger_async_temp: message") +
+                      count_lines(sout2.str(), "test_logger_async_temp: message") == 200);
+
+            temp.set_output_stream(sout3);
+            for (int i = 0; i < 100; ++i)
+                temp << LINFO << "message";
+            // The logger's destructor must wait for these messages to be output.
+        }
+        DLIB_TEST(count_lines(sout3.str(), "test_logger_async_temp: message") == 100);
+
+        disable_async_logging();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    class slow_hook
+    {
+    public:
+        slow_hook() : count(0), s(m), blocked(true) {}
+
+        mutex m;
+        int count;
+        signaler s;
+        bool blocked;
+        std::vector<std::string> msgs;
+
+        void hook (
+            const std::string& logger_name, 
+            const log_level& l,
+            const uint64 ,
+            const char* message_to_log
+        )
+        {
+            auto_mutex M(m);
+            while (blocked)
+                s.wait();
+            DLIB_TEST(logger_name == "test_logger_async");
+            DLIB_TEST(l.priority == LWARN.priority);
+            msgs.push_back(message_to_log);
+            ++count;
+        }
+
+        void unblock()
+        {
+            auto_mutex M(m);
+            blocked = false;
+            s.broadcast();
+        }
+    };
+
+    void test_async_drop_policy (
+    )
+    {
+        print_spinner();
+        slow_hook h;
+        tlog.set_output_hook(h, &slow_hook::hook);
+
+        const uint64 dropped_before = num_dropped_log_messages();
+        // A tiny queue and a hook that doesn't return means messages will have to be
+        // dropped.
+        enable_async_logging(500, ASYNC_LOGGING_DROP);
+        const int num = 200;
+        for (int i = 0; i < num; ++i)
+            tlog << LWARN << "message " << i;
+
+        h.unblock();
+        flush_async_logging();
+        const uint64 dropped = num_dropped_log_messages() - dropped_before;
+        dlog << LINFO << "dropped: " << dropped;
+        auto_mutex M(h.m);
+        DLIB_TEST(dropped > 0);
+        DLIB_TEST(h.count + dropped == num);
+        DLIB_TEST(h.msgs.size() > 0);
+        DLIB_TEST(h.msgs[0] == "message 0");
+        disable_async_logging();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    int num_evaluations = 0;
+    int evaluate ()
+    {
+        ++num_evaluations;
+        return num_evaluations;
+    }
+
+    void test_compile_time_elision (
+    )
+    {
+        std::ostringstream sout;
+        tlog.set_output_stream(sout);
+        tlog.set_logger_header(simple_header);
+        tlog.set_level(LALL);
+
+        num_evaluations = 0;
+        DLIB_LOG(tlog, LTRACE) << "trace " << evaluate();
+        DLIB_LOG(tlog, LDEBUG) << "debug " << evaluate();
+        DLIB_TEST(num_evaluations == 1);
+        DLIB_LOG(tlog, LINFO) << "info " << evaluate();
+        DLIB_TEST(num_evaluations == 2);
+        DLIB_TEST(sout.str() == "test_logger_async: debug 1\ntest_logger_async: info 2\n");
+
+        // make sure DLIB_LOG() doesn't mess up if statements it is nested in
+        if (num_evaluations == 0)
+            DLIB_LOG(tlog, LINFO) << "not printed";
+        else
+            num_evaluations = 10;
+        DLIB_TEST(num_evaluations == 10);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    class test_logger : public tester
+    {
+    public:
+        test_logger (
+        ) :
+            tester ("test_logger",
+                    "Runs tests on the logger component.")
+        {}
+
+        void perform_test (
+        )
+        {
+            test_compile_time_elision();
+            test_async_streams();
+            test_async_output_changes();
+            test_async_drop_policy();
+            tlog.set_output_stream(std::cout);
+            tlog.set_level(LERROR);
+        }
+    } a;
+
+}
+
@@ -85,6 +85,88 @@ namespace
         return perms[best_idx];
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <typename T>
+    double partial_assignment_cost (
+        const matrix<T>& cost,
+        const std::vector<long>& assignment
+    )
+    /*!
+        ensures
+            - returns the cost of the given assignment, where rows assigned to -1 don't
+              contribute anything.  Also checks that no column is used twice.
+    !*/
+    {
+        DLIB_TEST(assignment.size() == (unsigned long)cost.nr());
+        std::vector<bool> used(cost.nc(), false);
+        double total = 0;
+        for (unsigned long i = 0; i < assignment.size(); ++i)
+        {
+            if (assignment[i] == -1)
+                continue;
+            DLIB_TEST(0 <= assignment[i] && assignment[i] < cost.nc());
+            DLIB_TEST(!used[assignment[i]]);
+            used[assignment[i]] = true;
+            total += cost(i,assignment[i]);
+        }
+        return total;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename T>
+    double brute_force_rectangular_assignment_cost (
+        const matrix<T>& cost
+    )
+    {
+        if (cost.size() == 0)
+            return 0;
+        // Padding with zeros doesn't change the best cost of a rectangular problem.
+        const long n = std::max(cost.nr(), cost.nc());
+        matrix<T> padded(n,n);
+        padded = 0;
+        set_subm(padded, 0, 0, cost.nr(), cost.nc()) = cost;
+        // Shifting all the costs by the same amount doesn't change the best assignment
+        // of a square problem.  We make them non-negative since for floating point types
+        // brute_force_max_cost_assignment() starts its search at numeric_limits::min(),
+        // which is positive.
+        const matrix<T> shifted = padded - min(padded);
+        return partial_assignment_cost(padded, brute_force_max_cost_assignment(shifted));
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    double sparse_assignment_cost (
+        const std::vector<ordered_sample_pair>& edges,
+        const std::vector<long>& assignment
+    )
+    {
+        std::vector<bool> used;
+        double total = 0;
+        for (unsigned long i = 0; i < assignment.size(); ++i)
+        {
+            if (assignment[i] == -1)
+                continue;
+            bool found = false;
+            for (unsigned long k = 0; k < edges.size(); ++k)
+            {
+                if (edges[k].index1() == i && (long)edges[k].index2() == assignment[i])
+                {
+                    found = true;
+                    total += edges[k].distance();
+                    break;
+                }
+            }
+            DLIB_TEST(found);
+            if (used.size() <= (unsigned long)assignment[i])
+                used.resize(assignment[i]+1, false);
+            DLIB_TEST(!used[assignment[i]]);
+            used[assignment[i]] = true;
+        }
+        return total;
+    }
+
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
@@ -135,6 +217,113 @@ namespace
             DLIB_TEST(assignment_cost(cost,assign) == true_eval);
         }
 
+        template <typename T>
+        void test_solver()
+        {
+            max_cost_assignment_solver solver;
+            std::vector<long> assign;
+
+            // square integer problems should be solved as well as max_cost_assignment()
+            long size = rnd.get_random_32bit_number()%7;
+            long range = rnd.get_random_32bit_number()%100 + 1;
+            matrix<T> cost = matrix_cast<T>(randm(size,size,rnd)*range) - range/2;
+            const double true_eval = assignment_cost(cost, max_cost_assignment(cost));
+            solver(cost, assign);
+            DLIB_TEST(partial_assignment_cost(cost, assign) == true_eval);
+            DLIB_TEST(std::count(assign.begin(), assign.end(), -1) == 0);
+            solver.use_auction_algorithm();
+            solver.set_num_threads(rnd.get_random_32bit_number()%3 + 1);
+            solver(cost, assign);
+            DLIB_TEST(partial_assignment_cost(cost, assign) == true_eval);
+            DLIB_TEST(std::count(assign.begin(), assign.end(), -1) == 0);
+
+            // rectangular problems
+            long nr = rnd.get_random_32bit_number()%7;
+            long nc = rnd.get_random_32bit_number()%7;
+            cost = matrix_cast<T>(randm(nr,nc,rnd)*range) - range/2;
+            const double rect_eval = brute_force_rectangular_assignment_cost(cost);
+            solver.use_hungarian_algorithm();
+            solver(cost, assign);
+            DLIB_TEST(partial_assignment_cost(cost, assign) == rect_eval);
+            DLIB_TEST(std::count(assign.begin(), assign.end(), -1) == std::max(0L, nr-nc));
+            solver.use_auction_algorithm();
+            solver(cost, assign);
+            DLIB_TEST(partial_assignment_cost(cost, assign) == rect_eval);
+            DLIB_TEST(std::count(assign.begin(), assign.end(), -1) == std::max(0L, nr-nc));
+        }
+
+        void test_solver_float()
+        {
+            max_cost_assignment_solver solver;
+            std::vector<long> assign;
+
+            const long nr = rnd.get_random_32bit_number()%7;
+            const long nc = rnd.get_random_32bit_number()%7;
+            matrix<double> cost = randm(nr,nc,rnd) - 0.5;
+            if ((rnd.get_random_32bit_number()%10) == 0)
+                cost *= 1e6;
+            const double true_eval = brute_force_rectangular_assignment_cost(cost);
+            const double scale = std::max(1.0, cost.size() != 0 ? max(abs(cost)) : 0.0);
+            const double tol = 1e-6*scale;
+
+            solver(cost, assign);
+            DLIB_TEST(std::abs(partial_assignment_cost(cost, assign) - true_eval) < tol);
+            solver(matrix_cast<float>(cost), assign);
+            DLIB_TEST(std::abs(partial_assignment_cost(cost, assign) - true_eval) < 1e-4*scale);
+
+            solver.use_auction_algorithm();
+            solver(cost, assign);
+            DLIB_TEST_MSG(std::abs(partial_assignment_cost(cost, assign) - true_eval) < tol,
+                          partial_assignment_cost(cost, assign) - true_eval);
+        }
+
+        void test_solver_sparse()
+        {
+            max_cost_assignment_solver solver;
+            std::vector<long> assign;
+
+            // Make a random sparse problem along with the equivalent dense problem.  In
+            // the dense problem each row gets its own extra column with a cost of 0 which
+            // it is assigned to when it is left unassigned in the sparse problem.
+            const long nr = rnd.get_random_32bit_number()%20 + 1;
+            const long nc = rnd.get_random_32bit_number()%20 + 1;
+            const double density = rnd.get_random_double();
+            const double missing = -1e9;
+            matrix<double> cost(nr, nc+nr);
+            cost = missing;
+            std::vector<ordered_sample_pair> edges;
+            for (long r = 0; r < nr; ++r)
+            {
+                cost(r, nc+r) = 0;
+                for (long c = 0; c < nc; ++c)
+                {
+                    if (rnd.get_random_double() < density)
+                    {
+                        cost(r,c) = rnd.get_random_32bit_number()%21 - 10.0;
+                        edges.push_back(ordered_sample_pair(r,c,cost(r,c)));
+                    }
+                }
+            }
+            // make sure the last row shows up in edges
+            if (cost(nr-1,0) == missing)
+            {
+                cost(nr-1,0) = -1;
+                edges.push_back(ordered_sample_pair(nr-1,0,-1));
+            }
+            std::random_shuffle(edges.begin(), edges.end());
+
+            solver(cost, assign);
+            const double true_eval = partial_assignment_cost(cost, assign);
+
+            solver(edges, assign);
+            DLIB_TEST(assign.size() == (unsigned long)nr);
+            DLIB_TEST(sparse_assignment_cost(edges, assign) == true_eval);
+
+            edges.clear();
+            solver(edges, assign);
+            DLIB_TEST(assign.size() == 0);
+        }
+
         void perform_test (
         )
         {
@@ -147,6 +336,11 @@ namespace
                 test_hungarian<int>();
                 test_hungarian<long>();
                 test_hungarian<int64>();
+
+                test_solver<int>();
+                test_solver<long>();
+                test_solver_float();
+                test_solver_sparse();
             }
         }
     } a;
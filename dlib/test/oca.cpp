@@ -22,6 +22,42 @@ namespace
 
     logger dlog("test.oca");
 
+// ----------------------------------------------------------------------------------------
+
+    void test_threaded_gram_update (
+    )
+    {
+        // Make a problem big enough that the threaded Gram matrix update is used and
+        // that lots of cutting planes get pruned along the way.
+        typedef matrix<double,0,1> w_type;
+        dlib::rand rnd;
+        std::vector<w_type> x;
+        std::vector<double> y;
+        for (int i = 0; i < 60; ++i)
+        {
+            w_type temp = matrix_cast<double>(randm(10000,1,rnd)) - 0.5;
+            const double label = (i%2)==0 ? +1 : -1;
+            temp(0) += label;
+            x.push_back(temp);
+            y.push_back(label);
+        }
+
+        oca solver;
+        solver.set_inactive_plane_threshold(3);
+        DLIB_TEST(solver.get_num_threads() == 1);
+        w_type w1, w2;
+        const double obj1 = solver(make_oca_problem_c_svm<w_type>(1.0, 1.0, mat(x), mat(y), false, 1e-6, 400), w1);
+
+        solver.set_num_threads(4);
+        DLIB_TEST(solver.get_num_threads() == 4);
+        const double obj2 = solver(make_oca_problem_c_svm<w_type>(1.0, 1.0, mat(x), mat(y), false, 1e-6, 400), w2);
+
+        dlog << LINFO << "obj1: " << obj1;
+        dlog << LINFO << "obj2: " << obj2;
+        DLIB_TEST(std::abs(obj1 - obj2) < 1e-5);
+        DLIB_TEST(max(abs(w1 - w2)) < 1e-3);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     class test_oca : public tester
@@ -191,6 +227,8 @@ namespace
             dlog << LINFO << "error: "<< max(abs(w-true_w));
             DLIB_TEST(max(abs(w-true_w)) < 1e-10);
 
+            print_spinner();
+            test_threaded_gram_update();
         }
 
     } a;
@@ -14,6 +14,31 @@ namespace
     dlib::logger dlog("test.one_vs_all_trainer");
 
 
+    struct binary_trainer_failure {};
+
+    template <typename sample_type_>
+    struct failing_trainer
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is a binary trainer that always throws an exception which isn't
+                derived from std::exception.
+        !*/
+        typedef sample_type_ sample_type;
+        typedef double scalar_type;
+        typedef default_memory_manager mem_manager_type;
+        typedef decision_function<linear_kernel<sample_type> > trained_function_type;
+
+        template <typename T, typename U>
+        trained_function_type train (
+            const T& ,
+            const U& 
+        ) const
+        {
+            throw binary_trainer_failure();
+        }
+    };
+
     class test_one_vs_all_trainer : public tester
     {
         /*!
@@ -167,6 +192,26 @@ namespace
             DLIB_TEST(df(samples[0])  == labels[0])
             DLIB_TEST(df(samples[90])  == labels[90])
 
+            // Training the binary classifiers in parallel shouldn't change anything.
+            {
+                std::vector<typename ova_trainer::subproblem_timing> timing;
+                trainer.set_num_threads(3);
+                one_vs_all_decision_function<ova_trainer> tdf = trainer.train(samples, labels, timing);
+                // The thread pool is reused by later calls and by copies of the trainer.
+                const ova_trainer trainer_copy(trainer);
+                one_vs_all_decision_function<ova_trainer> tdf2 = trainer.train(samples, labels);
+                one_vs_all_decision_function<ova_trainer> tdf3 = trainer_copy.train(samples, labels);
+                trainer.set_num_threads(1);
+                DLIB_TEST(trainer_copy.get_num_threads() == 3);
+                for (unsigned long i = 0; i < samples.size(); ++i)
+                    DLIB_TEST(tdf2(samples[i]) == df(samples[i]) && tdf3(samples[i]) == df(samples[i]));
+                DLIB_TEST(timing.size() == 3);
+                for (unsigned long i = 0; i < timing.size(); ++i)
+                    DLIB_TEST(timing[i].seconds >= 0);
+                for (unsigned long i = 0; i < samples.size(); ++i)
+                    DLIB_TEST(tdf(samples[i]) == df(samples[i]));
+            }
+
 
             one_vs_all_decision_function<ova_trainer, 
                 decision_function<poly_kernel>,  // This is the output of the poly_trainer
@@ -269,9 +314,48 @@ namespace
 
         }
 
+        void test_trainer_exception (
+        )
+        {
+            print_spinner();
+            typedef matrix<double,2,1> sample_type;
+            typedef radial_basis_kernel<sample_type> rbf_kernel;
+            typedef one_vs_all_trainer<any_trainer<sample_type>,double> trainer_type;
+
+            std::vector<sample_type> samples;
+            std::vector<double> labels;
+            generate_data(samples, labels);
+
+            svm_nu_trainer<rbf_kernel> rbf_trainer;
+            rbf_trainer.set_kernel(rbf_kernel(0.1));
+            trainer_type trainer;
+            trainer.set_trainer(rbf_trainer);
+            trainer.set_trainer(failing_trainer<sample_type>(), 3);
+
+            // The exception from the binary trainer should come out with its own type
+            // whether or not we use several threads.
+            for (unsigned long num_threads = 1; num_threads <= 3; num_threads += 2)
+            {
+                trainer.set_num_threads(num_threads);
+                bool caught = false;
+                try
+                {
+                    trainer.train(samples, labels);
+                }
+                catch (binary_trainer_failure&)
+                {
+                    caught = true;
+                }
+                DLIB_TEST(caught);
+            }
+        }
+
         void perform_test (
         )
         {
+            dlog << LINFO << "test_trainer_exception()";
+            test_trainer_exception();
+
             dlog << LINFO << "run_test<double,double>()";
             run_test<double,double>();
 
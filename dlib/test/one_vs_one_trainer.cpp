@@ -15,6 +15,31 @@ namespace
     dlib::logger dlog("test.one_vs_one_trainer");
 
 
+    struct binary_trainer_failure {};
+
+    template <typename sample_type_>
+    struct failing_trainer
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is a binary trainer that always throws an exception which isn't
+                derived from std::exception.
+        !*/
+        typedef sample_type_ sample_type;
+        typedef double scalar_type;
+        typedef default_memory_manager mem_manager_type;
+        typedef decision_function<linear_kernel<sample_type> > trained_function_type;
+
+        template <typename T, typename U>
+        trained_function_type train (
+            const T& ,
+            const U& 
+        ) const
+        {
+            throw binary_trainer_failure();
+        }
+    };
+
     class test_one_vs_one_trainer : public tester
     {
         /*!
@@ -171,6 +196,28 @@ namespace
             DLIB_TEST(df(samples[0])  == labels[0])
             DLIB_TEST(df(samples[90])  == labels[90])
 
+            // Training the binary classifiers in parallel shouldn't change anything.
+            {
+                std::vector<typename ovo_trainer::subproblem_timing> timing;
+                trainer.set_num_threads(3);
+                one_vs_one_decision_function<ovo_trainer> tdf = trainer.train(samples, labels, timing);
+                // The thread pool is reused by later calls and by copies of the trainer.
+                const ovo_trainer trainer_copy(trainer);
+                one_vs_one_decision_function<ovo_trainer> tdf2 = trainer.train(samples, labels);
+                one_vs_one_decision_function<ovo_trainer> tdf3 = trainer_copy.train(samples, labels);
+                trainer.set_num_threads(1);
+                DLIB_TEST(trainer_copy.get_num_threads() == 3);
+                for (unsigned long i = 0; i < samples.size(); ++i)
+                    DLIB_TEST(tdf2(samples[i]) == df(samples[i]) && tdf3(samples[i]) == df(samples[i]));
+                DLIB_TEST(timing.size() == 3);
+                for (unsigned long i = 0; i < timing.size(); ++i)
+                    DLIB_TEST(timing[i].seconds >= 0);
+                for (unsigned long i = 1; i < timing.size(); ++i)
+                    DLIB_TEST(timing[i-1].num_samples >= timing[i].num_samples);
+                for (unsigned long i = 0; i < samples.size(); ++i)
+                    DLIB_TEST(tdf(samples[i]) == df(samples[i]));
+            }
+
 
             one_vs_one_decision_function<ovo_trainer, 
                 decision_function<poly_kernel>,  // This is the output of the poly_trainer
@@ -197,9 +244,113 @@ namespace
 
         }
 
+        template <typename label_type, typename scalar_type>
+        void test_compiled_df (
+        )
+        {
+            print_spinner();
+            typedef matrix<scalar_type,2,1> sample_type;
+            typedef radial_basis_kernel<sample_type> rbf_kernel;
+            typedef one_vs_one_trainer<any_trainer<sample_type,scalar_type>,label_type > ovo_trainer;
+
+            std::vector<sample_type> samples;
+            std::vector<label_type> labels;
+            generate_data(samples, labels);
+
+            svm_nu_trainer<rbf_kernel> rbf_trainer;
+            rbf_trainer.set_kernel(rbf_kernel(0.5));
+            rbf_trainer.set_nu(0.2);
+            ovo_trainer trainer;
+            trainer.set_trainer(rbf_trainer);
+
+            one_vs_one_decision_function<ovo_trainer> df = trainer.train(samples, labels);
+            compiled_one_vs_one_decision_function<rbf_kernel,label_type> cdf(df);
+
+            DLIB_TEST(cdf.number_of_classes() == 3);
+            DLIB_TEST(cdf.get_labels() == df.get_labels());
+
+            // Every support vector shows up in two of the three binary classifiers so
+            // the compiled version should need a lot fewer kernel evaluations.
+            unsigned long total_basis = 0;
+            typedef typename one_vs_one_decision_function<ovo_trainer>::binary_function_table table;
+            for (typename table::const_iterator i = df.get_binary_decision_functions().begin(); 
+                 i != df.get_binary_decision_functions().end(); ++i)
+            {
+                total_basis += any_cast<decision_function<rbf_kernel> >(i->second).basis_vectors.size();
+            }
+            dlog << LINFO << "total basis vectors: " << total_basis << "  distinct: " << cdf.number_of_basis_vectors();
+            DLIB_TEST(cdf.number_of_basis_vectors() < total_basis);
+
+            std::ostringstream sout;
+            serialize(cdf, sout);
+            compiled_one_vs_one_decision_function<rbf_kernel,label_type> cdf2;
+            DLIB_TEST(cdf2.number_of_classes() == 0);
+            std::istringstream sin(sout.str());
+            deserialize(cdf2, sin);
+            DLIB_TEST(cdf2.number_of_basis_vectors() == cdf.number_of_basis_vectors());
+
+            dlib::rand rnd;
+            for (unsigned long i = 0; i < samples.size(); ++i)
+            {
+                DLIB_TEST(cdf(samples[i]) == df(samples[i]));
+                DLIB_TEST(cdf2(samples[i]) == df(samples[i]));
+
+                // also try some points that aren't in the training data
+                sample_type temp;
+                temp(0) = 30*rnd.get_random_double() - 15;
+                temp(1) = 30*rnd.get_random_double() - 15;
+                DLIB_TEST(cdf(temp) == df(temp));
+            }
+        }
+
+        void test_trainer_exception (
+        )
+        {
+            print_spinner();
+            typedef matrix<double,2,1> sample_type;
+            typedef radial_basis_kernel<sample_type> rbf_kernel;
+            typedef one_vs_one_trainer<any_trainer<sample_type>,double> trainer_type;
+
+            std::vector<sample_type> samples;
+            std::vector<double> labels;
+            generate_data(samples, labels);
+
+            svm_nu_trainer<rbf_kernel> rbf_trainer;
+            rbf_trainer.set_kernel(rbf_kernel(0.1));
+            trainer_type trainer;
+            trainer.set_trainer(rbf_trainer);
+            trainer.set_trainer(failing_trainer<sample_type>(), 1, 3);
+
+            // The exception from the binary trainer should come out with its own type
+            // whether or not we use several threads.
+            for (unsigned long num_threads = 1; num_threads <= 3; num_threads += 2)
+            {
+                trainer.set_num_threads(num_threads);
+                bool caught = false;
+                try
+                {
+                    trainer.train(samples, labels);
+                }
+                catch (binary_trainer_failure&)
+                {
+                    caught = true;
+                }
+                DLIB_TEST(caught);
+            }
+        }
+
         void perform_test (
         )
         {
+            dlog << LINFO << "test_trainer_exception()";
+            test_trainer_exception();
+
+            dlog << LINFO << "test_compiled_df<double,double>()";
+            test_compiled_df<double,double>();
+
+            dlog << LINFO << "test_compiled_df<int,float>()";
+            test_compiled_df<int,float>();
+
             dlog << LINFO << "run_test<double,double>()";
             run_test<double,double>();
 
@@ -1182,6 +1182,274 @@ namespace
         off = 1.0; DLIB_TEST(std::abs( poly_min_extrap(off*off, -2*off, (1-off)*(1-off)) - off) < 1e-13); 
     }
 
+// ----------------------------------------------------------------------------------------
+
+    double rastrigin (
+        const matrix<double,0,1>& x
+    )
+    {
+        const double pi = 3.1415926535898;
+        double val = 10*x.size();
+        for (long i = 0; i < x.size(); ++i)
+            val += x(i)*x(i) - 10*std::cos(2*pi*x(i));
+        return val;
+    }
+
+    double rosen_max_objective (
+        const matrix<double,0,1>& x
+    )
+    {
+        // Unlike neg_rosen() this doesn't touch total_count so it's safe to call from
+        // multiple threads.
+        return -test_functions::rosen<double>(x);
+    }
+
+    class counted_function
+    {
+        /*!
+            Evaluates rastrigin() and counts how many times it has been called.  It is
+            safe to use from multiple threads.
+        !*/
+    public:
+        counted_function() : count(0) {}
+
+        double operator() (
+            const matrix<double,0,1>& x
+        ) const
+        {
+            auto_mutex lock(m);
+            ++count;
+            return rastrigin(x);
+        }
+
+        mutable unsigned long count;
+        mutex m;
+    };
+
+    void test_threaded_derivatives()
+    {
+        print_spinner();
+        dlog << LINFO << "test_threaded_derivatives()";
+        dlib::rand rnd;
+        thread_pool tp(3);
+        for (int i = 0; i < 20; ++i)
+        {
+            matrix<double,0,1> x = randm(rnd.get_random_32bit_number()%10 + 1, 1, rnd)*4 - 2;
+            DLIB_TEST(dlib::equal(derivative(rastrigin, 1e-6, tp)(x), derivative(rastrigin, 1e-6)(x), 0));
+            DLIB_TEST(derivative(rastrigin, 1e-6, tp)(x).size() == x.size());
+        }
+        DLIB_TEST(derivative(make_line_search_function(rastrigin, matrix<double,0,1>(ones_matrix<double>(3,1)),
+                                                       matrix<double,0,1>(ones_matrix<double>(3,1))), 1e-6, tp)(0.5) ==
+                  derivative(make_line_search_function(rastrigin, matrix<double,0,1>(ones_matrix<double>(3,1)),
+                                                       matrix<double,0,1>(ones_matrix<double>(3,1))), 1e-6)(0.5));
+
+        // The parallel gradients don't change the result of the optimizer at all.
+        matrix<double,0,1> x(2), x2;
+        x = -1.2, 1;
+        x2 = x;
+        const double val = find_min_using_approximate_derivatives(bfgs_search_strategy(),
+                                                                   objective_delta_stop_strategy(1e-12),
+                                                                   test_functions::rosen<double>, x, -1, 1e-7, tp);
+        const double val2 = find_min_using_approximate_derivatives(bfgs_search_strategy(),
+                                                                   objective_delta_stop_strategy(1e-12),
+                                                                   test_functions::rosen<double>, x2, -1, 1e-7);
+        DLIB_TEST(val == val2);
+        DLIB_TEST(dlib::equal(x, x2, 0));
+        DLIB_TEST_MSG(length(x - matrix<double,2,1>(ones_matrix<double>(2,1))) < 1e-4, x);
+
+        x = 1.5, 0.5;
+        x2 = x;
+        const double max_val = find_max_using_approximate_derivatives(bfgs_search_strategy(),
+                                                                      objective_delta_stop_strategy(1e-12),
+                                                                      rosen_max_objective, x, 1, 1e-7, tp);
+        const double max_val2 = find_max_using_approximate_derivatives(bfgs_search_strategy(),
+                                                                       objective_delta_stop_strategy(1e-12),
+                                                                       rosen_max_objective, x2, 1, 1e-7);
+        DLIB_TEST(max_val == max_val2);
+        DLIB_TEST(dlib::equal(x, x2, 0));
+    }
+
+    void test_function_evaluation_cache()
+    {
+        print_spinner();
+        dlog << LINFO << "test_function_evaluation_cache()";
+        counted_function f;
+        function_evaluation_cache<counted_function> cf(f);
+
+        matrix<double,0,1> x(3), y(3);
+        x = 1, 2, 3;
+        y = 1, 2, 3.5;
+        DLIB_TEST(cf(x) == rastrigin(x));
+        DLIB_TEST(cf(x) == rastrigin(x));
+        DLIB_TEST(cf(y) == rastrigin(y));
+        DLIB_TEST(f.count == 2);
+        DLIB_TEST(cf.number_of_evaluations() == 2);
+        DLIB_TEST(cf.number_of_cache_hits() == 1);
+        DLIB_TEST(cf.size() == 2);
+        cf.clear();
+        DLIB_TEST(cf.size() == 0);
+        DLIB_TEST(cf.number_of_evaluations() == 0);
+        DLIB_TEST(cf(x) == rastrigin(x));
+        DLIB_TEST(f.count == 3);
+
+        // Many runs which start from the same point share most of their evaluations.
+        thread_pool tp(4);
+        cf.clear();
+        f.count = 0;
+        matrix<double,0,1> lower(2), upper(2);
+        lower = -5.12;
+        upper = 5.12;
+        std::vector<matrix<double,0,1> > starts(8, matrix<double,0,1>(2));
+        for (unsigned long i = 0; i < starts.size(); ++i)
+            starts[i] = 3.1, -2.2;
+        const double val = find_min_bobyqa_multistart(cf, starts, x, 5, lower, upper, 1, 1e-8, 1000, tp);
+        DLIB_TEST(val == rastrigin(x));
+        DLIB_TEST(f.count == cf.number_of_evaluations());
+        DLIB_TEST(cf.number_of_cache_hits() >= 7*cf.number_of_evaluations());
+        dlog << LINFO << "evaluations: " << cf.number_of_evaluations() << "  cache hits: " << cf.number_of_cache_hits();
+    }
+
+    void test_bobyqa_multistart()
+    {
+        print_spinner();
+        dlog << LINFO << "test_bobyqa_multistart()";
+        matrix<double,0,1> lower(3), upper(3), x(3), x2(3);
+        lower = -5.12;
+        upper = 5.12;
+        thread_pool tp(3);
+        thread_pool tp0(0);
+
+        // A single run of BOBYQA gets stuck in a local minimum of the rastrigin function.
+        x = 3.1, -2.2, 4.2;
+        const double single_val = find_min_bobyqa(rastrigin, x, 7, lower, upper, 1, 1e-8, 10000);
+
+        x = 3.1, -2.2, 4.2;
+        x2 = x;
+        const double val = find_min_bobyqa_global(rastrigin, x, 40, 7, lower, upper, 1, 1e-8, 10000, tp);
+        const double val2 = find_min_bobyqa_global(rastrigin, x2, 40, 7, lower, upper, 1, 1e-8, 10000, tp0);
+        dlog << LINFO << "single run: " << single_val << "   global search: " << val;
+        DLIB_TEST(val == val2);
+        DLIB_TEST(dlib::equal(x, x2, 0));
+        DLIB_TEST(val <= single_val);
+        DLIB_TEST(val == rastrigin(x));
+        DLIB_TEST_MSG(val < 1, val);
+
+        // The best run is picked out of the given starting points.
+        std::vector<matrix<double,0,1> > starts(3, matrix<double,0,1>(3));
+        starts[0] = 3.1, -2.2, 4.2;
+        starts[1] = 0.1, 0.1, -0.1;
+        starts[2] = 2, 2, 2;
+        const double mval = find_min_bobyqa_multistart(rastrigin, starts, x, 7, lower, upper, 1, 1e-8, 10000, tp);
+        DLIB_TEST(mval == rastrigin(x));
+        DLIB_TEST_MSG(length(x) < 1e-3, x);
+
+        const double maxval = find_max_bobyqa_multistart(negate_function(rastrigin), starts, x2, 7, lower, upper, 1, 1e-8, 10000, tp);
+        DLIB_TEST(maxval == -mval);
+        DLIB_TEST(dlib::equal(x, x2, 0));
+
+        // If all the runs fail we get a bobyqa_failure exception.
+        bool got_exception = false;
+        try
+        {
+            find_min_bobyqa_multistart(rastrigin, starts, x, 7, lower, upper, 1, 1e-8, 5, tp);
+        }
+        catch (bobyqa_failure&)
+        {
+            got_exception = true;
+        }
+        DLIB_TEST(got_exception);
+    }
+
+    struct objective_failure {};
+
+    double rastrigin_throws_above_4 (
+        const matrix<double,0,1>& x
+    )
+    {
+        if (x(0) > 4)
+            throw objective_failure();
+        return rastrigin(x);
+    }
+
+    class throws_once_function
+    {
+        /*!
+            Evaluates rastrigin() but throws objective_failure the first time it is
+            called.  It is safe to use from multiple threads.
+        !*/
+    public:
+        throws_once_function() : has_thrown(false) {}
+
+        double operator() (
+            const matrix<double,0,1>& x
+        ) const
+        {
+            auto_mutex lock(m);
+            if (!has_thrown)
+            {
+                has_thrown = true;
+                throw objective_failure();
+            }
+            return rastrigin(x);
+        }
+
+        mutable bool has_thrown;
+        mutex m;
+    };
+
+    void test_threaded_objective_exceptions()
+    {
+        print_spinner();
+        dlog << LINFO << "test_threaded_objective_exceptions()";
+        matrix<double,0,1> lower(3), upper(3), x(3);
+        lower = -5.12;
+        upper = 5.12;
+        std::vector<matrix<double,0,1> > starts(3, matrix<double,0,1>(3));
+        starts[0] = 0.1, 0.1, -0.1;
+        starts[1] = 4.5, -2.2, 1;
+        starts[2] = 2, 2, 2;
+
+        for (int num_threads = 0; num_threads <= 3; num_threads += 3)
+        {
+            thread_pool tp(num_threads);
+
+            // Exceptions from the objective function reach the caller with their type.
+            bool got_exception = false;
+            try
+            {
+                x = 4 - 1e-7, 1, 1;
+                derivative(rastrigin_throws_above_4, 1e-6, tp)(x);
+            }
+            catch (objective_failure&) { got_exception = true; }
+            DLIB_TEST(got_exception);
+
+            got_exception = false;
+            try
+            {
+                find_min_bobyqa_multistart(rastrigin_throws_above_4, starts, x, 7, lower, upper, 1, 1e-8, 10000, tp);
+            }
+            catch (objective_failure&) { got_exception = true; }
+            DLIB_TEST(got_exception);
+
+            // If f doesn't throw when it is tried again then the failed evaluation or
+            // run is redone and we get the same answer as if f had never thrown.
+            x = 1.5, -0.5, 3;
+            throws_once_function f;
+            DLIB_TEST(dlib::equal(derivative(f, 1e-6, tp)(x), derivative(rastrigin, 1e-6)(x), 0));
+            DLIB_TEST(f.has_thrown);
+
+            matrix<double,0,1> x2;
+            throws_once_function f2;
+            const double val = find_min_bobyqa_multistart(f2, starts, x, 7, lower, upper, 1, 1e-8, 10000, tp);
+            const double val2 = find_min_bobyqa_multistart(rastrigin, starts, x2, 7, lower, upper, 1, 1e-8, 10000, tp);
+            DLIB_TEST(f2.has_thrown);
+            DLIB_TEST(val == val2);
+            DLIB_TEST(dlib::equal(x, x2, 0));
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
     class optimization_tester : public tester
     {
     public:
@@ -1200,6 +1468,10 @@ namespace
             test_box_constrained_optimizers(lbfgs_search_strategy(5));
             test_poly_min_extract_2nd();
             optimization_test();
+            test_threaded_derivatives();
+            test_function_evaluation_cache();
+            test_bobyqa_multistart();
+            test_threaded_objective_exceptions();
         }
     } a;
 
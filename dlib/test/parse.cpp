@@ -5,6 +5,8 @@
 #include <string>
 #include <cstdlib>
 #include <ctime>
+#include <map>
+#include <dlib/rand.h>
 
 #include "tester.h"
 
@@ -202,6 +204,350 @@ namespace
         DLIB_TEST(parse_tree.size() == 0);
     }
 
+// ----------------------------------------------------------------------------------------
+
+    class random_grammar
+    {
+        /*!
+            A randomly generated grammar over num_tags tags.  Each pair of tags can be
+            combined into a few different tags, each with a random score.
+        !*/
+    public:
+        random_grammar (
+            dlib::rand& rnd,
+            long num_tags,
+            double density
+        )
+        {
+            scores.set_size(num_tags*num_tags, num_tags);
+            for (long r = 0; r < scores.nr(); ++r)
+            {
+                for (long c = 0; c < scores.nc(); ++c)
+                {
+                    if (rnd.get_random_double() < density)
+                        scores(r,c) = -rnd.get_random_double()*10;
+                    else
+                        scores(r,c) = 1;
+                }
+            }
+        }
+
+        void operator() (
+            const std::vector<tags>& words,
+            const constituent<tags>& c,
+            std::vector<std::pair<tags,double> >& possible_ids
+        ) const
+        {
+            DLIB_TEST(c.begin < c.k && c.k < c.end && c.end <= words.size());
+            DLIB_TEST(possible_ids.size() == 0);
+            const long row = c.left_tag*scores.nc() + c.right_tag;
+            for (long t = 0; t < scores.nc(); ++t)
+            {
+                // a positive value marks a rule that doesn't exist
+                if (scores(row,t) <= 0)
+                    possible_ids.push_back(make_pair(t, scores(row,t)));
+            }
+        }
+
+        matrix<double> scores;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    typedef std::map<tags, parse_tree_element<tags> > reference_cell;
+
+    unsigned long reference_fill_parse_tree (
+        std::vector<parse_tree_element<tags> >& parse_tree,
+        const tags& tag,
+        const std::vector<std::vector<reference_cell> >& back,
+        long r,
+        long c
+    )
+    {
+        if (r == c)
+            return END_OF_TREE;
+
+        const unsigned long idx = parse_tree.size();
+        const parse_tree_element<tags>& item = back[r][c].find(tag)->second;
+        parse_tree.push_back(item);
+
+        const long k = item.c.k;
+        const unsigned long idx_left  = reference_fill_parse_tree(parse_tree, item.c.left_tag, back, r, k-1);
+        const unsigned long idx_right = reference_fill_parse_tree(parse_tree, item.c.right_tag, back, k, c);
+        parse_tree[idx].left = idx_left;
+        parse_tree[idx].right = idx_right;
+        return idx;
+    }
+
+    template <typename production_rule_function>
+    void reference_find_max_parse_cky (
+        const std::vector<tags>& sequence,
+        const production_rule_function& production_rules,
+        std::vector<parse_tree_element<tags> >& parse_tree
+    )
+    /*!
+        ensures
+            - A simple version of the CKY algorithm which uses a std::map for each chart
+              cell and fills the cells one at a time.  This is how find_max_parse_cky()
+              used to be implemented.
+    !*/
+    {
+        parse_tree.clear();
+        const long n = sequence.size();
+        if (n <= 1)
+            return;
+
+        typedef reference_cell cell;
+        std::vector<std::vector<cell> > back(n, std::vector<cell>(n));
+        for (long r = n-2; r >= 0; --r)
+        {
+            for (long c = r+1; c < n; ++c)
+            {
+                for (long k = r; k < c; ++k)
+                {
+                    cell right, left;
+                    if (k+1 == c)
+                        right[sequence[c]].score = 0;
+                    else
+                        right = back[k+1][c];
+                    if (k == r)
+                        left[sequence[r]].score = 0;
+                    else
+                        left = back[r][k];
+
+                    for (cell::iterator i = right.begin(); i != right.end(); ++i)
+                    {
+                        for (cell::iterator j = left.begin(); j != left.end(); ++j)
+                        {
+                            constituent<tags> con;
+                            con.begin = r;
+                            con.end = c+1;
+                            con.k = k+1;
+                            con.left_tag = j->first;
+                            con.right_tag = i->first;
+                            std::vector<std::pair<tags,double> > possible_tags;
+                            production_rules(sequence, con, possible_tags);
+                            for (unsigned long m = 0; m < possible_tags.size(); ++m)
+                            {
+                                const double score = possible_tags[m].second + i->second.score + j->second.score;
+                                cell::iterator match = back[r][c].find(possible_tags[m].first);
+                                if (match == back[r][c].end() || score > match->second.score)
+                                {
+                                    parse_tree_element<tags>& item = back[r][c][possible_tags[m].first];
+                                    item.c = con;
+                                    item.score = score;
+                                    item.tag = possible_tags[m].first;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // Walk the back pointers.  Like the old find_max_parse_cky() this numbers the
+        // nodes in depth first order, visiting left subtrees before right ones.
+        const cell& root = back[0][n-1];
+        if (root.size() == 0)
+            return;
+        cell::const_iterator best = root.begin();
+        for (cell::const_iterator i = root.begin(); i != root.end(); ++i)
+        {
+            if (i->second.score > best->second.score)
+                best = i;
+        }
+        reference_fill_parse_tree(parse_tree, best->first, back, 0, n-1);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    bool same_parse_trees (
+        std::vector<parse_tree_element<tags> > a,
+        std::vector<parse_tree_element<tags> > b
+    )
+    /*!
+        ensures
+            - returns true if a and b represent the same tree, even if the nodes are
+              stored in different orders.
+    !*/
+    {
+        if (a.size() != b.size())
+            return false;
+        if (a.size() == 0)
+            return true;
+        std::vector<std::pair<unsigned long,unsigned long> > stack;
+        stack.push_back(make_pair(0UL,0UL));
+        while (stack.size() != 0)
+        {
+            const parse_tree_element<tags>& x = a[stack.back().first];
+            const parse_tree_element<tags>& y = b[stack.back().second];
+            stack.pop_back();
+            if (x.tag != y.tag || x.score != y.score || x.c.begin != y.c.begin ||
+                x.c.end != y.c.end || x.c.k != y.c.k || x.c.left_tag != y.c.left_tag ||
+                x.c.right_tag != y.c.right_tag)
+                return false;
+            if ((x.left == END_OF_TREE) != (y.left == END_OF_TREE) ||
+                (x.right == END_OF_TREE) != (y.right == END_OF_TREE))
+                return false;
+            if (x.left != END_OF_TREE)
+                stack.push_back(make_pair(x.left, y.left));
+            if (x.right != END_OF_TREE)
+                stack.push_back(make_pair(x.right, y.right));
+        }
+        return true;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_random_grammars()
+    {
+        dlib::rand rnd;
+        for (int iter = 0; iter < 200; ++iter)
+        {
+            if ((iter%20) == 0)
+                print_spinner();
+
+            const long num_tags = rnd.get_random_32bit_number()%6 + 1;
+            random_grammar grammar(rnd, num_tags, rnd.get_random_double());
+            std::vector<tags> sequence(rnd.get_random_32bit_number()%12);
+            for (unsigned long i = 0; i < sequence.size(); ++i)
+                sequence[i] = rnd.get_random_32bit_number()%num_tags;
+
+            std::vector<parse_tree_element<tags> > parse_tree, parse_tree2;
+            reference_find_max_parse_cky(sequence, grammar, parse_tree);
+            find_max_parse_cky(sequence, grammar, parse_tree2);
+            // Since there are no ties in the scores the output is exactly the same as
+            // before, including the order of the nodes.
+            DLIB_TEST(parse_tree.size() == parse_tree2.size());
+            for (unsigned long i = 0; i < parse_tree.size() && i < parse_tree2.size(); ++i)
+            {
+                const parse_tree_element<tags>& x = parse_tree[i];
+                const parse_tree_element<tags>& y = parse_tree2[i];
+                DLIB_TEST(x.tag == y.tag && x.score == y.score);
+                DLIB_TEST(x.left == y.left && x.right == y.right);
+                DLIB_TEST(x.c.begin == y.c.begin && x.c.end == y.c.end && x.c.k == y.c.k);
+                DLIB_TEST(x.c.left_tag == y.c.left_tag && x.c.right_tag == y.c.right_tag);
+            }
+
+            cky_parse_options options;
+            options.num_threads = rnd.get_random_32bit_number()%3 + 2;
+            find_max_parse_cky(sequence, grammar, parse_tree2, options);
+            DLIB_TEST(same_parse_trees(parse_tree, parse_tree2));
+
+            // pruning which never removes anything
+            options.beam_width = num_tags;
+            options.score_threshold = 1e300;
+            find_max_parse_cky(sequence, grammar, parse_tree2, options);
+            DLIB_TEST(same_parse_trees(parse_tree, parse_tree2));
+
+            // Pruning only keeps the best tag in each cell.  The result is still a
+            // valid parse but might not be the best one.
+            options.beam_width = 1;
+            find_max_parse_cky(sequence, grammar, parse_tree2, options);
+            if (parse_tree2.size() != 0)
+            {
+                DLIB_TEST(parse_tree.size() != 0);
+                DLIB_TEST(parse_tree2[0].score <= parse_tree[0].score);
+                DLIB_TEST(parse_tree2[0].c.begin == 0 && parse_tree2[0].c.end == sequence.size());
+            }
+            std::vector<parse_tree_element<tags> > parse_tree3;
+            options.beam_width = std::numeric_limits<unsigned long>::max();
+            options.score_threshold = 0;
+            find_max_parse_cky(sequence, grammar, parse_tree3, options);
+            DLIB_TEST(same_parse_trees(parse_tree2, parse_tree3));
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    struct grammar_failure {};
+
+    class throwing_grammar
+    {
+        /*!
+            Acts like the given random_grammar except that it throws grammar_failure when
+            asked about the constituent covering words [begin, end).  If only_once is
+            true then it only throws the first time.
+        !*/
+    public:
+        throwing_grammar (
+            const random_grammar& grammar_,
+            unsigned long begin_,
+            unsigned long end_,
+            bool only_once_
+        ) : grammar(grammar_), begin(begin_), end(end_), only_once(only_once_), has_thrown(false) {}
+
+        void operator() (
+            const std::vector<tags>& words,
+            const constituent<tags>& c,
+            std::vector<std::pair<tags,double> >& possible_ids
+        ) const
+        {
+            if (c.begin == begin && c.end == end)
+            {
+                auto_mutex lock(m);
+                if (!only_once || !has_thrown)
+                {
+                    has_thrown = true;
+                    throw grammar_failure();
+                }
+            }
+            grammar(words, c, possible_ids);
+        }
+
+        const random_grammar& grammar;
+        const unsigned long begin;
+        const unsigned long end;
+        const bool only_once;
+        mutable bool has_thrown;
+        mutex m;
+    };
+
+    void test_production_rule_exceptions()
+    {
+        print_spinner();
+        dlib::rand rnd;
+        const long num_tags = 4;
+        random_grammar grammar(rnd, num_tags, 0.5);
+        std::vector<tags> sequence(20);
+        for (unsigned long i = 0; i < sequence.size(); ++i)
+            sequence[i] = rnd.get_random_32bit_number()%num_tags;
+
+        std::vector<parse_tree_element<tags> > parse_tree, parse_tree2;
+        find_max_parse_cky(sequence, grammar, parse_tree);
+
+        for (unsigned long num_threads = 1; num_threads <= 3; num_threads += 2)
+        {
+            cky_parse_options options;
+            options.num_threads = num_threads;
+
+            // The exception thrown by production_rules() gets to us with its type no
+            // matter which thread hit it.
+            bool got_exception = false;
+            try
+            {
+                find_max_parse_cky(sequence, throwing_grammar(grammar, 7, 11, false), parse_tree2, options);
+            }
+            catch (grammar_failure&)
+            {
+                got_exception = true;
+            }
+            DLIB_TEST(got_exception);
+
+            // When production_rules() only throws once the cell is rebuilt and the
+            // parse is the same as if nothing had happened.
+            throwing_grammar once(grammar, 7, 11, true);
+            if (num_threads > 1)
+            {
+                find_max_parse_cky(sequence, once, parse_tree2, options);
+                DLIB_TEST(once.has_thrown);
+                DLIB_TEST(same_parse_trees(parse_tree, parse_tree2));
+            }
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
@@ -222,6 +568,8 @@ namespace
         {
             dotest1();
             dotest2();
+            test_random_grammars();
+            test_production_rule_exceptions();
         }
     } a;
 
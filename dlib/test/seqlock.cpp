@@ -0,0 +1,116 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+
+
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <ctime>
+#include <dlib/misc_api.h>
+#include <dlib/threads.h>
+
+#include "tester.h"
+
+namespace  
+{
+    using namespace test;
+    using namespace dlib;
+    using namespace std;
+
+    logger dlog("test.seqlock");
+
+    struct triple
+    {
+        long a, b, c;
+    };
+
+    class seqlock_tester : public tester, multithreaded_object
+    {
+    public:
+        seqlock_tester (
+        ) :
+            tester ("test_seqlock",
+                    "Runs tests on the seqlock component.")
+        {
+            register_thread(*this, &seqlock_tester::thread_write);
+            register_thread(*this, &seqlock_tester::thread_read);
+            register_thread(*this, &seqlock_tester::thread_read);
+            register_thread(*this, &seqlock_tester::thread_read);
+        }
+
+        seqlock<triple> data;
+        mutex m;
+        bool failure;
+        long num_reads;
+        const static long num_writes = 20000;
+
+        void thread_write ()
+        {
+            for (long i = 1; i <= num_writes; ++i)
+            {
+                triple t;
+                t.a = i;
+                t.b = 2*i;
+                t.c = 3*i;
+                data.write(t);
+            }
+        }
+
+        void thread_read ()
+        {
+            long last = 0;
+            long count = 0;
+            while (last < num_writes)
+            {
+                const triple t = data.read();
+                // Every read must see a value from a single write and values can't go
+                // backwards in time.
+                if (t.b != 2*t.a || t.c != 3*t.a || t.a < last)
+                {
+                    auto_mutex M(m);
+                    failure = true;
+                    break;
+                }
+                last = t.a;
+                ++count;
+            }
+            auto_mutex M(m);
+            num_reads += count;
+        }
+
+        void perform_test (
+        )
+        {
+            seqlock<triple> s;
+            DLIB_TEST(s.get_sequence_number() == 0);
+            triple t = s.read();
+            DLIB_TEST(t.a == 0 && t.b == 0 && t.c == 0);
+            t.a = 1; t.b = 2; t.c = 3;
+            s.write(t);
+            DLIB_TEST(s.get_sequence_number() == 1);
+            triple t2 = triple();
+            DLIB_TEST(s.try_read(t2));
+            DLIB_TEST(t2.a == 1 && t2.b == 2 && t2.c == 3);
+
+            seqlock<int> si(5);
+            DLIB_TEST(si.read() == 5);
+
+            for (int round = 0; round < 3; ++round)
+            {
+                print_spinner();
+                failure = false;
+                num_reads = 0;
+                data.write(triple());
+                start();
+                wait();
+                dlog << LINFO << "num_reads: " << num_reads;
+                DLIB_TEST(failure == false);
+                DLIB_TEST(data.read().a == num_writes);
+            }
+            DLIB_TEST(data.get_sequence_number() == 3*(num_writes+1));
+        }
+
+    } a;
+
+}
+
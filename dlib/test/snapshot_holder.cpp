@@ -0,0 +1,157 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+
+
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+#include <dlib/misc_api.h>
+#include <dlib/threads.h>
+
+#include "tester.h"
+
+namespace  
+{
+    using namespace test;
+    using namespace dlib;
+    using namespace std;
+
+    logger dlog("test.snapshot_holder");
+
+    mutex count_m;
+    long num_alive = 0;
+
+    struct model
+    {
+        /*!
+            A stand in for something like a decision_function.  All the elements of
+            data have the same value while the model is alive and they are poisoned when
+            it is destroyed so readers can tell if they are using a deleted model.
+        !*/
+        model() : data(100, 0) { auto_mutex M(count_m); ++num_alive; }
+        explicit model(long v) : data(100, v) { auto_mutex M(count_m); ++num_alive; }
+        model(const model& item) : data(item.data) { auto_mutex M(count_m); ++num_alive; }
+        ~model() 
+        { 
+            for (unsigned long i = 0; i < data.size(); ++i)
+                data[i] = -1;
+            auto_mutex M(count_m); 
+            --num_alive; 
+        }
+
+        std::vector<long> data;
+    };
+
+    class snapshot_holder_tester : public tester, multithreaded_object
+    {
+    public:
+        snapshot_holder_tester (
+        ) :
+            tester ("test_snapshot_holder",
+                    "Runs tests on the snapshot_holder component.")
+        {
+            register_thread(*this, &snapshot_holder_tester::thread_write);
+            register_thread(*this, &snapshot_holder_tester::thread_read);
+            register_thread(*this, &snapshot_holder_tester::thread_read);
+            register_thread(*this, &snapshot_holder_tester::thread_read);
+        }
+
+        scoped_ptr<snapshot_holder<model> > holder;
+        mutex m;
+        bool failure;
+        bool done;
+        const static long num_versions = 200;
+
+        void thread_write ()
+        {
+            for (long i = 1; i <= num_versions; ++i)
+            {
+                holder->publish(model(i));
+                if (i%20 == 0)
+                    dlib::sleep(1);
+            }
+            auto_mutex M(m);
+            done = true;
+        }
+
+        void thread_read ()
+        {
+            snapshot_holder<model>::reader r(*holder);
+            long last = 0;
+            while (true)
+            {
+                {
+                    snapshot_holder<model>::read_lock lock(r);
+                    const long v = lock->data[0];
+                    // spend a little time using the model so the writer has to wait
+                    // for us sometimes.
+                    for (unsigned long i = 0; i < lock->data.size(); ++i)
+                    {
+                        if (lock->data[i] != v || v < last)
+                        {
+                            auto_mutex M(m);
+                            failure = true;
+                        }
+                    }
+                    last = v;
+                }
+
+                auto_mutex M(m);
+                if (done || failure)
+                    break;
+            }
+        }
+
+        void perform_test (
+        )
+        {
+            {
+                snapshot_holder<model> h(model(3));
+                DLIB_TEST(h.get_shared()->data[0] == 3);
+                DLIB_TEST(h.num_readers() == 0);
+                snapshot_holder<model>::reader r(h);
+                DLIB_TEST(h.num_readers() == 1);
+                DLIB_TEST(r.is_locked() == false);
+                const model& m1 = r.lock();
+                DLIB_TEST(r.is_locked());
+                DLIB_TEST(m1.data[0] == 3);
+                r.unlock();
+                DLIB_TEST(r.is_locked() == false);
+
+                // a version held through get_shared() outlives its replacement
+                shared_ptr_thread_safe<const model> old = h.get_shared();
+                h.publish(model(4));
+                DLIB_TEST(old->data[0] == 3);
+                DLIB_TEST(h.get_shared()->data[0] == 4);
+                {
+                    snapshot_holder<model>::read_lock lock(r);
+                    DLIB_TEST(lock->data[0] == 4);
+                    DLIB_TEST((*lock).data[0] == 4);
+                }
+            }
+            DLIB_TEST(num_alive == 0);
+
+            for (int round = 0; round < 3; ++round)
+            {
+                print_spinner();
+                holder.reset(new snapshot_holder<model>());
+                failure = false;
+                done = false;
+                start();
+                wait();
+                DLIB_TEST(failure == false);
+                DLIB_TEST(holder->num_readers() == 0);
+                DLIB_TEST(holder->get_shared()->data[0] == num_versions);
+                // Only the current version should still be around.
+                DLIB_TEST_MSG(num_alive == 1, num_alive);
+            }
+            holder.reset();
+            DLIB_TEST(num_alive == 0);
+        }
+
+    } a;
+
+}
+
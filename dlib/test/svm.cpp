@@ -16,6 +16,8 @@
 
 #include "tester.h"
 #include <dlib/svm_threaded.h>
+#include <dlib/data_io.h>
+#include <cstdio>
 
 
 namespace  
@@ -633,6 +635,369 @@ namespace
 
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <typename trainer_type>
+    struct set_gamma_and_c
+    {
+        void operator() (
+            trainer_type& trainer,
+            const matrix<double,0,1>& p
+        ) const
+        {
+            trainer.set_kernel(typename trainer_type::kernel_type(p(0)));
+            trainer.set_c(p(1));
+        }
+    };
+
+    template <typename trainer_type>
+    struct set_c
+    {
+        void operator() (
+            trainer_type& trainer,
+            const matrix<double,0,1>& p
+        ) const
+        {
+            trainer.set_c(p(0));
+        }
+    };
+
+    void test_parameter_search()
+    {
+        dlog << LINFO << "   begin test_parameter_search()";
+        print_spinner();
+
+        typedef matrix<double,2,1> sample_type;
+        typedef radial_basis_kernel<sample_type> kernel_type;
+
+        std::vector<sample_type> x;
+        std::vector<double> y;
+        get_checkerboard_problem(x,y, 200, 2);
+
+        svm_c_trainer<kernel_type> trainer;
+        const matrix<double> params = cartesian_product(logspace(log10(10.0), log10(0.01), 3),
+                                                        logspace(log10(1.0), log10(100.0), 3));
+
+        // Without successive halving every setting should get exactly the same score it
+        // gets from a normal cross validation.
+        matrix<double> table = cross_validate_parameter_search_threaded(trainer, set_gamma_and_c<svm_c_trainer<kernel_type> >(), 
+                                                                        params, x, y, 4, 3);
+        DLIB_TEST(table.nr() == params.nc());
+        DLIB_TEST(table.nc() == 3);
+        for (long i = 0; i < params.nc(); ++i)
+        {
+            print_spinner();
+            svm_c_trainer<kernel_type> temp;
+            set_gamma_and_c<svm_c_trainer<kernel_type> >()(temp, colm(params,i));
+            const matrix<double> res = cross_validate_trainer(temp, x, y, 4);
+            dlog << LINFO << "params: " << trans(colm(params,i)) << " cv: " << res << " search: " << rowm(table,i);
+            DLIB_TEST(max(abs(res - colm(rowm(table,i),range(0,1)))) < 1e-10);
+            DLIB_TEST(table(i,2) == 4);
+        }
+
+        // Now with successive halving.  The survivors of each round should have been
+        // tested on 1, 2, or 4 folds and the best setting should be among the ones that
+        // made it all the way.
+        matrix<double> table2 = cross_validate_parameter_search_threaded(trainer, set_gamma_and_c<svm_c_trainer<kernel_type> >(), 
+                                                                         params, x, y, 4, 3, 0.5);
+        dlog << LINFO << "successive halving table: \n" << join_rows(trans(params), table2);
+        long num_full = 0;
+        for (long i = 0; i < table2.nr(); ++i)
+        {
+            DLIB_TEST(table2(i,2) == 1 || table2(i,2) == 2 || table2(i,2) == 4);
+            if (table2(i,2) == 4)
+            {
+                ++num_full;
+                DLIB_TEST(max(abs(rowm(table2,i) - rowm(table,i))) < 1e-10);
+            }
+        }
+        // 9 settings, then 5 after the first round, then 3 after the second.
+        DLIB_TEST(num_full == 3);
+        DLIB_TEST(sum(colm(table2,2) == 1) == 4);
+        DLIB_TEST(sum(colm(table2,2) == 2) == 2);
+
+        // The linear dcd trainer warm starts along increasing values of C.  This should
+        // give the same accuracies as training each setting from scratch, give or take a
+        // test sample or two since the solutions are only equal up to the optimizer's
+        // tolerance.
+        print_spinner();
+        typedef linear_kernel<sample_type> lin_kernel;
+        svm_c_linear_dcd_trainer<lin_kernel> lin_trainer;
+        lin_trainer.set_epsilon(1e-5);
+        const matrix<double> c_values = logspace(log10(0.01), log10(100.0), 5);
+        matrix<double> table3 = cross_validate_parameter_search_threaded(lin_trainer, set_c<svm_c_linear_dcd_trainer<lin_kernel> >(), 
+                                                                         c_values, x, y, 4, 2);
+        for (long i = 0; i < c_values.nc(); ++i)
+        {
+            svm_c_linear_dcd_trainer<lin_kernel> temp(lin_trainer);
+            temp.set_c(c_values(i));
+            const matrix<double> res = cross_validate_trainer(temp, x, y, 4);
+            dlog << LINFO << "C: " << c_values(i) << " cv: " << res << " search: " << rowm(table3,i);
+            DLIB_TEST(max(abs(res - colm(rowm(table3,i),range(0,1)))) < 0.05);
+            DLIB_TEST(table3(i,2) == 4);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    struct failing_shard_loader
+    {
+        /*!
+            Loads shards like binary_shard_loader but throws once fail_at shards have been
+            loaded.  This simulates a training run dying part way through.
+        !*/
+        failing_shard_loader(int* count_, int fail_at_) : count(count_), fail_at(fail_at_) {}
+
+        template <typename sample_type, typename label_type>
+        void operator() (
+            const std::string& file_name,
+            std::vector<sample_type>& samples,
+            std::vector<label_type>& labels
+        ) const 
+        { 
+            if ((*count)++ == fail_at)
+                throw sample_data_io_error("simulated failure");
+            load_sample_shard(file_name, samples, labels); 
+        }
+
+        int* count;
+        int fail_at;
+    };
+
+    class temporary_files : noncopyable
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This makes file names that won't collide with files from other test runs
+                and deletes the files when it is destructed, even if a test fails.
+        !*/
+    public:
+        temporary_files (
+        ) 
+        {
+            timestamper ts;
+            prefix = "svm_test_" + cast_to_string(ts.get_timestamp()) + "_" + 
+                     cast_to_string(reinterpret_cast<std::size_t>(this)) + "_";
+        }
+
+        ~temporary_files (
+        )
+        {
+            for (unsigned long i = 0; i < names.size(); ++i)
+                std::remove(names[i].c_str());
+        }
+
+        std::string make_name (
+            const std::string& name
+        )
+        {
+            names.push_back(prefix + name);
+            return names.back();
+        }
+
+    private:
+        std::string prefix;
+        std::vector<std::string> names;
+    };
+
+    void test_streaming_training()
+    {
+        dlog << LINFO << "   begin test_streaming_training()";
+        print_spinner();
+
+        temporary_files temp_files;
+
+        typedef matrix<double,2,1> sample_type;
+        typedef linear_kernel<sample_type> kernel_type;
+
+        // Make a simple linearly separable problem and split it into shards of varying
+        // size, including an empty one.
+        dlib::rand rnd;
+        std::vector<std::string> files;
+        std::vector<sample_type> all_samples;
+        std::vector<double> all_labels;
+        const unsigned long shard_sizes[] = {100, 37, 0, 250, 13, 90, 1, 120};
+        const unsigned long num_shards = sizeof(shard_sizes)/sizeof(shard_sizes[0]);
+        for (unsigned long i = 0; i < num_shards; ++i)
+        {
+            std::vector<sample_type> samples;
+            std::vector<double> labels;
+            for (unsigned long j = 0; j < shard_sizes[i]; ++j)
+            {
+                sample_type samp;
+                samp = rnd.get_random_gaussian(), rnd.get_random_gaussian();
+                samples.push_back(samp);
+                labels.push_back(samp(0) + 2*samp(1) + 0.1 > 0 ? +1 : -1);
+                all_samples.push_back(samp);
+                all_labels.push_back(labels.back());
+            }
+            files.push_back(temp_files.make_name("shard_" + cast_to_string(i) + ".dat"));
+            save_sample_shard(files.back(), samples, labels);
+        }
+
+        std::vector<sample_type> samples;
+        std::vector<double> labels;
+
+        // When not shuffled the stream should give back the data in order.
+        {
+            sample_shard_stream<sample_type> stream(files);
+            DLIB_TEST(stream.number_of_shards() == num_shards);
+            stream.be_ordered();
+            unsigned long cnt = 0;
+            while (stream.next_minibatch(samples, labels, 17))
+            {
+                DLIB_TEST(samples.size() > 0 && samples.size() <= 17);
+                DLIB_TEST(samples.size() == labels.size());
+                for (unsigned long i = 0; i < samples.size(); ++i)
+                {
+                    DLIB_TEST(cnt < all_samples.size());
+                    DLIB_TEST(samples[i] == all_samples[cnt]);
+                    DLIB_TEST(labels[i] == all_labels[cnt]);
+                    ++cnt;
+                }
+            }
+            DLIB_TEST(cnt == all_samples.size());
+            DLIB_TEST(stream.end_of_pass());
+            DLIB_TEST(stream.shards_completed() == num_shards);
+        }
+
+        // When shuffled each pass should visit every sample exactly once, different passes
+        // should use different orders, and restarting a pass part way through should give
+        // the same samples as the original pass.
+        {
+            print_spinner();
+            sample_shard_stream<sample_type> stream(files);
+            std::vector<std::vector<sample_type> > pass_samples(2);
+            for (unsigned long pass = 0; pass < 2; ++pass)
+            {
+                stream.start_pass(pass);
+                while (stream.next_minibatch(samples, labels, 1000))
+                    pass_samples[pass].insert(pass_samples[pass].end(), samples.begin(), samples.end());
+                DLIB_TEST(pass_samples[pass].size() == all_samples.size());
+
+                double sum0 = 0, sum1 = 0;
+                for (unsigned long i = 0; i < all_samples.size(); ++i)
+                {
+                    sum0 += sum(all_samples[i]);
+                    sum1 += sum(pass_samples[pass][i]);
+                }
+                DLIB_TEST(std::abs(sum0-sum1) < 1e-8);
+            }
+            DLIB_TEST(pass_samples[0] != pass_samples[1]);
+            DLIB_TEST(pass_samples[0] != all_samples);
+
+            stream.start_pass(0, 3);
+            std::vector<sample_type> rest;
+            while (stream.next_minibatch(samples, labels, 10))
+                rest.insert(rest.end(), samples.begin(), samples.end());
+            DLIB_TEST(rest.size() > 0 && rest.size() < all_samples.size());
+            std::vector<sample_type> tail(pass_samples[0].end()-rest.size(), pass_samples[0].end());
+            DLIB_TEST(rest == tail);
+        }
+
+        // A shard that fails to load shouldn't be skipped.  The next call to
+        // next_minibatch() should load it again and carry on with the pass.
+        {
+            print_spinner();
+            int count = 0;
+            sample_shard_stream<sample_type, double, failing_shard_loader> stream(files, failing_shard_loader(&count, 3));
+            stream.be_ordered();
+            unsigned long cnt = 0;
+            int num_failures = 0;
+            while (true)
+            {
+                try
+                {
+                    if (!stream.next_minibatch(samples, labels, 17))
+                        break;
+                }
+                catch (sample_data_io_error&)
+                {
+                    ++num_failures;
+                    DLIB_TEST(num_failures == 1);
+                    continue;
+                }
+                for (unsigned long i = 0; i < samples.size(); ++i)
+                {
+                    DLIB_TEST(cnt < all_samples.size());
+                    DLIB_TEST(samples[i] == all_samples[cnt]);
+                    ++cnt;
+                }
+            }
+            DLIB_TEST(num_failures == 1);
+            DLIB_TEST(cnt == all_samples.size());
+            DLIB_TEST(stream.end_of_pass());
+        }
+
+        // Now train pegasos from the stream.  Training that gets interrupted and resumed
+        // from a checkpoint should give the same answer as an uninterrupted run.
+        print_spinner();
+        svm_pegasos<kernel_type> trainer;
+        trainer.set_lambda(0.001);
+
+        svm_pegasos<kernel_type> trainer1(trainer);
+        {
+            sample_shard_stream<sample_type> stream(files);
+            train_from_sample_stream(trainer1, stream, 3, "", 50);
+        }
+        const decision_function<kernel_type> df1 = trainer1.get_decision_function();
+        const matrix<double> acc = test_binary_decision_function(df1, all_samples, all_labels);
+        dlog << LINFO << "streaming pegasos accuracy: " << acc;
+        DLIB_TEST(acc(0) > 0.9 && acc(1) > 0.9);
+
+        const std::string checkpoint = temp_files.make_name("stream_checkpoint.dat");
+        svm_pegasos<kernel_type> trainer2(trainer);
+        int count = 0;
+        bool failed = false;
+        try
+        {
+            sample_shard_stream<sample_type, double, failing_shard_loader> stream(files, failing_shard_loader(&count, 12));
+            train_from_sample_stream(trainer2, stream, 3, checkpoint, 50);
+        }
+        catch (sample_data_io_error&)
+        {
+            failed = true;
+        }
+        DLIB_TEST(failed);
+
+        svm_pegasos<kernel_type> trainer3(trainer);
+        {
+            sample_shard_stream<sample_type> stream(files);
+            train_from_sample_stream(trainer3, stream, 3, checkpoint, 50);
+        }
+        const decision_function<kernel_type> df3 = trainer3.get_decision_function();
+        for (unsigned long i = 0; i < all_samples.size(); ++i)
+            DLIB_TEST(std::abs(df1(all_samples[i]) - df3(all_samples[i])) < 1e-10);
+
+        // A finished checkpoint should just be loaded.
+        svm_pegasos<kernel_type> trainer4(trainer);
+        {
+            sample_shard_stream<sample_type> stream(files);
+            train_from_sample_stream(trainer4, stream, 3, checkpoint, 50);
+        }
+        const decision_function<kernel_type> df4 = trainer4.get_decision_function();
+        for (unsigned long i = 0; i < all_samples.size(); ++i)
+            DLIB_TEST(std::abs(df1(all_samples[i]) - df4(all_samples[i])) < 1e-10);
+
+        // The same data in the LIBSVM format can be streamed too.
+        {
+            print_spinner();
+            typedef std::map<unsigned long,double> sparse_sample_type;
+            std::vector<std::string> libsvm_files;
+            std::vector<sparse_sample_type> sparse_samples;
+            for (unsigned long i = 0; i < 2; ++i)
+            {
+                libsvm_files.push_back(temp_files.make_name("shard_libsvm_" + cast_to_string(i) + ".txt"));
+                save_libsvm_formatted_data(libsvm_files.back(), all_samples, all_labels);
+            }
+            sample_shard_stream<sparse_sample_type, double, libsvm_shard_loader> stream(libsvm_files);
+            unsigned long cnt = 0;
+            while (stream.next_minibatch(sparse_samples, labels, 100))
+                cnt += sparse_samples.size();
+            DLIB_TEST(cnt == 2*all_samples.size());
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
 
     class svm_tester : public tester
@@ -653,6 +1018,8 @@ namespace
             test_regression();
             test_anomaly_detection();
             test_svm_trainer2();
+            test_parameter_search();
+            test_streaming_training();
         }
     } a;
 
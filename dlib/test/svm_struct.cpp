@@ -81,6 +81,10 @@ namespace
             feature_vector_type& psi
         ) const 
         {
+            // The cache must always stay within its memory budget.
+            DLIB_TEST(this->get_max_cache_memory() == 0 || 
+                      this->get_cache_memory_usage() <= this->get_max_cache_memory());
+
             scalar_type best_val = -std::numeric_limits<scalar_type>::infinity();
             unsigned long best_idx = 0;
 
@@ -139,6 +143,98 @@ namespace
         const long dims;
     };
 
+// ----------------------------------------------------------------------------------------
+
+    template <typename problem_type>
+    class flaky_processing_node : public threaded_object
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This pretends to be a svm_struct_processing_node.  It tells the controller
+                about its data but drops the connection, without answering, the first
+                time it is asked to do any work.  Then it starts a real processing node on
+                the same port.  So the controller has to hand that work to another node.
+        !*/
+    public:
+        typedef typename problem_type::matrix_type matrix_type;
+        typedef typename problem_type::feature_vector_type feature_vector_type;
+        typedef type_safe_union<impl::oracle_request<matrix_type>, bridge_status> tsu_in;
+        typedef type_safe_union<impl::oracle_response<matrix_type>, impl::node_info<matrix_type>, 
+                                impl::node_heartbeat> tsu_out;
+
+        flaky_processing_node (
+            const problem_type& prob_,
+            unsigned short port_,
+            uint64 dataset_id_
+        ) : prob(prob_), port(port_), dataset_id(dataset_id_), in(3), out(3), dropped(false)
+        {
+            b.reset(new bridge(listen_on_port(port), receive(in), transmit(out), 
+                               impl::oracle_bridge_options()));
+            start();
+        }
+
+        ~flaky_processing_node (
+        )
+        {
+            in.disable();
+            wait();
+        }
+
+        bool dropped_work (
+        ) const 
+        { 
+            auto_mutex lock(m);
+            return dropped; 
+        }
+
+    private:
+
+        void thread (
+        )
+        {
+            tsu_in msg;
+            tsu_out temp;
+            while (in.dequeue(msg))
+            {
+                if (msg.template contains<bridge_status>() && 
+                    msg.template get<bridge_status>().is_connected)
+                {
+                    impl::node_info<matrix_type>& info = temp.template get<impl::node_info<matrix_type> >();
+                    info.num_dims = prob.get_num_dimensions();
+                    info.num_samples = prob.get_num_samples();
+                    info.dataset_id = dataset_id;
+                    info.psi_true.set_size(prob.get_num_dimensions(),1);
+                    info.psi_true = 0;
+                    feature_vector_type psi;
+                    for (long i = 0; i < prob.get_num_samples(); ++i)
+                    {
+                        prob.get_truth_joint_feature_vector(i, psi);
+                        subtract_from(info.psi_true, psi);
+                    }
+                    out.enqueue(temp);
+                }
+                else if (msg.template contains<impl::oracle_request<matrix_type> >())
+                {
+                    b.reset();
+                    node.reset(new svm_struct_processing_node(prob, port, 1, dataset_id));
+                    auto_mutex lock(m);
+                    dropped = true;
+                    return;
+                }
+            }
+        }
+
+        const problem_type& prob;
+        const unsigned short port;
+        const uint64 dataset_id;
+        dlib::pipe<tsu_in> in;
+        dlib::pipe<tsu_out> out;
+        scoped_ptr<bridge> b;
+        scoped_ptr<svm_struct_processing_node> node;
+        mutex m;
+        bool dropped;
+    };
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -158,10 +254,12 @@ namespace
 
 
         test_svm_multiclass_linear_trainer2 (
+            bool use_replicas_ = false
         ) :
             C(10),
             eps(1e-4),
-            verbose(false)
+            verbose(false),
+            use_replicas(use_replicas_)
         {
         }
 
@@ -200,9 +298,6 @@ namespace
             problem1.set_max_cache_size(3);
             problem2.set_max_cache_size(0);
 
-            svm_struct_processing_node node1(problem1, 12345, 3);
-            svm_struct_processing_node node2(problem2, 12346, 0);
-
             solver.set_inactive_plane_threshold(50);
             solver.set_subproblem_epsilon(1e-4);
 
@@ -211,9 +306,48 @@ namespace
             controller.set_epsilon(eps);
             if (verbose)
                 controller.be_verbose();
-            controller.add_processing_node("127.0.0.1", 12345);
-            controller.add_processing_node("localhost:12346");
-            svm_objective = controller(solver, weights);
+
+            if (!use_replicas)
+            {
+                // Give one of the nodes a cache budget that is too small for everything
+                // so it has to adapt its eviction threshold as it goes.
+                problem1.set_max_cache_memory(1000);
+                svm_struct_processing_node node1(problem1, 12345, 3);
+                svm_struct_processing_node node2(problem2, 12346, 0);
+
+                controller.add_processing_node("127.0.0.1", 12345);
+                controller.add_processing_node("localhost:12346");
+                svm_objective = controller(solver, weights);
+
+                dlog << LINFO << "node cache evictions: " << problem1.get_num_cache_evictions();
+                DLIB_TEST(problem1.get_num_cache_evictions() > 0);
+                DLIB_TEST(problem1.get_cache_memory_usage() <= 1000);
+            }
+            else
+            {
+                // Put each half of the data on two nodes.  One of the replicas drops its
+                // connection as soon as it gets some work and then comes back as a normal
+                // node.  The controller should give that work to the other replica and
+                // keep going.
+                svm_struct_processing_node node1(problem1, 12345, 1, 1);
+                svm_struct_processing_node node2(problem2, 12346, 0, 2);
+                svm_struct_processing_node node2b(problem2, 12348, 2, 2);
+                flaky_processing_node<test_multiclass_svm_problem<w_type, sample_type, label_type> > flaky(problem1, 12347, 1);
+
+                controller.set_node_timeout(5000);
+                controller.add_processing_node("127.0.0.1", 12345);
+                controller.add_processing_node("127.0.0.1", 12346);
+                controller.add_processing_node("127.0.0.1", 12347);
+                controller.add_processing_node("127.0.0.1", 12348);
+                svm_objective = controller(solver, weights);
+
+                dlog << LINFO << "node failures:      " << controller.get_num_node_failures();
+                dlog << LINFO << "reassigned chunks:  " << controller.get_num_reassigned_chunks();
+                dlog << LINFO << "node reconnections: " << controller.get_num_node_reconnections();
+                DLIB_TEST(flaky.dropped_work());
+                DLIB_TEST(controller.get_num_node_failures() >= 1);
+                DLIB_TEST(controller.get_num_reassigned_chunks() >= 1);
+            }
 
 
 
@@ -230,6 +364,7 @@ namespace
         scalar_type C;
         scalar_type eps;
         bool verbose;
+        bool use_replicas;
         mutable oca solver;
     };
 
@@ -252,10 +387,14 @@ namespace
 
 
         test_svm_multiclass_linear_trainer3 (
+            unsigned long max_staleness_ = 0,
+            uint64 max_cache_memory_ = 0
         ) :
             C(10),
             eps(1e-4),
-            verbose(false)
+            verbose(false),
+            max_staleness(max_staleness_),
+            max_cache_memory(max_cache_memory_)
         {
         }
 
@@ -285,7 +424,18 @@ namespace
             typedef matrix<scalar_type,0,1> w_type;
             w_type weights;
             test_multiclass_svm_problem<w_type, sample_type, label_type> problem(all_samples, all_labels);
-            problem.set_max_cache_size(0);
+            if (max_cache_memory != 0)
+            {
+                problem.set_max_cache_size(10);
+                problem.set_max_cache_memory(max_cache_memory);
+                DLIB_TEST(problem.get_max_cache_memory() == max_cache_memory);
+            }
+            else
+            {
+                problem.set_max_cache_size(0);
+            }
+            problem.set_max_oracle_staleness(max_staleness);
+            DLIB_TEST(problem.get_max_oracle_staleness() == max_staleness);
 
             problem.set_c(C);
             problem.set_epsilon(eps);
@@ -297,6 +447,15 @@ namespace
             solver.set_subproblem_epsilon(1e-4);
             svm_objective = solver(problem, weights);
 
+            if (max_cache_memory != 0)
+            {
+                // The budget is too small to hold everything so some entries must have
+                // been evicted, and the oracle checked the budget was never exceeded.
+                dlog << LINFO << "cache evictions: " << problem.get_num_cache_evictions();
+                DLIB_TEST(problem.get_num_cache_evictions() > 0);
+                DLIB_TEST(problem.get_cache_memory_usage() <= max_cache_memory);
+            }
+
 
             trained_function_type df;
 
@@ -311,6 +470,8 @@ namespace
         scalar_type C;
         scalar_type eps;
         bool verbose;
+        unsigned long max_staleness;
+        uint64 max_cache_memory;
         mutable oca solver;
     };
 
@@ -505,6 +666,84 @@ namespace
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    struct oracle_failure : public error
+    {
+        oracle_failure() : error("oracle failure") {}
+    };
+
+    class throwing_svm_problem : public structural_svm_problem_threaded<matrix<double,0,1> >
+    {
+    public:
+        throwing_svm_problem (
+        ) : structural_svm_problem_threaded<matrix<double,0,1> >(2) {}
+
+        virtual long get_num_dimensions (
+        ) const { return 2; }
+
+        virtual long get_num_samples (
+        ) const { return 20; }
+
+        virtual void get_truth_joint_feature_vector (
+            long ,
+            matrix<double,0,1>& psi
+        ) const 
+        {
+            psi.set_size(2);
+            psi = 0;
+        }
+
+        virtual void separation_oracle (
+            const long idx,
+            const matrix<double,0,1>& ,
+            double& loss,
+            matrix<double,0,1>& psi
+        ) const 
+        {
+            if (idx == 13)
+                throw oracle_failure();
+            loss = 1;
+            psi.set_size(2);
+            psi = 1;
+        }
+    };
+
+    void test_async_oracle_exception (
+    )
+    {
+        print_spinner();
+        throwing_svm_problem problem;
+        problem.set_max_oracle_staleness(2);
+        oca solver;
+        matrix<double,0,1> w;
+
+        // The exception thrown inside the worker threads should come out of the solver
+        // with its original type.
+        bool caught = false;
+        try
+        {
+            solver(problem, w);
+        }
+        catch (oracle_failure&)
+        {
+            caught = true;
+        }
+        DLIB_TEST(caught);
+
+        // The problem object should still be usable afterwards.
+        caught = false;
+        try
+        {
+            solver(problem, w);
+        }
+        catch (oracle_failure&)
+        {
+            caught = true;
+        }
+        DLIB_TEST(caught);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     class test_svm_struct : public tester
@@ -584,6 +823,40 @@ namespace
             DLIB_TEST(max(abs(df1.b - df4.b)) < 1e-2);
             DLIB_TEST(max(abs(df1.b - df5.b)) < 1e-2);
 
+            // The asynchronous oracle mode should find nearly the same solution.
+            test_svm_multiclass_linear_trainer3<kernel_type> trainer6(2);
+            multiclass_linear_decision_function<kernel_type,double> df6;
+            double obj6;
+            df6 = trainer6.train(samples, labels, obj6);
+            print_spinner();
+            dlog << LINFO << "obj6: "<< obj6;
+            DLIB_TEST(std::abs(obj6 - true_obj) < 1e-2);
+            DLIB_TEST(max(abs(df1.weights - df6.weights)) < 1e-2);
+            DLIB_TEST(max(abs(df1.b - df6.b)) < 1e-2);
+
+            // Run the distributed solver with replicated data while one of the nodes
+            // drops its work and comes back.
+            test_svm_multiclass_linear_trainer2<kernel_type> trainer8(true);
+            multiclass_linear_decision_function<kernel_type,double> df8;
+            double obj8;
+            df8 = trainer8.train(samples, labels, obj8);
+            print_spinner();
+            dlog << LINFO << "obj8: "<< obj8;
+            DLIB_TEST(std::abs(obj8 - true_obj) < 1e-2);
+            DLIB_TEST(max(abs(df1.weights - df8.weights)) < 1e-2);
+            DLIB_TEST(max(abs(df1.b - df8.b)) < 1e-2);
+
+            // Use a cache with a memory budget too small to hold everything.
+            test_svm_multiclass_linear_trainer3<kernel_type> trainer7(0, 2000);
+            multiclass_linear_decision_function<kernel_type,double> df7;
+            double obj7;
+            df7 = trainer7.train(samples, labels, obj7);
+            print_spinner();
+            dlog << LINFO << "obj7: "<< obj7;
+            DLIB_TEST(std::abs(obj7 - true_obj) < 1e-2);
+            DLIB_TEST(max(abs(df1.weights - df7.weights)) < 1e-2);
+            DLIB_TEST(max(abs(df1.b - df7.b)) < 1e-2);
+
             matrix<double> res = test_multiclass_decision_function(df1, samples, labels);
             dlog << LINFO << res;
             dlog << LINFO << "accuracy: " << sum(diag(res))/sum(res);
@@ -629,6 +902,8 @@ namespace
             dlog << LINFO << "test with 2 sample per class";
             make_dataset(samples, labels, 2, rnd);
             run_test(samples, labels, 0.444);
+
+            test_async_oracle_exception();
         }
     } a;
 
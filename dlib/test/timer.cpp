@@ -6,6 +6,7 @@
 #include <string>
 #include <cstdlib>
 #include <ctime>
+#include <vector>
 
 #include <dlib/timer.h>
 #include <dlib/timeout.h>
@@ -318,6 +319,114 @@ namespace
 
 
 
+    class timeout_test_helper
+    {
+    public:
+        timeout_test_helper(
+            unsigned long n
+        ) : count(0), fire_time(n,0), start_time(0) {}
+
+        mutex m;
+        unsigned long count;
+        std::vector<dlib::uint64> fire_time;
+        dlib::uint64 start_time;
+        dlib::timestamper ts;
+
+        void fire(unsigned long idx)
+        {
+            auto_mutex M(m);
+            ++count;
+            fire_time[idx] = ts.get_timestamp();
+        }
+    };
+
+    void timeout_batch_test (
+    )
+    /*!
+        ensures
+            - checks that a lot of timeout objects with different delays all fire once
+              and not before their delay has elapsed.
+    !*/
+    {
+        const unsigned long num = 1000;
+        timeout_test_helper h(num);
+        std::vector<unsigned long> delays(num);
+        std::vector<timeout*> timeouts(num);
+        h.start_time = h.ts.get_timestamp();
+        for (unsigned long i = 0; i < num; ++i)
+        {
+            // Use delays that end up in the first two levels of the timing wheel.
+            delays[i] = (i*37)%700;
+            timeouts[i] = new timeout(h, &timeout_test_helper::fire, delays[i], i);
+        }
+
+        dlib::sleep(1500);
+        print_spinner();
+
+        {
+            auto_mutex M(h.m);
+            DLIB_TEST_MSG(h.count == num, h.count);
+            for (unsigned long i = 0; i < num; ++i)
+            {
+                DLIB_TEST(h.fire_time[i] != 0);
+                // timers trigger on millisecond ticks so they can go off up to 1ms early
+                DLIB_TEST_MSG(h.fire_time[i] + 1000 >= h.start_time + delays[i]*1000,
+                    "delay: " << delays[i] << "  actual: " << (h.fire_time[i]-h.start_time)/1000.0);
+            }
+        }
+
+        for (unsigned long i = 0; i < num; ++i)
+            delete timeouts[i];
+        DLIB_TEST(h.count == num);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void timer_wheel_test (
+    )
+    /*!
+        ensures
+            - runs tests on scheduling, rescheduling, and canceling many active timers
+              which are spread over all the levels of the timing wheel.
+    !*/
+    {
+        typedef timer<timer_test_helper> timer_t;
+        const unsigned long num = 2000;
+        timer_test_helper h;
+        std::vector<timer_t*> timers(num);
+        for (unsigned long i = 0; i < num; ++i)
+        {
+            timers[i] = new timer_t(h, &timer_test_helper::add);
+            // spread the timers between 1 minute and 2 days so they cover all the
+            // levels of the timing wheel.
+            timers[i]->set_delay_time(60000 + (i*7919*50)%(2*24*3600*1000UL));
+        }
+        print_spinner();
+
+        for (unsigned long i = 0; i < num; ++i)
+            timers[i]->start();
+        for (unsigned long i = 0; i < num; ++i)
+            DLIB_TEST(timers[i]->is_running());
+
+        for (unsigned long i = 0; i < num; ++i)
+            timers[i]->set_delay_time(30000 + (i*104729*50)%(24*3600*1000UL));
+        for (unsigned long i = 0; i < num; ++i)
+            DLIB_TEST(timers[i]->is_running());
+        print_spinner();
+
+        for (unsigned long i = 0; i < num; ++i)
+            timers[i]->stop();
+
+        for (unsigned long i = 0; i < num; ++i)
+        {
+            DLIB_TEST(timers[i]->is_running() == false);
+            delete timers[i];
+        }
+        DLIB_TEST(h.count == 0);
+    }
+
+// ----------------------------------------------------------------------------------------
+
     class timer_tester : public tester
     {
     public:
@@ -339,6 +448,11 @@ namespace
             timer_test<timer<timer_test_helper> >  ();
             dlog << LINFO << "testing timer with test_timer2";
             timer_test2<timer<timer_test_helper> >  ();
+
+            dlog << LINFO << "testing timeout with timeout_batch_test";
+            timeout_batch_test();
+            dlog << LINFO << "testing timer with timer_wheel_test";
+            timer_wheel_test();
         }
     } a;
 
@@ -17,6 +17,9 @@
 #include "threads/thread_pool_extension.h"
 #include "threads/read_write_mutex_extension.h"
 #include "threads/parallel_for_extension.h"
+#include "threads/memory_barrier_extension.h"
+#include "threads/seqlock_extension.h"
+#include "threads/snapshot_holder_extension.h"
 
 #endif // DLIB_THREADs_
 
@@ -0,0 +1,40 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_MEMORY_BARRIER_EXTENSIOn_
+#define DLIB_MEMORY_BARRIER_EXTENSIOn_
+
+#include "memory_barrier_extension_abstract.h"
+#include "threads_kernel.h"
+
+#if !defined(__GNUC__) && defined(_MSC_VER)
+#include "../windows_magic.h"
+#include <windows.h>
+#endif
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    inline void memory_barrier (
+    )
+    {
+#if defined(__GNUC__)
+        __sync_synchronize();
+#elif defined(_MSC_VER)
+        MemoryBarrier();
+#else
+        // Locking and unlocking a mutex is a full memory barrier on every platform
+        // dlib supports, so fall back to that if we don't know how to do it directly.
+        static mutex m;
+        m.lock();
+        m.unlock();
+#endif
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_MEMORY_BARRIER_EXTENSIOn_
+
@@ -0,0 +1,28 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_MEMORY_BARRIER_EXTENSIOn_ABSTRACT_
+#ifdef DLIB_MEMORY_BARRIER_EXTENSIOn_ABSTRACT_
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    void memory_barrier (
+    );
+    /*!
+        ensures
+            - Acts as a full memory barrier.  That is, all memory reads and writes
+              issued by the calling thread before the call are completed and visible
+              to other threads before any reads or writes issued after the call.  This
+              also prevents the compiler from moving memory accesses across the call.
+            - This is a low level tool used to build objects like the seqlock and
+              snapshot_holder.  Most code should use a mutex instead.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_MEMORY_BARRIER_EXTENSIOn_ABSTRACT_
+
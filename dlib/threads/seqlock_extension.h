@@ -0,0 +1,115 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_SEQLOCK_EXTENSIOn_
+#define DLIB_SEQLOCK_EXTENSIOn_
+
+#include "seqlock_extension_abstract.h"
+#include "threads_kernel.h"
+#include "auto_mutex_extension.h"
+#include "memory_barrier_extension.h"
+#include "../algs.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename T
+        >
+    class seqlock
+    {
+        /*!
+            INITIAL VALUE
+                - seq == 0
+                - item == T()
+
+            CONVENTION
+                - get_sequence_number() == seq/2
+                - if (seq is odd) then
+                    - a writer is in the middle of modifying item
+                - write_m is held by writers so that only one modifies item at a time.
+                  Readers never touch write_m or any other shared state other than
+                  seq and item, and they only ever read those.
+        !*/
+
+    public:
+
+        seqlock (
+        ) : seq(0), item() {}
+
+        explicit seqlock (
+            const T& init
+        ) : seq(0), item(init) {}
+
+        T read (
+        ) const
+        {
+            T temp;
+            read(temp);
+            return temp;
+        }
+
+        void read (
+            T& out
+        ) const
+        {
+            while (true)
+            {
+                const unsigned long s1 = seq;
+                if ((s1&1) == 0)
+                {
+                    memory_barrier();
+                    out = item;
+                    memory_barrier();
+                    if (seq == s1)
+                        return;
+                }
+            }
+        }
+
+        bool try_read (
+            T& out
+        ) const
+        {
+            const unsigned long s1 = seq;
+            if ((s1&1) != 0)
+                return false;
+            memory_barrier();
+            out = item;
+            memory_barrier();
+            return seq == s1;
+        }
+
+        void write (
+            const T& new_value
+        )
+        {
+            auto_mutex M(write_m);
+            seq = seq + 1;
+            memory_barrier();
+            item = new_value;
+            memory_barrier();
+            seq = seq + 1;
+        }
+
+        unsigned long get_sequence_number (
+        ) const { return seq/2; }
+
+    private:
+
+        volatile unsigned long seq;
+        T item;
+        mutex write_m;
+
+        // restricted functions
+        seqlock(const seqlock&);        // copy constructor
+        seqlock& operator=(const seqlock&);    // assignment operator
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_SEQLOCK_EXTENSIOn_
+
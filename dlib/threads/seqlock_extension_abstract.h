@@ -0,0 +1,125 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_SEQLOCK_EXTENSIOn_ABSTRACT_
+#ifdef DLIB_SEQLOCK_EXTENSIOn_ABSTRACT_
+
+#include "threads_kernel_abstract.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename T
+        >
+    class seqlock
+    {
+        /*!
+            REQUIREMENTS ON T
+                - T must be a POD type (e.g. a struct of numbers).  In particular, it
+                  must be safe to copy a T while another thread is writing to it, since
+                  readers may do that before discovering they need to retry.
+
+            INITIAL VALUE
+                - read() == T()
+                - get_sequence_number() == 0
+
+            WHAT THIS OBJECT REPRESENTS
+                This object is a sequence lock protecting a small value of type T.  It
+                is intended for data that is read very often and written rarely, such as
+                a set of counters or configuration values.  
+
+                Readers never write to any shared memory.  Instead, they read a sequence
+                number, copy the value, and then check that the sequence number didn't
+                change while they were copying.  If it did then they simply try again.
+                So any number of readers can proceed in parallel without contending for
+                cache lines, and a writer is never blocked by readers.  Writers are
+                serialized with respect to each other by an internal mutex.
+
+            THREAD SAFETY
+                All methods of this class are thread safe.
+        !*/
+
+    public:
+
+        seqlock (
+        );
+        /*!
+            ensures
+                - #*this is properly initialized
+            throws
+                - dlib::thread_error
+        !*/
+
+        explicit seqlock (
+            const T& init
+        );
+        /*!
+            ensures
+                - #*this is properly initialized
+                - #read() == init
+            throws
+                - dlib::thread_error
+        !*/
+
+        T read (
+        ) const;
+        /*!
+            ensures
+                - returns a consistent copy of the most recently written value.  That
+                  is, the returned value is never a mix of two different write() calls.
+                - This function spins while a write() is in progress.
+        !*/
+
+        void read (
+            T& out
+        ) const;
+        /*!
+            ensures
+                - #out == read()
+        !*/
+
+        bool try_read (
+            T& out
+        ) const;
+        /*!
+            ensures
+                - Attempts to read the value just once without retrying.
+                - if (no write() happened while the value was being copied) then
+                    - #out == a consistent copy of the most recently written value
+                    - returns true
+                - else
+                    - returns false and #out is in an unspecified state
+        !*/
+
+        void write (
+            const T& new_value
+        );
+        /*!
+            ensures
+                - #read() == new_value
+                - #get_sequence_number() == get_sequence_number() + 1
+        !*/
+
+        unsigned long get_sequence_number (
+        ) const;
+        /*!
+            ensures
+                - returns the number of times write() has been called on this object.
+                  (This count wraps around to 0 if it overflows.)
+        !*/
+
+    private:
+
+        // restricted functions
+        seqlock(const seqlock&);        // copy constructor
+        seqlock& operator=(const seqlock&);    // assignment operator
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_SEQLOCK_EXTENSIOn_ABSTRACT_
+
@@ -0,0 +1,285 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_SNAPSHOT_HOLDER_EXTENSIOn_
+#define DLIB_SNAPSHOT_HOLDER_EXTENSIOn_
+
+#include "snapshot_holder_extension_abstract.h"
+#include "threads_kernel.h"
+#include "auto_mutex_extension.h"
+#include "memory_barrier_extension.h"
+#include "../algs.h"
+#include "../assert.h"
+#include "../misc_api.h"
+#include "../smart_pointers_thread_safe.h"
+#include <vector>
+#include <algorithm>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename T
+        >
+    class snapshot_holder
+    {
+        /*!
+            INITIAL VALUE
+                - cur_sp == a pointer to a default constructed T
+                - cur == cur_sp.get()
+                - epoch == 1
+                - slots.size() == 0
+
+            CONVENTION
+                - cur_sp == get_shared()
+                - cur == cur_sp.get().  This is the pointer readers look at and it is
+                  only ever assigned while m is locked.
+                - epoch == the number of times publish() has been called plus one.  It
+                  is never 0.
+                - slots == the reader_slot objects of all the reader objects currently
+                  attached to *this.  Each slot lives on its own cache line and is only
+                  ever written by the thread using that reader, except for its
+                  registration which happens while m is locked.
+                - for all slots S:
+                    - if (S->active_epoch == 0) then
+                        - the reader that owns S doesn't have a snapshot locked.
+                    - else
+                        - the reader might be using the object cur pointed to when 
+                          epoch == S->active_epoch.  So publish() must not release that
+                          object until S->active_epoch changes.
+        !*/
+
+        struct reader_slot
+        {
+            reader_slot() : active_epoch(0) {}
+            // pad things out so each slot has its own cache line
+            char pad1[64];
+            volatile unsigned long active_epoch;
+            char pad2[64];
+        };
+
+    public:
+
+        class reader
+        {
+            /*!
+                CONVENTION
+                    - holder == the snapshot_holder this reader is attached to
+                    - slot == the reader_slot registered with holder for this reader
+                    - lock_count == the number of nested lock() calls outstanding
+            !*/
+        public:
+            explicit reader (
+                const snapshot_holder& holder_
+            ) : holder(holder_), lock_count(0)
+            {
+                slot = holder.register_slot();
+            }
+
+            ~reader (
+            )
+            {
+                DLIB_ASSERT(lock_count == 0,
+                    "\t snapshot_holder::reader::~reader()"
+                    << "\n\t You can't destroy a reader that still has a snapshot locked."
+                    << "\n\t this: " << this
+                    );
+                holder.unregister_slot(slot);
+            }
+
+            const T& lock (
+            )
+            {
+                if (lock_count++ == 0)
+                {
+                    slot->active_epoch = holder.epoch;
+                    // Make sure publish() can see we are active before we look at cur.
+                    // This is the only synchronization a reader does and it doesn't
+                    // touch any memory shared with other readers.
+                    memory_barrier();
+                }
+                return *holder.cur;
+            }
+
+            void unlock (
+            )
+            {
+                DLIB_ASSERT(lock_count > 0,
+                    "\t void snapshot_holder::reader::unlock()"
+                    << "\n\t You can't unlock a reader that isn't locked."
+                    << "\n\t this: " << this
+                    );
+                if (--lock_count == 0)
+                {
+                    memory_barrier();
+                    slot->active_epoch = 0;
+                }
+            }
+
+            bool is_locked (
+            ) const { return lock_count != 0; }
+
+        private:
+            const snapshot_holder& holder;
+            reader_slot* slot;
+            unsigned long lock_count;
+
+            // restricted functions
+            reader(const reader&);        // copy constructor
+            reader& operator=(const reader&);    // assignment operator
+        };
+
+        class read_lock
+        {
+        public:
+            explicit read_lock (
+                reader& r_
+            ) : r(r_), item(r_.lock()) {}
+
+            ~read_lock (
+            ) { r.unlock(); }
+
+            const T& get (
+            ) const { return item; }
+
+            const T* operator-> (
+            ) const { return &item; }
+
+            const T& operator* (
+            ) const { return item; }
+
+        private:
+            reader& r;
+            const T& item;
+
+            // restricted functions
+            read_lock(const read_lock&);        // copy constructor
+            read_lock& operator=(const read_lock&);    // assignment operator
+        };
+
+        snapshot_holder (
+        ) : 
+            cur_sp(new T),
+            epoch(1)
+        {
+            cur = cur_sp.get();
+        }
+
+        explicit snapshot_holder (
+            const T& init
+        ) : 
+            cur_sp(new T(init)),
+            epoch(1)
+        {
+            cur = cur_sp.get();
+        }
+
+        ~snapshot_holder (
+        )
+        {
+            DLIB_ASSERT(slots.size() == 0,
+                "\t snapshot_holder::~snapshot_holder()"
+                << "\n\t You must destroy all the readers before the snapshot_holder."
+                << "\n\t this: " << this
+                );
+        }
+
+        void publish (
+            const T& new_version
+        )
+        {
+            shared_ptr_thread_safe<const T> temp(new T(new_version));
+            publish(temp);
+        }
+
+        void publish (
+            const shared_ptr_thread_safe<const T>& new_version
+        )
+        {
+            DLIB_ASSERT(new_version,
+                "\t void snapshot_holder::publish()"
+                << "\n\t You can't publish a null pointer."
+                << "\n\t this: " << this
+                );
+
+            shared_ptr_thread_safe<const T> old;
+            auto_mutex M(m);
+            old = cur_sp;
+            cur_sp = new_version;
+            cur = cur_sp.get();
+            memory_barrier();
+            unsigned long new_epoch = epoch + 1;
+            if (new_epoch == 0)
+                new_epoch = 1;
+            epoch = new_epoch;
+            memory_barrier();
+
+            // Now wait for a grace period.  That is, until every reader has either
+            // unlocked or locked again after seeing the new object.  
+            for (unsigned long i = 0; i < slots.size(); ++i)
+            {
+                while (true)
+                {
+                    const unsigned long e = slots[i]->active_epoch;
+                    if (e == 0 || e == new_epoch)
+                        break;
+                    dlib::sleep(1);
+                }
+            }
+            // old gets released when this function returns.  If someone got it from
+            // get_shared() then it stays alive until they are done with it.
+        }
+
+        shared_ptr_thread_safe<const T> get_shared (
+        ) const
+        {
+            auto_mutex M(m);
+            return cur_sp;
+        }
+
+        unsigned long num_readers (
+        ) const
+        {
+            auto_mutex M(m);
+            return slots.size();
+        }
+
+    private:
+
+        reader_slot* register_slot (
+        ) const
+        {
+            reader_slot* s = new reader_slot;
+            auto_mutex M(m);
+            try { slots.push_back(s); }
+            catch (...) { delete s; throw; }
+            return s;
+        }
+
+        void unregister_slot (
+            reader_slot* s
+        ) const
+        {
+            auto_mutex M(m);
+            slots.erase(std::find(slots.begin(), slots.end(), s));
+            delete s;
+        }
+
+        shared_ptr_thread_safe<const T> cur_sp;
+        const T* volatile cur;
+        volatile unsigned long epoch;
+        mutable std::vector<reader_slot*> slots;
+        mutex m;
+
+        // restricted functions
+        snapshot_holder(const snapshot_holder&);        // copy constructor
+        snapshot_holder& operator=(const snapshot_holder&);    // assignment operator
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_SNAPSHOT_HOLDER_EXTENSIOn_
+
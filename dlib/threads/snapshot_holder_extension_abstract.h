@@ -0,0 +1,250 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_SNAPSHOT_HOLDER_EXTENSIOn_ABSTRACT_
+#ifdef DLIB_SNAPSHOT_HOLDER_EXTENSIOn_ABSTRACT_
+
+#include "threads_kernel_abstract.h"
+#include "../smart_pointers_thread_safe.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename T
+        >
+    class snapshot_holder
+    {
+        /*!
+            REQUIREMENTS ON T
+                - T must be copy constructable and default constructable.
+
+            INITIAL VALUE
+                - *get_shared() == T()
+                - num_readers() == 0
+
+            WHAT THIS OBJECT REPRESENTS
+                This object holds the current version of some read-mostly object, for
+                example a decision_function or object_detector that gets reloaded from
+                time to time while many threads are using it.  It works like read-copy-
+                update (RCU).  That is, writers never modify the object readers are
+                looking at.  Instead, they publish() a whole new version and the old one
+                is deleted once no reader can still be using it.
+
+                To read the object a thread creates a reader attached to the
+                snapshot_holder and then locks it.  Locking and unlocking a reader only
+                writes to memory owned by that reader, so unlike a read_write_mutex,
+                readers in different threads don't contend for shared cache lines.  The
+                price is paid by publish(), which has to wait until all the readers
+                which might be looking at the old version have unlocked.
+
+                If you want to hold on to a version for a long time you can instead use
+                get_shared().  It returns a reference counted pointer which keeps that
+                version alive for as long as you hold it, but it does lock a mutex.
+
+            THREAD SAFETY
+                All methods of this class are thread safe.  However, each reader object
+                must only be used by one thread at a time.
+
+            EXAMPLE
+                snapshot_holder<model_type> models;
+
+                // In each worker thread:
+                snapshot_holder<model_type>::reader r(models);
+                while (more work)
+                {
+                    snapshot_holder<model_type>::read_lock lock(r);
+                    use(*lock);
+                }
+
+                // Somewhere else:
+                models.publish(new_model);
+        !*/
+
+    public:
+
+        class reader
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is a handle a thread uses to read the object in a
+                    snapshot_holder.  Create one per thread and keep it around since
+                    constructing and destroying readers locks a mutex.
+            !*/
+        public:
+            explicit reader (
+                const snapshot_holder& holder
+            );
+            /*!
+                ensures
+                    - #*this is attached to holder
+                    - #is_locked() == false
+                throws
+                    - std::bad_alloc
+            !*/
+
+            ~reader (
+            );
+            /*!
+                requires
+                    - is_locked() == false
+                ensures
+                    - detaches *this from its snapshot_holder
+            !*/
+
+            const T& lock (
+            );
+            /*!
+                ensures
+                    - returns a reference to the version of the object that was current
+                      when this function was called.  The reference stays valid until
+                      the matching call to unlock().  
+                    - #is_locked() == true
+                    - Calls to lock() may be nested.  Only the outermost lock() looks
+                      up the current version.
+            !*/
+
+            void unlock (
+            );
+            /*!
+                requires
+                    - is_locked() == true
+                ensures
+                    - undoes one call to lock().  Once every lock() has been undone the
+                      reference returned by lock() must not be used anymore.
+            !*/
+
+            bool is_locked (
+            ) const;
+            /*!
+                ensures
+                    - returns true if lock() has been called more times than unlock()
+            !*/
+        };
+
+        class read_lock
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is a RAII helper that calls r.lock() in its constructor and
+                    r.unlock() in its destructor.
+            !*/
+        public:
+            explicit read_lock (
+                reader& r
+            );
+            /*!
+                ensures
+                    - calls r.lock()
+                    - #get() == the reference returned by r.lock()
+            !*/
+
+            ~read_lock (
+            );
+            /*!
+                ensures
+                    - calls r.unlock()
+            !*/
+
+            const T& get (
+            ) const;
+            const T* operator-> (
+            ) const;
+            const T& operator* (
+            ) const;
+            /*!
+                ensures
+                    - these all provide access to the locked version of the object
+            !*/
+        };
+
+        snapshot_holder (
+        );
+        /*!
+            ensures
+                - #*this is properly initialized
+            throws
+                - std::bad_alloc
+                - dlib::thread_error
+        !*/
+
+        explicit snapshot_holder (
+            const T& init
+        );
+        /*!
+            ensures
+                - #*this is properly initialized
+                - #*get_shared() == init 
+            throws
+                - std::bad_alloc
+                - dlib::thread_error
+        !*/
+
+        ~snapshot_holder (
+        );
+        /*!
+            requires
+                - num_readers() == 0
+            ensures
+                - all resources associated with *this have been released
+        !*/
+
+        void publish (
+            const T& new_version
+        );
+        /*!
+            requires
+                - The calling thread does not have a reader attached to *this locked.
+                  (otherwise this function would wait on itself forever)
+            ensures
+                - makes a copy of new_version and then performs publish() on it as
+                  described below.
+        !*/
+
+        void publish (
+            const shared_ptr_thread_safe<const T>& new_version
+        );
+        /*!
+            requires
+                - new_version != 0
+                - The calling thread does not have a reader attached to *this locked.
+                  (otherwise this function would wait on itself forever)
+            ensures
+                - #get_shared() == new_version
+                - Any reader that calls lock() after this function has started will
+                  get *new_version.
+                - This function doesn't return until every reader that locked the
+                  previous version has unlocked.  Then the reference to the previous
+                  version held by *this is released.  Therefore, if nothing else holds
+                  a pointer to it, the previous version is deleted.
+                - Calls to publish() are serialized.
+        !*/
+
+        shared_ptr_thread_safe<const T> get_shared (
+        ) const;
+        /*!
+            ensures
+                - returns a pointer to the current version of the object
+        !*/
+
+        unsigned long num_readers (
+        ) const;
+        /*!
+            ensures
+                - returns the number of reader objects attached to *this
+        !*/
+
+    private:
+
+        // restricted functions
+        snapshot_holder(const snapshot_holder&);        // copy constructor
+        snapshot_holder& operator=(const snapshot_holder&);    // assignment operator
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_SNAPSHOT_HOLDER_EXTENSIOn_ABSTRACT_
+
@@ -4,6 +4,7 @@
 #define DLIB_TIMER_cPP__
 
 #include "timer.h"
+#include <limits>
 
 namespace dlib
 {
@@ -13,10 +14,16 @@ namespace dlib
     timer_global_clock::
     timer_global_clock(
     ): 
+        num_timers(0),
+        current_tick(0),
+        next_wakeup(std::numeric_limits<uint64>::max()),
         s(m),
         shutdown(false),
         running(false)
     {
+        for (unsigned long i = 0; i <= overflow_slot; ++i)
+            wheel[i] = 0;
+        current_tick = ts.get_timestamp()/1000;
     }
 
 // ----------------------------------------------------------------------------------------
@@ -31,6 +38,164 @@ namespace dlib
         wait();
     }
 
+// ----------------------------------------------------------------------------------------
+
+    void timer_global_clock::
+    link (
+        timer_base* r
+    )
+    {
+        uint64 expire = r->next_time_to_run/1000;
+        if (expire < current_tick)
+            expire = current_tick;
+        const uint64 diff = expire - current_tick;
+
+        unsigned long slot = overflow_slot;
+        for (unsigned long level = 0; level < num_levels; ++level)
+        {
+            if (diff < ((uint64)1 << (wheel_bits*(level+1))))
+            {
+                slot = level*wheel_size + ((expire >> (wheel_bits*level))&(wheel_size-1));
+                break;
+            }
+        }
+
+        r->wheel_slot = slot;
+        r->wheel_prev = 0;
+        r->wheel_next = wheel[slot];
+        if (wheel[slot])
+            wheel[slot]->wheel_prev = r;
+        wheel[slot] = r;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void timer_global_clock::
+    unlink (
+        timer_base* r
+    )
+    {
+        if (r->wheel_prev)
+            r->wheel_prev->wheel_next = r->wheel_next;
+        else
+            wheel[r->wheel_slot] = r->wheel_next;
+
+        if (r->wheel_next)
+            r->wheel_next->wheel_prev = r->wheel_prev;
+
+        r->wheel_next = 0;
+        r->wheel_prev = 0;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void timer_global_clock::
+    cascade (
+        unsigned long slot
+    )
+    {
+        timer_base* r = wheel[slot];
+        wheel[slot] = 0;
+        while (r)
+        {
+            timer_base* next = r->wheel_next;
+            link(r);
+            r = next;
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void timer_global_clock::
+    process_tick (
+    )
+    {
+        const uint64 t = current_tick;
+
+        // Move timers down from the higher wheels whenever t crosses one of their slot
+        // boundaries.
+        for (unsigned long level = 1; level <= num_levels; ++level)
+        {
+            if ((t & (((uint64)1 << (wheel_bits*level))-1)) != 0)
+                break;
+
+            if (level == num_levels)
+                cascade(overflow_slot);
+            else
+                cascade(level*wheel_size + ((t >> (wheel_bits*level))&(wheel_size-1)));
+        }
+
+        // Now everything in this level 0 slot expires at tick t.  Take the whole list
+        // at once and start all the timers in it.
+        const unsigned long slot = t&(wheel_size-1);
+        timer_base* r = wheel[slot];
+        wheel[slot] = 0;
+        ++current_tick;
+        while (r)
+        {
+            timer_base* next = r->wheel_next;
+            r->wheel_next = 0;
+            r->wheel_prev = 0;
+            r->in_global_clock = false;
+            --num_timers;
+
+            // if this timer is still "running" then start its action function
+            if (r->running)
+            {
+                r->restart();
+            }
+            r = next;
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    uint64 timer_global_clock::
+    next_event_tick (
+    ) const
+    {
+        uint64 best = std::numeric_limits<uint64>::max();
+
+        // level 0 slots expire exactly at the tick they are indexed by
+        for (unsigned long j = 0; j < wheel_size; ++j)
+        {
+            if (wheel[j])
+            {
+                const uint64 t = current_tick + ((j - current_tick)&(wheel_size-1));
+                if (t < best)
+                    best = t;
+            }
+        }
+
+        // The other slots need to be cascaded at the first slot boundary, at or after
+        // current_tick, that has the slot's index.
+        for (unsigned long level = 1; level < num_levels; ++level)
+        {
+            const unsigned long shift = wheel_bits*level;
+            const uint64 first_block = (current_tick + ((uint64)1<<shift) - 1) >> shift;
+            for (unsigned long j = 0; j < wheel_size; ++j)
+            {
+                if (wheel[level*wheel_size + j])
+                {
+                    const uint64 block = first_block + ((j - first_block)&(wheel_size-1));
+                    const uint64 t = block << shift;
+                    if (t < best)
+                        best = t;
+                }
+            }
+        }
+
+        if (wheel[overflow_slot])
+        {
+            const unsigned long shift = wheel_bits*num_levels;
+            const uint64 t = ((current_tick + ((uint64)1<<shift) - 1) >> shift) << shift;
+            if (t < best)
+                best = t;
+        }
+
+        return best;
+    }
+
 // ----------------------------------------------------------------------------------------
 
     void timer_global_clock::
@@ -47,20 +212,26 @@ namespace dlib
                 running = true;
             }
 
-            uint64 t = ts.get_timestamp() + r->delay*1000;
-            tm.reset();
-            if (!tm.move_next() || t < tm.element().key())
+            const uint64 cur_time = ts.get_timestamp();
+            // Nothing is in the wheel so there is no reason to make the thread step over
+            // all the ticks since it last looked at it.  
+            if (num_timers == 0 && current_tick < cur_time/1000)
+                current_tick = cur_time/1000;
+
+            uint64 t = cur_time + r->delay*(uint64)1000;
+            r->next_time_to_run = t;
+            link(r);
+            r->in_global_clock = true;
+            ++num_timers;
+
+            if (t/1000 < next_wakeup)
             {
                 // we need to make the thread adjust its next time to
                 // trigger if this new event occurrs sooner than the
-                // next event in tm
+                // next time it was going to wake up.
+                next_wakeup = t/1000;
                 s.signal();
             }
-            timer_base* rtemp = r;
-            uint64 ttemp = t;
-            tm.add(ttemp,rtemp);
-            r->next_time_to_run = t;
-            r->in_global_clock = true;
         }
     }
 
@@ -73,18 +244,9 @@ namespace dlib
     {
         if (r->in_global_clock)
         {
-            tm.position_enumerator(r->next_time_to_run-1);
-            do
-            {
-                if (tm.element().value() == r)
-                {
-                    uint64 t;
-                    timer_base* rtemp;
-                    tm.remove_current_element(t,rtemp);
-                    r->in_global_clock = false;
-                    break;
-                }
-            } while (tm.move_next());
+            unlink(r);
+            --num_timers;
+            r->in_global_clock = false;
         }
     }
 
@@ -101,31 +263,20 @@ namespace dlib
             remove(r);
             // compute the new next_time_to_run and store it in t
             uint64 t = r->next_time_to_run;
-            t -= r->delay*1000;
-            t += new_delay*1000;
+            t -= r->delay*(uint64)1000;
+            t += new_delay*(uint64)1000;
 
-            tm.reset();
-            if (!tm.move_next() || t < tm.element().key())
-            {
-                // we need to make the thread adjust its next time to
-                // trigger if this new event occurrs sooner than the
-                // next event in tm
-                s.signal();
-            }
-
-            // set this incase add throws
-            r->running = false;
             r->delay = new_delay;
-
-            timer_base* rtemp = r;
-            uint64 ttemp = t;
-            tm.add(ttemp,rtemp);
             r->next_time_to_run = t;
+            link(r);
             r->in_global_clock = true;
+            ++num_timers;
 
-            // put this back now that we know add didn't throw
-            r->running = true;
-
+            if (t/1000 < next_wakeup)
+            {
+                next_wakeup = t/1000;
+                s.signal();
+            }
         }
         else
         {
@@ -141,38 +292,39 @@ namespace dlib
         auto_mutex M(m);
         while (!shutdown)
         {
-            unsigned long delay = 100000;
+            const uint64 now = ts.get_timestamp()/1000;
 
-            tm.reset();
-            tm.move_next();
-            // loop and start all the action functions for timers that should have
-            // triggered.
-            while(tm.current_element_valid())
+            // Process all the ticks up to now.  Ticks where nothing happens are skipped
+            // over entirely rather than being visited one at a time.
+            while (current_tick <= now)
             {
-                const uint64 cur_time = ts.get_timestamp();
-                uint64 t = tm.element().key();
-                // if the next event in tm is ready to trigger
-                if (t <= cur_time + 999)
+                if (num_timers == 0)
                 {
-                    // remove this event from the tm map
-                    timer_base* r = tm.element().value();
-                    timer_base* rtemp;
-                    tm.remove_current_element(t,rtemp);
-                    r->in_global_clock = false;
-
-                    // if this timer is still "running" then start its action function
-                    if (r->running)
-                    {
-                        r->restart();
-                    }
+                    current_tick = now+1;
+                    break;
                 }
-                else
+
+                const uint64 next = next_event_tick();
+                if (next > now)
                 {
-                    // there aren't any more timers that should trigger so we compute
-                    // the delay to the next timer event.
-                    delay = static_cast<unsigned long>((t - cur_time)/1000);
+                    current_tick = now+1;
                     break;
                 }
+
+                current_tick = next;
+                process_tick();
+            }
+
+            unsigned long delay = 100000;
+            if (num_timers != 0)
+            {
+                next_wakeup = next_event_tick();
+                if (next_wakeup - now < delay)
+                    delay = static_cast<unsigned long>(next_wakeup - now);
+            }
+            else
+            {
+                next_wakeup = std::numeric_limits<uint64>::max();
             }
 
             s.wait_or_timeout(delay);
@@ -29,6 +29,12 @@ namespace dlib
         timestamper ts;
         bool running;
         bool in_global_clock;
+
+        // These link the timer into one of the timer_global_clock's wheel slots.  They
+        // are only meaningful while in_global_clock == true.
+        timer_base* wheel_next;
+        timer_base* wheel_prev;
+        unsigned long wheel_slot;
     };
 
 // ----------------------------------------------------------------------------------------
@@ -38,9 +44,26 @@ namespace dlib
         /*!
             This object sets up a timer that triggers the action function
             for timer objects that are tracked inside this object. 
+
+            The timers are kept in a hierarchical timing wheel with a resolution of one
+            millisecond.  There are num_levels wheels of wheel_size slots each.  Wheel
+            level L covers the times that are less than wheel_size^(L+1) milliseconds
+            away from current_tick, and anything further away than that goes into a
+            single overflow slot.  Each slot is an intrusive doubly linked list of
+            timer_base objects, so adding and removing a timer are O(1) operations.
+            When current_tick crosses a slot boundary of wheel level L the contents of
+            the matching slot are moved down into the lower levels (i.e. cascaded).
+            All the timers in a level 0 slot expire at the same tick and are dispatched
+            together.  Note that this object never calls the action functions itself.
+            Expired timers are simply restarted, which hands them off to dlib's pool of
+            reusable threads, so the clock thread only does bookkeeping.
+
             INITIAL VALUE
                 - shutdown == false
                 - running == false
+                - num_timers == 0
+                - all the wheel slots are empty
+                - next_wakeup == the largest possible uint64 value
 
             CONVENTION
                 - if (shutdown) then
@@ -48,9 +71,22 @@ namespace dlib
                 - else (running) then
                     - thread() is running
 
-                - tm[time] == pointer to a timer_base object 
+                - current_tick == the next millisecond tick that thread() will process.
+                  All ticks before it have already been processed.
+                - num_timers == the number of timers in the wheel slots
+                - for all timers r in the wheel slots:
+                    - r->in_global_clock == true
+                    - wheel[r->wheel_slot] is the head of the list containing r
+                    - r->next_time_to_run/1000 is the tick at which r expires
+                - next_wakeup == a tick no later than the time thread() has
+                  scheduled itself to wake up.  That is, adding a timer that expires
+                  before next_wakeup requires signaling the thread.
         !*/
-        typedef binary_search_tree<uint64,timer_base*,memory_manager<char>::kernel_2b>::kernel_2a_c time_map;
+        const static unsigned long wheel_bits = 8;
+        const static unsigned long wheel_size = 1<<wheel_bits;
+        const static unsigned long num_levels = 4;
+        const static unsigned long overflow_slot = num_levels*wheel_size;
+
     public:
 
         ~timer_global_clock();
@@ -63,7 +99,7 @@ namespace dlib
                 - m is locked
             ensures
                 - starts the thread if it isn't already started
-                - adds r to tm
+                - adds r to the timing wheel
                 - #r->in_global_clock == true
                 - updates r->next_time_to_run appropriately according to
                     r->delay
@@ -76,8 +112,8 @@ namespace dlib
             requires
                 - m is locked
             ensures
-                - if (r is in tm) then
-                    - removes r from tm
+                - if (r is in the timing wheel) then
+                    - removes r from the timing wheel
                 - #r->in_global_clock == false
         !*/
 
@@ -101,7 +137,67 @@ namespace dlib
     private:
         timer_global_clock();
 
-        time_map tm;  
+        void link (
+            timer_base* r
+        );
+        /*!
+            requires
+                - m is locked
+                - r is not in any wheel slot
+            ensures
+                - puts r into the wheel slot appropriate for r->next_time_to_run
+                  relative to current_tick.
+        !*/
+
+        void unlink (
+            timer_base* r
+        );
+        /*!
+            requires
+                - m is locked
+                - r is in a wheel slot
+            ensures
+                - removes r from its wheel slot
+        !*/
+
+        void cascade (
+            unsigned long slot
+        );
+        /*!
+            requires
+                - m is locked
+            ensures
+                - moves all the timers in wheel[slot] into the slots appropriate for
+                  their expiration times relative to current_tick.
+        !*/
+
+        void process_tick (
+        );
+        /*!
+            requires
+                - m is locked
+            ensures
+                - performs any cascading needed at current_tick and then restarts all
+                  the running timers that expire at current_tick.
+                - #current_tick == current_tick + 1
+        !*/
+
+        uint64 next_event_tick (
+        ) const;
+        /*!
+            requires
+                - m is locked
+                - num_timers != 0
+            ensures
+                - returns the first tick >= current_tick at which process_tick() has
+                  something to do.  That is, either a level 0 slot holding expiring
+                  timers or a cascade of a non-empty slot.
+        !*/
+
+        timer_base* wheel[num_levels*wheel_size + 1];
+        unsigned long num_timers;
+        uint64 current_tick;
+        uint64 next_wakeup;
         signaler s;
         bool shutdown;
         bool running;
@@ -239,6 +335,9 @@ namespace dlib
         next_time_to_run = 0;
         running = false;
         in_global_clock = false;
+        wheel_next = 0;
+        wheel_prev = 0;
+        wheel_slot = 0;
     }
 
 // ----------------------------------------------------------------------------------------
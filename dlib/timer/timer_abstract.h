@@ -30,6 +30,10 @@ namespace dlib
                 guaranteed to have that level of resolution.  The actual resolution
                 is implementation dependent.
 
+                All the timer objects in a program share a single clock thread which
+                keeps them in a timing wheel.  So start(), stop(), and set_delay_time()
+                run in constant time regardless of how many timers are active.
+
             THREAD SAFETY
                 All methods of this class are thread safe. 
         !*/
@@ -0,0 +1,85 @@
+// Copyright (C) 2011  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+/*
+    This program times the assignment problem solvers in dlib.  It runs the original
+    max_cost_assignment() routine and both algorithms of the max_cost_assignment_solver
+    on random dense cost matrices from 10x10 up to 5000x5000, and then runs the solver
+    on a large sparse problem.
+*/
+
+#include <dlib/optimization.h>
+#include <dlib/rand.h>
+#include <dlib/misc_api.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace std;
+using namespace dlib;
+
+// ----------------------------------------------------------------------------------------
+
+void print_time (
+    const std::string& name,
+    const uint64 start,
+    const uint64 stop
+)
+{
+    cout << "   " << left << setw(32) << name << (stop-start)/1000.0 << " ms" << endl;
+}
+
+// ----------------------------------------------------------------------------------------
+
+int main()
+{
+    dlib::rand rnd;
+    max_cost_assignment_solver solver;
+    std::vector<long> assign;
+    timestamper ts;
+
+    const long sizes[] = {10, 100, 500, 1000, 2000, 5000};
+    for (unsigned long i = 0; i < sizeof(sizes)/sizeof(sizes[0]); ++i)
+    {
+        const long n = sizes[i];
+        matrix<long> cost = matrix_cast<long>(randm(n,n,rnd)*1000);
+        cout << "dense " << n << "x" << n << endl;
+
+        uint64 start = ts.get_timestamp();
+        const long true_eval = assignment_cost(cost, max_cost_assignment(cost));
+        print_time("max_cost_assignment():", start, ts.get_timestamp());
+
+        solver.use_hungarian_algorithm();
+        start = ts.get_timestamp();
+        solver(cost, assign);
+        print_time("hungarian solver:", start, ts.get_timestamp());
+        if (assignment_cost(cost, assign) != true_eval)
+            cout << "   ERROR: the hungarian solver found a worse assignment" << endl;
+
+        const unsigned long threads[] = {1, 4};
+        for (unsigned long t = 0; t < sizeof(threads)/sizeof(threads[0]); ++t)
+        {
+            solver.use_auction_algorithm();
+            solver.set_num_threads(threads[t]);
+            start = ts.get_timestamp();
+            solver(cost, assign);
+            print_time("auction solver (" + cast_to_string(threads[t]) + " threads):", start, ts.get_timestamp());
+            if (assignment_cost(cost, assign) != true_eval)
+                cout << "   ERROR: the auction solver found a worse assignment" << endl;
+        }
+    }
+
+    std::vector<ordered_sample_pair> edges;
+    const long n = 5000;
+    for (long r = 0; r < n; ++r)
+    {
+        for (long k = 0; k < 10; ++k)
+            edges.push_back(ordered_sample_pair(r, rnd.get_random_32bit_number()%n, rnd.get_random_double()));
+    }
+    cout << "sparse " << n << "x" << n << " with " << edges.size() << " edges" << endl;
+    uint64 start = ts.get_timestamp();
+    solver(edges, assign);
+    print_time("solver:", start, ts.get_timestamp());
+}
+
+// ----------------------------------------------------------------------------------------
+
@@ -0,0 +1,135 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+/*
+    This program times the graph clustering routines in dlib on a large random graph
+    made of dense groups of nodes with some noise edges between them.
+*/
+
+#include <dlib/clustering.h>
+#include <dlib/graph_utils.h>
+#include <dlib/rand.h>
+#include <dlib/misc_api.h>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+using namespace dlib;
+
+// ----------------------------------------------------------------------------------------
+
+void make_graph(
+    dlib::rand& rnd,
+    std::vector<ordered_sample_pair>& edges,
+    const int groups,
+    const int group_size,
+    const int noise_level,
+    const double missed_edges
+)
+{
+    std::vector<sample_pair> temp;
+    for (int i = 0; i < groups; ++i)
+    {
+        for (int j = 0; j < group_size; ++j)
+        {
+            for (int k = 0; k < group_size; ++k)
+            {
+                if (j == k || rnd.get_random_double() < missed_edges)
+                    continue;
+                temp.push_back(sample_pair(j+group_size*i, k+group_size*i, 1));
+            }
+        }
+    }
+
+    const unsigned long num_nodes = groups*group_size;
+    for (int k = 0; k < groups*noise_level; ++k)
+    {
+        const unsigned long i = rnd.get_random_32bit_number()%num_nodes;
+        const unsigned long j = rnd.get_random_32bit_number()%num_nodes;
+        temp.push_back(sample_pair(i,j,1));
+    }
+
+    convert_unordered_to_ordered(temp, edges);
+    std::sort(edges.begin(), edges.end(), &order_by_index<ordered_sample_pair>);
+}
+
+// ----------------------------------------------------------------------------------------
+
+void print_time (
+    const std::string& name,
+    const uint64 start,
+    const uint64 stop,
+    const unsigned long num_clusters
+)
+{
+    cout << left << setw(52) << name << (stop-start)/1000.0 << " ms, clusters: " << num_clusters << endl;
+}
+
+// ----------------------------------------------------------------------------------------
+
+void time_chinese_whispers (
+    const std::vector<ordered_sample_pair>& edges
+)
+{
+    std::vector<unsigned long> labels;
+    timestamper ts;
+
+    uint64 start = ts.get_timestamp();
+    unsigned long num = chinese_whispers(edges, labels, 20);
+    print_time("chinese_whispers()", start, ts.get_timestamp(), num);
+
+    const unsigned long threads[] = {1, 2, 4, 8};
+    for (unsigned long i = 0; i < sizeof(threads)/sizeof(threads[0]); ++i)
+    {
+        std::ostringstream sout;
+        sout << "chinese_whispers_threaded(" << threads[i] << " threads";
+
+        start = ts.get_timestamp();
+        num = chinese_whispers_threaded(edges, labels, 20, threads[i]);
+        print_time(sout.str() + ")", start, ts.get_timestamp(), num);
+
+        start = ts.get_timestamp();
+        num = chinese_whispers_threaded(edges, labels, 20, threads[i], chinese_whispers_synchronous);
+        print_time(sout.str() + ", synchronous)", start, ts.get_timestamp(), num);
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+void time_louvain_cluster (
+    const std::vector<ordered_sample_pair>& edges
+)
+{
+    std::vector<unsigned long> labels;
+    timestamper ts;
+
+    const unsigned long threads[] = {1, 2, 4, 8};
+    for (unsigned long i = 0; i < sizeof(threads)/sizeof(threads[0]); ++i)
+    {
+        std::ostringstream sout;
+        sout << "louvain_cluster(" << threads[i] << " threads)";
+
+        const uint64 start = ts.get_timestamp();
+        const unsigned long num = louvain_cluster(edges, labels, threads[i]);
+        print_time(sout.str(), start, ts.get_timestamp(), num);
+    }
+    cout << "louvain_cluster() modularity: " << modularity(edges, labels) << endl;
+}
+
+// ----------------------------------------------------------------------------------------
+
+int main()
+{
+    dlib::rand rnd;
+    std::vector<ordered_sample_pair> edges;
+    make_graph(rnd, edges, 300, 40, 10, 0.5);
+    cout << "num nodes: " << max_index_plus_one(edges) << "  num directed edges: " << edges.size() << endl;
+
+    time_chinese_whispers(edges);
+    time_louvain_cluster(edges);
+}
+
+// ----------------------------------------------------------------------------------------
+
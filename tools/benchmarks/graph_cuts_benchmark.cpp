@@ -0,0 +1,90 @@
+// Copyright (C) 2012  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+/*
+    This program times find_max_factor_graph_potts() on random Potts grid problems.
+    It compares the grid-specialized solver used for potts_grid_problem objects with
+    running the general min_cut object on the same grid graph.
+*/
+
+#include <dlib/graph_cuts.h>
+#include <dlib/rand.h>
+#include <dlib/hash.h>
+#include <dlib/misc_api.h>
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+
+using namespace std;
+using namespace dlib;
+
+// ----------------------------------------------------------------------------------------
+
+class random_potts_grid_problem
+{
+public:
+    random_potts_grid_problem(
+        long nr_,
+        long nc_,
+        dlib::rand& rnd
+    ) : nr__(nr_), nc__(nc_), seed(rnd.get_random_32bit_number())
+    {
+        unary.set_size(nr_*nc_);
+        for (long i = 0; i < unary.size(); ++i)
+            unary(i) = rnd.get_random_gaussian()*20;
+    }
+
+    long nr() const { return nr__;}
+    long nc() const { return nc__;}
+
+    typedef double value_type;
+
+    value_type factor_value(unsigned long idx) const
+    {
+        return unary(idx);
+    }
+
+    value_type factor_value_disagreement(unsigned long idx1, unsigned long idx2) const
+    {
+        // Any symmetric function of idx1 and idx2 will do.
+        const uint32 h = murmur_hash3_2(std::min(idx1,idx2), std::max(idx1,idx2)^seed);
+        return h%16;
+    }
+
+private:
+    long nr__;
+    long nc__;
+    uint32 seed;
+    matrix<double,0,1> unary;
+};
+
+// ----------------------------------------------------------------------------------------
+
+int main()
+{
+    dlib::rand rnd;
+    const long sizes[] = {100, 400, 1000};
+    for (unsigned long i = 0; i < sizeof(sizes)/sizeof(sizes[0]); ++i)
+    {
+        random_potts_grid_problem prob(sizes[i], sizes[i], rnd);
+        array2d<node_label> labels, general_labels(prob.nr(),prob.nc());
+
+        timestamper ts;
+        uint64 start = ts.get_timestamp();
+        find_max_factor_graph_potts(prob, labels);
+        const uint64 grid_time = ts.get_timestamp()-start;
+
+        start = ts.get_timestamp();
+        dlib::impl::potts_grid_problem<array2d<node_label>,random_potts_grid_problem> model(general_labels, prob);
+        find_max_factor_graph_potts(model);
+        const uint64 general_time = ts.get_timestamp()-start;
+
+        cout << sizes[i] << "x" << sizes[i] << " grid" << endl;
+        cout << "   grid min cut time:    " << grid_time/1000.0 << " ms" << endl;
+        cout << "   general min cut time: " << general_time/1000.0 << " ms" << endl;
+        if (std::abs(potts_model_score(prob, labels) - potts_model_score(prob, general_labels)) > 1e-6)
+            cout << "   ERROR: the two solvers found cuts with different scores" << endl;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
@@ -0,0 +1,96 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+/*
+    This program compares the speed and quality of the different k-means routines in
+    dlib on random float vectors drawn around 50 cluster centers.
+*/
+
+#include <dlib/svm_threaded.h>
+#include <dlib/rand.h>
+#include <dlib/misc_api.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <limits>
+
+using namespace std;
+using namespace dlib;
+
+typedef matrix<float,0,1> sample_type;
+
+// ----------------------------------------------------------------------------------------
+
+double kmeans_error (
+    const std::vector<sample_type>& samples,
+    const std::vector<sample_type>& centers
+)
+{
+    double error = 0;
+    for (unsigned long i = 0; i < samples.size(); ++i)
+    {
+        double best = std::numeric_limits<double>::infinity();
+        for (unsigned long j = 0; j < centers.size(); ++j)
+            best = std::min<double>(best, length_squared(samples[i] - centers[j]));
+        error += best;
+    }
+    return error/samples.size();
+}
+
+void print_time (
+    const std::string& name,
+    const uint64 start,
+    const uint64 stop
+)
+{
+    cout << left << setw(52) << name << (stop-start)/1000.0 << " ms" << endl;
+}
+
+// ----------------------------------------------------------------------------------------
+
+int main()
+{
+    dlib::rand rnd;
+    std::vector<sample_type> samples, seeds;
+    for (int i = 0; i < 50; ++i)
+        seeds.push_back(matrix_cast<float>(10*randm(16,1,rnd)));
+    for (int i = 0; i < 100000; ++i)
+        samples.push_back(seeds[i%seeds.size()] + matrix_cast<float>(3*randm(16,1,rnd)));
+    cout << "num samples: " << samples.size() << "  num centers: " << seeds.size() << endl;
+
+    std::vector<sample_type> init, centers;
+    timestamper ts;
+    uint64 start = ts.get_timestamp();
+    pick_initial_centers(seeds.size(), init, samples, linear_kernel<sample_type>());
+    print_time("pick_initial_centers()", start, ts.get_timestamp());
+
+    start = ts.get_timestamp();
+    pick_initial_centers_kmeanspp(seeds.size(), init, samples, 4, rnd);
+    print_time("pick_initial_centers_kmeanspp(4 threads)", start, ts.get_timestamp());
+
+    const unsigned long max_iter = 30;
+    centers = init;
+    start = ts.get_timestamp();
+    find_clusters_using_kmeans(samples, centers, max_iter);
+    print_time("find_clusters_using_kmeans()", start, ts.get_timestamp());
+    cout << "   error: " << kmeans_error(samples, centers) << endl;
+
+    const unsigned long threads[] = {1, 4};
+    for (unsigned long t = 0; t < sizeof(threads)/sizeof(threads[0]); ++t)
+    {
+        centers = init;
+        start = ts.get_timestamp();
+        find_clusters_using_kmeans_threaded(samples, centers, threads[t], max_iter);
+        print_time("find_clusters_using_kmeans_threaded(" + cast_to_string(threads[t]) + " threads)", 
+                   start, ts.get_timestamp());
+        cout << "   error: " << kmeans_error(samples, centers) << endl;
+    }
+
+    centers = init;
+    start = ts.get_timestamp();
+    find_clusters_using_minibatch_kmeans(samples, centers, 500, 30, 4, rnd);
+    print_time("find_clusters_using_minibatch_kmeans(4 threads)", start, ts.get_timestamp());
+    cout << "   error: " << kmeans_error(samples, centers) << endl;
+}
+
+// ----------------------------------------------------------------------------------------
+
@@ -0,0 +1,60 @@
+// Copyright (C) 2013  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+/*
+    This program compares the speed of find_k_nearest_neighbors() and
+    find_k_nearest_neighbors_threaded() on random dense samples.
+*/
+
+#include <dlib/graph_utils_threaded.h>
+#include <dlib/matrix.h>
+#include <dlib/misc_api.h>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+using namespace dlib;
+
+// ----------------------------------------------------------------------------------------
+
+int main()
+{
+    const unsigned long num_samples[] = {2000, 10000};
+    const long dims[] = {5, 20, 100};
+    const unsigned long k = 10;
+
+    for (unsigned long n = 0; n < sizeof(num_samples)/sizeof(num_samples[0]); ++n)
+    {
+        for (unsigned long d = 0; d < sizeof(dims)/sizeof(dims[0]); ++d)
+        {
+            std::vector<matrix<double,0,1> > samples(num_samples[n]);
+            for (unsigned long i = 0; i < samples.size(); ++i)
+                samples[i] = gaussian_randm(dims[d],1,i);
+
+            cout << "num samples: " << samples.size() << "  dims: " << dims[d] << "  k: " << k << endl;
+
+            std::vector<sample_pair> edges1, edges2;
+            timestamper ts;
+            uint64 start = ts.get_timestamp();
+            find_k_nearest_neighbors(samples, squared_euclidean_distance(), k, edges1);
+            cout << "   find_k_nearest_neighbors():                     " 
+                 << (ts.get_timestamp()-start)/1000.0 << " ms" << endl;
+
+            const unsigned long threads[] = {1, 4};
+            for (unsigned long t = 0; t < sizeof(threads)/sizeof(threads[0]); ++t)
+            {
+                start = ts.get_timestamp();
+                find_k_nearest_neighbors_threaded(samples, squared_euclidean_distance(), k, threads[t], edges2);
+                cout << "   find_k_nearest_neighbors_threaded(" << threads[t] << " threads):  " 
+                     << (ts.get_timestamp()-start)/1000.0 << " ms" << endl;
+            }
+
+            std::sort(edges1.begin(), edges1.end(), order_by_index<sample_pair>);
+            if (edges1 != edges2)
+                cout << "   ERROR: the two functions found different neighbors" << endl;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
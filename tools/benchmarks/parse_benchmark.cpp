@@ -0,0 +1,189 @@
+// Copyright (C) 2012  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+/*
+    This program times find_max_parse_cky() on random grammars.  It compares the
+    current implementation, with and without threads and pruning, against the
+    original version of the algorithm which kept a std::map in each chart cell.
+*/
+
+#include <dlib/optimization.h>
+#include <dlib/array2d.h>
+#include <dlib/rand.h>
+#include <dlib/misc_api.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <map>
+
+using namespace std;
+using namespace dlib;
+
+typedef unsigned long tags;
+
+// ----------------------------------------------------------------------------------------
+
+class random_grammar
+{
+    /*!
+        A randomly generated grammar over num_tags tags.  Each pair of tags can be
+        combined into a few different tags, each with a random score.
+    !*/
+public:
+    random_grammar (
+        dlib::rand& rnd,
+        long num_tags,
+        double density
+    )
+    {
+        scores.set_size(num_tags*num_tags, num_tags);
+        for (long r = 0; r < scores.nr(); ++r)
+        {
+            for (long c = 0; c < scores.nc(); ++c)
+            {
+                if (rnd.get_random_double() < density)
+                    scores(r,c) = -rnd.get_random_double()*10;
+                else
+                    scores(r,c) = 1;
+            }
+        }
+    }
+
+    void operator() (
+        const std::vector<tags>& ,
+        const constituent<tags>& c,
+        std::vector<std::pair<tags,double> >& possible_ids
+    ) const
+    {
+        const long row = c.left_tag*scores.nc() + c.right_tag;
+        for (long t = 0; t < scores.nc(); ++t)
+        {
+            // a positive value marks a rule that doesn't exist
+            if (scores(row,t) <= 0)
+                possible_ids.push_back(make_pair(t, scores(row,t)));
+        }
+    }
+
+    matrix<double> scores;
+};
+
+// ----------------------------------------------------------------------------------------
+
+double map_based_cky (
+    const std::vector<tags>& sequence,
+    const random_grammar& production_rules
+)
+/*!
+    ensures
+        - Fills in the chart the way find_max_parse_cky() originally did, with a
+          std::map of scores and a std::map of back pointers in each cell, and returns
+          the score of the best parse.
+!*/
+{
+    const long n = sequence.size();
+    array2d<std::map<tags,double> > table(n, n);
+    array2d<std::map<tags,parse_tree_element<tags> > > back(n, n);
+    typedef std::map<tags,double>::iterator itr;
+
+    for (long r = 0; r < n; ++r)
+        table[r][r][sequence[r]] = 0;
+
+    std::vector<std::pair<tags,double> > possible_tags;
+    for (long r = n-2; r >= 0; --r)
+    {
+        for (long c = r+1; c < n; ++c)
+        {
+            for (long k = r; k < c; ++k)
+            {
+                for (itr i = table[k+1][c].begin(); i != table[k+1][c].end(); ++i)
+                {
+                    for (itr j = table[r][k].begin(); j != table[r][k].end(); ++j)
+                    {
+                        constituent<tags> con;
+                        con.begin = r;
+                        con.end = c+1;
+                        con.k = k+1;
+                        con.left_tag = j->first;
+                        con.right_tag = i->first;
+                        possible_tags.clear();
+                        production_rules(sequence, con, possible_tags);
+                        for (unsigned long m = 0; m < possible_tags.size(); ++m)
+                        {
+                            const double score = possible_tags[m].second + i->second + j->second;
+                            itr match = table[r][c].find(possible_tags[m].first);
+                            if (match == table[r][c].end() || score > match->second)
+                            {
+                                table[r][c][possible_tags[m].first] = score;
+                                parse_tree_element<tags>& item = back[r][c][possible_tags[m].first];
+                                item.c = con;
+                                item.score = score;
+                                item.tag = possible_tags[m].first;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    double best = -std::numeric_limits<double>::infinity();
+    for (itr i = table[0][n-1].begin(); i != table[0][n-1].end(); ++i)
+        best = std::max(best, i->second);
+    return best;
+}
+
+// ----------------------------------------------------------------------------------------
+
+void print_time (
+    const std::string& name,
+    const uint64 start,
+    const uint64 stop
+)
+{
+    cout << "   " << left << setw(48) << name << (stop-start)/1000.0 << " ms" << endl;
+}
+
+// ----------------------------------------------------------------------------------------
+
+int main()
+{
+    dlib::rand rnd;
+    const long num_tags = 20;
+    random_grammar grammar(rnd, num_tags, 0.2);
+    const long lengths[] = {10, 30, 60};
+    for (unsigned long l = 0; l < sizeof(lengths)/sizeof(lengths[0]); ++l)
+    {
+        std::vector<tags> sequence(lengths[l]);
+        for (unsigned long i = 0; i < sequence.size(); ++i)
+            sequence[i] = rnd.get_random_32bit_number()%num_tags;
+        cout << "sequence length " << sequence.size() << ", " << num_tags << " tags" << endl;
+
+        timestamper ts;
+        uint64 start = ts.get_timestamp();
+        const double best_score = map_based_cky(sequence, grammar);
+        print_time("map based CKY:", start, ts.get_timestamp());
+
+        std::vector<parse_tree_element<tags> > parse_tree;
+        start = ts.get_timestamp();
+        find_max_parse_cky(sequence, grammar, parse_tree);
+        print_time("find_max_parse_cky():", start, ts.get_timestamp());
+        if (parse_tree.size() == 0 || parse_tree[0].score != best_score)
+            cout << "   ERROR: find_max_parse_cky() didn't find the best parse" << endl;
+
+        cky_parse_options options;
+        options.num_threads = 4;
+        start = ts.get_timestamp();
+        find_max_parse_cky(sequence, grammar, parse_tree, options);
+        print_time("find_max_parse_cky() with 4 threads:", start, ts.get_timestamp());
+
+        options.num_threads = 1;
+        options.beam_width = 5;
+        start = ts.get_timestamp();
+        find_max_parse_cky(sequence, grammar, parse_tree, options);
+        print_time("find_max_parse_cky() with a beam width of 5:", start, ts.get_timestamp());
+        if (parse_tree.size() != 0)
+            cout << "      score lost by the beam: " << best_score - parse_tree[0].score << endl;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
@@ -0,0 +1,98 @@
+// Copyright (C) 2007  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+/*
+    This program times start(), set_delay_time(), and stop() on 100k active timer
+    objects.  Their delays are spread between 1 minute and 2 days so they land on all
+    the levels of the timer_global_clock's timing wheel.
+*/
+
+#include <dlib/timer.h>
+#include <dlib/misc_api.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace std;
+using namespace dlib;
+
+// ----------------------------------------------------------------------------------------
+
+class timer_target
+{
+public:
+    timer_target() : count(0) {}
+
+    void add()
+    {
+        auto_mutex lock(m);
+        ++count;
+    }
+
+    mutex m;
+    unsigned long count;
+};
+
+typedef timer<timer_target> target_timer;
+
+// ----------------------------------------------------------------------------------------
+
+void print_time (
+    const string& name,
+    uint64 elapsed,
+    unsigned long num
+)
+{
+    cout << setw(20) << left << name << setw(10) << right << elapsed/1000.0 << " ms   "
+         << setw(8) << elapsed*1000.0/num << " ns per timer" << endl;
+}
+
+// ----------------------------------------------------------------------------------------
+
+int main()
+{
+    const unsigned long num = 100000;
+    timer_target target;
+    std::vector<target_timer*> timers(num);
+    for (unsigned long i = 0; i < num; ++i)
+    {
+        timers[i] = new target_timer(target, &timer_target::add);
+        timers[i]->set_delay_time(60000 + (i*7919)%(2*24*3600*1000UL));
+    }
+
+    timestamper ts;
+    uint64 start = ts.get_timestamp();
+    for (unsigned long i = 0; i < num; ++i)
+        timers[i]->start();
+    print_time("start()", ts.get_timestamp()-start, num);
+
+    for (unsigned long i = 0; i < num; ++i)
+    {
+        if (!timers[i]->is_running())
+        {
+            cout << "ERROR: a timer isn't running after start()" << endl;
+            break;
+        }
+    }
+
+    start = ts.get_timestamp();
+    for (unsigned long i = 0; i < num; ++i)
+        timers[i]->set_delay_time(30000 + (i*104729)%(24*3600*1000UL));
+    print_time("set_delay_time()", ts.get_timestamp()-start, num);
+
+    start = ts.get_timestamp();
+    for (unsigned long i = 0; i < num; ++i)
+        timers[i]->stop();
+    print_time("stop()", ts.get_timestamp()-start, num);
+
+    for (unsigned long i = 0; i < num; ++i)
+    {
+        if (timers[i]->is_running())
+            cout << "ERROR: a timer is still running after stop()" << endl;
+        delete timers[i];
+    }
+    if (target.count != 0)
+        cout << "ERROR: " << target.count << " timers went off early" << endl;
+}
+
+// ----------------------------------------------------------------------------------------
+
@@ -0,0 +1,174 @@
+// Copyright (C) 2011  Davis E. King (davis@dlib.net)
+// License: Boost Software License   See LICENSE.txt for the full license.
+/*
+    This program times find_max_factor_graph_viterbi() and its threaded and beam
+    search variants on a second order chain with many states.  The problem can be
+    solved either through its factor_values() member or one factor_value() call at a
+    time, so both code paths are timed.
+*/
+
+#include <dlib/optimization.h>
+#include <dlib/rand.h>
+#include <dlib/misc_api.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace std;
+using namespace dlib;
+
+// ----------------------------------------------------------------------------------------
+
+class transition_map_problem
+{
+    /*!
+        A second order model where the factors are a per node score plus a score for
+        each triple of labels.
+    !*/
+public:
+    transition_map_problem(
+        unsigned long num_states,
+        unsigned long num_nodes,
+        dlib::rand& rnd
+    )
+    {
+        node_scores = randm(num_nodes, num_states, rnd);
+        transitions = randm(num_states, num_states*num_states, rnd);
+    }
+
+    unsigned long order() const { return 2; }
+    unsigned long num_states() const { return node_scores.nc(); }
+    unsigned long number_of_nodes() const { return node_scores.nr(); }
+
+    template <
+        typename EXP 
+        >
+    double factor_value (
+        unsigned long node_id,
+        const matrix_exp<EXP>& node_states
+    ) const
+    {
+        double val = node_scores(node_id, node_states(0));
+        if (node_states.size() == 3)
+            val += transitions(node_states(0), node_states(1)*num_states() + node_states(2));
+        return val;
+    }
+
+    void factor_values (
+        unsigned long node_id,
+        matrix<double>& values
+    ) const
+    {
+        if (node_id >= 2)
+            values = transitions;
+        else
+            values.set_size(num_states(), node_id == 1 ? num_states() : 1);
+
+        for (long r = 0; r < values.nr(); ++r)
+        {
+            const double score = node_scores(node_id, r);
+            for (long c = 0; c < values.nc(); ++c)
+            {
+                if (node_id >= 2)
+                    values(r,c) += score;
+                else
+                    values(r,c) = score;
+            }
+        }
+    }
+
+    matrix<double> node_scores;
+    matrix<double> transitions;
+};
+
+// ----------------------------------------------------------------------------------------
+
+class map_problem_ref
+{
+    /*!
+        Forwards everything but factor_values() to a transition_map_problem so we can
+        time the factor_value() code path.
+    !*/
+public:
+    map_problem_ref(const transition_map_problem& prob_) : prob(prob_) {}
+    unsigned long order() const { return prob.order(); }
+    unsigned long num_states() const { return prob.num_states(); }
+    unsigned long number_of_nodes() const { return prob.number_of_nodes(); }
+    template <typename EXP>
+    double factor_value (
+        unsigned long node_id,
+        const matrix_exp<EXP>& node_states
+    ) const { return prob.factor_value(node_id, node_states); }
+
+    const transition_map_problem& prob;
+};
+
+// ----------------------------------------------------------------------------------------
+
+double map_assignment_value (
+    const transition_map_problem& prob,
+    const std::vector<unsigned long>& assign
+)
+{
+    matrix<unsigned long,1,0> states = trans(mat(assign));
+    double score = 0;
+    for (unsigned long i = 0; i < assign.size(); ++i)
+    {
+        const unsigned long o = std::min<unsigned long>(prob.order(), i);
+        score += prob.factor_value(i, colm(states, range(i, i-o)));
+    }
+    return score;
+}
+
+void print_time (
+    const std::string& name,
+    const uint64 start,
+    const uint64 stop
+)
+{
+    cout << left << setw(52) << name << (stop-start)/1000.0 << " ms" << endl;
+}
+
+// ----------------------------------------------------------------------------------------
+
+int main()
+{
+    dlib::rand rnd;
+    transition_map_problem prob(60, 30, rnd);
+    cout << "num states: " << prob.num_states() << "  num nodes: " << prob.number_of_nodes() << endl;
+    std::vector<unsigned long> assign, assign2;
+    timestamper ts;
+
+    uint64 start = ts.get_timestamp();
+    find_max_factor_graph_viterbi(prob, assign);
+    print_time("exact viterbi with factor_values():", start, ts.get_timestamp());
+
+    const unsigned long threads[] = {2, 4};
+    for (unsigned long i = 0; i < sizeof(threads)/sizeof(threads[0]); ++i)
+    {
+        start = ts.get_timestamp();
+        find_max_factor_graph_viterbi_threaded(prob, assign2, threads[i]);
+        print_time("threaded exact viterbi (" + cast_to_string(threads[i]) + " threads):", start, ts.get_timestamp());
+        if (assign != assign2)
+            cout << "   ERROR: the threaded version gave a different assignment" << endl;
+    }
+
+    start = ts.get_timestamp();
+    find_max_factor_graph_viterbi(map_problem_ref(prob), assign2);
+    print_time("exact viterbi with factor_value():", start, ts.get_timestamp());
+    if (assign != assign2)
+        cout << "   ERROR: the factor_value() path gave a different assignment" << endl;
+
+    const double best_val = map_assignment_value(prob, assign);
+    const unsigned long widths[] = {1, 10, 100};
+    for (unsigned long i = 0; i < sizeof(widths)/sizeof(widths[0]); ++i)
+    {
+        start = ts.get_timestamp();
+        find_max_factor_graph_viterbi_beam(map_problem_ref(prob), assign2, widths[i]);
+        print_time("beam viterbi, width " + cast_to_string(widths[i]) + ":", start, ts.get_timestamp());
+        cout << "   value lost: " << best_val - map_assignment_value(prob, assign2) << endl;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+